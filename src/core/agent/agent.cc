@@ -22,6 +22,7 @@
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <typeinfo>
 #include <unordered_map>
 #include <vector>
 
@@ -31,8 +32,11 @@
 #include "core/execution_context/in_place_exec_ctxt.h"
 #include "core/resource_manager.h"
 #include "core/simulation.h"
+#include "core/util/cost_accounting.h"
 #include "core/util/log.h"
 #include "core/util/macros.h"
+#include "core/util/philox.h"
+#include "core/util/profiler.h"
 #include "core/util/root.h"
 #include "core/util/type.h"
 
@@ -47,6 +51,7 @@ Agent::Agent(TRootIOCtor* io_ctor) {}
 Agent::Agent(const Agent& other)
     : uid_(other.uid_),
       box_idx_(other.box_idx_),
+      canonical_key_(other.canonical_key_),
       run_behavior_loop_idx_(other.run_behavior_loop_idx_),
       propagate_staticness_neighborhood_(
           other.propagate_staticness_neighborhood_),
@@ -112,6 +117,10 @@ void Agent::UpdateStaticness() {
   auto* param = Simulation::GetActive()->GetParam();
   is_static_ = is_static_next_ts_;
   is_static_next_ts_ = param->detect_static_agents;
+  AgentHandle ah;
+  if (auto* columns = GetAgentColumns(&ah)) {
+    columns->SetStatic(ah, is_static_);
+  }
 }
 
 void Agent::RunDiscretization() {}
@@ -122,10 +131,32 @@ void Agent::AssignNewUid() {
 
 const AgentUid& Agent::GetUid() const { return uid_; }
 
+uint64_t Agent::GetCanonicalKey() const {
+  if (canonical_key_ != 0) {
+    return canonical_key_;
+  }
+  return Philox::HashCombine(uid_.GetIndex(), uid_.GetReused());
+}
+
 uint32_t Agent::GetBoxIdx() const { return box_idx_; }
 
 void Agent::SetBoxIdx(uint32_t idx) { box_idx_ = idx; }
 
+AgentColumns* Agent::GetAgentColumns(AgentHandle* ah) const {
+  auto* sim = Simulation::GetActive();
+  auto* rm = sim != nullptr ? sim->GetResourceManager() : nullptr;
+  auto* columns = rm != nullptr ? rm->GetAgentColumns() : nullptr;
+  if (columns == nullptr || !rm->ContainsAgent(uid_)) {
+    return nullptr;
+  }
+  *ah = rm->GetAgentHandle(uid_);
+  // Copies share the uid with the agent in the ResourceManager
+  if (rm->GetAgent(*ah) != this) {
+    return nullptr;
+  }
+  return columns;
+}
+
 // ---------------------------------------------------------------------------
 // Behaviors
 
@@ -144,10 +175,20 @@ void Agent::RemoveBehavior(const Behavior* behavior) {
 }
 
 void Agent::RunBehaviors() {
+  auto* cost_accounting = CostAccounting::GetActive();
+  bool sampling = cost_accounting && cost_accounting->IsSampling();
   for (run_behavior_loop_idx_ = 0; run_behavior_loop_idx_ < behaviors_.size();
        ++run_behavior_loop_idx_) {
     auto* behavior = behaviors_[run_behavior_loop_idx_];
-    behavior->Run(this);
+    ProfileScope scope(typeid(*behavior));
+    if (sampling) {
+      auto start = CostAccounting::Now();
+      behavior->Run(this);
+      cost_accounting->AddBehaviorCost(typeid(*behavior),
+                                       CostAccounting::Now() - start);
+    } else {
+      behavior->Run(this);
+    }
   }
 }
 
@@ -26,6 +26,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "core/agent/agent_handle.h"
 #include "core/agent/agent_pointer.h"
 #include "core/agent/agent_uid.h"
 #include "core/agent/new_agent_event.h"
@@ -73,6 +74,7 @@ namespace bdm {
 
 // -----------------------------------------------------------------------------
 
+class AgentColumns;
 class Behavior;
 
 /// Contains code required by all agents
@@ -147,6 +149,14 @@ class Agent {
 
   const AgentUid& GetUid() const;
 
+  /// Returns the key that identifies this agent independent of the number of
+  /// threads (see `Param::deterministic`). Agents that are created during the
+  /// agent operations derive it from the key of the creating agent, all other
+  /// agents from their uid.
+  uint64_t GetCanonicalKey() const;
+
+  void SetCanonicalKey(uint64_t key) { canonical_key_ = key; }
+
   Spinlock* GetLock() { return &lock_; }
 
   /// If the thread-safety mechanism is set to user-specified this function
@@ -271,6 +281,8 @@ class Agent {
   AgentUid uid_;
   /// Grid box index
   uint32_t box_idx_ = std::numeric_limits<uint32_t>::max();
+  /// Key of `GetCanonicalKey`; zero if it is derived from the uid
+  uint64_t canonical_key_ = 0;
   /// collection of behaviors which define the internal behavior
   InlineVector<Behavior*, 2> behaviors_;
 
@@ -286,6 +298,14 @@ class Agent {
     return dynamic_cast<TTo*>(agent);
   }
 
+  /// Returns the agent columns of the ResourceManager and sets `ah` to the
+  /// handle of this agent if the columns are enabled and this agent is
+  /// stored in the ResourceManager. Returns a nullptr otherwise (e.g. for new
+  /// agents that have not been committed yet, or for agent copies).\n
+  /// Setters of attributes that are stored in the columns use this function
+  /// to write the new value through. \see `AgentColumns`
+  AgentColumns* GetAgentColumns(AgentHandle* ah) const;
+
  private:
   Spinlock lock_;  //!
 
@@ -315,7 +335,7 @@ class Agent {
   /// and `NewAgentEvent::new_behaviors` to their correct value.
   void UpdateBehaviors(const NewAgentEvent& event);
 
-  BDM_CLASS_DEF(Agent, 1)
+  BDM_CLASS_DEF(Agent, 2)
 };
 
 }  // namespace bdm
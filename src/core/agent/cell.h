@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "core/agent/agent.h"
+#include "core/agent_columns.h"
 #include "core/agent/cell_division_event.h"
 #include "core/agent/new_agent_event.h"
 #include "core/container/inline_vector.h"
@@ -204,6 +205,7 @@ class Cell : public Agent {
     }
     diameter_ = diameter;
     UpdateVolume();
+    UpdateAgentColumns();
   }
 
   void SetVolume(real_t volume) {
@@ -223,10 +225,12 @@ class Cell : public Agent {
   void SetPosition(const Real3& position) override {
     position_ = position;
     SetPropagateStaticness();
+    UpdateAgentColumns();
   }
 
   void SetTractorForce(const Real3& tractor_force) {
     tractor_force_ = tractor_force;
+    UpdateAgentColumns();
   }
 
   void ChangeVolume(real_t speed) {
@@ -247,6 +251,7 @@ class Cell : public Agent {
       Base::SetPropagateStaticness();
     }
     diameter_ = diameter;
+    UpdateAgentColumns();
   }
 
   void UpdateVolume() {
@@ -257,6 +262,7 @@ class Cell : public Agent {
   void UpdatePosition(const Real3& delta) {
     position_ += delta;
     SetPropagateStaticness();
+    UpdateAgentColumns();
   }
 
   Real3 CalculateDisplacement(const InteractionForce* force,
@@ -266,26 +272,6 @@ class Cell : public Agent {
     // There is also a computation of the torque (only applied
     // by the daughter neurites), stored in rotationForce.
 
-    // TODO(roman) : There might be a problem, in the sense that the biology
-    // is not applied if the total Force is smaller than adherence.
-    // Once, I should look at this more carefully.
-
-    // fixme why? copying
-    const auto& tf = GetTractorForce();
-
-    // the 3 types of movement that can occur
-    // bool biological_translation = false;
-    bool physical_translation = false;
-    // bool physical_rotation = false;
-
-    real_t h = dt;
-    Real3 movement_at_next_step{0, 0, 0};
-
-    // BIOLOGY :
-    // 0) Start with tractor force : What the biology defined as active
-    // movement------------
-    movement_at_next_step += tf * h;
-
     // PHYSICS
     // the physics force to move the point mass
     Real3 translation_force_on_point_mass{0, 0, 0};
@@ -317,10 +303,44 @@ class Cell : public Agent {
             }
           });
       ctxt->ForEachNeighbor(calculate_neighbor_forces, *this, squared_radius);
+    }
 
-      if (non_zero_neighbor_forces > 1) {
-        SetStaticnessNextTimestep(false);
-      }
+    return CalculateDisplacementFromForce(translation_force_on_point_mass,
+                                          non_zero_neighbor_forces, dt);
+  }
+
+  /// Second half of `CalculateDisplacement`: calculates the displacement
+  /// from the sum of the neighbor forces `translation_force_on_point_mass`,
+  /// which consists of `non_zero_neighbor_forces` non-zero contributions.
+  /// Takes the tractor force, adherence, mass, and maximum displacement into
+  /// account. Operations that sum up the neighbor forces themselves (e.g.
+  /// from `AgentColumns`) use it to get the same result as
+  /// `CalculateDisplacement`.
+  Real3 CalculateDisplacementFromForce(
+      const Real3& translation_force_on_point_mass,
+      uint64_t non_zero_neighbor_forces, real_t dt) {
+    // TODO(roman) : There might be a problem, in the sense that the biology
+    // is not applied if the total Force is smaller than adherence.
+    // Once, I should look at this more carefully.
+
+    // fixme why? copying
+    const auto& tf = GetTractorForce();
+
+    // the 3 types of movement that can occur
+    // bool biological_translation = false;
+    bool physical_translation = false;
+    // bool physical_rotation = false;
+
+    real_t h = dt;
+    Real3 movement_at_next_step{0, 0, 0};
+
+    // BIOLOGY :
+    // 0) Start with tractor force : What the biology defined as active
+    // movement------------
+    movement_at_next_step += tf * h;
+
+    if (non_zero_neighbor_forces > 1) {
+      SetStaticnessNextTimestep(false);
     }
 
     // 4) PhysicalBonds
@@ -356,6 +376,7 @@ class Cell : public Agent {
 
   void MovePointMass(const Real3& normalized_dir, real_t speed) {
     tractor_force_ += normalized_dir * speed;
+    UpdateAgentColumns();
   }
 
  protected:
@@ -377,6 +398,17 @@ class Cell : public Agent {
   real_t adherence_ = 0;
   /// NB: Use setter and don't assign values directly
   real_t density_ = 0;
+
+  /// Writes the position, diameter, and tractor force through to the agent
+  /// columns (if enabled). \see `Param::agent_columns`
+  void UpdateAgentColumns() {
+    AgentHandle ah;
+    if (auto* columns = GetAgentColumns(&ah)) {
+      columns->SetPosition(ah, position_);
+      columns->SetDiameter(ah, diameter_);
+      columns->SetTractorForce(ah, tractor_force_);
+    }
+  }
 };
 
 }  // namespace bdm
@@ -16,6 +16,7 @@
 #define CORE_AGENT_SPHERICAL_AGENT_H_
 
 #include "core/agent/agent.h"
+#include "core/agent_columns.h"
 #include "core/container/math_array.h"
 #include "core/interaction_force.h"
 #include "core/shape.h"
@@ -47,11 +48,13 @@ class SphericalAgent : public Agent {
       SetPropagateStaticness();
     }
     diameter_ = diameter;
+    UpdateAgentColumns();
   }
 
   void SetPosition(const Real3& position) override {
     position_ = position;
     SetPropagateStaticness();
+    UpdateAgentColumns();
   }
 
   /// This agent type has an empty implementation for CalculateDisplacement.
@@ -67,6 +70,7 @@ class SphericalAgent : public Agent {
     }
     position_ += displacement;
     SetPropagateStaticness();
+    UpdateAgentColumns();
   }
 
  private:
@@ -74,6 +78,16 @@ class SphericalAgent : public Agent {
   Real3 position_ = {{0, 0, 0}};
   /// NB: Use setter and don't assign values directly
   real_t diameter_ = 0;
+
+  /// Writes the position and diameter through to the agent columns (if
+  /// enabled). \see `Param::agent_columns`
+  void UpdateAgentColumns() {
+    AgentHandle ah;
+    if (auto* columns = GetAgentColumns(&ah)) {
+      columns->SetPosition(ah, position_);
+      columns->SetDiameter(ah, diameter_);
+    }
+  }
 };
 
 }  // namespace bdm
@@ -0,0 +1,81 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/agent_columns.h"
+
+#include "core/agent/agent.h"
+#include "core/agent/cell.h"
+#include "core/functor.h"
+#include "core/resource_manager.h"
+
+namespace bdm {
+
+// -----------------------------------------------------------------------------
+void AgentColumns::Update(ResourceManager* rm) {
+  for (uint64_t n = 0; n < columns_.size(); ++n) {
+    columns_[n].Resize(rm->GetNumAgents(n));
+  }
+  auto set = L2F([&](Agent* agent, AgentHandle ah) { Set(ah, agent); });
+  rm->ForEachAgentParallel(set);
+}
+
+// -----------------------------------------------------------------------------
+void AgentColumns::Clear() {
+  for (auto& c : columns_) {
+    c.Resize(0);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void AgentColumns::Resize(uint64_t nid, uint64_t size) {
+  columns_[nid].Resize(size);
+}
+
+// -----------------------------------------------------------------------------
+void AgentColumns::Set(AgentHandle ah, const Agent* agent) {
+  SetPosition(ah, agent->GetPosition());
+  SetDiameter(ah, agent->GetDiameter());
+  // Only cells have a tractor force
+  auto* cell = dynamic_cast<const Cell*>(agent);
+  SetTractorForce(ah, cell ? cell->GetTractorForce() : Real3{0, 0, 0});
+  SetStatic(ah, agent->IsStatic());
+  SetBoxIdx(ah, agent->GetBoxIdx());
+  columns_[ah.GetNumaNode()].shape[ah.GetElementIdx()] =
+      static_cast<uint8_t>(agent->GetShape());
+}
+
+// -----------------------------------------------------------------------------
+void AgentColumns::FinishRemoval(const std::vector<uint64_t>& num_agents) {
+  for (uint64_t n = 0; n < columns_.size() && n < num_agents.size(); ++n) {
+    if (columns_[n].x.size() > num_agents[n]) {
+      columns_[n].Resize(num_agents[n]);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void AgentColumns::Columns::Resize(uint64_t size) {
+  x.resize(size);
+  y.resize(size);
+  z.resize(size);
+  diameter.resize(size);
+  tractor_x.resize(size);
+  tractor_y.resize(size);
+  tractor_z.resize(size);
+  is_static.resize(size);
+  shape.resize(size);
+  box_idx.resize(size);
+}
+
+}  // namespace bdm
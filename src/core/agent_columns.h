@@ -0,0 +1,204 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_AGENT_COLUMNS_H_
+#define CORE_AGENT_COLUMNS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "core/agent/agent_handle.h"
+#include "core/container/math_array.h"
+#include "core/real_t.h"
+#include "core/shape.h"
+
+namespace bdm {
+
+class Agent;
+class ResourceManager;
+
+/// Structure-of-arrays copy of the most frequently accessed agent attributes
+/// (position, diameter, tractor force, staticness, shape, and box index).
+/// The attributes of agent `ah` are stored at index `ah.GetElementIdx()` of
+/// the columns of NUMA node `ah.GetNumaNode()`, i.e. the columns follow the
+/// order of the agents in the ResourceManager.\n
+/// The columns are kept in sync with the agents:
+/// - The agent setters (e.g. `Cell::SetPosition`, `Cell::SetDiameter`,
+///   `Cell::SetTractorForce`, `Agent::UpdateStaticness`) write the new value
+///   through to the columns (see `Agent::GetAgentColumns`). Agents that are
+///   not stored in the ResourceManager (e.g. new agents that have not been
+///   committed yet, or agent copies) are not written through.
+/// - The ResourceManager adds, moves and removes the entries together with
+///   the agents, and reorders them during load balancing.
+/// - The box index is written by the `UniformGridEnvironment`.
+///
+/// Kernels that only need these attributes (e.g. the neighbor search) can
+/// read them without virtual function calls on scattered agent objects.
+/// \see `Param::agent_columns`
+class AgentColumns {
+ public:
+  explicit AgentColumns(uint64_t num_numa_nodes)
+      : columns_(num_numa_nodes), columns_lb_(num_numa_nodes) {}
+
+  /// Copies the attributes of all agents in `rm` into the columns.
+  void Update(ResourceManager* rm);
+
+  /// Removes all entries.
+  void Clear();
+
+  uint64_t GetNumNumaNodes() const { return columns_.size(); }
+
+  uint64_t GetNumAgents(uint64_t nid) const {
+    return columns_[nid].x.size();
+  }
+
+  /// Resizes the columns of NUMA node `nid` to hold `size` agents.
+  void Resize(uint64_t nid, uint64_t size);
+
+  /// Copies all attributes of `agent` into the entry of `ah`.
+  /// Thread-safe as long as different threads set different agents.
+  void Set(AgentHandle ah, const Agent* agent);
+
+  void SetPosition(AgentHandle ah, const Real3& position) {
+    auto& c = columns_[ah.GetNumaNode()];
+    auto idx = ah.GetElementIdx();
+    c.x[idx] = position[0];
+    c.y[idx] = position[1];
+    c.z[idx] = position[2];
+  }
+
+  void SetDiameter(AgentHandle ah, real_t diameter) {
+    columns_[ah.GetNumaNode()].diameter[ah.GetElementIdx()] = diameter;
+  }
+
+  void SetTractorForce(AgentHandle ah, const Real3& tractor_force) {
+    auto& c = columns_[ah.GetNumaNode()];
+    auto idx = ah.GetElementIdx();
+    c.tractor_x[idx] = tractor_force[0];
+    c.tractor_y[idx] = tractor_force[1];
+    c.tractor_z[idx] = tractor_force[2];
+  }
+
+  void SetStatic(AgentHandle ah, bool is_static) {
+    columns_[ah.GetNumaNode()].is_static[ah.GetElementIdx()] = is_static;
+  }
+
+  void SetBoxIdx(AgentHandle ah, uint32_t box_idx) {
+    columns_[ah.GetNumaNode()].box_idx[ah.GetElementIdx()] = box_idx;
+  }
+
+  Real3 GetPosition(AgentHandle ah) const {
+    const auto& c = columns_[ah.GetNumaNode()];
+    auto idx = ah.GetElementIdx();
+    return {c.x[idx], c.y[idx], c.z[idx]};
+  }
+
+  real_t GetDiameter(AgentHandle ah) const {
+    return columns_[ah.GetNumaNode()].diameter[ah.GetElementIdx()];
+  }
+
+  Real3 GetTractorForce(AgentHandle ah) const {
+    const auto& c = columns_[ah.GetNumaNode()];
+    auto idx = ah.GetElementIdx();
+    return {c.tractor_x[idx], c.tractor_y[idx], c.tractor_z[idx]};
+  }
+
+  bool IsStatic(AgentHandle ah) const {
+    return columns_[ah.GetNumaNode()].is_static[ah.GetElementIdx()] != 0;
+  }
+
+  Shape GetShape(AgentHandle ah) const {
+    return static_cast<Shape>(
+        columns_[ah.GetNumaNode()].shape[ah.GetElementIdx()]);
+  }
+
+  uint32_t GetBoxIdx(AgentHandle ah) const {
+    return columns_[ah.GetNumaNode()].box_idx[ah.GetElementIdx()];
+  }
+
+  const real_t* GetX(uint64_t nid) const { return columns_[nid].x.data(); }
+  const real_t* GetY(uint64_t nid) const { return columns_[nid].y.data(); }
+  const real_t* GetZ(uint64_t nid) const { return columns_[nid].z.data(); }
+  const real_t* GetDiameter(uint64_t nid) const {
+    return columns_[nid].diameter.data();
+  }
+  const uint32_t* GetBoxIdx(uint64_t nid) const {
+    return columns_[nid].box_idx.data();
+  }
+
+  /// Load balancing moves agents to new storage locations. Prepares the
+  /// columns of NUMA node `nid` to hold `size` reordered agents.
+  void ResizeReordered(uint64_t nid, uint64_t size) {
+    columns_lb_[nid].Resize(size);
+  }
+
+  /// Copies the entry of `from` to index `idx` of the reordered columns of
+  /// NUMA node `nid`.
+  void SetReordered(uint64_t nid, uint64_t idx, AgentHandle from) {
+    columns_lb_[nid].Copy(idx, columns_[from.GetNumaNode()],
+                          from.GetElementIdx());
+  }
+
+  /// Replaces the columns with the reordered ones.
+  void FinishReorder() { columns_.swap(columns_lb_); }
+
+  /// Removing agents moves agent `from` of NUMA node `nid` to index `to`.
+  /// Thread-safe as long as different threads move different agents.
+  void Move(uint64_t nid, uint64_t from, uint64_t to) {
+    auto& c = columns_[nid];
+    c.Copy(to, c, from);
+  }
+
+  /// Discards the entries of removed agents. `num_agents[n]` is the number of
+  /// agents of NUMA node `n` after the removal.
+  void FinishRemoval(const std::vector<uint64_t>& num_agents);
+
+ private:
+  /// Columns of one NUMA node
+  struct Columns {
+    std::vector<real_t> x;
+    std::vector<real_t> y;
+    std::vector<real_t> z;
+    std::vector<real_t> diameter;
+    std::vector<real_t> tractor_x;
+    std::vector<real_t> tractor_y;
+    std::vector<real_t> tractor_z;
+    std::vector<uint8_t> is_static;
+    std::vector<uint8_t> shape;
+    std::vector<uint32_t> box_idx;
+
+    void Resize(uint64_t size);
+
+    void Copy(uint64_t to, const Columns& src, uint64_t from) {
+      x[to] = src.x[from];
+      y[to] = src.y[from];
+      z[to] = src.z[from];
+      diameter[to] = src.diameter[from];
+      tractor_x[to] = src.tractor_x[from];
+      tractor_y[to] = src.tractor_y[from];
+      tractor_z[to] = src.tractor_z[from];
+      is_static[to] = src.is_static[from];
+      shape[to] = src.shape[from];
+      box_idx[to] = src.box_idx[from];
+    }
+  };
+
+  std::vector<Columns> columns_;
+  /// Columns used during load balancing
+  std::vector<Columns> columns_lb_;
+};
+
+}  // namespace bdm
+
+#endif  // CORE_AGENT_COLUMNS_H_
@@ -0,0 +1,102 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/agent_costs.h"
+
+#include <cmath>
+
+#include "core/resource_manager.h"
+#include "core/util/thread_info.h"
+
+namespace bdm {
+
+// -----------------------------------------------------------------------------
+void AgentCosts::StartMeasurement(const ResourceManager* rm) {
+  auto num_numa_nodes = ThreadInfo::GetInstance()->GetNumaNodes();
+  costs_.resize(num_numa_nodes);
+  costs_lb_.resize(num_numa_nodes);
+  prefix_.resize(num_numa_nodes);
+  for (int n = 0; n < num_numa_nodes; ++n) {
+    costs_[n].assign(rm->GetNumAgents(n), 0);
+  }
+  measuring_ = true;
+}
+
+// -----------------------------------------------------------------------------
+void AgentCosts::StopMeasurement() {
+  measuring_ = false;
+  has_costs_ = true;
+  UpdatePrefixSum();
+}
+
+// -----------------------------------------------------------------------------
+real_t AgentCosts::GetCummulatedCost(uint64_t nid, uint64_t num_agents) const {
+  const auto& prefix = prefix_[nid];
+  uint64_t measured = prefix.size() - 1;
+  if (num_agents <= measured) {
+    return prefix[num_agents];
+  }
+  return prefix[measured] + (num_agents - measured) * average_cost_;
+}
+
+// -----------------------------------------------------------------------------
+uint64_t AgentCosts::FindAgent(uint64_t nid, uint64_t num_agents,
+                               real_t cost) const {
+  const auto& prefix = prefix_[nid];
+  uint64_t measured = std::min(prefix.size() - 1, num_agents);
+  if (cost <= prefix[measured]) {
+    return std::lower_bound(prefix.begin(), prefix.begin() + measured, cost) -
+           prefix.begin();
+  }
+  if (average_cost_ <= 0) {
+    return num_agents;
+  }
+  auto remaining = std::ceil((cost - prefix[measured]) / average_cost_);
+  return std::min(num_agents, measured + static_cast<uint64_t>(remaining));
+}
+
+// -----------------------------------------------------------------------------
+void AgentCosts::FinishReorder() {
+  costs_.swap(costs_lb_);
+  UpdatePrefixSum();
+}
+
+// -----------------------------------------------------------------------------
+void AgentCosts::FinishRemoval(const std::vector<uint64_t>& num_agents) {
+  for (uint64_t n = 0; n < costs_.size() && n < num_agents.size(); ++n) {
+    if (costs_[n].size() > num_agents[n]) {
+      costs_[n].resize(num_agents[n]);
+    }
+  }
+  UpdatePrefixSum();
+}
+
+// -----------------------------------------------------------------------------
+void AgentCosts::UpdatePrefixSum() {
+  real_t total = 0;
+  uint64_t num_agents = 0;
+  for (uint64_t n = 0; n < costs_.size(); ++n) {
+    auto& prefix = prefix_[n];
+    prefix.resize(costs_[n].size() + 1);
+    prefix[0] = 0;
+    for (uint64_t i = 0; i < costs_[n].size(); ++i) {
+      prefix[i + 1] = prefix[i] + costs_[n][i];
+    }
+    total += prefix.back();
+    num_agents += costs_[n].size();
+  }
+  average_cost_ = num_agents != 0 ? total / num_agents : 0;
+}
+
+}  // namespace bdm
@@ -0,0 +1,143 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_AGENT_COSTS_H_
+#define CORE_AGENT_COSTS_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "core/agent/agent_handle.h"
+#include "core/real_t.h"
+
+namespace bdm {
+
+class ResourceManager;
+
+/// Measured execution time of the agent operations for each agent.\n
+/// `ResourceManager::ForEachAgentParallel(chunk, ...)` measures the
+/// execution time of each chunk and distributes it evenly among the agents of
+/// the chunk. The cost of agent `ah` is stored at
+/// `costs_[ah.GetNumaNode()][ah.GetElementIdx()]`, i.e. the costs follow the
+/// order of the agents in the ResourceManager.\n
+/// Agents that have been added after the last measurement are assumed to
+/// have the average cost. `ResourceManager::RemoveAgents` moves the costs
+/// together with the agents.
+/// \see `Param::cost_weighted_load_balancing`
+class AgentCosts {
+ public:
+  /// Returns the current time in nanoseconds.
+  static int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /// Discards the previous measurement and resizes the containers to the
+  /// number of agents in `rm`. Until `StopMeasurement` is called, the
+  /// execution times of all calls to `ForEachAgentParallel(chunk, ...)` are
+  /// accumulated. `GetCummulatedCost` and `FindAgent` return the result of
+  /// the previous measurement in the meantime.
+  void StartMeasurement(const ResourceManager* rm);
+
+  void StopMeasurement();
+
+  bool IsMeasuring() const { return measuring_; }
+
+  /// Discards all measurements.
+  void Clear() {
+    measuring_ = false;
+    has_costs_ = false;
+  }
+
+  /// Returns true if at least one measurement has been completed.
+  bool HasCosts() const { return has_costs_; }
+
+  /// Distributes `cost` evenly among the agents [start, end) of NUMA node
+  /// `nid`. Thread-safe as long as different threads add costs for different
+  /// agents.
+  void AddChunkCost(uint64_t nid, uint64_t start, uint64_t end, real_t cost) {
+    auto& costs = costs_[nid];
+    end = std::min(end, static_cast<uint64_t>(costs.size()));
+    if (end <= start) {
+      return;
+    }
+    real_t cost_per_agent = cost / (end - start);
+    for (uint64_t i = start; i < end; ++i) {
+      costs[i] += cost_per_agent;
+    }
+  }
+
+  real_t GetCost(AgentHandle ah) const {
+    const auto& costs = costs_[ah.GetNumaNode()];
+    if (ah.GetElementIdx() < costs.size()) {
+      return costs[ah.GetElementIdx()];
+    }
+    return average_cost_;
+  }
+
+  /// Returns the accumulated cost of the first `num_agents` agents of NUMA
+  /// node `nid`.
+  real_t GetCummulatedCost(uint64_t nid, uint64_t num_agents) const;
+
+  /// Returns the smallest index `i <= num_agents`, for which the accumulated
+  /// cost of the agents [0, i) of NUMA node `nid` is at least `cost`.
+  uint64_t FindAgent(uint64_t nid, uint64_t num_agents, real_t cost) const;
+
+  /// Load balancing moves agents to new storage locations. Prepares the
+  /// container for NUMA node `nid` to hold `size` reordered costs.
+  void ResizeReordered(uint64_t nid, uint64_t size) {
+    costs_lb_[nid].resize(size);
+  }
+
+  void SetReorderedCost(uint64_t nid, uint64_t idx, real_t cost) {
+    costs_lb_[nid][idx] = cost;
+  }
+
+  /// Replaces the costs with the reordered ones.
+  void FinishReorder();
+
+  /// Removing agents moves agent `from` of NUMA node `nid` to index `to`.
+  /// Agents that have not been measured receive the average cost.
+  /// Thread-safe as long as different threads move different agents.
+  void MoveCost(uint64_t nid, uint64_t from, uint64_t to) {
+    if (nid >= costs_.size() || to >= costs_[nid].size()) {
+      return;
+    }
+    auto& costs = costs_[nid];
+    costs[to] = from < costs.size() ? costs[from] : average_cost_;
+  }
+
+  /// Discards the costs of removed agents. `num_agents[n]` is the number of
+  /// agents of NUMA node `n` after the removal.
+  void FinishRemoval(const std::vector<uint64_t>& num_agents);
+
+ private:
+  bool measuring_ = false;
+  bool has_costs_ = false;
+  real_t average_cost_ = 0;
+  std::vector<std::vector<real_t>> costs_;
+  /// Container used during load balancing
+  std::vector<std::vector<real_t>> costs_lb_;
+  /// Inclusive prefix sum of `costs_` with a leading zero
+  std::vector<std::vector<real_t>> prefix_;
+
+  void UpdatePrefixSum();
+};
+
+}  // namespace bdm
+
+#endif  // CORE_AGENT_COSTS_H_
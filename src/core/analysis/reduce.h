@@ -70,7 +70,10 @@ struct Reducer : public Functor<void, Agent*> {
 /// all agents.
 /// The benefit in comparison with `bdm::experimental::Reduce` is that
 /// multiple counters can be combined and processed in one sweep over
-/// all agents.
+/// all agents.\n
+/// In the deterministic mode (see `Param::deterministic`), each agent has its
+/// own partial result and the partial results are combined in the order of
+/// the canonical agent keys.
 /// \see bdm::experimental::Reducer`
 template <typename T, typename TResult = T>
 class GenericReducer : public Reducer<TResult> {
@@ -96,6 +99,10 @@ class GenericReducer : public Reducer<TResult> {
 
   void operator()(Agent* agent) override {
     if (!filter_ || (filter_(agent))) {
+      if (deterministic_) {
+        agent_function_(agent, partials_.Add(agent));
+        return;
+      }
       auto tid = ThreadInfo::GetInstance()->GetMyThreadId();
       agent_function_(agent, &(tl_results_[tid]));
     }
@@ -106,10 +113,15 @@ class GenericReducer : public Reducer<TResult> {
     for (auto& el : tl_results_) {
       el = T();
     }
+    auto* sim = Simulation::GetActive();
+    deterministic_ = sim != nullptr && sim->GetParam()->deterministic;
+    partials_.Clear();
   }
 
   TResult GetResult() override {
-    auto combined = static_cast<TResult>(reduce_partial_results_(tl_results_));
+    auto combined = static_cast<TResult>(
+        deterministic_ ? partials_.Reduce(reduce_partial_results_)
+                       : reduce_partial_results_(tl_results_));
     if (post_process_) {
       return post_process_(combined);
     }
@@ -122,6 +134,9 @@ class GenericReducer : public Reducer<TResult> {
 
  private:
   SharedData<T> tl_results_;                                     //!
+  /// Partial results of the agents in the deterministic mode
+  CanonicalPartialResults<T> partials_;                          //!
+  bool deterministic_ = false;                                   //!
   void (*agent_function_)(Agent*, T*) = nullptr;                 //!
   T (*reduce_partial_results_)(const SharedData<T>&) = nullptr;  //!
   bool (*filter_)(Agent*) = nullptr;                             //!
@@ -178,6 +193,8 @@ inline void GenericReducer<T, TResult>::Streamer(TBuffer& R__b) {
 /// \endcode
 /// The optional argument `filter` allows to reduce only a subset of
 /// all agents.\n
+/// In the deterministic mode, the partial results are combined like in
+/// `GenericReducer`.\n
 /// NB: For better performance consider using `GenericReducer` instead.
 template <typename T>
 inline T Reduce(Simulation* sim, Functor<void, Agent*, T*>& agent_functor,
@@ -191,13 +208,22 @@ inline T Reduce(Simulation* sim, Functor<void, Agent*, T*>& agent_functor,
     el = T();
   }
 
+  auto* rm = sim->GetResourceManager();
+  if (sim->GetParam()->deterministic) {
+    CanonicalPartialResults<T> partials;
+    auto agent_func = L2F([&](Agent* agent, AgentHandle) {
+      agent_functor(agent, partials.Add(agent));
+    });
+    rm->ForEachAgentParallel(agent_func, filter);
+    return partials.Reduce(reduce_partial_results);
+  }
+
   // reduce
   //   execute agent functor in parallel
   auto actual_agent_func = L2F([&](Agent* agent, AgentHandle) {
     auto tid = ThreadInfo::GetInstance()->GetMyThreadId();
     agent_functor(agent, &(tl_results[tid]));
   });
-  auto* rm = sim->GetResourceManager();
   rm->ForEachAgentParallel(actual_agent_func, filter);
   //   combine thread-local results
   return reduce_partial_results(tl_results);
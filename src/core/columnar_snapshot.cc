@@ -0,0 +1,222 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/columnar_snapshot.h"
+
+#include <Compression.h>
+#include <RZip.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+#include "core/util/log.h"
+
+namespace bdm {
+namespace columnar {
+
+// -----------------------------------------------------------------------------
+uint64_t GetSize(ColumnType type) {
+  switch (type) {
+    case ColumnType::kInt8:
+    case ColumnType::kUInt8:
+      return 1;
+    case ColumnType::kInt16:
+    case ColumnType::kUInt16:
+      return 2;
+    case ColumnType::kInt32:
+    case ColumnType::kUInt32:
+    case ColumnType::kFloat:
+      return 4;
+    case ColumnType::kInt64:
+    case ColumnType::kUInt64:
+    case ColumnType::kDouble:
+      return 8;
+  }
+  Log::Fatal("columnar::GetSize", "Unknown column type ",
+             static_cast<int>(type));
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+uint64_t CompressBlock(Compression compression, int level, const char* src,
+                       uint64_t size, char* dst) {
+  using Algorithm = ROOT::RCompressionSetting::EAlgorithm;
+  Algorithm::EValues algorithm;
+  switch (compression) {
+    case Compression::kZlib:
+      algorithm = Algorithm::kZLIB;
+      break;
+    case Compression::kLz4:
+      algorithm = Algorithm::kLZ4;
+      break;
+    case Compression::kZstd:
+      algorithm = Algorithm::kZSTD;
+      break;
+    default:
+      return 0;
+  }
+  int src_size = static_cast<int>(size);
+  int dst_size = static_cast<int>(size);
+  int compressed_size = 0;
+  // R__zip does not modify the source buffer
+  R__zipMultipleAlgorithm(std::max(level, 1), &src_size,
+                          const_cast<char*>(src), &dst_size, dst,
+                          &compressed_size, algorithm);
+  if (compressed_size <= 0 || static_cast<uint64_t>(compressed_size) >= size) {
+    return 0;
+  }
+  return compressed_size;
+}
+
+}  // namespace columnar
+
+// -----------------------------------------------------------------------------
+ColumnarSnapshotReader::ColumnarSnapshotReader(const std::string& filename) {
+  fd_ = open(filename.c_str(), O_RDONLY);
+  if (fd_ == -1) {
+    Log::Fatal("ColumnarSnapshotReader", "Could not open file ", filename);
+  }
+  struct stat file_stat;
+  if (fstat(fd_, &file_stat) != 0 ||
+      static_cast<uint64_t>(file_stat.st_size) < sizeof(header_)) {
+    Log::Fatal("ColumnarSnapshotReader", "File ", filename,
+               " is not a columnar snapshot");
+  }
+  size_ = file_stat.st_size;
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (data == MAP_FAILED) {
+    Log::Fatal("ColumnarSnapshotReader", "Could not map file ", filename);
+  }
+  data_ = static_cast<const char*>(data);
+
+  std::memcpy(&header_, data_, sizeof(header_));
+  if (std::memcmp(header_.magic, columnar::kMagic, sizeof(header_.magic))) {
+    Log::Fatal("ColumnarSnapshotReader", "File ", filename,
+               " is not a columnar snapshot");
+  }
+  if (header_.byte_order != columnar::kByteOrderMark) {
+    Log::Fatal("ColumnarSnapshotReader", "File ", filename,
+               " has been written with a different byte order");
+  }
+  if (header_.version != columnar::kVersion) {
+    Log::Fatal("ColumnarSnapshotReader", "File ", filename, " has version ",
+               header_.version, ", but only version ", columnar::kVersion,
+               " is supported");
+  }
+  auto column_table_size = header_.num_columns * sizeof(columnar::ColumnEntry);
+  if (header_.column_table + column_table_size > size_ ||
+      header_.type_table + header_.type_table_size > size_) {
+    Log::Fatal("ColumnarSnapshotReader", "File ", filename, " is truncated");
+  }
+
+  columns_ = reinterpret_cast<const columnar::ColumnEntry*>(
+      data_ + header_.column_table);
+  for (uint64_t i = 0; i < header_.num_columns; ++i) {
+    const auto& column = columns_[i];
+    if (column.offset + column.size > size_) {
+      Log::Fatal("ColumnarSnapshotReader", "File ", filename, " is truncated");
+    }
+    auto length = strnlen(column.name, sizeof(column.name));
+    column_index_[std::string(column.name, length)] = i;
+  }
+
+  const char* types = data_ + header_.type_table;
+  const char* types_end = types + header_.type_table_size;
+  while (types < types_end) {
+    type_names_.emplace_back(types, strnlen(types, types_end - types));
+    types += type_names_.back().size() + 1;
+  }
+}
+
+// -----------------------------------------------------------------------------
+ColumnarSnapshotReader::~ColumnarSnapshotReader() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+// -----------------------------------------------------------------------------
+std::vector<std::string> ColumnarSnapshotReader::GetColumnNames() const {
+  std::vector<std::string> names(header_.num_columns);
+  for (auto& el : column_index_) {
+    names[el.second] = el.first;
+  }
+  return names;
+}
+
+// -----------------------------------------------------------------------------
+const columnar::ColumnEntry& ColumnarSnapshotReader::GetColumnEntry(
+    const std::string& name) const {
+  auto it = column_index_.find(name);
+  if (it == column_index_.end()) {
+    Log::Fatal("ColumnarSnapshotReader::GetColumnEntry", "Column ", name,
+               " does not exist");
+  }
+  return columns_[it->second];
+}
+
+// -----------------------------------------------------------------------------
+const void* ColumnarSnapshotReader::GetColumnData(const std::string& name,
+                                                  columnar::ColumnType type) {
+  const auto& column = GetColumnEntry(name);
+  if (column.type != type) {
+    Log::Fatal("ColumnarSnapshotReader::GetColumn", "Column ", name,
+               " has type ", static_cast<int>(column.type), ", but type ",
+               static_cast<int>(type), " was requested");
+  }
+  const char* src = data_ + column.offset;
+  if (column.compression == columnar::Compression::kNone) {
+    return src;
+  }
+
+  auto& buffer = decompressed_[name];
+  if (buffer) {
+    return buffer.get();
+  }
+  buffer.reset(new char[column.raw_size]);
+  const auto* block_sizes = reinterpret_cast<const uint64_t*>(src);
+  src += column.num_blocks * sizeof(uint64_t);
+  uint64_t raw_offset = 0;
+  for (uint32_t b = 0; b < column.num_blocks; ++b) {
+    auto raw_size =
+        std::min(columnar::kBlockSize, column.raw_size - raw_offset);
+    auto* dst = buffer.get() + raw_offset;
+    if (block_sizes[b] == raw_size) {
+      std::memcpy(dst, src, raw_size);
+    } else {
+      int src_size = static_cast<int>(block_sizes[b]);
+      int dst_size = static_cast<int>(raw_size);
+      int decompressed_size = 0;
+      R__unzip(&src_size,
+               reinterpret_cast<unsigned char*>(const_cast<char*>(src)),
+               &dst_size, reinterpret_cast<unsigned char*>(dst),
+               &decompressed_size);
+      if (static_cast<uint64_t>(decompressed_size) != raw_size) {
+        Log::Fatal("ColumnarSnapshotReader::GetColumn",
+                   "Could not decompress column ", name);
+      }
+    }
+    src += block_sizes[b];
+    raw_offset += raw_size;
+  }
+  return buffer.get();
+}
+
+}  // namespace bdm
@@ -0,0 +1,187 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_COLUMNAR_SNAPSHOT_H_
+#define CORE_COLUMNAR_SNAPSHOT_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace bdm {
+
+/// Definitions of the binary snapshot format that `ColumnarExporter` writes.
+/// A file consists of
+///   * a `FileHeader` at offset zero,
+///   * the column table (`FileHeader::num_columns` `ColumnEntry`s),
+///   * the type table (the null-terminated class names that the `type`
+///     column refers to),
+///   * the data of each column. Uncompressed columns are stored as one
+///     contiguous array with `kAlignment`, such that a memory-mapped file can
+///     be used without copying. Compressed columns start with an array of
+///     the stored sizes of their blocks (`uint64_t`), followed by the blocks.
+///     Each block holds up to `kBlockSize` bytes of the array. A block whose
+///     stored size equals its uncompressed size is not compressed.
+/// Columns with more than one component (e.g. `position`) are interleaved:
+/// element `i` of component `c` is at index `i * components + c`.
+namespace columnar {
+
+constexpr char kMagic[8] = "BDMCOLS";
+constexpr uint32_t kVersion = 1;
+/// Written in native byte order. Readers use it to detect files that have
+/// been written on a machine with a different byte order.
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr uint64_t kAlignment = 64;
+/// Maximum uncompressed size of a compressed block
+constexpr uint64_t kBlockSize = 1 << 20;
+
+enum class ColumnType : uint8_t {
+  kInt8,
+  kUInt8,
+  kInt16,
+  kUInt16,
+  kInt32,
+  kUInt32,
+  kInt64,
+  kUInt64,
+  kFloat,
+  kDouble
+};
+
+enum class Compression : uint8_t { kNone, kZlib, kLz4, kZstd };
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t num_agents;
+  uint64_t iteration;
+  uint64_t num_columns;
+  /// Offset of the column table in bytes
+  uint64_t column_table;
+  /// Offset and size of the type table in bytes
+  uint64_t type_table;
+  uint64_t type_table_size;
+};
+
+struct ColumnEntry {
+  /// Null-terminated name
+  char name[64];
+  ColumnType type;
+  Compression compression;
+  uint16_t components;
+  uint32_t num_blocks;
+  /// Offset of the column data in bytes
+  uint64_t offset;
+  /// Number of bytes that are stored in the file
+  uint64_t size;
+  /// Number of bytes after decompression
+  uint64_t raw_size;
+};
+
+static_assert(sizeof(FileHeader) == 64, "Unexpected padding in FileHeader");
+static_assert(sizeof(ColumnEntry) == 96, "Unexpected padding in ColumnEntry");
+
+/// Returns the size of one component of `type` in bytes.
+uint64_t GetSize(ColumnType type);
+
+/// Compresses `size` (<= `kBlockSize`) bytes of `src` into `dst`, which must
+/// have space for `size` bytes.\n
+/// Returns the compressed size, or zero if the block could not be compressed
+/// to fewer than `size` bytes.
+uint64_t CompressBlock(Compression compression, int level, const char* src,
+                       uint64_t size, char* dst);
+
+/// Returns the `ColumnType` that corresponds to `T`.
+template <typename T>
+constexpr ColumnType GetColumnType() {
+  static_assert(std::is_arithmetic<T>::value, "T must be an arithmetic type");
+  if (std::is_floating_point<T>::value) {
+    return sizeof(T) == 4 ? ColumnType::kFloat : ColumnType::kDouble;
+  }
+  switch (sizeof(T)) {
+    case 1:
+      return std::is_signed<T>::value ? ColumnType::kInt8 : ColumnType::kUInt8;
+    case 2:
+      return std::is_signed<T>::value ? ColumnType::kInt16
+                                      : ColumnType::kUInt16;
+    case 4:
+      return std::is_signed<T>::value ? ColumnType::kInt32
+                                      : ColumnType::kUInt32;
+    default:
+      return std::is_signed<T>::value ? ColumnType::kInt64
+                                      : ColumnType::kUInt64;
+  }
+}
+
+}  // namespace columnar
+
+/// Reads the files of `ColumnarExporter`. The file is memory-mapped.
+/// Uncompressed columns are returned without copying; compressed columns
+/// are decompressed when they are accessed for the first time.
+/// \see columnar
+class ColumnarSnapshotReader {
+ public:
+  explicit ColumnarSnapshotReader(const std::string& filename);
+
+  ColumnarSnapshotReader(const ColumnarSnapshotReader&) = delete;
+  ColumnarSnapshotReader& operator=(const ColumnarSnapshotReader&) = delete;
+
+  ~ColumnarSnapshotReader();
+
+  uint64_t GetNumAgents() const { return header_.num_agents; }
+
+  uint64_t GetIteration() const { return header_.iteration; }
+
+  /// Returns the class names that the values of the `type` column refer to.
+  const std::vector<std::string>& GetTypeNames() const { return type_names_; }
+
+  std::vector<std::string> GetColumnNames() const;
+
+  bool HasColumn(const std::string& name) const {
+    return column_index_.find(name) != column_index_.end();
+  }
+
+  const columnar::ColumnEntry& GetColumnEntry(const std::string& name) const;
+
+  /// Returns the data of column `name`
+  /// (`GetNumAgents() * GetColumnEntry(name).components` elements).
+  /// Calls `Log::Fatal` if `T` does not match the type of the column.
+  /// The pointer is valid until this reader is destroyed.
+  template <typename T>
+  const T* GetColumn(const std::string& name) {
+    return static_cast<const T*>(
+        GetColumnData(name, columnar::GetColumnType<T>()));
+  }
+
+ private:
+  int fd_ = -1;
+  const char* data_ = nullptr;
+  uint64_t size_ = 0;
+  columnar::FileHeader header_;
+  const columnar::ColumnEntry* columns_ = nullptr;
+  std::vector<std::string> type_names_;
+  std::unordered_map<std::string, uint64_t> column_index_;
+  /// Decompressed data of compressed columns
+  std::unordered_map<std::string, std::unique_ptr<char[]>> decompressed_;
+
+  const void* GetColumnData(const std::string& name, columnar::ColumnType type);
+};
+
+}  // namespace bdm
+
+#endif  // CORE_COLUMNAR_SNAPSHOT_H_
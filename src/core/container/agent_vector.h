@@ -15,6 +15,7 @@
 #ifndef CORE_CONTAINER_AGENT_VECTOR_H_
 #define CORE_CONTAINER_AGENT_VECTOR_H_
 
+#include <algorithm>
 #include <vector>
 #include "core/resource_manager.h"  // AgentHandle
 #include "core/simulation.h"
@@ -59,6 +60,23 @@ class AgentVector {
     }
   }
 
+  /// Same as `reserve()`, but keeps the existing elements. Can be used if
+  /// agents have only been appended to the ResourceManager.
+  /// NB: New elements will not be initialized.
+  void grow() {  // NOLINT
+    auto* rm = Simulation::GetActive()->GetResourceManager();
+    for (int n = 0; n < thread_info_->GetNumaNodes(); n++) {
+      auto num_agents = rm->GetNumAgents(n);
+      if (data_[n].capacity() < num_agents) {
+        std::vector<T> tmp;
+        tmp.reserve(num_agents * 1.5);
+        std::copy(data_[n].data(), data_[n].data() + size_[n], tmp.data());
+        data_[n].swap(tmp);
+      }
+      size_[n] = num_agents;
+    }
+  }
+
   void clear() {  // NOLINT
     for (auto& el : size_) {
       el = 0;
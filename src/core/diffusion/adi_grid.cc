@@ -0,0 +1,232 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/diffusion/adi_grid.h"
+
+namespace bdm {
+
+void ADIGrid::DiffuseWithClosedEdge(real_t dt) { Solve(dt, true, false); }
+
+void ADIGrid::DiffuseWithOpenEdge(real_t dt) { Solve(dt, false, false); }
+
+void ADIGrid::DiffuseWithDirichlet(real_t dt) {
+  const size_t n = resolution_;
+  const auto sim_time = GetSimulatedTime();
+
+  // The boxes on the boundary take the value of the boundary condition and
+  // are kept fixed by the identity rows of the line systems
+#pragma omp parallel for collapse(2)
+  for (size_t z = 0; z < n; z++) {
+    for (size_t y = 0; y < n; y++) {
+      const bool boundary_line = y == 0 || y == n - 1 || z == 0 || z == n - 1;
+      for (size_t x = 0; x < n; x++) {
+        if (boundary_line || x == 0 || x == n - 1) {
+          real_t real_x = grid_dimensions_[0] + x * box_length_;
+          real_t real_y = grid_dimensions_[0] + y * box_length_;
+          real_t real_z = grid_dimensions_[0] + z * box_length_;
+          c1_[x + y * n + z * n * n] =
+              boundary_condition_->Evaluate(real_x, real_y, real_z, sim_time);
+        }
+      }
+    }
+  }
+
+  Solve(dt, true, false);
+}
+
+void ADIGrid::DiffuseWithNeumann(real_t dt) { Solve(dt, false, true); }
+
+void ADIGrid::DiffuseWithPeriodic(real_t dt) { Solve(dt, false, false); }
+
+void ADIGrid::Solve(real_t dt, bool interior_only, bool neumann) {
+  if (resolution_ > 1) {
+    const real_t d = 1 - dc_[0];
+    const real_t r = d * dt / (box_length_ * box_length_);
+    auto system = BuildSystem(r);
+    for (int axis = 0; axis < 3; axis++) {
+      Sweep(system, axis, interior_only, neumann ? r : 0);
+    }
+  }
+  Decay(dt, interior_only);
+}
+
+ADIGrid::LineSystem ADIGrid::BuildSystem(real_t r) const {
+  const size_t n = resolution_;
+  std::vector<real_t> sub(n, -r);
+  std::vector<real_t> diag(n, 1 + 2 * r);
+  std::vector<real_t> super(n, -r);
+  sub[0] = 0;
+  super[n - 1] = 0;
+
+  LineSystem system;
+  real_t gamma = 0;
+  real_t corner = 0;
+  if (bc_type_ == BoundaryConditionType::kDirichlet ||
+      bc_type_ == BoundaryConditionType::kClosedBoundaries) {
+    // identity rows for the fixed boxes
+    diag[0] = diag[n - 1] = 1;
+    super[0] = sub[n - 1] = 0;
+  } else if (bc_type_ == BoundaryConditionType::kNeumann) {
+    // the boundary boxes only have one neighbor along the line; the flux
+    // is added to the right hand side in `Sweep`
+    diag[0] = diag[n - 1] = 1 + r;
+  } else if (bc_type_ == BoundaryConditionType::kPeriodic) {
+    // Split the cyclic matrix into a tridiagonal matrix and the rank one
+    // update u * v^T, with u = (gamma, 0, ..., 0, corner) and
+    // v = (1, 0, ..., 0, corner / gamma).
+    system.cyclic = true;
+    gamma = -diag[0];
+    corner = -r;
+    diag[0] -= gamma;
+    diag[n - 1] -= corner * corner / gamma;
+  }
+
+  // Forward elimination of the coefficients (Thomas algorithm)
+  system.sub = sub;
+  system.super.resize(n);
+  system.inv_diag.resize(n);
+  system.inv_diag[0] = 1 / diag[0];
+  system.super[0] = super[0] * system.inv_diag[0];
+  for (size_t i = 1; i < n; i++) {
+    system.inv_diag[i] = 1 / (diag[i] - sub[i] * system.super[i - 1]);
+    system.super[i] = super[i] * system.inv_diag[i];
+  }
+
+  if (system.cyclic) {
+    // Solve the tridiagonal system for u
+    auto& q = system.correction;
+    q.assign(n, 0);
+    q[0] = gamma;
+    q[n - 1] += corner;
+    q[0] *= system.inv_diag[0];
+    for (size_t i = 1; i < n; i++) {
+      q[i] = (q[i] - sub[i] * q[i - 1]) * system.inv_diag[i];
+    }
+    for (size_t i = n - 1; i-- > 0;) {
+      q[i] -= system.super[i] * q[i + 1];
+    }
+    system.corner_ratio = corner / gamma;
+    system.correction_denom = 1 + q[0] + system.corner_ratio * q[n - 1];
+  }
+  return system;
+}
+
+void ADIGrid::Sweep(const LineSystem& system, int axis, bool interior_only,
+                    real_t neumann_r) {
+  const size_t n = resolution_;
+  // stride between two boxes of a line, between two lines of a plane, and
+  // between two planes
+  size_t box_stride = 1;
+  size_t line_stride = n;
+  size_t plane_stride = n * n;
+  if (axis == 1) {
+    box_stride = n;
+    line_stride = 1;
+  } else if (axis == 2) {
+    box_stride = n * n;
+    line_stride = 1;
+    plane_stride = n;
+  }
+
+  const size_t begin = interior_only ? 1 : 0;
+  const size_t end = interior_only ? n - 1 : n;
+  const auto sim_time = GetSimulatedTime();
+
+  // The lines of a plane are solved together, such that the innermost loop
+  // runs over consecutive lines and can be vectorized.
+#pragma omp parallel for
+  for (size_t p = begin; p < end; p++) {
+    real_t* plane = c1_.data() + p * plane_stride;
+
+    if (neumann_r != 0) {
+      for (size_t l = begin; l < end; l++) {
+        for (size_t i : {size_t{0}, n - 1}) {
+          size_t idx = p * plane_stride + l * line_stride + i * box_stride;
+          auto box = GetBoxCoordinates(idx);
+          real_t real_x = grid_dimensions_[0] + box[0] * box_length_;
+          real_t real_y = grid_dimensions_[0] + box[1] * box_length_;
+          real_t real_z = grid_dimensions_[0] + box[2] * box_length_;
+          real_t boundary_value =
+              -box_length_ *
+              boundary_condition_->Evaluate(real_x, real_y, real_z, sim_time);
+          c1_[idx] += neumann_r * boundary_value;
+        }
+      }
+    }
+
+    // forward substitution
+    const real_t inv_diag0 = system.inv_diag[0];
+#pragma omp simd
+    for (size_t l = begin; l < end; l++) {
+      plane[l * line_stride] *= inv_diag0;
+    }
+    for (size_t i = 1; i < n; i++) {
+      real_t* row = plane + i * box_stride;
+      const real_t* prev = row - box_stride;
+      const real_t sub = system.sub[i];
+      const real_t inv_diag = system.inv_diag[i];
+#pragma omp simd
+      for (size_t l = begin; l < end; l++) {
+        row[l * line_stride] =
+            (row[l * line_stride] - sub * prev[l * line_stride]) * inv_diag;
+      }
+    }
+
+    // back substitution
+    for (size_t i = n - 1; i-- > 0;) {
+      real_t* row = plane + i * box_stride;
+      const real_t* next = row + box_stride;
+      const real_t super = system.super[i];
+#pragma omp simd
+      for (size_t l = begin; l < end; l++) {
+        row[l * line_stride] -= super * next[l * line_stride];
+      }
+    }
+
+    if (system.cyclic) {
+      for (size_t l = begin; l < end; l++) {
+        real_t* line = plane + l * line_stride;
+        const real_t f =
+            (line[0] + system.corner_ratio * line[(n - 1) * box_stride]) /
+            system.correction_denom;
+        for (size_t i = 0; i < n; i++) {
+          line[i * box_stride] -= f * system.correction[i];
+        }
+      }
+    }
+  }
+}
+
+void ADIGrid::Decay(real_t dt, bool interior_only) {
+  if (mu_ == 0) {
+    return;
+  }
+  const size_t n = resolution_;
+  const size_t begin = interior_only ? 1 : 0;
+  const size_t end = interior_only ? n - 1 : n;
+  const real_t factor = 1 / (1 + mu_ * dt);
+
+#pragma omp parallel for collapse(2)
+  for (size_t z = begin; z < end; z++) {
+    for (size_t y = begin; y < end; y++) {
+      size_t c = begin + y * n + z * n * n;
+#pragma omp simd
+      for (size_t x = begin; x < end; x++) {
+        c1_[c + x - begin] *= factor;
+      }
+    }
+  }
+}
+
+}  // namespace bdm
@@ -0,0 +1,111 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_DIFFUSION_ADI_GRID_H_
+#define CORE_DIFFUSION_ADI_GRID_H_
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "core/diffusion/diffusion_grid.h"
+
+namespace bdm {
+
+/** @brief Continuum model for the 3D heat equation with exponential decay
+           \f$ \partial_t u = \nabla D \nabla u - \mu u \f$, solved with an
+           unconditionally stable implicit scheme.
+
+  We use an alternating direction implicit (ADI) method in its locally
+  one-dimensional form: each time step consists of three backward Euler
+  steps, one for each axis,
+  \f$ (1 - \Delta t D \delta_x^2) u^{*} = u^n \f$,
+  \f$ (1 - \Delta t D \delta_y^2) u^{**} = u^{*} \f$,
+  \f$ (1 - \Delta t D \delta_z^2) u^{***} = u^{**} \f$,
+  followed by the implicit decay \f$ u^{n+1} = u^{***} / (1 + \mu \Delta t)
+  \f$. Each step solves one tridiagonal system per grid line with the Thomas
+  algorithm (Sherman-Morrison for periodic boundaries). All lines of an axis
+  are independent and solved in parallel.
+
+  In contrast to the `EulerGrid`, the time step is not limited by a stability
+  condition. Hence, substances with high diffusion coefficients or fine
+  resolutions can be integrated with the time step of the agents. The error
+  scales linearly with the time step and quadratically with the box length.
+
+  Select this solver with `Param::diffusion_method = "adi"`.
+*/
+class ADIGrid : public DiffusionGrid {
+ public:
+  ADIGrid() = default;
+  ADIGrid(int substance_id, std::string substance_name, real_t dc, real_t mu,
+          int resolution = 10)
+      : DiffusionGrid(substance_id, std::move(substance_name), dc, mu,
+                      resolution) {}
+
+  /// Boxes on the boundary keep their value.
+  void DiffuseWithClosedEdge(real_t dt) override;
+  /// The concentration outside of the grid is zero.
+  void DiffuseWithOpenEdge(real_t dt) override;
+  void DiffuseWithDirichlet(real_t dt) override;
+  void DiffuseWithNeumann(real_t dt) override;
+  void DiffuseWithPeriodic(real_t dt) override;
+
+  /// The implicit scheme is unconditionally stable.
+  real_t GetStableTimeStep() const override {
+    return std::numeric_limits<real_t>::max();
+  }
+
+ private:
+  /// Factorization of the tridiagonal system of one grid line. All lines of
+  /// the grid share the same system.
+  struct LineSystem {
+    /// Sub-diagonal
+    std::vector<real_t> sub;
+    /// Super-diagonal after forward elimination
+    std::vector<real_t> super;
+    /// Inverse of the diagonal after forward elimination
+    std::vector<real_t> inv_diag;
+    /// Sherman-Morrison correction for periodic boundaries
+    bool cyclic = false;
+    std::vector<real_t> correction;
+    real_t corner_ratio = 0;
+    real_t correction_denom = 1;
+  };
+
+  /// Builds the system for `resolution_` boxes per line with
+  /// `r = D dt / dx^2`.
+  LineSystem BuildSystem(real_t r) const;
+
+  /// Solves the lines along `axis` in place. If `interior_only` is true,
+  /// only lines whose boxes are not on the boundary of the other axes are
+  /// solved. `neumann_r` is non-zero for Neumann boundaries and scales the
+  /// boundary flux that is added to the first and last box of each line.
+  void Sweep(const LineSystem& system, int axis, bool interior_only,
+             real_t neumann_r);
+
+  /// Applies the implicit decay to all (or all inner) boxes.
+  void Decay(real_t dt, bool interior_only);
+
+  /// Runs the three sweeps and the decay.
+  void Solve(real_t dt, bool interior_only, bool neumann);
+
+  /// The implicit scheme is unconditionally stable.
+  void ParametersCheck(real_t dt) override {}
+
+  BDM_CLASS_DEF_OVERRIDE(ADIGrid, 1);
+};
+
+}  // namespace bdm
+
+#endif  // CORE_DIFFUSION_ADI_GRID_H_
@@ -55,6 +55,35 @@ void Continuum::IntegrateTimeAsynchronously(real_t dt) {
   }
 }
 
+bool Continuum::IntegrateTimeMultiRate(real_t dt, uint64_t max_interval) {
+  if (time_step_ != std::numeric_limits<real_t>::max()) {
+    IntegrateTimeAsynchronously(dt);
+    return true;
+  }
+
+  // We stay below the stability limit to be robust against rounding errors.
+  const real_t stable_dt = kStableTimeStepFraction * GetStableTimeStep();
+  time_to_simulate_ += dt;
+  accumulated_calls_++;
+  if (accumulated_calls_ < max_interval &&
+      time_to_simulate_ + dt <= stable_dt) {
+    return false;
+  }
+
+  uint64_t n_steps = 1;
+  if (stable_dt > 0 && time_to_simulate_ > stable_dt) {
+    n_steps = static_cast<uint64_t>(std::ceil(time_to_simulate_ / stable_dt));
+  }
+  const real_t substep = time_to_simulate_ / n_steps;
+  for (uint64_t i = 0; i < n_steps; i++) {
+    Step(substep);
+  }
+  simulated_time_ += time_to_simulate_;
+  time_to_simulate_ = 0;
+  accumulated_calls_ = 0;
+  return true;
+}
+
 void Continuum::SetTimeStep(real_t dt) { time_step_ = dt; }
 
 real_t Continuum::GetTimeStep() const {
@@ -19,6 +19,7 @@
 #include <limits>
 #include <string>
 #include "core/container/math_array.h"
+#include "core/operation/op_data_access.h"
 
 namespace bdm {
 
@@ -61,6 +62,32 @@ class Continuum {
   /// the time step is not set, `dt` is used.
   void IntegrateTimeAsynchronously(real_t dt);
 
+  /// Multi-rate alternative to `IntegrateTimeAsynchronously`, used by
+  /// `ContinuumOp` if `Param::continuum_multi_rate` is set. The passed time
+  /// `dt` is accumulated until one more call would exceed the stable time
+  /// step (see `GetStableTimeStep`) or `max_interval` calls have been
+  /// accumulated. The accumulated time is then integrated with the smallest
+  /// number of equal substeps that do not exceed the stable time step. Hence,
+  /// slow continua are integrated less often with a larger time step, and
+  /// stiff continua subcycle with their stable time step. If a time step has
+  /// been set with `SetTimeStep`, this function behaves like
+  /// `IntegrateTimeAsynchronously`.
+  /// Returns true if `Step` has been called.
+  bool IntegrateTimeMultiRate(real_t dt, uint64_t max_interval);
+
+  /// Returns the largest time step for which `Step` is stable, or the
+  /// maximum value of `real_t` if there is no limit.
+  virtual real_t GetStableTimeStep() const {
+    return std::numeric_limits<real_t>::max();
+  }
+
+  /// Returns the simulation data that `Update` and `Step` read and write.
+  /// Determines which operations `ContinuumOp` may be executed concurrently
+  /// with (see `Param::concurrent_operations`). An arbitrary continuum might
+  /// read the agents or use thread state. Hence, it conflicts with all other
+  /// operations by default.
+  virtual OpDataAccess GetDataAccess() const { return OpDataAccess::All(); }
+
   /// Initializes the continuum. This method is called via
   /// `Scheduler::Initialize`. For some implementations, this method may be
   /// useful, other may not require it. A possibly use case is that agents move
@@ -108,6 +135,9 @@ class Continuum {
   real_t GetTimeStep() const;
 
  private:
+  /// Fraction of the stable time step used by `IntegrateTimeMultiRate`
+  static constexpr real_t kStableTimeStepFraction = 0.95;
+
   /// Name of the continuum.
   std::string continuum_name_ = "";
 
@@ -122,6 +152,10 @@ class Continuum {
   /// Time that the continuum (still) has to integrate.
   real_t time_to_simulate_ = 0.0;
 
+  /// Number of calls to `IntegrateTimeMultiRate` since `Step` has been
+  /// called last.
+  uint64_t accumulated_calls_ = 0;
+
   /// Id of the continuum.
   int continuum_id_ = -1;
 
@@ -12,13 +12,17 @@
 //
 // -----------------------------------------------------------------------------
 
+#include <omp.h>
 #include <algorithm>
+#include <limits>
 #include <mutex>
 
 #include "core/diffusion/diffusion_grid.h"
 #include "core/environment/environment.h"
+#include "core/execution_context/execution_context.h"
 #include "core/simulation.h"
 #include "core/util/log.h"
+#include "core/util/thread_info.h"
 
 namespace bdm {
 
@@ -58,6 +62,12 @@ BoundaryConditionType StringToBoundaryType(const std::string& type) {
   }
 }
 
+DiffusionGrid::~DiffusionGrid() {
+  for (auto& page : gradient_cache_) {
+    delete page.load();
+  }
+}
+
 DiffusionGrid::DiffusionGrid(int substance_id,
                              const std::string& substance_name, real_t dc,
                              real_t mu, int resolution)
@@ -109,11 +119,20 @@ void DiffusionGrid::Initialize() {
   parity_ = resolution_ % 2;
   total_num_boxes_ = resolution_ * resolution_ * resolution_;
 
-  // Allocate memory for the concentration and gradient arrays
-  locks_.resize(total_num_boxes_);
-  c1_.resize(total_num_boxes_);
-  c2_.resize(total_num_boxes_);
-  gradients_.resize(total_num_boxes_);
+  // In deferred update mode, concentration changes are recorded in
+  // per-thread buffers (plus one shared buffer), and the lock array is not
+  // needed. The deterministic mode requires it, because the locked changes
+  // of a box are applied in the order of the threads.
+  auto* param = Simulation::GetActive()->GetParam();
+  defer_updates_ =
+      param->deferred_concentration_updates || param->deterministic;
+  deferred_updates_.resize(ThreadInfo::GetInstance()->GetMaxThreads() + 1);
+  lazy_gradients_ = param->lazy_gradients;
+
+  AllocateGrid();
+  if (lazy_gradients_) {
+    ResetGradientCache();
+  }
 
   // Print Info
   initialized_ = true;
@@ -122,7 +141,30 @@ void DiffusionGrid::Initialize() {
   }
 }
 
+void DiffusionGrid::AllocateGrid() {
+  // In deferred update mode, the lock array is not needed
+  locks_.resize(defer_updates_ ? 0 : total_num_boxes_);
+  c1_.resize(total_num_boxes_);
+  c2_.resize(total_num_boxes_);
+  gradients_.resize(lazy_gradients_ ? 0 : total_num_boxes_);
+}
+
+void DiffusionGrid::ResetGradientCache() {
+  for (auto& page : gradient_cache_) {
+    delete page.exchange(nullptr);
+  }
+  const size_t num_pages =
+      (total_num_boxes_ + kGradientCachePageSize - 1) / kGradientCachePageSize;
+  if (gradient_cache_.size() != num_pages) {
+    // Value initialization sets all entries to nullptr
+    std::vector<std::atomic<GradientCachePage*>> cache(num_pages);
+    gradient_cache_.swap(cache);
+  }
+}
+
 void DiffusionGrid::Diffuse(real_t dt) {
+  ApplyDeferredUpdates();
+
   // check if diffusion coefficient and decay constant are 0
   // i.e. if we don't need to calculate diffusion update
   if (IsFixedSubstance()) {
@@ -154,6 +196,9 @@ void DiffusionGrid::Diffuse(real_t dt) {
 }
 
 void DiffusionGrid::Update() {
+  // Recorded changes refer to the box indices of the current grid
+  ApplyDeferredUpdates();
+
   // Get neighbor grid dimensions
   auto* env = Simulation::GetActive()->GetEnvironment();
   auto bounds = env->GetDimensionThresholds();
@@ -205,6 +250,9 @@ void DiffusionGrid::Update() {
     total_num_boxes_ = resolution_ * resolution_ * resolution_;
 
     CopyOldData(tmp_c1, tmp_gradients, tmp_resolution);
+    if (lazy_gradients_) {
+      ResetGradientCache();
+    }
   }
 }
 
@@ -212,10 +260,10 @@ void DiffusionGrid::CopyOldData(
     const ParallelResizeVector<real_t>& old_c1,
     const ParallelResizeVector<Real3>& old_gradients, size_t old_resolution) {
   // Allocate more memory for the grid data arrays
-  locks_.resize(total_num_boxes_);
-  c1_.resize(total_num_boxes_);
-  c2_.resize(total_num_boxes_);
-  gradients_.resize(total_num_boxes_);
+  AllocateGrid();
+  // Lazy gradients are not stored in `gradients_`
+  const bool copy_gradients = old_gradients.size() == old_c1.size() &&
+                              gradients_.size() == total_num_boxes_;
 
   Log::Warning(
       "DiffusionGrid::CopyOldData",
@@ -242,7 +290,9 @@ void DiffusionGrid::CopyOldData(
       for (size_t i = 0; i < old_resolution; i++) {
         auto idx = k * old_box_xy + j * old_resolution + i;
         c1_[offset + i] = old_c1[idx];
-        gradients_[offset + i] = old_gradients[idx];
+        if (copy_gradients) {
+          gradients_[offset + i] = old_gradients[idx];
+        }
       }
     }
   }
@@ -324,6 +374,12 @@ void DiffusionGrid::CalculateGradient() {
   if (!precompute_gradients_) {
     return;
   }
+  if (lazy_gradients_) {
+    // Invalidate the cached gradients of the previous step
+    gradient_epoch_++;
+    init_gradient_ = true;
+    return;
+  }
 
 #pragma omp parallel for collapse(2)
   for (uint32_t z = 0; z < resolution_; z++) {
@@ -374,19 +430,56 @@ void DiffusionGrid::ChangeConcentrationBy(size_t idx, real_t amount,
     // volume of box
     amount /= box_length_ * box_length_ * box_length_;
   }
-  std::lock_guard<Spinlock> guard(locks_[idx]);
+  if (defer_updates_) {
+    DeferUpdate(idx, amount, mode);
+    return;
+  }
+  ApplyLockedConcentrationChange(idx, amount, mode);
+}
+
+void DiffusionGrid::DeferUpdate(size_t idx, real_t amount,
+                                InteractionMode mode) {
+  DeferredUpdate update{idx, 0, 0, amount, mode};
+  // Thread ids are only unique within the outermost thread team. Threads of
+  // nested teams use the shared buffer. Operations that change the same
+  // substance are never executed concurrently (see `OpDataAccess`).
+  size_t tid = omp_get_thread_num();
+  size_t shared = deferred_updates_.size() - 1;
+  if (omp_get_level() > 1 || tid >= shared) {
+    std::lock_guard<Spinlock> guard(deferred_updates_lock_);
+    deferred_updates_[shared].updates.push_back(update);
+    return;
+  }
+  auto* ctxt = Simulation::GetActive()->GetExecutionContext();
+  ctxt->NextChange(&update.agent_key, &update.change);
+  deferred_updates_[tid].updates.push_back(update);
+}
+
+void DiffusionGrid::ApplyLockedConcentrationChange(size_t idx, real_t amount,
+                                                   InteractionMode mode) {
   assert(idx < locks_.size());
+  std::lock_guard<Spinlock> guard(locks_[idx]);
+  ApplyConcentrationChange(idx, amount, mode);
+}
+
+void DiffusionGrid::ApplyConcentrationChange(size_t idx, real_t amount,
+                                             InteractionMode mode) {
+  c1_[idx] = ChangedConcentration(c1_[idx], amount, mode);
+}
+
+real_t DiffusionGrid::ChangedConcentration(real_t value, real_t amount,
+                                           InteractionMode mode) const {
   switch (mode) {
     case InteractionMode::kAdditive:
-      c1_[idx] += amount;
+      value += amount;
       break;
     case InteractionMode::kExponential:
-      c1_[idx] *= amount;
+      value *= amount;
       break;
     case InteractionMode::kLogistic:
-      c1_[idx] += ((amount > 0) ? upper_threshold_ - c1_[idx]
-                                : c1_[idx] - lower_threshold_) *
-                  amount;
+      value += ((amount > 0) ? upper_threshold_ - value
+                             : value - lower_threshold_) *
+               amount;
       break;
     default:
       Log::Fatal("DiffusionGrid::ChangeConcentrationBy",
@@ -394,7 +487,55 @@ void DiffusionGrid::ChangeConcentrationBy(size_t idx, real_t amount,
   }
 
   // Enforce upper and lower bounds.
-  c1_[idx] = std::clamp(c1_[idx], lower_threshold_, upper_threshold_);
+  return std::clamp(value, lower_threshold_, upper_threshold_);
+}
+
+void DiffusionGrid::ApplyDeferredUpdates() {
+  uint64_t num_updates = 0;
+  for (const auto& buffer : deferred_updates_) {
+    num_updates += buffer.updates.size();
+  }
+  if (num_updates == 0) {
+    return;
+  }
+
+  // Sort the changes of each buffer by box index and agent order.
+  const int64_t num_buffers = deferred_updates_.size();
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int64_t b = 0; b < num_buffers; ++b) {
+    auto& updates = deferred_updates_[b].updates;
+    std::sort(updates.begin(), updates.end());
+  }
+
+  // Each thread applies all changes of a contiguous range of boxes. Hence,
+  // no two threads modify the same box and no locks are required. The
+  // changes of the range are merged from all buffers, such that they are
+  // applied in the same order regardless of which thread recorded them.
+  const int64_t num_ranges = num_buffers;
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int64_t r = 0; r < num_ranges; ++r) {
+    size_t begin = total_num_boxes_ * r / num_ranges;
+    size_t end = total_num_boxes_ * (r + 1) / num_ranges;
+    std::vector<DeferredUpdate> range;
+    for (const auto& buffer : deferred_updates_) {
+      const auto& updates = buffer.updates;
+      auto first = std::lower_bound(
+          updates.begin(), updates.end(), begin,
+          [](const DeferredUpdate& u, size_t idx) { return u.idx < idx; });
+      auto last = std::lower_bound(
+          first, updates.end(), end,
+          [](const DeferredUpdate& u, size_t idx) { return u.idx < idx; });
+      auto middle = range.insert(range.end(), first, last);
+      std::inplace_merge(range.begin(), middle, range.end());
+    }
+    for (const auto& update : range) {
+      ApplyConcentrationChange(update.idx, update.amount, update.mode);
+    }
+  }
+
+  for (auto& buffer : deferred_updates_) {
+    buffer.updates.clear();
+  }
 }
 
 /// Get the concentration at specified position
@@ -411,6 +552,10 @@ real_t DiffusionGrid::GetConcentration(const size_t idx) const {
                "the diffusion grid!");
     return 0;
   }
+  if (defer_updates_) {
+    // `c1_` is not modified during the agent operations
+    return c1_[idx];
+  }
   assert(idx < locks_.size());
   std::lock_guard<Spinlock> guard(locks_[idx]);
   return c1_[idx];
@@ -426,31 +571,12 @@ void DiffusionGrid::GetGradient(const Real3& position, Real3* gradient,
                "the diffusion grid! Returning zero gradient.");
     return;
   }
-  if (init_gradient_) {
+  if (init_gradient_ && lazy_gradients_) {
+    *gradient = GetCachedGradient(idx);
+  } else if (init_gradient_) {
     *gradient = gradients_[idx];
   } else {
-    // Get the neighboring boxes
-    const auto neighbors = GetNeighboringBoxes(idx);
-    std::array<int, 6> comparison;  // array to determine discretization h
-    std::transform(neighbors.begin(), neighbors.end(), comparison.begin(),
-                   [idx](size_t n) { return (n == idx) ? 0 : 1; });
-
-    // Calculate the gradient (GetConcentration for thread safety)
-    const real_t x_minus = GetConcentration(neighbors[0]);
-    const real_t x_plus = GetConcentration(neighbors[1]);
-    const real_t y_minus = GetConcentration(neighbors[2]);
-    const real_t y_plus = GetConcentration(neighbors[3]);
-    const real_t z_minus = GetConcentration(neighbors[4]);
-    const real_t z_plus = GetConcentration(neighbors[5]);
-
-    real_t grad_x =
-        (x_plus - x_minus) / ((comparison[1] + comparison[0]) * box_length_);
-    real_t grad_y =
-        (y_plus - y_minus) / ((comparison[3] + comparison[2]) * box_length_);
-    real_t grad_z =
-        (z_plus - z_minus) / ((comparison[5] + comparison[4]) * box_length_);
-
-    *gradient = Real3({grad_x, grad_y, grad_z});
+    *gradient = ComputeGradient(idx);
   }
   if (normalize) {
     auto norm = gradient->Norm();
@@ -460,6 +586,77 @@ void DiffusionGrid::GetGradient(const Real3& position, Real3* gradient,
   }
 }
 
+Real3 DiffusionGrid::ComputeGradient(size_t idx) const {
+  // Get the neighboring boxes
+  const auto neighbors = GetNeighboringBoxes(idx);
+  std::array<int, 6> comparison;  // array to determine discretization h
+  std::transform(neighbors.begin(), neighbors.end(), comparison.begin(),
+                 [idx](size_t n) { return (n == idx) ? 0 : 1; });
+
+  // Calculate the gradient (GetConcentration for thread safety)
+  const real_t x_minus = GetConcentration(neighbors[0]);
+  const real_t x_plus = GetConcentration(neighbors[1]);
+  const real_t y_minus = GetConcentration(neighbors[2]);
+  const real_t y_plus = GetConcentration(neighbors[3]);
+  const real_t z_minus = GetConcentration(neighbors[4]);
+  const real_t z_plus = GetConcentration(neighbors[5]);
+
+  real_t grad_x =
+      (x_plus - x_minus) / ((comparison[1] + comparison[0]) * box_length_);
+  real_t grad_y =
+      (y_plus - y_minus) / ((comparison[3] + comparison[2]) * box_length_);
+  real_t grad_z =
+      (z_plus - z_minus) / ((comparison[5] + comparison[4]) * box_length_);
+
+  return Real3({grad_x, grad_y, grad_z});
+}
+
+Real3 DiffusionGrid::GetCachedGradient(size_t idx) const {
+  auto& slot = gradient_cache_[idx / kGradientCachePageSize];
+  auto* page = slot.load(std::memory_order_acquire);
+  if (page == nullptr) {
+    auto* new_page = new GradientCachePage();
+    if (slot.compare_exchange_strong(page, new_page,
+                                     std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+      page = new_page;
+    } else {
+      // Another thread allocated the page in the meantime
+      delete new_page;
+    }
+  }
+
+  const size_t i = idx % kGradientCachePageSize;
+  auto& stamp = page->stamps[i];
+  const uint64_t valid = 2 * gradient_epoch_;
+  uint64_t current = stamp.load(std::memory_order_acquire);
+  if (current == valid) {
+    return page->gradients[i];
+  }
+  auto gradient = ComputeGradient(idx);
+  // Only one thread stores the gradient. If another thread is storing it at
+  // the same time, this thread returns its own result.
+  if (current != valid + 1 &&
+      stamp.compare_exchange_strong(current, valid + 1,
+                                    std::memory_order_acquire)) {
+    page->gradients[i] = gradient;
+    stamp.store(valid, std::memory_order_release);
+  }
+  return gradient;
+}
+
+const real_t* DiffusionGrid::GetAllGradients() const {
+  if (lazy_gradients_) {
+    gradients_.resize(total_num_boxes_);
+#pragma omp parallel for
+    for (size_t idx = 0; idx < total_num_boxes_; idx++) {
+      gradients_[idx] =
+          init_gradient_ ? GetCachedGradient(idx) : ComputeGradient(idx);
+    }
+  }
+  return gradients_.data()->data();
+}
+
 std::array<uint32_t, 3> DiffusionGrid::GetBoxCoordinates(
     const Real3& position) const {
   std::array<uint32_t, 3> box_coord;
@@ -590,6 +787,23 @@ void DiffusionGrid::PrintInfo(std::ostream& out) {
   out << "    boundary   : " << BoundaryTypeToString(bc_type_) << "\n";
 };
 
+real_t DiffusionGrid::GetStableTimeStep() const {
+  const real_t diffusion_coefficient = 1 - dc_[0];
+  const real_t box_area = box_length_ * box_length_;
+  real_t max_dt = std::numeric_limits<real_t>::max();
+  // Stability condition
+  const real_t rate = mu_ + 12.0 * diffusion_coefficient / box_area;
+  if (rate > 0) {
+    max_dt = 2.0 / rate;
+  }
+  // Decay condition
+  if (diffusion_coefficient > 0) {
+    max_dt = std::min(max_dt,
+                      (1 - mu_) * box_area / (6.0 * diffusion_coefficient));
+  }
+  return max_dt;
+}
+
 void DiffusionGrid::ParametersCheck(real_t dt) {
   // We evaluate a stability condition derived via a von Neumann stability
   // analysis (https://en.wikipedia.org/wiki/Von_Neumann_stability_analysis,
@@ -16,9 +16,11 @@
 #define CORE_DIFFUSION_DIFFUSION_GRID_H_
 
 #include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -93,7 +95,7 @@ class DiffusionGrid : public ScalarField {
   explicit DiffusionGrid(const TRootIOCtor*) {}
   DiffusionGrid(int substance_id, const std::string& substance_name, real_t dc,
                 real_t mu, int resolution = 10);
-  ~DiffusionGrid() override = default;
+  ~DiffusionGrid() override;
   DiffusionGrid(const DiffusionGrid&) = delete;             // copy constructor
   DiffusionGrid& operator=(const DiffusionGrid&) = delete;  // copy assignment
   DiffusionGrid(DiffusionGrid&&) = delete;                  // move constructor
@@ -108,6 +110,17 @@ class DiffusionGrid : public ScalarField {
   void Update() override;
 
   void Step(real_t dt) override { Diffuse(dt); }
+
+  /// Returns the largest time step that satisfies the stability and decay
+  /// conditions of the explicit scheme (see `ParametersCheck`).
+  real_t GetStableTimeStep() const override;
+
+  /// Diffusion reads the environment (see `Update`) and writes this
+  /// substance.
+  OpDataAccess GetDataAccess() const override {
+    return OpDataAccess().ReadEnvironment().WriteContinuum(GetContinuumName());
+  }
+
   void Diffuse(real_t dt);
 
   virtual void DiffuseWithClosedEdge(real_t dt) = 0;
@@ -130,12 +143,16 @@ class DiffusionGrid : public ScalarField {
   /// where c(x) implies the concentration at position x
   ///
   /// At the edges the gradient is the same as the box next to it
-  void CalculateGradient();
+  ///
+  /// If `Param::lazy_gradients` is set, this function only invalidates the
+  /// gradients of the previous step. They are computed on demand by
+  /// `GetGradient`.
+  virtual void CalculateGradient();
 
   /// Initialize the diffusion grid according to the initialization functions.
   /// Note that if your initializers our outside the defined bounds (lower and
   /// upper threshold), they will be clamped to the bounds.
-  void RunInitializers();
+  virtual void RunInitializers();
 
   /// Increase the concentration at a specified position a with specified
   /// amount.
@@ -154,6 +171,8 @@ class DiffusionGrid : public ScalarField {
   /// for instance, [mg] but the diffusion grid is in units of [mg / um^3]. It's
   /// helpful to model this way to obtain similar/identical results independent
   /// of the resolution of the diffusion grid.
+  /// If `Param::deferred_concentration_updates` is set, the change is only
+  /// recorded and applied later by `ApplyDeferredUpdates`.
   void ChangeConcentrationBy(const Real3& position, real_t amount,
                              InteractionMode mode = InteractionMode::kAdditive,
                              bool scale_with_resolution = false);
@@ -163,6 +182,12 @@ class DiffusionGrid : public ScalarField {
                              InteractionMode mode = InteractionMode::kAdditive,
                              bool scale_with_resolution = false);
 
+  /// Applies all concentration changes that have been recorded by
+  /// `ChangeConcentrationBy` since the last call.
+  /// Only relevant if `Param::deferred_concentration_updates` is set.
+  /// Called by `ContinuumOp` before the diffusion step.
+  void ApplyDeferredUpdates();
+
   /// @brief  Get the value of the scalar field at specified position
   /// @param position 3D position of
   /// @return c1_[idx[position]]
@@ -174,7 +199,7 @@ class DiffusionGrid : public ScalarField {
   /// @brief  Get the concentration at specified index
   /// @param idx Flat index of the grid
   /// @return c1_[idx]
-  real_t GetConcentration(const size_t idx) const;
+  virtual real_t GetConcentration(const size_t idx) const;
 
   /// Get the gradient at a specified position. By default, the obtained
   /// gradient is scaled to norm 1, but with `normalize = false` one can obtain
@@ -253,9 +278,11 @@ class DiffusionGrid : public ScalarField {
   // Returns the lower threshold for allowed values in the diffusion grid.
   real_t GetLowerThreshold() const { return lower_threshold_; }
 
-  const real_t* GetAllConcentrations() const { return c1_.data(); }
+  virtual const real_t* GetAllConcentrations() const { return c1_.data(); }
 
-  const real_t* GetAllGradients() const { return gradients_.data()->data(); }
+  /// If `Param::lazy_gradients` is set, the gradients of all boxes are
+  /// computed by this call.
+  virtual const real_t* GetAllGradients() const;
 
   std::array<size_t, 3> GetNumBoxesArray() const {
     std::array<size_t, 3> ret;
@@ -351,9 +378,19 @@ class DiffusionGrid : public ScalarField {
  private:
   friend class EulerGrid;
   friend class EulerDepletionGrid;
+  friend class ADIGrid;
+  friend class MultiSpeciesEulerGrid;
+  friend class SparseEulerGrid;
+  friend class SteadyStateGrid;
   friend class TestGrid;  // class used for testing (e.g. initialization)
 
-  void ParametersCheck(real_t dt);
+  /// Checks the stability condition of the explicit diffusion kernels.
+  /// Implicit solvers override this function.
+  virtual void ParametersCheck(real_t dt);
+
+  /// Allocates the concentration, gradient and lock arrays for
+  /// `total_num_boxes_` boxes. Called by `Initialize`.
+  virtual void AllocateGrid();
 
   /// Copies the concentration and gradients values to the new
   /// (larger) grid. In the 2D case it looks like the following:
@@ -371,19 +408,102 @@ class DiffusionGrid : public ScalarField {
                    const ParallelResizeVector<Real3>& old_gradients,
                    size_t old_resolution);
 
+  /// Returns the concentration `value` after a change by `amount`,
+  /// clamped to the thresholds.
+  real_t ChangedConcentration(real_t value, real_t amount,
+                              InteractionMode mode) const;
+
+  /// Computes the gradient of box `idx` from the current concentrations.
+  Real3 ComputeGradient(size_t idx) const;
+
+  /// Returns the gradient of box `idx` from the lazy gradient cache and
+  /// computes it on the first access after `CalculateGradient`.
+  Real3 GetCachedGradient(size_t idx) const;
+
+  /// Clears the lazy gradient cache and adapts it to `total_num_boxes_`.
+  void ResetGradientCache();
+
+  /// Changes the concentration of box `idx` without synchronization.
+  virtual void ApplyConcentrationChange(size_t idx, real_t amount,
+                                        InteractionMode mode);
+
+  /// Changes the concentration of box `idx` while holding its lock.
+  virtual void ApplyLockedConcentrationChange(size_t idx, real_t amount,
+                                              InteractionMode mode);
+
+  /// Concentration change recorded in deferred update mode
+  struct DeferredUpdate {
+    size_t idx;
+    /// Canonical key of the agent that made the change and index of the
+    /// change among the changes of this agent (see
+    /// `ExecutionContext::NextChange`)
+    uint64_t agent_key;
+    uint64_t change;
+    real_t amount;
+    InteractionMode mode;
+
+    /// The changes of a box are applied in the order of the agent keys.
+    /// Remaining ties are broken by the value, such that the order does not
+    /// depend on the thread that recorded the change, nor on the storage
+    /// location of the agent.
+    bool operator<(const DeferredUpdate& other) const {
+      return std::tie(idx, agent_key, change, amount, mode) <
+             std::tie(other.idx, other.agent_key, other.change, other.amount,
+                      other.mode);
+    }
+  };
+
+  /// Per-thread buffer of deferred updates. Aligned to a cache line to
+  /// avoid false sharing between threads.
+  struct alignas(64) DeferredUpdateBuffer {
+    std::vector<DeferredUpdate> updates;
+  };
+
+  /// Records a change in deferred update mode
+  void DeferUpdate(size_t idx, real_t amount, InteractionMode mode);
+
+  /// Number of boxes in a page of the lazy gradient cache
+  static constexpr size_t kGradientCachePageSize = 512;
+
+  /// Page of the lazy gradient cache. An entry is valid if its stamp equals
+  /// `2 * gradient_epoch_`. The stamp `2 * gradient_epoch_ + 1` marks an
+  /// entry that is being written by another thread.
+  struct GradientCachePage {
+    std::array<std::atomic<uint64_t>, kGradientCachePageSize> stamps;
+    std::array<Real3, kGradientCachePageSize> gradients;
+  };
+
   /// The side length of each box
   real_t box_length_ = 0;
   /// the volume of each box
   real_t box_volume_ = 0;
   /// Lock for each voxel used to prevent race conditions between
-  /// multiple threads
+  /// multiple threads. Empty in deferred update mode.
   mutable ParallelResizeVector<Spinlock> locks_ = {};  //!
+  /// If true, `ChangeConcentrationBy` records the changes in
+  /// `deferred_updates_` instead of modifying `c1_`.
+  /// \see `Param::deferred_concentration_updates`
+  bool defer_updates_ = false;  //!
+  /// Concentration changes recorded by each thread of the outermost team.
+  /// The last buffer is shared by all other threads (see `DeferUpdate`).
+  std::vector<DeferredUpdateBuffer> deferred_updates_ = {};  //!
+  /// Protects the shared buffer of `deferred_updates_`
+  Spinlock deferred_updates_lock_;  //!
   /// The array of concentration values
   ParallelResizeVector<real_t> c1_ = {};
   /// An extra concentration data buffer for faster value updating
   ParallelResizeVector<real_t> c2_ = {};
-  /// The array of gradients (x, y, z)
-  ParallelResizeVector<Real3> gradients_ = {};
+  /// The array of gradients (x, y, z). Empty if `lazy_gradients_` is set,
+  /// unless filled by `GetAllGradients`.
+  mutable ParallelResizeVector<Real3> gradients_ = {};
+  /// If true, gradients are computed on demand and cached until the next
+  /// call to `CalculateGradient`. \see `Param::lazy_gradients`
+  bool lazy_gradients_ = false;  //!
+  /// Incremented by `CalculateGradient` to invalidate the cached gradients
+  uint64_t gradient_epoch_ = 1;  //!
+  /// Pages of the lazy gradient cache, allocated on first access
+  mutable std::vector<std::atomic<GradientCachePage*>> gradient_cache_ =
+      {};  //!
   /// The maximum concentration value that a box can have
   real_t upper_threshold_ = 1e15;
   /// The minimum concentration value that a box can have
@@ -18,6 +18,15 @@
 
 namespace bdm {
 
+OpDataAccess EulerDepletionGrid::GetDataAccess() const {
+  auto access = EulerGrid::GetDataAccess();
+  const auto* rm = Simulation::GetActive()->GetResourceManager();
+  for (auto substance : binding_substances_) {
+    access.ReadContinuum(rm->GetDiffusionGrid(substance)->GetContinuumName());
+  }
+  return access;
+}
+
 void EulerDepletionGrid::ApplyDepletion(real_t dt) {
   auto* sim = Simulation::GetActive();
   const auto* rm = sim->GetResourceManager();
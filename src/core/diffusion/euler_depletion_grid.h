@@ -63,6 +63,10 @@ class EulerDepletionGrid : public EulerGrid {
   /// binding_coefficients_. See ApplyDepletion for details.
   void DiffuseWithPeriodic(real_t dt) override;
 
+  /// In addition to the accesses of the diffusion, the depletion reads the
+  /// binding substances.
+  OpDataAccess GetDataAccess() const override;
+
   // To avoid missing substances or coefficients, name of the sub and binding
   // coefficient must be set at the same time
 
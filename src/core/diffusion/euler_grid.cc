@@ -13,11 +13,33 @@
 // -----------------------------------------------------------------------------
 
 #include "core/diffusion/euler_grid.h"
+#include <algorithm>
+#include <limits>
+#include "core/diffusion/multi_species_euler_grid.h"
 #include "core/resource_manager.h"
 #include "core/simulation.h"
 
 namespace bdm {
 
+void EulerGrid::Step(real_t dt) {
+  if (species_group_) {
+    species_group_->Step(this, dt);
+  } else {
+    Diffuse(dt);
+  }
+}
+
+real_t EulerGrid::GetStableTimeStep() const {
+  if (!species_group_) {
+    return DiffusionGrid::GetStableTimeStep();
+  }
+  real_t max_dt = std::numeric_limits<real_t>::max();
+  for (const auto* species : species_group_->GetSpecies()) {
+    max_dt = std::min(max_dt, species->DiffusionGrid::GetStableTimeStep());
+  }
+  return max_dt;
+}
+
 void EulerGrid::DiffuseWithClosedEdge(real_t dt) {
   const auto nx = resolution_;
   const auto ny = resolution_;
@@ -73,7 +95,6 @@ void EulerGrid::DiffuseWithOpenEdge(real_t dt) {
 
   const real_t ibl2 = 1 / (box_length_ * box_length_);
   const real_t d = 1 - dc_[0];
-  std::array<int, 4> l;
 
   constexpr size_t YBF = 16;
 #pragma omp parallel for collapse(2)
@@ -92,6 +113,7 @@ void EulerGrid::DiffuseWithOpenEdge(real_t dt) {
         size_t t{0};
         c = x + y * nx + z * nx * ny;
 
+        std::array<int, 4> l;
         l.fill(1);
 
         if (y == 0) {
@@ -15,12 +15,15 @@
 #ifndef CORE_DIFFUSION_EULER_GRID_H_
 #define CORE_DIFFUSION_EULER_GRID_H_
 
+#include <memory>
 #include <utility>
 
 #include "core/diffusion/diffusion_grid.h"
 
 namespace bdm {
 
+class MultiSpeciesEulerGrid;
+
 /** @brief Continuum model for the 3D heat equation with exponential decay
            \f$ \partial_t u = \nabla D \nabla u - \mu u \f$.
 
@@ -54,7 +57,25 @@ class EulerGrid : public DiffusionGrid {
   void DiffuseWithNeumann(real_t dt) override;
   void DiffuseWithPeriodic(real_t dt) override;
 
+  /// Diffuses this grid, or forwards the call to its group if it has been
+  /// fused with other grids (see `MultiSpeciesEulerGrid`).
+  void Step(real_t dt) override;
+
+  /// Fused grids share the smallest stable time step of the group, because
+  /// they are integrated together.
+  real_t GetStableTimeStep() const override;
+
+  /// Returns the group of this grid, or nullptr if it is diffused on its own.
+  MultiSpeciesEulerGrid* GetSpeciesGroup() const {
+    return species_group_.get();
+  }
+
  private:
+  friend class MultiSpeciesEulerGrid;
+
+  /// Shared by all grids of the group
+  std::shared_ptr<MultiSpeciesEulerGrid> species_group_ = nullptr;  //!
+
   BDM_CLASS_DEF_OVERRIDE(EulerGrid, 1);
 };
 
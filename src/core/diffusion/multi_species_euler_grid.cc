@@ -0,0 +1,300 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/diffusion/multi_species_euler_grid.h"
+#include <algorithm>
+#include <typeinfo>
+#include "core/util/log.h"
+
+namespace bdm {
+
+MultiSpeciesEulerGrid* MultiSpeciesEulerGrid::Fuse(
+    const std::vector<EulerGrid*>& species, Reaction reaction) {
+  if (species.empty()) {
+    Log::Fatal("MultiSpeciesEulerGrid::Fuse", "No species given.");
+  }
+  for (auto* grid : species) {
+    if (grid == nullptr || typeid(*grid) != typeid(EulerGrid)) {
+      Log::Fatal("MultiSpeciesEulerGrid::Fuse",
+                 "Only grids of type EulerGrid can be fused.");
+    }
+    if (grid->species_group_) {
+      Log::Fatal("MultiSpeciesEulerGrid::Fuse", "The substance '",
+                 grid->GetContinuumName(), "' is already part of a group.");
+    }
+    // The group is integrated with the time step of the first species
+    if (grid->GetTimeStep() != species[0]->GetTimeStep()) {
+      Log::Fatal("MultiSpeciesEulerGrid::Fuse", "The substance '",
+                 grid->GetContinuumName(), "' has the time step ",
+                 grid->GetTimeStep(), ", but the substance '",
+                 species[0]->GetContinuumName(), "' has the time step ",
+                 species[0]->GetTimeStep(), ".");
+    }
+  }
+
+  std::shared_ptr<MultiSpeciesEulerGrid> group(
+      new MultiSpeciesEulerGrid(species));
+  group->reaction_ = std::move(reaction);
+  for (auto* grid : species) {
+    grid->species_group_ = group;
+  }
+  return group.get();
+}
+
+void MultiSpeciesEulerGrid::Step(const EulerGrid* caller, real_t dt) {
+  if (caller == species_[0]) {
+    Diffuse(dt);
+  }
+}
+
+void MultiSpeciesEulerGrid::Diffuse(real_t dt) {
+  const auto* first = species_[0];
+  std::vector<EulerGrid*> active;
+  std::vector<real_t> decay;
+  std::vector<real_t> diffusion;
+  for (auto* grid : species_) {
+    grid->ApplyDeferredUpdates();
+    if (grid->resolution_ != first->resolution_ ||
+        grid->box_length_ != first->box_length_ ||
+        grid->bc_type_ != first->bc_type_) {
+      Log::Fatal("MultiSpeciesEulerGrid::Diffuse", "The substance '",
+                 grid->GetContinuumName(),
+                 "' differs from the first species of the group in ",
+                 "resolution, box length or boundary condition type.");
+    }
+    if (grid->IsFixedSubstance()) {
+      continue;
+    }
+    grid->last_dt_ = dt;
+    grid->ParametersCheck(dt);
+    active.push_back(grid);
+    decay.push_back(1 - grid->mu_ * dt);
+    // Same expressions as in `EulerGrid::DiffuseWith*`
+    const real_t d = 1 - grid->dc_[0];
+    const real_t box_length2 = grid->box_length_ * grid->box_length_;
+    if (grid->bc_type_ == BoundaryConditionType::kPeriodic) {
+      diffusion.push_back(d * dt / box_length2);
+    } else {
+      const real_t ibl2 = 1 / box_length2;
+      diffusion.push_back(d * dt * ibl2);
+    }
+  }
+
+  if (!active.empty()) {
+    DiffuseInnerBoxes(active, decay, diffusion);
+    DiffuseBoundaryBoxes(active, decay, diffusion);
+    for (auto* grid : active) {
+      grid->c1_.swap(grid->c2_);
+    }
+  }
+
+  if (reaction_) {
+    React(dt);
+  }
+}
+
+void MultiSpeciesEulerGrid::DiffuseInnerBoxes(
+    const std::vector<EulerGrid*>& active, const std::vector<real_t>& decay,
+    const std::vector<real_t>& diffusion) {
+  const size_t n = species_[0]->resolution_;
+  const size_t nn = n * n;
+  const size_t num_species = active.size();
+  const auto bc_type = species_[0]->bc_type_;
+  if (n < 3) {
+    return;
+  }
+
+  // The terms of the stencil are summed in the same order as in the
+  // corresponding `EulerGrid::DiffuseWith*` function, such that the results
+  // are identical.
+  constexpr size_t YBF = 16;
+#pragma omp parallel for collapse(2)
+  for (size_t yy = 1; yy < n - 1; yy += YBF) {
+    for (size_t z = 1; z < n - 1; z++) {
+      size_t ymax = std::min(yy + YBF, n - 1);
+      for (size_t y = yy; y < ymax; y++) {
+        const size_t row = y * n + z * nn;
+        // All species are updated while the row index is hot
+        for (size_t s = 0; s < num_species; s++) {
+          const real_t* c1 = active[s]->c1_.data();
+          real_t* c2 = active[s]->c2_.data();
+          const real_t a = decay[s];
+          const real_t b = diffusion[s];
+          if (bc_type == BoundaryConditionType::kNeumann) {
+            const real_t center_factor{6.0};
+#pragma omp simd
+            for (size_t x = 1; x < n - 1; x++) {
+              const size_t c = row + x;
+              c2[c] = c1[c] * a + b * (c1[c - 1] + c1[c + 1] + c1[c + n] +
+                                       c1[c - n] + c1[c + nn] + c1[c - nn] -
+                                       center_factor * c1[c]);
+            }
+          } else if (bc_type == BoundaryConditionType::kPeriodic) {
+#pragma omp simd
+            for (size_t x = 1; x < n - 1; x++) {
+              const size_t c = row + x;
+              c2[c] = c1[c] * a + (b * (c1[c - 1] + c1[c + 1] + c1[c - n] +
+                                        c1[c + n] + c1[c + nn] + c1[c - nn] -
+                                        6.0 * c1[c]));
+            }
+          } else {
+#pragma omp simd
+            for (size_t x = 1; x < n - 1; x++) {
+              const size_t c = row + x;
+              c2[c] = c1[c] * a +
+                      b * (c1[c - 1] - 2 * c1[c] + c1[c + 1] + c1[c + n] -
+                           2 * c1[c] + c1[c - n] + c1[c - nn] - 2 * c1[c] +
+                           c1[c + nn]);
+            }
+          }
+        }
+      }  // tile ny
+    }    // tile nz
+  }      // block ny
+}
+
+void MultiSpeciesEulerGrid::DiffuseBoundaryBoxes(
+    const std::vector<EulerGrid*>& active, const std::vector<real_t>& decay,
+    const std::vector<real_t>& diffusion) {
+  const auto* first = species_[0];
+  const size_t n = first->resolution_;
+  const size_t nn = n * n;
+  const size_t num_species = active.size();
+  const auto bc_type = first->bc_type_;
+  const real_t box_length = first->box_length_;
+  const real_t origin = first->grid_dimensions_[0];
+
+  // `EulerGrid::DiffuseWithClosedEdge` does not update the boundary boxes
+  if (bc_type == BoundaryConditionType::kClosedBoundaries) {
+    return;
+  }
+
+#pragma omp parallel for collapse(2)
+  for (size_t z = 0; z < n; z++) {
+    for (size_t y = 0; y < n; y++) {
+      // Inner rows only have boundary boxes at x = 0 and x = n - 1
+      const bool boundary_row = y == 0 || y == n - 1 || z == 0 || z == n - 1;
+      const size_t x_step = boundary_row ? 1 : n - 1;
+      for (size_t x = 0; x < n; x += x_step) {
+        const size_t c = x + y * n + z * nn;
+        const real_t real_x = origin + x * box_length;
+        const real_t real_y = origin + y * box_length;
+        const real_t real_z = origin + z * box_length;
+
+        for (size_t s = 0; s < num_species; s++) {
+          auto* grid = active[s];
+          const real_t* c1 = grid->c1_.data();
+          real_t* c2 = grid->c2_.data();
+          const real_t a = decay[s];
+          const real_t b = diffusion[s];
+
+          if (bc_type == BoundaryConditionType::kDirichlet) {
+            c2[c] = grid->boundary_condition_->Evaluate(
+                real_x, real_y, real_z, grid->GetSimulatedTime());
+          } else if (bc_type == BoundaryConditionType::kNeumann) {
+            const real_t boundary_value =
+                -box_length *
+                grid->boundary_condition_->Evaluate(real_x, real_y, real_z,
+                                                    grid->GetSimulatedTime());
+            real_t left = x > 0 ? c1[c - 1] : 0;
+            real_t right = x < n - 1 ? c1[c + 1] : 0;
+            real_t north = y > 0 ? c1[c - n] : 0;
+            real_t south = y < n - 1 ? c1[c + n] : 0;
+            real_t bottom = z > 0 ? c1[c - nn] : 0;
+            real_t top = z < n - 1 ? c1[c + nn] : 0;
+            real_t center_factor{6.0};
+            if (x == 0) {
+              left = boundary_value;
+              center_factor -= 1.0;
+            } else if (x == n - 1) {
+              right = boundary_value;
+              center_factor -= 1.0;
+            }
+            if (y == 0) {
+              north = boundary_value;
+              center_factor -= 1.0;
+            } else if (y == n - 1) {
+              south = boundary_value;
+              center_factor -= 1.0;
+            }
+            if (z == 0) {
+              bottom = boundary_value;
+              center_factor -= 1.0;
+            } else if (z == n - 1) {
+              top = boundary_value;
+              center_factor -= 1.0;
+            }
+            c2[c] = c1[c] * a + b * (left + right + south + north + top +
+                                     bottom - center_factor * c1[c]);
+          } else if (bc_type == BoundaryConditionType::kPeriodic) {
+            const size_t l = x == 0 ? c + n - 1 : c - 1;
+            const size_t r = x == n - 1 ? c - (n - 1) : c + 1;
+            const size_t no = y == 0 ? c + (n - 1) * n : c - n;
+            const size_t so = y == n - 1 ? c - (n - 1) * n : c + n;
+            const size_t bo = z == 0 ? c + (n - 1) * nn : c - nn;
+            const size_t to = z == n - 1 ? c - (n - 1) * nn : c + nn;
+            c2[c] = c1[c] * a + (b * (c1[l] + c1[r] + c1[no] + c1[so] +
+                                      c1[to] + c1[bo] - 6.0 * c1[c]));
+          } else if (bc_type == BoundaryConditionType::kOpenBoundaries) {
+            // Mirrors `EulerGrid::DiffuseWithOpenEdge` term by term,
+            // including its treatment of the neighbors outside of the grid.
+            const size_t no = y == 0 ? c : c - n;
+            const size_t so = y == n - 1 ? c : c + n;
+            const size_t bo = z == 0 ? c : c - nn;
+            const size_t to = z == n - 1 ? c : c + nn;
+            if (x == 0) {
+              c2[c] = c1[c] * a +
+                      b * (0 - 2 * c1[c] + c1[c + 1] + c1[so] - 2 * c1[c] +
+                           c1[no] + c1[bo] - 2 * c1[c] + c1[to]);
+            } else if (x == n - 1) {
+              c2[c] = c1[c] * a +
+                      b * (c1[c - 1] - 2 * c1[c] + 0 + c1[so] - 2 * c1[c] +
+                           c1[no] + c1[bo] - 2 * c1[c] + c1[to]);
+            } else {
+              const int l0 = y == 0 ? 0 : 1;
+              const int l1 = y == n - 1 ? 0 : 1;
+              const int l2 = z == 0 ? 0 : 1;
+              const int l3 = z == n - 1 ? 0 : 1;
+              c2[c] = c1[c] * a +
+                      b * (c1[c - 1] - 2 * c1[c] + c1[c + 1] + l0 * c1[so] -
+                           2 * c1[c] + l1 * c1[no] + l2 * c1[bo] -
+                           2 * c1[c] + l3 * c1[to]);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+void MultiSpeciesEulerGrid::React(real_t dt) {
+  const size_t num_boxes = species_[0]->total_num_boxes_;
+  const size_t num_species = species_.size();
+#pragma omp parallel
+  {
+    std::vector<real_t> concentrations(num_species);
+#pragma omp for
+    for (size_t c = 0; c < num_boxes; c++) {
+      for (size_t s = 0; s < num_species; s++) {
+        concentrations[s] = species_[s]->c1_[c];
+      }
+      reaction_(concentrations.data(), dt);
+      for (size_t s = 0; s < num_species; s++) {
+        species_[s]->c1_[c] = concentrations[s];
+      }
+    }
+  }
+}
+
+}  // namespace bdm
@@ -0,0 +1,102 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_DIFFUSION_MULTI_SPECIES_EULER_GRID_H_
+#define CORE_DIFFUSION_MULTI_SPECIES_EULER_GRID_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "core/diffusion/euler_grid.h"
+
+namespace bdm {
+
+/** @brief Diffuses several substances that share the same grid in one fused
+           stencil sweep.
+
+  Each substance remains a regular `EulerGrid` with its own diffusion
+  coefficient, decay constant and concentration array, i.e. the species are
+  stored in blocked SoA form, and agents access them as usual (e.g.
+  `ResourceManager::GetDiffusionGrid`). The group replaces the separate sweeps
+  of the grids by a single sweep: each row of the grid is updated for all
+  species before the next row is processed. Hence, the index computations
+  and the loop overhead are shared, and the neighboring rows of all species
+  are still in the cache.\n
+  Optionally, a reaction is applied to each box after the diffusion step. It
+  receives the concentrations of all species in this box and can modify them,
+  e.g. to model the binding of substances (see `EulerDepletionGrid`).\n
+  Usage:
+
+      auto* rm = simulation.GetResourceManager();
+      std::vector<EulerGrid*> species;
+      for (int i = 0; i < num_substances; i++) {
+        species.push_back(dynamic_cast<EulerGrid*>(rm->GetDiffusionGrid(i)));
+      }
+      MultiSpeciesEulerGrid::Fuse(species, [](real_t* c, real_t dt) {
+        c[0] -= 0.1 * c[0] * c[1] * dt;
+      });
+
+  All species must have the same resolution, boundary condition type and time
+  step (see `Continuum::SetTimeStep`). The results are identical to those of
+  the separate `EulerGrid::DiffuseWith*` functions for all boundary
+  conditions.
+*/
+class MultiSpeciesEulerGrid {
+ public:
+  /// Called for each box after the diffusion step. `concentrations` contains
+  /// the concentration of each species in the order given to `Fuse`.
+  using Reaction = std::function<void(real_t* concentrations, real_t dt)>;
+
+  /// Groups `species` such that they are diffused together. The group is
+  /// owned by the grids. Calls `Log::Fatal` if the species have different
+  /// time steps.
+  static MultiSpeciesEulerGrid* Fuse(const std::vector<EulerGrid*>& species,
+                                     Reaction reaction = nullptr);
+
+  const std::vector<EulerGrid*>& GetSpecies() const { return species_; }
+
+  void SetReaction(Reaction reaction) { reaction_ = std::move(reaction); }
+
+  /// Called from `EulerGrid::Step` of each species. The step of the first
+  /// species diffuses all species; the others return immediately.
+  void Step(const EulerGrid* caller, real_t dt);
+
+  /// Diffuses all species by `dt` and applies the reaction.
+  void Diffuse(real_t dt);
+
+ private:
+  std::vector<EulerGrid*> species_;
+  Reaction reaction_;
+
+  explicit MultiSpeciesEulerGrid(std::vector<EulerGrid*> species)
+      : species_(std::move(species)) {}
+
+  /// Updates all boxes that are not on the boundary.
+  void DiffuseInnerBoxes(const std::vector<EulerGrid*>& active,
+                         const std::vector<real_t>& decay,
+                         const std::vector<real_t>& diffusion);
+
+  /// Updates all boxes on the boundary according to the boundary condition.
+  void DiffuseBoundaryBoxes(const std::vector<EulerGrid*>& active,
+                            const std::vector<real_t>& decay,
+                            const std::vector<real_t>& diffusion);
+
+  /// Calls the reaction for each box.
+  void React(real_t dt);
+};
+
+}  // namespace bdm
+
+#endif  // CORE_DIFFUSION_MULTI_SPECIES_EULER_GRID_H_
@@ -0,0 +1,670 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/diffusion/sparse_euler_grid.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include "core/environment/environment.h"
+#include "core/simulation.h"
+#include "core/util/log.h"
+
+namespace bdm {
+
+SparseEulerGrid::~SparseEulerGrid() { ReleaseBricks(); }
+
+void SparseEulerGrid::Update() {
+  auto* env = Simulation::GetActive()->GetEnvironment();
+  auto bounds = env->GetDimensionThresholds();
+  if (bounds[0] < grid_dimensions_[0] || bounds[1] > grid_dimensions_[1]) {
+    Log::Fatal("SparseEulerGrid::Update", "The substance '",
+               GetContinuumName(),
+               "' cannot grow with the simulation space. Please bound the ",
+               "simulation space (see Param::bound_space).");
+  }
+}
+
+void SparseEulerGrid::AllocateGrid() {
+  bricks_per_axis_ = (resolution_ + kBrickSize - 1) / kBrickSize;
+  const size_t num_bricks =
+      bricks_per_axis_ * bricks_per_axis_ * bricks_per_axis_;
+  if (bricks_.size() != num_bricks) {
+    ReleaseBricks();
+    // Value initialization sets all entries to nullptr
+    std::vector<std::atomic<Brick*>> bricks(num_bricks);
+    bricks_.swap(bricks);
+  }
+}
+
+void SparseEulerGrid::ReleaseBricks() {
+  for (auto& brick : bricks_) {
+    delete brick.exchange(nullptr);
+  }
+  active_bricks_.clear();
+}
+
+SparseEulerGrid::Brick* SparseEulerGrid::ActivateBrick(size_t b) {
+  auto* brick = bricks_[b].load(std::memory_order_acquire);
+  if (brick != nullptr) {
+    return brick;
+  }
+  auto* new_brick = new Brick();
+  if (bricks_[b].compare_exchange_strong(brick, new_brick,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire)) {
+    return new_brick;
+  }
+  // Another thread activated the brick in the meantime
+  delete new_brick;
+  return brick;
+}
+
+size_t SparseEulerGrid::GetNumActiveBricks() const {
+  size_t num_active = 0;
+  for (size_t b = 0; b < bricks_.size(); b++) {
+    num_active += GetBrick(b) != nullptr;
+  }
+  return num_active;
+}
+
+void SparseEulerGrid::CollectActiveBricks() {
+  active_bricks_.clear();
+  for (size_t b = 0; b < bricks_.size(); b++) {
+    if (GetBrick(b) != nullptr) {
+      active_bricks_.push_back(b);
+    }
+  }
+}
+
+real_t SparseEulerGrid::GetBoxValue(const std::array<int64_t, 3>& box) const {
+  std::array<uint32_t, 3> coord = {static_cast<uint32_t>(box[0]),
+                                   static_cast<uint32_t>(box[1]),
+                                   static_cast<uint32_t>(box[2])};
+  const auto* brick = GetBrick(GetBrickIndex(coord));
+  return brick != nullptr ? brick->Current()[GetLocalIndex(coord)] : 0;
+}
+
+void SparseEulerGrid::FillHalo(size_t b, real_t* halo) const {
+  const int64_t n = resolution_;
+  const auto brick_coord = GetBrickCoordinates(b);
+  std::array<int64_t, 3> origin;
+  for (int d = 0; d < 3; d++) {
+    origin[d] = brick_coord[d] * kBrickSize;
+  }
+
+  std::fill(halo, halo + kHaloVolume, 0);
+  const real_t* current = GetBrick(b)->Current();
+  for (size_t z = 0; z < kBrickSize; z++) {
+    for (size_t y = 0; y < kBrickSize; y++) {
+      std::copy(current + y * kBrickSize + z * kBrickSize * kBrickSize,
+                current + (y + 1) * kBrickSize + z * kBrickSize * kBrickSize,
+                halo + GetHaloIndex(1, y + 1, z + 1));
+    }
+  }
+
+  // Adjacent boxes of the six neighboring bricks
+  for (int d = 0; d < 3; d++) {
+    for (size_t side : {size_t{0}, kHaloSize - 1}) {
+      for (size_t v = 1; v <= kBrickSize; v++) {
+        for (size_t u = 1; u <= kBrickSize; u++) {
+          std::array<size_t, 3> h;
+          h[d] = side;
+          h[(d + 1) % 3] = u;
+          h[(d + 2) % 3] = v;
+          std::array<int64_t, 3> box;
+          bool inside = true;
+          for (int i = 0; i < 3; i++) {
+            box[i] = origin[i] + static_cast<int64_t>(h[i]) - 1;
+            inside = inside && box[i] >= 0 && box[i] < n;
+          }
+          if (inside) {
+            halo[GetHaloIndex(h[0], h[1], h[2])] = GetBoxValue(box);
+          }
+        }
+      }
+    }
+  }
+}
+
+void SparseEulerGrid::ActivateNeighborBricks() {
+  const size_t n = resolution_;
+  const size_t nb = bricks_per_axis_;
+  const bool periodic = bc_type_ == BoundaryConditionType::kPeriodic;
+  const int64_t num_bricks = bricks_.size();
+
+#pragma omp parallel for schedule(dynamic, 64)
+  for (int64_t b = 0; b < num_bricks; b++) {
+    const auto* brick = GetBrick(b);
+    if (brick == nullptr) {
+      continue;
+    }
+    const real_t* current = brick->Current();
+    const auto coord = GetBrickCoordinates(b);
+    std::array<size_t, 3> extent;
+    for (int d = 0; d < 3; d++) {
+      extent[d] = std::min(kBrickSize, n - coord[d] * kBrickSize);
+    }
+
+    for (int d = 0; d < 3; d++) {
+      for (int side = 0; side < 2; side++) {
+        auto neighbor = coord;
+        if (side == 0) {
+          neighbor[d] = coord[d] > 0 ? coord[d] - 1 : nb - 1;
+        } else {
+          neighbor[d] = coord[d] < nb - 1 ? coord[d] + 1 : 0;
+        }
+        const bool wraps = side == 0 ? coord[d] == 0 : coord[d] == nb - 1;
+        if ((wraps && !periodic) || neighbor[d] == coord[d]) {
+          continue;
+        }
+        const size_t nb_idx = neighbor[0] + neighbor[1] * nb +
+                              neighbor[2] * nb * nb;
+        if (GetBrick(nb_idx) != nullptr) {
+          continue;
+        }
+
+        // Check the layer of boxes that is adjacent to the neighbor
+        const int du = (d + 1) % 3;
+        const int dv = (d + 2) % 3;
+        std::array<uint32_t, 3> box;
+        box[d] = side == 0 ? 0 : extent[d] - 1;
+        bool above_threshold = false;
+        for (uint32_t v = 0; v < extent[dv] && !above_threshold; v++) {
+          for (uint32_t u = 0; u < extent[du]; u++) {
+            box[du] = u;
+            box[dv] = v;
+            if (std::abs(current[GetLocalIndex(box)]) >
+                activation_threshold_) {
+              above_threshold = true;
+              break;
+            }
+          }
+        }
+        if (above_threshold) {
+          ActivateBrick(nb_idx);
+        }
+      }
+    }
+  }
+
+  if (bc_type_ == BoundaryConditionType::kNeumann ||
+      bc_type_ == BoundaryConditionType::kDirichlet) {
+    ActivateBoundaryBricks();
+  }
+  CollectActiveBricks();
+}
+
+void SparseEulerGrid::ActivateBoundaryBricks() {
+  const size_t n = resolution_;
+  const int64_t num_bricks = bricks_.size();
+  const bool neumann = bc_type_ == BoundaryConditionType::kNeumann;
+  const auto sim_time = GetSimulatedTime();
+
+#pragma omp parallel for schedule(dynamic, 64)
+  for (int64_t b = 0; b < num_bricks; b++) {
+    if (GetBrick(b) != nullptr) {
+      continue;
+    }
+    const auto brick_coord = GetBrickCoordinates(b);
+    std::array<size_t, 3> origin;
+    std::array<size_t, 3> extent;
+    bool on_boundary = false;
+    for (int d = 0; d < 3; d++) {
+      origin[d] = brick_coord[d] * kBrickSize;
+      extent[d] = std::min(kBrickSize, n - origin[d]);
+      on_boundary = on_boundary || origin[d] == 0 || origin[d] + extent[d] == n;
+    }
+    if (!on_boundary) {
+      continue;
+    }
+
+    bool above_threshold = false;
+    for (size_t z = 0; z < extent[2] && !above_threshold; z++) {
+      for (size_t y = 0; y < extent[1] && !above_threshold; y++) {
+        for (size_t x = 0; x < extent[0]; x++) {
+          const std::array<size_t, 3> box = {origin[0] + x, origin[1] + y,
+                                             origin[2] + z};
+          if (box[0] != 0 && box[0] != n - 1 && box[1] != 0 &&
+              box[1] != n - 1 && box[2] != 0 && box[2] != n - 1) {
+            continue;
+          }
+          real_t value = boundary_condition_->Evaluate(
+              grid_dimensions_[0] + box[0] * box_length_,
+              grid_dimensions_[0] + box[1] * box_length_,
+              grid_dimensions_[0] + box[2] * box_length_, sim_time);
+          if (neumann) {
+            value *= box_length_;
+          }
+          if (std::abs(value) > activation_threshold_) {
+            above_threshold = true;
+            break;
+          }
+        }
+      }
+    }
+    if (above_threshold) {
+      ActivateBrick(b);
+    }
+  }
+}
+
+void SparseEulerGrid::DiffuseBricks(real_t dt) {
+  ActivateNeighborBricks();
+
+  const real_t decay = 1 - mu_ * dt;
+  const real_t diffusion = (1 - dc_[0]) * dt / (box_length_ * box_length_);
+  const int64_t num_active = active_bricks_.size();
+  std::vector<char> keep(num_active);
+
+#pragma omp parallel
+  {
+    std::array<real_t, kHaloVolume> halo;
+#pragma omp for schedule(dynamic, 16)
+    for (int64_t i = 0; i < num_active; i++) {
+      keep[i] = DiffuseBrick(active_bricks_[i], decay, diffusion, halo.data());
+    }
+  }
+
+  // The next time step becomes the current one. Bricks whose concentrations
+  // all dropped below the activation threshold are released.
+#pragma omp parallel for
+  for (int64_t i = 0; i < num_active; i++) {
+    auto b = active_bricks_[i];
+    auto* brick = GetBrick(b);
+    if (keep[i]) {
+      brick->current = 1 - brick->current;
+    } else {
+      bricks_[b].store(nullptr, std::memory_order_release);
+      delete brick;
+    }
+  }
+}
+
+bool SparseEulerGrid::DiffuseBrick(size_t b, real_t decay, real_t diffusion,
+                                   real_t* halo) {
+  auto* brick = GetBrick(b);
+  FillHalo(b, halo);
+
+  const size_t n = resolution_;
+  const auto brick_coord = GetBrickCoordinates(b);
+  std::array<size_t, 3> origin;
+  std::array<size_t, 3> extent;
+  bool on_boundary = false;
+  for (int d = 0; d < 3; d++) {
+    origin[d] = brick_coord[d] * kBrickSize;
+    extent[d] = std::min(kBrickSize, n - origin[d]);
+    on_boundary = on_boundary || origin[d] == 0 || origin[d] + extent[d] == n;
+  }
+  const std::array<size_t, 3> halo_strides = {1, kHaloSize,
+                                              kHaloSize * kHaloSize};
+  const auto sim_time = GetSimulatedTime();
+  auto real_coord = [&](size_t x, size_t y, size_t z) {
+    return Real3({grid_dimensions_[0] + (origin[0] + x) * box_length_,
+                  grid_dimensions_[0] + (origin[1] + y) * box_length_,
+                  grid_dimensions_[0] + (origin[2] + z) * box_length_});
+  };
+
+  // Set the halo values outside of the grid according to the boundary
+  // condition (zero for open, closed and Dirichlet boundaries)
+  const bool periodic = bc_type_ == BoundaryConditionType::kPeriodic;
+  const bool neumann = bc_type_ == BoundaryConditionType::kNeumann;
+  if (on_boundary && (periodic || neumann)) {
+    for (size_t z = 0; z < extent[2]; z++) {
+      for (size_t y = 0; y < extent[1]; y++) {
+        for (size_t x = 0; x < extent[0]; x++) {
+          const std::array<size_t, 3> local = {x, y, z};
+          const size_t h = GetHaloIndex(x + 1, y + 1, z + 1);
+          real_t boundary_value = 0;
+          bool evaluated = false;
+          for (int d = 0; d < 3; d++) {
+            const size_t box = origin[d] + local[d];
+            for (int side = 0; side < 2; side++) {
+              if (box != (side == 0 ? 0 : n - 1)) {
+                continue;
+              }
+              const size_t ghost =
+                  side == 0 ? h - halo_strides[d] : h + halo_strides[d];
+              if (periodic) {
+                std::array<int64_t, 3> wrapped = {
+                    static_cast<int64_t>(origin[0] + x),
+                    static_cast<int64_t>(origin[1] + y),
+                    static_cast<int64_t>(origin[2] + z)};
+                wrapped[d] = side == 0 ? n - 1 : 0;
+                halo[ghost] = GetBoxValue(wrapped);
+              } else {
+                if (!evaluated) {
+                  auto pos = real_coord(x, y, z);
+                  boundary_value =
+                      -box_length_ * boundary_condition_->Evaluate(
+                                         pos[0], pos[1], pos[2], sim_time);
+                  evaluated = true;
+                }
+                halo[ghost] = halo[h] + boundary_value;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  const real_t* current = brick->Current();
+  real_t* next = brick->concentrations[1 - brick->current];
+  constexpr size_t kHaloPlane = kHaloSize * kHaloSize;
+  for (size_t z = 0; z < extent[2]; z++) {
+    for (size_t y = 0; y < extent[1]; y++) {
+      const real_t* c = halo + GetHaloIndex(1, y + 1, z + 1);
+      real_t* out = next + y * kBrickSize + z * kBrickSize * kBrickSize;
+#pragma omp simd
+      for (size_t x = 0; x < extent[0]; x++) {
+        out[x] = c[x] * decay +
+                 diffusion * (c[x - 1] + c[x + 1] + c[x - kHaloSize] +
+                              c[x + kHaloSize] + c[x - kHaloPlane] +
+                              c[x + kHaloPlane] - 6 * c[x]);
+      }
+    }
+  }
+
+  // Fixed boxes on closed and Dirichlet boundaries
+  const bool closed = bc_type_ == BoundaryConditionType::kClosedBoundaries;
+  const bool dirichlet = bc_type_ == BoundaryConditionType::kDirichlet;
+  if (on_boundary && (closed || dirichlet)) {
+    for (size_t z = 0; z < extent[2]; z++) {
+      for (size_t y = 0; y < extent[1]; y++) {
+        for (size_t x = 0; x < extent[0]; x++) {
+          const std::array<size_t, 3> box = {origin[0] + x, origin[1] + y,
+                                             origin[2] + z};
+          if (box[0] != 0 && box[0] != n - 1 && box[1] != 0 &&
+              box[1] != n - 1 && box[2] != 0 && box[2] != n - 1) {
+            continue;
+          }
+          const size_t l = x + y * kBrickSize + z * kBrickSize * kBrickSize;
+          if (closed) {
+            next[l] = current[l];
+          } else {
+            auto pos = real_coord(x, y, z);
+            next[l] = boundary_condition_->Evaluate(pos[0], pos[1], pos[2],
+                                                    sim_time);
+          }
+        }
+      }
+    }
+  }
+
+  real_t max_value = 0;
+  for (size_t l = 0; l < kBoxesPerBrick; l++) {
+    max_value = std::max(max_value, std::abs(next[l]));
+  }
+  return max_value > activation_threshold_;
+}
+
+void SparseEulerGrid::CalculateGradient() {
+  if (init_gradient_ && IsFixedSubstance()) {
+    return;
+  }
+  if (!precompute_gradients_) {
+    return;
+  }
+  if (lazy_gradients_) {
+    DiffusionGrid::CalculateGradient();
+    return;
+  }
+
+  CollectActiveBricks();
+  const size_t n = resolution_;
+  const int64_t num_active = active_bricks_.size();
+  const std::array<size_t, 3> halo_strides = {1, kHaloSize,
+                                              kHaloSize * kHaloSize};
+
+#pragma omp parallel
+  {
+    std::array<real_t, kHaloVolume> halo;
+#pragma omp for schedule(dynamic, 16)
+    for (int64_t i = 0; i < num_active; i++) {
+      auto b = active_bricks_[i];
+      auto* brick = GetBrick(b);
+      if (!brick->gradients) {
+        brick->gradients.reset(new Real3[kBoxesPerBrick]);
+      }
+      FillHalo(b, halo.data());
+
+      const auto brick_coord = GetBrickCoordinates(b);
+      std::array<size_t, 3> origin;
+      std::array<size_t, 3> extent;
+      for (int d = 0; d < 3; d++) {
+        origin[d] = brick_coord[d] * kBrickSize;
+        extent[d] = std::min(kBrickSize, n - origin[d]);
+      }
+      for (size_t z = 0; z < extent[2]; z++) {
+        for (size_t y = 0; y < extent[1]; y++) {
+          for (size_t x = 0; x < extent[0]; x++) {
+            const std::array<size_t, 3> box = {origin[0] + x, origin[1] + y,
+                                               origin[2] + z};
+            const size_t h = GetHaloIndex(x + 1, y + 1, z + 1);
+            auto& gradient =
+                brick->gradients[x + y * kBrickSize +
+                                 z * kBrickSize * kBrickSize];
+            // Forward/backward difference for boxes on the edge
+            for (int d = 0; d < 3; d++) {
+              const bool has_minus = box[d] > 0;
+              const bool has_plus = box[d] < n - 1;
+              const size_t stride = halo_strides[d];
+              const real_t minus = has_minus ? halo[h - stride] : halo[h];
+              const real_t plus = has_plus ? halo[h + stride] : halo[h];
+              gradient[d] =
+                  (plus - minus) / ((has_minus + has_plus) * box_length_);
+            }
+          }
+        }
+      }
+    }
+  }
+  if (!init_gradient_) {
+    init_gradient_ = true;
+  }
+}
+
+void SparseEulerGrid::RunInitializers() {
+  if (initializers_.empty()) {
+    return;
+  }
+
+  const size_t n = resolution_;
+  const int64_t num_bricks = bricks_.size();
+  const bool dirichlet = bc_type_ == BoundaryConditionType::kDirichlet;
+
+#pragma omp parallel for schedule(dynamic, 16)
+  for (int64_t b = 0; b < num_bricks; b++) {
+    const auto brick_coord = GetBrickCoordinates(b);
+    std::array<size_t, 3> origin;
+    std::array<size_t, 3> extent;
+    for (int d = 0; d < 3; d++) {
+      origin[d] = brick_coord[d] * kBrickSize;
+      extent[d] = std::min(kBrickSize, n - origin[d]);
+    }
+
+    std::array<real_t, kBoxesPerBrick> values = {};
+    bool non_zero = false;
+    for (size_t z = 0; z < extent[2]; z++) {
+      for (size_t y = 0; y < extent[1]; y++) {
+        for (size_t x = 0; x < extent[0]; x++) {
+          const std::array<size_t, 3> box = {origin[0] + x, origin[1] + y,
+                                             origin[2] + z};
+          std::array<real_t, 3> real_coord;
+          for (int i = 0; i < 3; i++) {
+            real_coord[i] = grid_dimensions_[0] +
+                            static_cast<real_t>(box[i]) * box_length_ +
+                            box_length_ / 2.0;
+          }
+
+          real_t value{0};
+          const bool on_boundary = box[0] == 0 || box[0] == n - 1 ||
+                                   box[1] == 0 || box[1] == n - 1 ||
+                                   box[2] == 0 || box[2] == n - 1;
+          if (dirichlet && on_boundary) {
+            value = boundary_condition_->Evaluate(real_coord[0], real_coord[1],
+                                                  real_coord[2], 0);
+          } else {
+            for (auto& initializer : initializers_) {
+              value += initializer(real_coord[0], real_coord[1], real_coord[2]);
+            }
+          }
+          value = std::clamp(value, lower_threshold_, upper_threshold_);
+
+          values[x + y * kBrickSize + z * kBrickSize * kBrickSize] = value;
+          non_zero = non_zero || value != 0;
+        }
+      }
+    }
+
+    if (non_zero) {
+      auto* brick = ActivateBrick(b);
+      std::copy(values.begin(), values.end(), brick->Current());
+    }
+  }
+
+  // Clear the initializer to free up space
+  initializers_.clear();
+  initializers_.shrink_to_fit();
+}
+
+real_t SparseEulerGrid::GetConcentration(const size_t idx) const {
+  if (idx >= total_num_boxes_) {
+    Log::Error("SparseEulerGrid::GetConcentration",
+               "You tried to get the concentration outside the bounds of "
+               "the diffusion grid!");
+    return 0;
+  }
+  const auto box = GetBoxCoordinates(idx);
+  auto* brick = GetBrick(GetBrickIndex(box));
+  if (brick == nullptr) {
+    return 0;
+  }
+  if (defer_updates_) {
+    return brick->Current()[GetLocalIndex(box)];
+  }
+  std::lock_guard<Spinlock> guard(brick->lock);
+  return brick->Current()[GetLocalIndex(box)];
+}
+
+void SparseEulerGrid::ApplyConcentrationChange(size_t idx, real_t amount,
+                                               InteractionMode mode) {
+  const auto box = GetBoxCoordinates(idx);
+  auto* brick = ActivateBrick(GetBrickIndex(box));
+  real_t& value = brick->Current()[GetLocalIndex(box)];
+  value = ChangedConcentration(value, amount, mode);
+}
+
+void SparseEulerGrid::ApplyLockedConcentrationChange(size_t idx,
+                                                     real_t amount,
+                                                     InteractionMode mode) {
+  const auto box = GetBoxCoordinates(idx);
+  auto* brick = ActivateBrick(GetBrickIndex(box));
+  std::lock_guard<Spinlock> guard(brick->lock);
+  real_t& value = brick->Current()[GetLocalIndex(box)];
+  value = ChangedConcentration(value, amount, mode);
+}
+
+void SparseEulerGrid::GetGradient(const Real3& position, Real3* gradient,
+                                  bool normalize) const {
+  if (!init_gradient_ || lazy_gradients_) {
+    // Computed from `GetConcentration`
+    DiffusionGrid::GetGradient(position, gradient, normalize);
+    return;
+  }
+  assert(gradient != nullptr);
+  auto idx = GetBoxIndex(position);
+  if (idx >= total_num_boxes_) {
+    Log::Error("SparseEulerGrid::GetGradient",
+               "You tried to get the gradient outside the bounds of "
+               "the diffusion grid! Returning zero gradient.");
+    return;
+  }
+  const auto box = GetBoxCoordinates(idx);
+  const auto* brick = GetBrick(GetBrickIndex(box));
+  if (brick != nullptr && brick->gradients) {
+    *gradient = brick->gradients[GetLocalIndex(box)];
+  } else {
+    *gradient = {0, 0, 0};
+  }
+  if (normalize) {
+    auto norm = gradient->Norm();
+    if (norm > 1e-10) {
+      gradient->Normalize(norm);
+    }
+  }
+}
+
+const real_t* SparseEulerGrid::GetAllConcentrations() const {
+  dense_concentrations_.assign(total_num_boxes_, 0);
+  const size_t n = resolution_;
+  const int64_t num_bricks = bricks_.size();
+#pragma omp parallel for schedule(dynamic, 16)
+  for (int64_t b = 0; b < num_bricks; b++) {
+    const auto* brick = GetBrick(b);
+    if (brick == nullptr) {
+      continue;
+    }
+    const auto coord = GetBrickCoordinates(b);
+    for (uint32_t z = 0; z < kBrickSize; z++) {
+      for (uint32_t y = 0; y < kBrickSize; y++) {
+        for (uint32_t x = 0; x < kBrickSize; x++) {
+          const std::array<uint32_t, 3> box = {
+              static_cast<uint32_t>(coord[0] * kBrickSize + x),
+              static_cast<uint32_t>(coord[1] * kBrickSize + y),
+              static_cast<uint32_t>(coord[2] * kBrickSize + z)};
+          if (box[0] < n && box[1] < n && box[2] < n) {
+            dense_concentrations_[GetBoxIndex(box)] =
+                brick->Current()[GetLocalIndex(box)];
+          }
+        }
+      }
+    }
+  }
+  return dense_concentrations_.data();
+}
+
+const real_t* SparseEulerGrid::GetAllGradients() const {
+  if (lazy_gradients_) {
+    return DiffusionGrid::GetAllGradients();
+  }
+  dense_gradients_.assign(total_num_boxes_, {0, 0, 0});
+  const size_t n = resolution_;
+  const int64_t num_bricks = bricks_.size();
+#pragma omp parallel for schedule(dynamic, 16)
+  for (int64_t b = 0; b < num_bricks; b++) {
+    const auto* brick = GetBrick(b);
+    if (brick == nullptr || !brick->gradients) {
+      continue;
+    }
+    const auto coord = GetBrickCoordinates(b);
+    for (uint32_t z = 0; z < kBrickSize; z++) {
+      for (uint32_t y = 0; y < kBrickSize; y++) {
+        for (uint32_t x = 0; x < kBrickSize; x++) {
+          const std::array<uint32_t, 3> box = {
+              static_cast<uint32_t>(coord[0] * kBrickSize + x),
+              static_cast<uint32_t>(coord[1] * kBrickSize + y),
+              static_cast<uint32_t>(coord[2] * kBrickSize + z)};
+          if (box[0] < n && box[1] < n && box[2] < n) {
+            dense_gradients_[GetBoxIndex(box)] =
+                brick->gradients[GetLocalIndex(box)];
+          }
+        }
+      }
+    }
+  }
+  return dense_gradients_.data()->data();
+}
+
+}  // namespace bdm
@@ -0,0 +1,224 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_DIFFUSION_SPARSE_EULER_GRID_H_
+#define CORE_DIFFUSION_SPARSE_EULER_GRID_H_
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/diffusion/diffusion_grid.h"
+
+namespace bdm {
+
+/** @brief Explicit diffusion solver (see `EulerGrid`) that only stores and
+           updates the regions of the grid that contain the substance.
+
+  The grid is divided into bricks of `kBrickSize`^3 boxes. Memory for a brick
+  is allocated on demand, i.e. when an agent or an initializer adds substance
+  to one of its boxes, or when the substance diffuses into it. A brick is
+  activated before each diffusion step if a face of a neighboring brick
+  contains a concentration above the activation threshold, or if it touches a
+  Neumann or Dirichlet boundary with a value above the threshold. It is
+  released once all its concentrations have dropped below the threshold.
+  Boxes of inactive bricks have the concentration zero.\n
+  The diffusion step and the gradient computation skip all inactive bricks.
+  Hence, memory and run time scale with the volume that contains the
+  substance rather than with the volume of the simulation space. This is
+  beneficial for localized sources in large spaces and fine resolutions.\n
+  With an activation threshold of zero, the results are identical to the
+  `EulerGrid`, except for closed boundaries, where the boxes on the boundary
+  keep their value, and open boundaries, where the concentration outside of
+  the grid is zero. A positive threshold trades accuracy for sparsity: the
+  substance in a released brick is lost.\n
+  The grid does not grow with the simulation space. `GetAllConcentrations`
+  and `GetAllGradients` assemble dense copies of the grid, e.g. for the
+  visualization.\n
+  Select this solver with `Param::diffusion_method = "sparse_euler"`.
+*/
+class SparseEulerGrid : public DiffusionGrid {
+ public:
+  /// Number of boxes of a brick along each axis
+  static constexpr size_t kBrickSize = 8;
+  static constexpr size_t kBoxesPerBrick = kBrickSize * kBrickSize * kBrickSize;
+
+  SparseEulerGrid() = default;
+  SparseEulerGrid(int substance_id, std::string substance_name, real_t dc,
+                  real_t mu, int resolution = 10)
+      : DiffusionGrid(substance_id, std::move(substance_name), dc, mu,
+                      resolution) {}
+  ~SparseEulerGrid() override;
+
+  using DiffusionGrid::GetConcentration;
+  using DiffusionGrid::GetGradient;
+
+  /// The sparse grid cannot grow. Fails if the simulation space exceeds the
+  /// grid.
+  void Update() override;
+
+  /// Boxes on the boundary keep their value.
+  void DiffuseWithClosedEdge(real_t dt) override { DiffuseBricks(dt); }
+  /// The concentration outside of the grid is zero.
+  void DiffuseWithOpenEdge(real_t dt) override { DiffuseBricks(dt); }
+  void DiffuseWithDirichlet(real_t dt) override { DiffuseBricks(dt); }
+  void DiffuseWithNeumann(real_t dt) override { DiffuseBricks(dt); }
+  void DiffuseWithPeriodic(real_t dt) override { DiffuseBricks(dt); }
+
+  /// Calculates the gradient of the boxes of all active bricks.
+  void CalculateGradient() override;
+
+  /// Only activates the bricks that contain non-zero values.
+  void RunInitializers() override;
+
+  real_t GetConcentration(const size_t idx) const override;
+
+  void GetGradient(const Real3& position, Real3* gradient,
+                   bool normalize = true) const override;
+
+  /// Returns a dense copy of the concentrations. The copy is valid until the
+  /// next call.
+  const real_t* GetAllConcentrations() const override;
+
+  /// Returns a dense copy of the gradients. The copy is valid until the next
+  /// call.
+  const real_t* GetAllGradients() const override;
+
+  /// Concentrations below or equal to `threshold` are treated as zero when
+  /// bricks are activated or released. Default value: 0
+  void SetActivationThreshold(real_t threshold) {
+    activation_threshold_ = threshold;
+  }
+
+  real_t GetActivationThreshold() const { return activation_threshold_; }
+
+  /// Returns the total number of bricks.
+  size_t GetNumBricks() const { return bricks_.size(); }
+
+  /// Returns the number of bricks for which memory is allocated.
+  size_t GetNumActiveBricks() const;
+
+ private:
+  /// Memory of `kBrickSize`^3 boxes. The boxes are stored in x, y, z order.
+  struct Brick {
+    /// Concentrations of the current and the next time step
+    real_t concentrations[2][kBoxesPerBrick] = {};
+    /// Index of the current time step in `concentrations`
+    int current = 0;
+    /// Allocated by the first gradient computation
+    std::unique_ptr<Real3[]> gradients;
+    /// Protects the concentrations if agents change them concurrently
+    Spinlock lock;
+
+    real_t* Current() { return concentrations[current]; }
+    const real_t* Current() const { return concentrations[current]; }
+  };
+
+  /// Number of halo values along each axis (brick plus one box on each side)
+  static constexpr size_t kHaloSize = kBrickSize + 2;
+  static constexpr size_t kHaloVolume = kHaloSize * kHaloSize * kHaloSize;
+
+  /// Concentrations below or equal to this value are treated as zero
+  real_t activation_threshold_ = 0;
+  /// Number of bricks along each axis
+  size_t bricks_per_axis_ = 0;
+  /// Brick of each brick index, or nullptr if the brick is inactive.
+  /// Bricks are activated concurrently by the agents.
+  std::vector<std::atomic<Brick*>> bricks_;  //!
+  /// Indices of the active bricks, updated at the beginning of each
+  /// diffusion step
+  std::vector<size_t> active_bricks_;  //!
+  /// Dense copies returned by `GetAllConcentrations` and `GetAllGradients`
+  mutable std::vector<real_t> dense_concentrations_;  //!
+  mutable std::vector<Real3> dense_gradients_;        //!
+
+  /// Allocates the brick table instead of the dense arrays.
+  void AllocateGrid() override;
+
+  void ApplyConcentrationChange(size_t idx, real_t amount,
+                                InteractionMode mode) override;
+
+  void ApplyLockedConcentrationChange(size_t idx, real_t amount,
+                                      InteractionMode mode) override;
+
+  /// Computes the next time step of all active bricks.
+  void DiffuseBricks(real_t dt);
+
+  /// Computes the next time step of brick `b`. Returns false if all new
+  /// concentrations are below or equal to the activation threshold.
+  bool DiffuseBrick(size_t b, real_t decay, real_t diffusion, real_t* halo);
+
+  /// Activates the neighbors of all bricks with concentrations above the
+  /// activation threshold on the respective face and updates
+  /// `active_bricks_`.
+  void ActivateNeighborBricks();
+
+  /// Activates the bricks on the boundary of the grid whose Neumann flux or
+  /// Dirichlet value is above the activation threshold. The boundary acts as
+  /// a source in this case.
+  void ActivateBoundaryBricks();
+
+  /// Collects the indices of all active bricks in `active_bricks_`.
+  void CollectActiveBricks();
+
+  /// Copies the concentrations of brick `b` and of the adjacent boxes of the
+  /// neighboring bricks into `halo`. Adjacent boxes outside of the grid are
+  /// zero (or wrapped around for periodic boundaries).
+  void FillHalo(size_t b, real_t* halo) const;
+
+  /// Returns the brick with index `b`, or nullptr if it is inactive.
+  Brick* GetBrick(size_t b) const {
+    return bricks_[b].load(std::memory_order_acquire);
+  }
+
+  /// Returns the brick with index `b` and allocates it if necessary. Thread
+  /// safe.
+  Brick* ActivateBrick(size_t b);
+
+  /// Releases all bricks.
+  void ReleaseBricks();
+
+  /// Returns the concentration of the box with coordinates `box`. The
+  /// coordinates must be inside of the grid.
+  real_t GetBoxValue(const std::array<int64_t, 3>& box) const;
+
+  size_t GetBrickIndex(const std::array<uint32_t, 3>& box) const {
+    return box[0] / kBrickSize + (box[1] / kBrickSize) * bricks_per_axis_ +
+           (box[2] / kBrickSize) * bricks_per_axis_ * bricks_per_axis_;
+  }
+
+  std::array<size_t, 3> GetBrickCoordinates(size_t b) const {
+    return {b % bricks_per_axis_, (b / bricks_per_axis_) % bricks_per_axis_,
+            b / (bricks_per_axis_ * bricks_per_axis_)};
+  }
+
+  /// Index of a box within its brick
+  static size_t GetLocalIndex(const std::array<uint32_t, 3>& box) {
+    return box[0] % kBrickSize + (box[1] % kBrickSize) * kBrickSize +
+           (box[2] % kBrickSize) * kBrickSize * kBrickSize;
+  }
+
+  static size_t GetHaloIndex(size_t x, size_t y, size_t z) {
+    return x + y * kHaloSize + z * kHaloSize * kHaloSize;
+  }
+
+  BDM_CLASS_DEF_OVERRIDE(SparseEulerGrid, 1);
+};
+
+}  // namespace bdm
+
+#endif  // CORE_DIFFUSION_SPARSE_EULER_GRID_H_
@@ -0,0 +1,556 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/diffusion/steady_state_grid.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "core/param/param.h"
+#include "core/simulation.h"
+#include "core/util/log.h"
+
+namespace bdm {
+
+namespace {
+
+/// Levels with at most this many boxes per axis are solved directly
+constexpr size_t kCoarsestSize = 4;
+/// Gauss-Seidel sweeps before and after the coarse grid correction
+constexpr int kSmoothingSweeps = 2;
+/// Levels with fewer boxes per axis are processed by a single thread
+constexpr size_t kMinParallelSize = 16;
+
+/// Sums the values of the neighbors of box (x, y, z) of a level with `n`
+/// boxes per axis. Returns the sum of the weights of the faces, i.e. the
+/// diagonal of the system without the decay. Faces on a reflecting boundary
+/// do not contribute, faces on a zero boundary with `lower` or `upper`.
+inline real_t StencilSum(const real_t* u, size_t n, bool periodic,
+                         bool reflect, real_t lower, real_t upper, size_t x,
+                         size_t y, size_t z, real_t* sum) {
+  const size_t c = x + n * (y + n * z);
+  real_t faces = 0;
+  real_t s = 0;
+  auto axis = [&](size_t v, size_t stride) {
+    if (v > 0) {
+      s += u[c - stride];
+      faces += 1;
+    } else if (periodic) {
+      s += u[c + (n - 1) * stride];
+      faces += 1;
+    } else if (!reflect) {
+      faces += lower;
+    }
+    if (v + 1 < n) {
+      s += u[c + stride];
+      faces += 1;
+    } else if (periodic) {
+      s += u[c - (n - 1) * stride];
+      faces += 1;
+    } else if (!reflect) {
+      faces += upper;
+    }
+  };
+  axis(x, 1);
+  axis(y, n);
+  axis(z, n * n);
+  *sum = s;
+  return faces;
+}
+
+/// Coarse boxes and weights for the trilinear interpolation of one fine box
+/// along one axis
+struct Interpolation {
+  size_t idx[2];
+  real_t weight[2];
+};
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::Initialize() {
+  DiffusionGrid::Initialize();
+  sources_.assign(total_num_boxes_, 0);
+}
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::Update() {
+  const auto old_resolution = resolution_;
+  DiffusionGrid::Update();
+  if (resolution_ == old_resolution || sources_.empty()) {
+    return;
+  }
+  // Move the recorded sources to the enlarged grid (see `CopyOldData`)
+  std::vector<real_t> sources(total_num_boxes_, 0);
+  const size_t off = (resolution_ - old_resolution) / 2;
+  const size_t n = resolution_;
+  for (size_t z = 0; z < old_resolution; z++) {
+    for (size_t y = 0; y < old_resolution; y++) {
+      for (size_t x = 0; x < old_resolution; x++) {
+        sources[(x + off) + n * ((y + off) + n * (z + off))] =
+            sources_[x + old_resolution * (y + old_resolution * z)];
+      }
+    }
+  }
+  sources_.swap(sources);
+}
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::ApplyConcentrationChange(size_t idx, real_t amount,
+                                               InteractionMode mode) {
+  const real_t old_value = c1_[idx];
+  c1_[idx] = ChangedConcentration(old_value, amount, mode);
+  if (idx < sources_.size()) {
+    sources_[idx] += c1_[idx] - old_value;
+  }
+}
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::ParametersCheck(real_t dt) {
+  if (mu_ == 0 && (bc_type_ == BoundaryConditionType::kNeumann ||
+                   bc_type_ == BoundaryConditionType::kPeriodic)) {
+    Log::Fatal("SteadyStateGrid::ParametersCheck", "The substance '",
+               GetContinuumName(),
+               "' requires a positive decay constant, since the steady state "
+               "is not unique for Neumann or periodic boundaries without "
+               "decay.");
+  }
+}
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::DiffuseWithClosedEdge(real_t dt) { Solve(dt, true); }
+
+void SteadyStateGrid::DiffuseWithOpenEdge(real_t dt) { Solve(dt, false); }
+
+void SteadyStateGrid::DiffuseWithDirichlet(real_t dt) {
+  const size_t n = resolution_;
+  const auto sim_time = GetSimulatedTime();
+
+  // The boxes on the boundary take the value of the boundary condition
+#pragma omp parallel for collapse(2)
+  for (size_t z = 0; z < n; z++) {
+    for (size_t y = 0; y < n; y++) {
+      const bool boundary_line = y == 0 || y == n - 1 || z == 0 || z == n - 1;
+      for (size_t x = 0; x < n; x++) {
+        if (boundary_line || x == 0 || x == n - 1) {
+          real_t real_x = grid_dimensions_[0] + x * box_length_;
+          real_t real_y = grid_dimensions_[0] + y * box_length_;
+          real_t real_z = grid_dimensions_[0] + z * box_length_;
+          c1_[x + y * n + z * n * n] =
+              boundary_condition_->Evaluate(real_x, real_y, real_z, sim_time);
+        }
+      }
+    }
+  }
+
+  Solve(dt, true);
+}
+
+void SteadyStateGrid::DiffuseWithNeumann(real_t dt) { Solve(dt, false); }
+
+void SteadyStateGrid::DiffuseWithPeriodic(real_t dt) { Solve(dt, false); }
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::Solve(real_t dt, bool interior_only) {
+  const size_t n = resolution_;
+  const size_t o = interior_only ? 1 : 0;
+  if (sources_.size() != total_num_boxes_) {
+    // e.g. after restoring a backup
+    sources_.assign(total_num_boxes_, 0);
+  }
+  if (n <= 2 * o) {
+    // All boxes are fixed by the boundary condition
+    std::fill(sources_.begin(), sources_.end(), 0);
+    return;
+  }
+
+  if (bc_type_ == BoundaryConditionType::kNeumann) {
+    level_boundary_ = LevelBoundary::kReflect;
+  } else if (bc_type_ == BoundaryConditionType::kPeriodic) {
+    level_boundary_ = LevelBoundary::kPeriodic;
+  } else {
+    level_boundary_ = LevelBoundary::kZero;
+  }
+  diffusion_ = 1 - dc_[0];
+
+  const size_t m = n - 2 * o;
+  if (levels_.empty() || levels_[0].n != m || levels_[0].h != box_length_) {
+    BuildLevels(m, box_length_);
+  }
+  // The decay constant might have changed since the last step
+  FactorizeCoarsest();
+
+  // Right hand side and initial guess (previous solution) of the unknowns
+  auto& fine = levels_[0];
+  const real_t inv_dt = 1 / dt;
+#pragma omp parallel for collapse(2)
+  for (size_t z = 0; z < m; z++) {
+    for (size_t y = 0; y < m; y++) {
+      for (size_t x = 0; x < m; x++) {
+        const size_t g = (x + o) + n * ((y + o) + n * (z + o));
+        const size_t l = x + m * (y + m * z);
+        fine.u[l] = c1_[g] - sources_[g];
+        fine.f[l] = sources_[g] * inv_dt;
+      }
+    }
+  }
+  AddBoundaryTerms(interior_only);
+
+  real_t f_norm2 = 0;
+#pragma omp parallel for reduction(+ : f_norm2)
+  for (size_t i = 0; i < fine.f.size(); i++) {
+    f_norm2 += fine.f[i] * fine.f[i];
+  }
+  const real_t f_norm = std::sqrt(f_norm2);
+
+  auto* param = Simulation::GetActive()->GetParam();
+  const real_t tolerance = param->multigrid_tolerance * f_norm;
+  real_t residual = std::sqrt(Residual(&fine));
+  num_v_cycles_ = 0;
+  while (residual > tolerance &&
+         num_v_cycles_ < param->multigrid_max_v_cycles) {
+    VCycle(0);
+    residual = std::sqrt(Residual(&fine));
+    num_v_cycles_++;
+  }
+  relative_residual_ = f_norm != 0 ? residual / f_norm : residual;
+
+#pragma omp parallel for collapse(2)
+  for (size_t z = 0; z < m; z++) {
+    for (size_t y = 0; y < m; y++) {
+      for (size_t x = 0; x < m; x++) {
+        const size_t g = (x + o) + n * ((y + o) + n * (z + o));
+        c1_[g] = fine.u[x + m * (y + m * z)];
+      }
+    }
+  }
+  std::fill(sources_.begin(), sources_.end(), 0);
+}
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::BuildLevels(size_t n, real_t h) {
+  levels_.clear();
+  const size_t m = n;
+  const real_t h0 = h;
+  while (true) {
+    levels_.emplace_back();
+    auto& level = levels_.back();
+    level.n = n;
+    level.h = h;
+    // The zero boundary lies one fine box outside of the unknowns. On coarse
+    // levels, the outermost box centers are closer to it than one coarse box
+    // length, which the face weights correct for. The upper end of a level
+    // is not aligned with the fine level if a level has an odd size.
+    const real_t lower_distance = (h + h0) / 2;
+    const real_t upper_distance =
+        (m + real_t(0.5)) * h0 - (n - real_t(0.5)) * h;
+    level.lower = h / lower_distance;
+    level.upper = h / std::max(upper_distance, h / 4);
+    const size_t size = n * n * n;
+    level.u.assign(size, 0);
+    level.f.assign(size, 0);
+    level.r.assign(size, 0);
+    if (n <= kCoarsestSize) {
+      break;
+    }
+    n = (n + 1) / 2;
+    h *= 2;
+  }
+}
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::AddBoundaryTerms(bool interior_only) {
+  if (bc_type_ != BoundaryConditionType::kNeumann && !interior_only) {
+    // Open and periodic boundaries do not contribute
+    return;
+  }
+  const size_t n = resolution_;
+  const size_t o = interior_only ? 1 : 0;
+  const size_t m = n - 2 * o;
+  auto& fine = levels_[0];
+  const real_t a = diffusion_ / (box_length_ * box_length_);
+  const auto sim_time = GetSimulatedTime();
+
+#pragma omp parallel for collapse(2)
+  for (size_t z = 0; z < m; z++) {
+    for (size_t y = 0; y < m; y++) {
+      const bool boundary_line = y == 0 || y == m - 1 || z == 0 || z == m - 1;
+      for (size_t x = 0; x < m; x++) {
+        if (!boundary_line && x != 0 && x != m - 1) {
+          continue;
+        }
+        const std::array<size_t, 3> box = {x + o, y + o, z + o};
+        const size_t g = box[0] + n * (box[1] + n * box[2]);
+        real_t sum = 0;
+        if (interior_only) {
+          // Fixed values of the neighbors on the boundary of the grid
+          const size_t strides[3] = {1, n, n * n};
+          for (int d = 0; d < 3; d++) {
+            if (box[d] == 1) {
+              sum += c1_[g - strides[d]];
+            }
+            if (box[d] == n - 2) {
+              sum += c1_[g + strides[d]];
+            }
+          }
+        } else {
+          // Flux over the boundary (see `EulerGrid::DiffuseWithNeumann`)
+          real_t real_x = grid_dimensions_[0] + box[0] * box_length_;
+          real_t real_y = grid_dimensions_[0] + box[1] * box_length_;
+          real_t real_z = grid_dimensions_[0] + box[2] * box_length_;
+          real_t boundary_value =
+              -box_length_ *
+              boundary_condition_->Evaluate(real_x, real_y, real_z, sim_time);
+          for (int d = 0; d < 3; d++) {
+            sum += box[d] == 0 ? boundary_value : 0;
+            sum += box[d] == n - 1 ? boundary_value : 0;
+          }
+        }
+        fine.f[x + m * (y + m * z)] += a * sum;
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::VCycle(size_t l) {
+  auto* level = &levels_[l];
+  if (l + 1 == levels_.size()) {
+    SolveCoarsest(level);
+    return;
+  }
+  auto* coarse = &levels_[l + 1];
+  Smooth(level, kSmoothingSweeps);
+  Residual(level);
+  Restrict(*level, coarse);
+  std::fill(coarse->u.begin(), coarse->u.end(), 0);
+  VCycle(l + 1);
+  Prolongate(*coarse, level);
+  Smooth(level, kSmoothingSweeps);
+}
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::Smooth(Level* level, int sweeps) const {
+  const size_t n = level->n;
+  const real_t a = diffusion_ / (level->h * level->h);
+  const bool periodic = level_boundary_ == LevelBoundary::kPeriodic;
+  const bool reflect = level_boundary_ == LevelBoundary::kReflect;
+  const real_t lower = level->lower;
+  const real_t upper = level->upper;
+  real_t* u = level->u.data();
+  const real_t* f = level->f.data();
+  const real_t mu = mu_;
+
+  for (int s = 0; s < sweeps; s++) {
+    for (size_t color = 0; color < 2; color++) {
+      // Boxes of the same color do not depend on each other
+#pragma omp parallel for collapse(2) if (n >= kMinParallelSize)
+      for (size_t z = 0; z < n; z++) {
+        for (size_t y = 0; y < n; y++) {
+          for (size_t x = (y + z + color) % 2; x < n; x += 2) {
+            real_t sum;
+            real_t faces = StencilSum(u, n, periodic, reflect, lower, upper,
+                                      x, y, z, &sum);
+            u[x + n * (y + n * z)] =
+                (f[x + n * (y + n * z)] + a * sum) / (mu + a * faces);
+          }
+        }
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+real_t SteadyStateGrid::Residual(Level* level) const {
+  const size_t n = level->n;
+  const real_t a = diffusion_ / (level->h * level->h);
+  const bool periodic = level_boundary_ == LevelBoundary::kPeriodic;
+  const bool reflect = level_boundary_ == LevelBoundary::kReflect;
+  const real_t lower = level->lower;
+  const real_t upper = level->upper;
+  const real_t* u = level->u.data();
+  const real_t* f = level->f.data();
+  real_t* r = level->r.data();
+  const real_t mu = mu_;
+
+  real_t norm2 = 0;
+#pragma omp parallel for collapse(2) reduction(+ : norm2) \
+    if (n >= kMinParallelSize)
+  for (size_t z = 0; z < n; z++) {
+    for (size_t y = 0; y < n; y++) {
+      for (size_t x = 0; x < n; x++) {
+        const size_t c = x + n * (y + n * z);
+        real_t sum;
+        real_t faces = StencilSum(u, n, periodic, reflect, lower, upper, x,
+                                  y, z, &sum);
+        r[c] = f[c] - (mu + a * faces) * u[c] + a * sum;
+        norm2 += r[c] * r[c];
+      }
+    }
+  }
+  return norm2;
+}
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::Restrict(const Level& fine, Level* coarse) const {
+  const size_t n = fine.n;
+  const size_t nc = coarse->n;
+  // Average of the (up to eight) fine boxes of each coarse box
+#pragma omp parallel for collapse(2) if (nc >= kMinParallelSize)
+  for (size_t z = 0; z < nc; z++) {
+    for (size_t y = 0; y < nc; y++) {
+      for (size_t x = 0; x < nc; x++) {
+        real_t sum = 0;
+        int count = 0;
+        for (size_t fz = 2 * z; fz < std::min(2 * z + 2, n); fz++) {
+          for (size_t fy = 2 * y; fy < std::min(2 * y + 2, n); fy++) {
+            for (size_t fx = 2 * x; fx < std::min(2 * x + 2, n); fx++) {
+              sum += fine.r[fx + n * (fy + n * fz)];
+              count++;
+            }
+          }
+        }
+        coarse->f[x + nc * (y + nc * z)] = sum / count;
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::Prolongate(const Level& coarse, Level* fine) const {
+  const size_t n = fine->n;
+  const size_t nc = coarse.n;
+
+  // Each fine box lies between the center of its coarse box (weight 3/4) and
+  // the center of the closest neighbor of this coarse box (weight 1/4).
+  std::vector<Interpolation> ip(n);
+  for (size_t i = 0; i < n; i++) {
+    const size_t c = i / 2;
+    const bool upper = i % 2 == 1;
+    ip[i] = {{c, c}, {0.75, 0}};
+    if (upper ? c + 1 < nc : c > 0) {
+      ip[i].idx[1] = upper ? c + 1 : c - 1;
+      ip[i].weight[1] = 0.25;
+    } else if (level_boundary_ == LevelBoundary::kPeriodic) {
+      ip[i].idx[1] = upper ? 0 : nc - 1;
+      ip[i].weight[1] = 0.25;
+    } else if (level_boundary_ == LevelBoundary::kReflect) {
+      ip[i].weight[0] = 1;
+    }
+    // kZero: the value outside of the level is zero
+  }
+
+  const real_t* e = coarse.u.data();
+  real_t* u = fine->u.data();
+#pragma omp parallel for collapse(2) if (n >= kMinParallelSize)
+  for (size_t z = 0; z < n; z++) {
+    for (size_t y = 0; y < n; y++) {
+      const auto& iz = ip[z];
+      const auto& iy = ip[y];
+      for (size_t x = 0; x < n; x++) {
+        const auto& ix = ip[x];
+        real_t value = 0;
+        for (int k = 0; k < 2; k++) {
+          for (int j = 0; j < 2; j++) {
+            const real_t wzy = iz.weight[k] * iy.weight[j];
+            const size_t row = nc * (iy.idx[j] + nc * iz.idx[k]);
+            value += wzy * (ix.weight[0] * e[ix.idx[0] + row] +
+                            ix.weight[1] * e[ix.idx[1] + row]);
+          }
+        }
+        u[x + n * (y + n * z)] += value;
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::FactorizeCoarsest() {
+  const auto& level = levels_.back();
+  const size_t n = level.n;
+  const size_t size = n * n * n;
+  const real_t a = diffusion_ / (level.h * level.h);
+  const bool periodic = level_boundary_ == LevelBoundary::kPeriodic;
+  const bool reflect = level_boundary_ == LevelBoundary::kReflect;
+
+  // Assemble the matrix column by column by applying the stencil to the
+  // unit vectors
+  auto& l = coarse_factor_;
+  l.assign(size * size, 0);
+  std::vector<real_t> unit(size, 0);
+  for (size_t j = 0; j < size; j++) {
+    unit[j] = 1;
+    for (size_t z = 0; z < n; z++) {
+      for (size_t y = 0; y < n; y++) {
+        for (size_t x = 0; x < n; x++) {
+          const size_t i = x + n * (y + n * z);
+          real_t sum;
+          real_t faces = StencilSum(unit.data(), n, periodic, reflect,
+                                    level.lower, level.upper, x, y, z, &sum);
+          l[i * size + j] = (mu_ + a * faces) * unit[i] - a * sum;
+        }
+      }
+    }
+    unit[j] = 0;
+  }
+
+  // Cholesky decomposition in place (the system is symmetric and positive
+  // definite)
+  for (size_t j = 0; j < size; j++) {
+    real_t d = l[j * size + j];
+    for (size_t k = 0; k < j; k++) {
+      d -= l[j * size + k] * l[j * size + k];
+    }
+    if (d <= 0) {
+      Log::Fatal("SteadyStateGrid::FactorizeCoarsest",
+                 "The system of substance '", GetContinuumName(),
+                 "' is not positive definite.");
+    }
+    d = std::sqrt(d);
+    l[j * size + j] = d;
+    for (size_t i = j + 1; i < size; i++) {
+      real_t v = l[i * size + j];
+      for (size_t k = 0; k < j; k++) {
+        v -= l[i * size + k] * l[j * size + k];
+      }
+      l[i * size + j] = v / d;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void SteadyStateGrid::SolveCoarsest(Level* level) const {
+  const size_t size = level->u.size();
+  const auto& l = coarse_factor_;
+  auto& u = level->u;
+  // L y = f
+  for (size_t i = 0; i < size; i++) {
+    real_t v = level->f[i];
+    for (size_t k = 0; k < i; k++) {
+      v -= l[i * size + k] * u[k];
+    }
+    u[i] = v / l[i * size + i];
+  }
+  // L^T u = y
+  for (size_t i = size; i-- > 0;) {
+    real_t v = u[i];
+    for (size_t k = i + 1; k < size; k++) {
+      v -= l[k * size + i] * u[k];
+    }
+    u[i] = v / l[i * size + i];
+  }
+}
+
+}  // namespace bdm
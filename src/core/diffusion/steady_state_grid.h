@@ -0,0 +1,171 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_DIFFUSION_STEADY_STATE_GRID_H_
+#define CORE_DIFFUSION_STEADY_STATE_GRID_H_
+
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/diffusion/diffusion_grid.h"
+
+namespace bdm {
+
+/** @brief Continuum model for substances that are in equilibrium with the
+           current sources and sinks, i.e. the solution of the steady-state
+           reaction-diffusion equation
+           \f$ 0 = \nabla D \nabla u - \mu u + s \f$.
+
+  Many substances (e.g. oxygen) equilibrate much faster than the agents move.
+  Integrating them in time to the equilibrium requires many steps of the
+  explicit scheme. Instead, this grid solves the discretized equation (the
+  same seven-point stencil and boundary conditions as the `EulerGrid`) with a
+  geometric multigrid method: red-black Gauss-Seidel smoothing, restriction by
+  averaging, trilinear prolongation, and a direct solve on the coarsest level.
+  Each step starts from the previous solution and runs V-cycles until the
+  residual has been reduced below `Param::multigrid_tolerance` (relative to
+  the right hand side) or `Param::multigrid_max_v_cycles` have been run.
+
+  The sources and sinks \f$ s \f$ are the concentration changes of
+  `ChangeConcentrationBy` (e.g. by `Secretion`) since the last step divided
+  by the time step. Hence, a secretion of `q` per agent step corresponds to
+  the same rate as for the time-dependent solvers. Each step of the continuum
+  must cover the full interval since the last step, i.e. do not set a time
+  step with `SetTimeStep` that is smaller than the interval of the
+  `ContinuumOp`.
+
+  For Neumann and periodic boundaries the decay constant must be positive,
+  since otherwise the equilibrium is not unique.\n
+  Select this solver with `Param::diffusion_method = "steady_state"`.
+*/
+class SteadyStateGrid : public DiffusionGrid {
+ public:
+  SteadyStateGrid() = default;
+  SteadyStateGrid(int substance_id, std::string substance_name, real_t dc,
+                  real_t mu, int resolution = 10)
+      : DiffusionGrid(substance_id, std::move(substance_name), dc, mu,
+                      resolution) {}
+
+  void Initialize() override;
+
+  void Update() override;
+
+  /// Boxes on the boundary keep their value.
+  void DiffuseWithClosedEdge(real_t dt) override;
+  /// The concentration outside of the grid is zero.
+  void DiffuseWithOpenEdge(real_t dt) override;
+  void DiffuseWithDirichlet(real_t dt) override;
+  void DiffuseWithNeumann(real_t dt) override;
+  void DiffuseWithPeriodic(real_t dt) override;
+
+  /// The equilibrium does not depend on the time step.
+  real_t GetStableTimeStep() const override {
+    return std::numeric_limits<real_t>::max();
+  }
+
+  /// Returns the number of V-cycles of the last step.
+  uint64_t GetNumVCycles() const { return num_v_cycles_; }
+
+  /// Returns the residual of the last step relative to the right hand side.
+  real_t GetRelativeResidual() const { return relative_residual_; }
+
+ private:
+  /// Boundary condition of the (homogeneous) system on each level
+  enum class LevelBoundary {
+    /// The value outside of the level is zero (open, Dirichlet and closed
+    /// boundaries; the fixed boxes are part of the right hand side)
+    kZero,
+    /// No flux over the boundary (Neumann boundaries; the flux is part of
+    /// the right hand side)
+    kReflect,
+    kPeriodic
+  };
+
+  /// Unknowns of one multigrid level. The finest level contains the boxes
+  /// of the grid that are not fixed by the boundary condition.
+  struct Level {
+    /// Number of boxes along each axis
+    size_t n = 0;
+    /// Box length
+    real_t h = 0;
+    /// Weights of the faces on the lower and upper zero boundary
+    real_t lower = 1;
+    real_t upper = 1;
+    /// Solution (finest level) or correction (coarser levels)
+    std::vector<real_t> u;
+    /// Right hand side
+    std::vector<real_t> f;
+    /// Residual
+    std::vector<real_t> r;
+  };
+
+  /// Concentration changes since the last step
+  std::vector<real_t> sources_;  //!
+  std::vector<Level> levels_;    //!
+  /// Cholesky factor of the coarsest level (lower triangle, row major)
+  std::vector<real_t> coarse_factor_;  //!
+  LevelBoundary level_boundary_ = LevelBoundary::kZero;  //!
+  /// Diffusion coefficient
+  real_t diffusion_ = 0;  //!
+  uint64_t num_v_cycles_ = 0;
+  real_t relative_residual_ = 0;
+
+  /// Records the change of the concentration in `sources_`.
+  void ApplyConcentrationChange(size_t idx, real_t amount,
+                                InteractionMode mode) override;
+
+  /// Fails if the equilibrium is not unique.
+  void ParametersCheck(real_t dt) override;
+
+  /// Solves the steady-state equation for the boxes that are not on the
+  /// boundary (`interior_only`) or for all boxes.
+  void Solve(real_t dt, bool interior_only);
+
+  /// Creates the levels for `n` unknowns per axis with box length `h`.
+  void BuildLevels(size_t n, real_t h);
+
+  /// Adds the right hand side contributions of the fixed boundary boxes
+  /// (Dirichlet and closed boundaries) or of the boundary flux (Neumann
+  /// boundaries) to the finest level.
+  void AddBoundaryTerms(bool interior_only);
+
+  /// Runs one V-cycle starting at level `l`.
+  void VCycle(size_t l);
+
+  /// Red-black Gauss-Seidel sweeps.
+  void Smooth(Level* level, int sweeps) const;
+
+  /// Computes the residual and returns its squared norm.
+  real_t Residual(Level* level) const;
+
+  /// Restricts the residual of `fine` to the right hand side of `coarse`.
+  void Restrict(const Level& fine, Level* coarse) const;
+
+  /// Adds the interpolated correction of `coarse` to the solution of `fine`.
+  void Prolongate(const Level& coarse, Level* fine) const;
+
+  /// Factorizes the system of the coarsest level.
+  void FactorizeCoarsest();
+
+  /// Solves the system of the coarsest level with the Cholesky factor.
+  void SolveCoarsest(Level* level) const;
+
+  BDM_CLASS_DEF_OVERRIDE(SteadyStateGrid, 1);
+};
+
+}  // namespace bdm
+
+#endif  // CORE_DIFFUSION_STEADY_STATE_GRID_H_
@@ -16,6 +16,8 @@
 #define CORE_ENVIRONMENT_ENVIRONMENT_H_
 
 #include <omp.h>
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <mutex>
 #include <vector>
@@ -33,6 +35,11 @@ class Environment {
   // E.g. load balancing can result in an environment that does no longer
   // describe the actual state of the simulation.
   bool out_of_sync_ = true;
+  // Flag that indicates if agents have been removed or reordered since the
+  // last update (i.e. if AgentHandles have changed).
+  bool agent_handles_changed_ = true;
+  // Flag that indicates if agents have been added since the last update.
+  bool agents_added_ = false;
 
  public:
   virtual ~Environment() = default;
@@ -41,7 +48,18 @@ class Environment {
   /// that the state of the simulation might not be reflected correctly in the
   /// current environment. For instance, the load balancing operation causes
   /// such a synchronization issue and therefore calls this member function.
-  void MarkAsOutOfSync() { out_of_sync_ = true; }
+  void MarkAsOutOfSync() {
+    out_of_sync_ = true;
+    agent_handles_changed_ = true;
+  }
+
+  /// Informs the environment that agents have been appended to the
+  /// ResourceManager. In contrast to `MarkAsOutOfSync`, the AgentHandles of
+  /// the existing agents remain valid.
+  void MarkAgentsAdded() {
+    out_of_sync_ = true;
+    agents_added_ = true;
+  }
 
   /// Updates the environment if it is marked as out_of_sync_. This function
   /// should not be called in parallel regions for performance reasons.
@@ -50,12 +68,14 @@ class Environment {
     if (out_of_sync_) {
       UpdateImplementation();
       out_of_sync_ = false;
+      agent_handles_changed_ = false;
+      agents_added_ = false;
     }
   }
 
   /// Updates the environment. Prefer Update() for implementations.
   void ForcedUpdate() {
-    MarkAsOutOfSync();
+    out_of_sync_ = true;
     Update();
   }
 
@@ -123,6 +143,14 @@ class Environment {
   bool HasGrown() const { return has_grown_; }
 
  protected:
+  /// Returns true if agents have been removed or reordered since the last
+  /// update. Can be used in `UpdateImplementation` to reuse data structures
+  /// that are indexed by AgentHandle.
+  bool HaveAgentHandlesChanged() const { return agent_handles_changed_; }
+
+  /// Returns true if agents have been added since the last update.
+  bool HaveAgentsBeenAdded() const { return agents_added_; }
+
   bool has_grown_ = false;
   /// The size of the largest object in the simulation
   real_t largest_object_size_ = 0.0;
@@ -194,6 +222,11 @@ class Environment {
       std::array<real_t, 6>* ret_grid_dimensions) {
     auto* rm = Simulation::GetActive()->GetResourceManager();
 
+    if (auto* columns = rm->GetAgentColumns()) {
+      CalcSimDimensionsAndLargestAgent(*columns, ret_grid_dimensions);
+      return;
+    }
+
     const auto max_threads = omp_get_max_threads();
     // allocate version for each thread - avoid false sharing by padding them
     // assumes 64 byte cache lines (8 * sizeof(real_t))
@@ -249,6 +282,38 @@ class Environment {
 
     largest_object_size_squared_ = largest_object_size_ * largest_object_size_;
   }
+
+  /// Same as above, but reads the agent attributes from the agent columns.
+  /// \see `Param::agent_columns`
+  void CalcSimDimensionsAndLargestAgent(
+      const AgentColumns& columns, std::array<real_t, 6>* ret_grid_dimensions) {
+    auto& dim = *ret_grid_dimensions;
+    real_t xmin = dim[0], xmax = dim[1];
+    real_t ymin = dim[2], ymax = dim[3];
+    real_t zmin = dim[4], zmax = dim[5];
+    real_t largest = largest_object_size_;
+    for (uint64_t n = 0; n < columns.GetNumNumaNodes(); ++n) {
+      const auto* x = columns.GetX(n);
+      const auto* y = columns.GetY(n);
+      const auto* z = columns.GetZ(n);
+      const auto* diameter = columns.GetDiameter(n);
+      const auto size = columns.GetNumAgents(n);
+#pragma omp parallel for simd reduction(min : xmin, ymin, zmin) \
+    reduction(max : xmax, ymax, zmax, largest)
+      for (uint64_t i = 0; i < size; ++i) {
+        xmin = std::min(xmin, x[i]);
+        xmax = std::max(xmax, x[i]);
+        ymin = std::min(ymin, y[i]);
+        ymax = std::max(ymax, y[i]);
+        zmin = std::min(zmin, z[i]);
+        zmax = std::max(zmax, z[i]);
+        largest = std::max(largest, diameter[i]);
+      }
+    }
+    dim = {xmin, xmax, ymin, ymax, zmin, zmax};
+    largest_object_size_ = largest;
+    largest_object_size_squared_ = largest_object_size_ * largest_object_size_;
+  }
 };
 
 }  // namespace bdm
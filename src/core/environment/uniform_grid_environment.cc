@@ -14,7 +14,12 @@
 
 #include "core/environment/uniform_grid_environment.h"
 #include <morton/morton.h>  // NOLINT
+#include <algorithm>
+#include <utility>
+#include <vector>
 #include "core/algorithm.h"
+#include "core/util/profiler.h"
+#include "core/util/thread_info.h"
 
 namespace bdm {
 
@@ -34,9 +39,16 @@ void UniformGridEnvironment::LoadBalanceInfoUG::Update() {
 
   mo_.Update(grid_->num_boxes_axis_);
 
+  auto* agent_costs =
+      Simulation::GetActive()->GetResourceManager()->GetAgentCosts();
+  has_costs_ = agent_costs && agent_costs->HasCosts();
+
   AllocateMemory();
   InitializeVectors();
   InPlaceParallelPrefixSum(cummulated_agents_, grid_->total_num_boxes_);
+  if (has_costs_) {
+    InPlaceParallelPrefixSum(cummulated_costs_, grid_->total_num_boxes_);
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -47,6 +59,9 @@ void UniformGridEnvironment::LoadBalanceInfoUG::AllocateMemory() {
   if (cummulated_agents_.capacity() < grid_->boxes_.size()) {
     cummulated_agents_.reserve(grid_->boxes_.capacity());
   }
+  if (has_costs_ && cummulated_costs_.capacity() < grid_->boxes_.size()) {
+    cummulated_costs_.reserve(grid_->boxes_.capacity());
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -62,7 +77,12 @@ void UniformGridEnvironment::LoadBalanceInfoUG::InitializeVectors() {
     auto start = tid * chunk;
     auto end = std::min(grid_->total_num_boxes_, start + chunk);
 
-    InitializeVectorFunctor f(grid_, start, sorted_boxes_, cummulated_agents_);
+    auto* agent_costs =
+        has_costs_
+            ? Simulation::GetActive()->GetResourceManager()->GetAgentCosts()
+            : nullptr;
+    InitializeVectorFunctor f(grid_, start, sorted_boxes_, cummulated_agents_,
+                              cummulated_costs_, agent_costs);
     mo_.CallMortonIteratorConsumer(start, end - 1, f);
   }
 }
@@ -110,13 +130,27 @@ struct AgentHandleIterator : public Iterator<AgentHandle> {
 // -----------------------------------------------------------------------------
 
 void UniformGridEnvironment::UpdateImplementation() {
+  BDM_PROFILE_SCOPE("UniformGridEnvironment::Update");
   auto* rm = Simulation::GetActive()->GetResourceManager();
 
   if (rm->GetNumAgents() != 0) {
+    auto* param = Simulation::GetActive()->GetParam();
+    // Keep the current grid and Verlet lists if they are still valid
+    if (verlet_valid_ && !HaveAgentHandlesChanged() &&
+        !HaveAgentsBeenAdded() &&
+        !IsVerletRebuildRequired(param->verlet_skin)) {
+      has_grown_ = false;
+      return;
+    }
+
+    if (param->uniform_grid_incremental_update && UpdateIncrementally()) {
+      UpdateDerivedDataStructures();
+      return;
+    }
+
     Clear();
     timestamp_++;
 
-    auto* param = Simulation::GetActive()->GetParam();
     if (determine_sim_size_) {
       auto inf = Math::kInfinity;
       std::array<real_t, 6> tmp_dim = {{inf, -inf, inf, -inf, inf, -inf}};
@@ -131,10 +165,18 @@ void UniformGridEnvironment::UpdateImplementation() {
       grid_dimensions_[5] = static_cast<int>(ceil(param->max_bound));
     }
 
+    largest_small_agent_size_ = GetLargestAgentSize();
+    if (param->uniform_grid_large_agent_factor > 0 && adjacency_ == kHigh &&
+        param->verlet_skin <= 0 && !is_custom_box_length_ &&
+        determine_sim_size_) {
+      DetermineSizeClasses(param->uniform_grid_large_agent_factor);
+    }
+
     // If the box_length_ is not set manually, we set it to the largest agent
-    // size
+    // size (of the small size class) plus the Verlet skin
     if (!is_custom_box_length_ && determine_sim_size_) {
-      auto los = ceil(GetLargestAgentSize());
+      auto los = ceil(largest_small_agent_size_ +
+                      std::max<real_t>(param->verlet_skin, 0));
       assert(los > 0 &&
              "The largest object size was found to be 0. Please check if your "
              "cells are correctly initialized.");
@@ -199,8 +241,12 @@ void UniformGridEnvironment::UpdateImplementation() {
     successors_.reserve();
 
     // Assign agents to boxes
-    AssignToBoxesFunctor functor(this);
-    rm->ForEachAgentParallel(param->scheduling_batch_size, functor);
+    if (auto* columns = rm->GetAgentColumns()) {
+      AssignToBoxes(columns);
+    } else {
+      AssignToBoxesFunctor functor(this);
+      rm->ForEachAgentParallel(param->scheduling_batch_size, functor);
+    }
     if (param->bound_space) {
       int min = param->min_bound;
       int max = param->max_bound;
@@ -211,7 +257,11 @@ void UniformGridEnvironment::UpdateImplementation() {
         Param::ThreadSafetyMechanism::kAutomatic) {
       nb_mutex_builder_->Update();
     }
+
+    UpdateDerivedDataStructures();
   } else {
+    cell_list_valid_ = false;
+    size_classes_ = false;
     // There are no agents in this simulation
     auto* param = Simulation::GetActive()->GetParam();
 
@@ -242,6 +292,372 @@ void UniformGridEnvironment::UpdateImplementation() {
   }
 }
 
+// -----------------------------------------------------------------------------
+bool UniformGridEnvironment::UpdateIncrementally() {
+  BDM_PROFILE_SCOPE("UniformGridEnvironment::UpdateIncrementally");
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto* param = Simulation::GetActive()->GetParam();
+
+  // AgentHandles of existing agents must still be valid and agents must not
+  // be reclassified into size classes.
+  if (timestamp_ == 0 || total_num_boxes_ == 0 || HaveAgentHandlesChanged() ||
+      !determine_sim_size_ || param->uniform_grid_large_agent_factor > 0) {
+    return false;
+  }
+
+  auto inf = Math::kInfinity;
+  std::array<real_t, 6> dim = {{inf, -inf, inf, -inf, inf, -inf}};
+  CalcSimDimensionsAndLargestAgent(&dim);
+  // Fall back to a full rebuild if the boxes became too small, or if the
+  // agents left the inner grid (excluding the padding boxes)
+  if (!is_custom_box_length_ &&
+      ceil(GetLargestAgentSize() + std::max<real_t>(param->verlet_skin, 0)) >
+          box_length_) {
+    return false;
+  }
+  for (int i = 0; i < 3; i++) {
+    if (dim[2 * i] < grid_dimensions_[2 * i] + box_length_ ||
+        dim[2 * i + 1] >= grid_dimensions_[2 * i + 1] - box_length_) {
+      return false;
+    }
+  }
+
+  cell_list_valid_ = false;
+  verlet_valid_ = false;
+  has_grown_ = false;
+  successors_.grow();
+
+  if (auto* columns = rm->GetAgentColumns()) {
+    RelocateAgents(columns);
+    return true;
+  }
+
+  // Only relink agents that changed their box and insert new agents.
+  // New agents have been appended to the ResourceManager and might have
+  // copied the box index of the agent that created them.
+  auto relocate = L2F([&](Agent* agent, AgentHandle ah) {
+    auto idx = GetBoxIndex(agent->GetPosition());
+    if (ah.GetElementIdx() >= last_num_agents_[ah.GetNumaNode()]) {
+      boxes_[idx].AddObject(ah, &successors_, this);
+    } else if (idx != agent->GetBoxIdx()) {
+      boxes_[agent->GetBoxIdx()].RemoveObject(ah, &successors_);
+      boxes_[idx].AddObject(ah, &successors_, this);
+    } else {
+      return;
+    }
+    assert(idx <= std::numeric_limits<uint32_t>::max());
+    agent->SetBoxIdx(static_cast<uint32_t>(idx));
+  });
+  rm->ForEachAgentParallel(param->scheduling_batch_size, relocate);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::AssignToBoxes(AgentColumns* columns) {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  for (AgentHandle::NumaNode_t n = 0; n < columns->GetNumNumaNodes(); ++n) {
+    const auto* x = columns->GetX(n);
+    const auto* y = columns->GetY(n);
+    const auto* z = columns->GetZ(n);
+    const AgentHandle::ElementIdx_t size = columns->GetNumAgents(n);
+#pragma omp parallel for schedule(static, 4096)
+    for (AgentHandle::ElementIdx_t i = 0; i < size; ++i) {
+      auto idx = GetBoxIndex(Real3{x[i], y[i], z[i]});
+      assert(idx <= std::numeric_limits<uint32_t>::max());
+      AgentHandle ah(n, i);
+      boxes_[idx].AddObject(ah, &successors_, this);
+      columns->SetBoxIdx(ah, static_cast<uint32_t>(idx));
+      rm->GetAgent(ah)->SetBoxIdx(static_cast<uint32_t>(idx));
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::RelocateAgents(AgentColumns* columns) {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  for (AgentHandle::NumaNode_t n = 0; n < columns->GetNumNumaNodes(); ++n) {
+    const auto* x = columns->GetX(n);
+    const auto* y = columns->GetY(n);
+    const auto* z = columns->GetZ(n);
+    const auto* box_idx = columns->GetBoxIdx(n);
+    const AgentHandle::ElementIdx_t size = columns->GetNumAgents(n);
+    AgentHandle::ElementIdx_t num_old = 0;
+    if (n < last_num_agents_.size()) {
+      num_old = last_num_agents_[n];
+    }
+#pragma omp parallel for schedule(static, 4096)
+    for (AgentHandle::ElementIdx_t i = 0; i < size; ++i) {
+      auto idx = GetBoxIndex(Real3{x[i], y[i], z[i]});
+      AgentHandle ah(n, i);
+      // New agents have been appended to the ResourceManager and might have
+      // copied the box index of the agent that created them.
+      if (i >= num_old) {
+        boxes_[idx].AddObject(ah, &successors_, this);
+      } else if (idx != box_idx[i]) {
+        boxes_[box_idx[i]].RemoveObject(ah, &successors_);
+        boxes_[idx].AddObject(ah, &successors_, this);
+      } else {
+        continue;
+      }
+      assert(idx <= std::numeric_limits<uint32_t>::max());
+      columns->SetBoxIdx(ah, static_cast<uint32_t>(idx));
+      rm->GetAgent(ah)->SetBoxIdx(static_cast<uint32_t>(idx));
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::UpdateDerivedDataStructures() {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto* param = Simulation::GetActive()->GetParam();
+
+  if (param->deterministic) {
+    SortBoxes();
+  }
+
+  auto num_numa_nodes = ThreadInfo::GetInstance()->GetNumaNodes();
+  last_num_agents_.resize(num_numa_nodes);
+  for (int n = 0; n < num_numa_nodes; ++n) {
+    last_num_agents_[n] = rm->GetNumAgents(n);
+  }
+
+  if ((param->uniform_grid_cell_list || size_classes_) &&
+      adjacency_ == kHigh) {
+    UpdateCellList();
+  }
+  if (param->verlet_skin > 0 && adjacency_ == kHigh) {
+    UpdateVerletLists(param->verlet_skin);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::SortBoxes() {
+  BDM_PROFILE_SCOPE("UniformGridEnvironment::SortBoxes");
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+#pragma omp parallel
+  {
+    std::vector<std::pair<uint64_t, AgentHandle>> sorted;
+#pragma omp for schedule(dynamic, 1024)
+    for (uint64_t i = 0; i < total_num_boxes_; ++i) {
+      auto& box = boxes_[i];
+      if (box.Size(timestamp_) < 2) {
+        continue;
+      }
+      sorted.clear();
+      for (Box::Iterator it(this, &box); !it.IsAtEnd(); ++it) {
+        sorted.emplace_back(rm->GetAgent(*it)->GetCanonicalKey(), *it);
+      }
+      std::sort(sorted.begin(), sorted.end(),
+                [](const std::pair<uint64_t, AgentHandle>& a,
+                   const std::pair<uint64_t, AgentHandle>& b) {
+                  return a.first < b.first;
+                });
+      box.start_ = sorted[0].second;
+      for (uint64_t j = 1; j < sorted.size(); ++j) {
+        successors_[sorted[j - 1].second] = sorted[j].second;
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::UpdateCellList() {
+  BDM_PROFILE_SCOPE("UniformGridEnvironment::UpdateCellList");
+  SortAgentsByBox(&cl_box_start_, &cl_agents_, &cl_handles_);
+
+  auto num_agents = cl_box_start_[total_num_boxes_];
+  cl_diameter_.resize(num_agents);
+#pragma omp parallel for
+  for (uint64_t i = 0; i < num_agents; ++i) {
+    cl_diameter_[i] = cl_agents_[i]->GetDiameter();
+  }
+
+  cl_large_.clear();
+  if (size_classes_) {
+#pragma omp parallel
+    {
+      std::vector<uint64_t> large;
+#pragma omp for nowait
+      for (uint64_t i = 0; i < num_agents; ++i) {
+        if (cl_diameter_[i] > largest_small_agent_size_) {
+          large.push_back(i);
+        }
+      }
+#pragma omp critical
+      cl_large_.insert(cl_large_.end(), large.begin(), large.end());
+    }
+    // The threads append in arbitrary order
+    std::sort(cl_large_.begin(), cl_large_.end());
+  }
+  cell_list_valid_ = true;
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::SortAgentsByBox(
+    ParallelResizeVector<uint64_t>* box_start,
+    ParallelResizeVector<Agent*>* agents,
+    ParallelResizeVector<AgentHandle>* handles) {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+
+  // Counting sort: determine the number of agents per box and convert it
+  // into the start offset of each box with a prefix sum.
+  box_start->resize(total_num_boxes_ + 1);
+  (*box_start)[0] = 0;
+#pragma omp parallel for
+  for (uint64_t i = 0; i < total_num_boxes_; ++i) {
+    (*box_start)[i + 1] = boxes_[i].Size(timestamp_);
+  }
+  InPlaceParallelPrefixSum(*box_start, total_num_boxes_ + 1);
+
+  auto num_agents = (*box_start)[total_num_boxes_];
+  agents->resize(num_agents);
+  if (handles != nullptr) {
+    handles->resize(num_agents);
+  }
+
+  // Most boxes are empty or contain only a few agents -> dynamic scheduling
+#pragma omp parallel for schedule(dynamic, 1024)
+  for (uint64_t i = 0; i < total_num_boxes_; ++i) {
+    auto offset = (*box_start)[i];
+    for (auto it = boxes_[i].begin(this); !it.IsAtEnd(); ++it) {
+      auto ah = *it;
+      (*agents)[offset] = rm->GetAgent(ah);
+      if (handles != nullptr) {
+        (*handles)[offset] = ah;
+      }
+      offset++;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::UpdateVerletLists(real_t skin) {
+  BDM_PROFILE_SCOPE("UniformGridEnvironment::UpdateVerletLists");
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto num_numa_nodes = ThreadInfo::GetInstance()->GetNumaNodes();
+  verlet_offset_.resize(num_numa_nodes + 1);
+  verlet_offset_[0] = 0;
+  for (int n = 0; n < num_numa_nodes; ++n) {
+    verlet_offset_[n + 1] = verlet_offset_[n] + rm->GetNumAgents(n);
+  }
+  auto num_agents = verlet_offset_[num_numa_nodes];
+  verlet_start_.resize(num_agents + 1);
+  verlet_start_[0] = 0;
+  verlet_position_.resize(num_agents);
+
+  // Two passes: count the neighbors of each agent, determine the start
+  // offsets, and fill in the neighbors.
+  const real_t squared_radius = box_length_squared_;
+  auto count = L2F([&](Agent* agent, AgentHandle ah) {
+    auto idx = verlet_offset_[ah.GetNumaNode()] + ah.GetElementIdx();
+    uint64_t num_neighbors = 0;
+    auto count_neighbors = L2F([&](Agent*, real_t) { num_neighbors++; });
+    ForEachNeighbor(count_neighbors, *agent, squared_radius);
+    verlet_start_[idx + 1] = num_neighbors;
+    verlet_position_[idx] = agent->GetPosition();
+  });
+  rm->ForEachAgentParallel(1000, count);
+  InPlaceParallelPrefixSum(verlet_start_, num_agents + 1);
+
+  verlet_neighbors_.resize(verlet_start_[num_agents]);
+  auto fill = L2F([&](Agent* agent, AgentHandle ah) {
+    auto idx = verlet_offset_[ah.GetNumaNode()] + ah.GetElementIdx();
+    auto offset = verlet_start_[idx];
+    auto fill_neighbors = L2F([&](Agent* neighbor, real_t) {
+      verlet_neighbors_[offset++] = neighbor;
+    });
+    ForEachNeighbor(fill_neighbors, *agent, squared_radius);
+  });
+  rm->ForEachAgentParallel(1000, fill);
+
+  real_t radius = std::max<real_t>(box_length_ - skin, 0);
+  verlet_squared_radius_ = radius * radius;
+  verlet_valid_ = true;
+}
+
+// -----------------------------------------------------------------------------
+bool UniformGridEnvironment::IsVerletRebuildRequired(real_t skin) {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  const real_t max_squared_displacement = skin * skin / 4;
+  const auto max_threads = omp_get_max_threads();
+  // padded to avoid false sharing (assumes 64 byte cache lines)
+  std::vector<std::array<real_t, 8>> displacement(max_threads, {{0}});
+  std::vector<std::array<real_t, 8>> largest(max_threads, {{0}});
+  auto check = L2F([&](Agent* agent, AgentHandle ah) {
+    auto tid = omp_get_thread_num();
+    auto idx = verlet_offset_[ah.GetNumaNode()] + ah.GetElementIdx();
+    auto squared_displacement =
+        SquaredEuclideanDistance(verlet_position_[idx], agent->GetPosition());
+    if (squared_displacement > displacement[tid][0]) {
+      displacement[tid][0] = squared_displacement;
+    }
+    auto diameter = agent->GetDiameter();
+    if (diameter > largest[tid][0]) {
+      largest[tid][0] = diameter;
+    }
+  });
+  rm->ForEachAgentParallel(1000, check);
+
+  real_t max_displacement = 0;
+  real_t largest_agent = 0;
+  for (int tid = 0; tid < max_threads; tid++) {
+    max_displacement = std::max(max_displacement, displacement[tid][0]);
+    largest_agent = std::max(largest_agent, largest[tid][0]);
+  }
+  if (max_displacement > max_squared_displacement ||
+      largest_agent > box_length_ - skin) {
+    return true;
+  }
+  // Agents might have grown since the last build
+  if (determine_sim_size_) {
+    largest_object_size_ = largest_agent;
+    largest_object_size_squared_ = largest_agent * largest_agent;
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::DetermineSizeClasses(real_t factor) {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  const auto max_threads = omp_get_max_threads();
+  // padded to avoid false sharing (assumes 64 byte cache lines)
+  std::vector<std::array<real_t, 8>> sum(max_threads, {{0}});
+  auto sum_diameters = L2F([&](Agent* agent, AgentHandle) {
+    sum[omp_get_thread_num()][0] += agent->GetDiameter();
+  });
+  rm->ForEachAgentParallel(1000, sum_diameters);
+
+  real_t total = 0;
+  for (int tid = 0; tid < max_threads; tid++) {
+    total += sum[tid][0];
+  }
+  const real_t threshold = factor * total / rm->GetNumAgents();
+  if (GetLargestAgentSize() <= threshold) {
+    return;
+  }
+
+  std::vector<std::array<real_t, 8>> largest(max_threads, {{0}});
+  auto largest_small = L2F([&](Agent* agent, AgentHandle) {
+    auto diameter = agent->GetDiameter();
+    auto& current = largest[omp_get_thread_num()][0];
+    if (diameter <= threshold && diameter > current) {
+      current = diameter;
+    }
+  });
+  rm->ForEachAgentParallel(1000, largest_small);
+
+  real_t largest_small_agent = 0;
+  for (int tid = 0; tid < max_threads; tid++) {
+    largest_small_agent = std::max(largest_small_agent, largest[tid][0]);
+  }
+  // factor < 1 might put all agents into the large class
+  if (largest_small_agent == 0) {
+    return;
+  }
+  largest_small_agent_size_ = largest_small_agent;
+  size_classes_ = true;
+}
+
 // -----------------------------------------------------------------------------
 void UniformGridEnvironment::LoadBalanceInfoUG::CallHandleIteratorConsumer(
     uint64_t start, uint64_t end,
@@ -257,15 +673,49 @@ void UniformGridEnvironment::LoadBalanceInfoUG::CallHandleIteratorConsumer(
   f(&it);
 }
 
+// -----------------------------------------------------------------------------
+real_t UniformGridEnvironment::LoadBalanceInfoUG::GetTotalCost() const {
+  if (!has_costs_ || grid_->total_num_boxes_ == 0) {
+    return 0;
+  }
+  return cummulated_costs_[grid_->total_num_boxes_ - 1];
+}
+
+// -----------------------------------------------------------------------------
+uint64_t UniformGridEnvironment::LoadBalanceInfoUG::GetNumAgentsBelowCost(
+    real_t cost) const {
+  if (!has_costs_ || grid_->total_num_boxes_ == 0) {
+    return 0;
+  }
+  // Agents of the same box are not split. Therefore, find the box boundary
+  // that is closest to `cost`.
+  const auto* begin = cummulated_costs_.data();
+  const auto* end = begin + grid_->total_num_boxes_;
+  auto box = std::lower_bound(begin, end, cost) - begin;
+  if (box == static_cast<int64_t>(grid_->total_num_boxes_)) {
+    return cummulated_agents_[box - 1];
+  }
+  real_t previous_cost = box != 0 ? cummulated_costs_[box - 1] : 0;
+  uint64_t previous_agents = box != 0 ? cummulated_agents_[box - 1] : 0;
+  if (cost - previous_cost < cummulated_costs_[box] - cost) {
+    return previous_agents;
+  }
+  return cummulated_agents_[box];
+}
+
 // -----------------------------------------------------------------------------
 UniformGridEnvironment::LoadBalanceInfoUG::InitializeVectorFunctor::
     InitializeVectorFunctor(UniformGridEnvironment* grid, uint64_t start,
                             decltype(sorted_boxes) sorted_boxes,
-                            decltype(cummulated_agents) cummulated_agents)
+                            decltype(cummulated_agents) cummulated_agents,
+                            decltype(cummulated_costs) cummulated_costs,
+                            const AgentCosts* agent_costs)
     : grid(grid),
       start(start),
       sorted_boxes(sorted_boxes),
-      cummulated_agents(cummulated_agents) {}
+      cummulated_agents(cummulated_agents),
+      cummulated_costs(cummulated_costs),
+      agent_costs(agent_costs) {}
 
 // -----------------------------------------------------------------------------
 UniformGridEnvironment::LoadBalanceInfoUG::InitializeVectorFunctor::
@@ -283,10 +733,54 @@ operator()(Iterator<uint64_t>* it) {
         static_cast<uint64_t>(z)}));
     sorted_boxes[start] = box;
     cummulated_agents[start] = box->Size(grid->timestamp_);
+    if (agent_costs) {
+      real_t cost = 0;
+      for (Box::Iterator bit(grid, box); !bit.IsAtEnd(); ++bit) {
+        cost += agent_costs->GetCost(*bit);
+      }
+      cummulated_costs[start] = cost;
+    }
     start++;
   }
 }
 
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::ForEachAgentByBoxColor(
+    Functor<void, Agent*, AgentHandle>& functor,
+    Functor<bool, Agent*>* filter) {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  const auto nx = num_boxes_axis_[0];
+  const auto ny = num_boxes_axis_[1];
+  const auto nz = num_boxes_axis_[2];
+  // The scopes of the worker threads are recorded below the scope of the
+  // calling thread (e.g. "agent ops")
+  const auto profile_path = ProfilePathScope::GetPath();
+  for (uint64_t color = 0; color < 27; ++color) {
+    const uint64_t cx = color % 3;
+    const uint64_t cy = (color / 3) % 3;
+    const uint64_t cz = color / 9;
+#pragma omp parallel
+    {
+      ProfilePathScope profile_scope(profile_path);
+#pragma omp for collapse(2) schedule(dynamic, 1)
+      for (uint64_t z = cz; z < nz; z += 3) {
+        for (uint64_t y = cy; y < ny; y += 3) {
+          for (uint64_t x = cx; x < nx; x += 3) {
+            const auto& box = boxes_[x + y * nx + z * num_boxes_xy_];
+            for (Box::Iterator it(this, &box); !it.IsAtEnd(); ++it) {
+              auto ah = *it;
+              auto* agent = rm->GetAgent(ah);
+              if (!filter || (*filter)(agent)) {
+                functor(agent, ah);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 using NeighborMutex = Environment::NeighborMutexBuilder::NeighborMutex;
 using GridNeighborMutexBuilder =
@@ -303,12 +797,80 @@ NeighborMutex* GridNeighborMutexBuilder::GetMutex(uint64_t box_idx) {
   return mutex;
 }
 
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::ForEachNeighborHandle(
+    Functor<void, AgentHandle, real_t>& lambda, const Agent& query,
+    real_t squared_radius) {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  if (verlet_valid_) {
+    auto for_each = L2F([&](Agent* neighbor, real_t squared_distance) {
+      lambda(rm->GetAgentHandle(neighbor->GetUid()), squared_distance);
+    });
+    if (ForEachNeighborInVerletList(for_each, query, squared_radius)) {
+      return;
+    }
+  }
+  const auto& position = query.GetPosition();
+  uint32_t idx;
+  if (!GetQueryBoxIdx(position, squared_radius, &query, &idx)) {
+    return;
+  }
+  ForEachNeighborInBoxes(
+      [&](AgentHandle ah, Agent*, real_t squared_distance) {
+        lambda(ah, squared_distance);
+      },
+      position, squared_radius, idx, &query);
+}
+
 // -----------------------------------------------------------------------------
 void UniformGridEnvironment::ForEachNeighbor(Functor<void, Agent*>& functor,
                                              const Agent& query,
                                              void* criteria) {
   auto idx = query.GetBoxIdx();
 
+  if (cell_list_valid_) {
+    const auto nx = static_cast<int64_t>(num_boxes_axis_[0]);
+    const auto nxy = static_cast<int64_t>(num_boxes_xy_);
+    std::array<std::pair<uint64_t, uint64_t>, 9> ranges;
+    for (int64_t oz = -1; oz <= 1; ++oz) {
+      for (int64_t oy = -1; oy <= 1; ++oy) {
+        auto center = static_cast<int64_t>(idx) + oz * nxy + oy * nx;
+        auto& range = ranges[(oz + 1) * 3 + oy + 1];
+        range = {cl_box_start_[center - 1], cl_box_start_[center + 2]};
+        for (uint64_t i = range.first; i < range.second; ++i) {
+          if (cl_agents_[i] != &query) {
+            functor(cl_agents_[i]);
+          }
+        }
+      }
+    }
+    if (!size_classes_) {
+      return;
+    }
+    // Large agents outside the surrounding boxes are neighbors if they are
+    // within the box length plus their additional reach (same criterion as
+    // `ForEachNeighborInCellList`).
+    const auto& position = query.GetPosition();
+    const auto* columns =
+        Simulation::GetActive()->GetResourceManager()->GetAgentColumns();
+    for (auto i : cl_large_) {
+      bool processed = false;
+      for (auto& range : ranges) {
+        processed = processed || (i >= range.first && i < range.second);
+      }
+      if (processed || cl_agents_[i] == &query) {
+        continue;
+      }
+      const auto diff = GetCellListPosition(columns, i) - position;
+      const real_t r =
+          box_length_ + (cl_diameter_[i] - largest_small_agent_size_) / 2;
+      if (diff * diff < r * r) {
+        functor(cl_agents_[i]);
+      }
+    }
+    return;
+  }
+
   FixedSizeVector<const Box*, 27> neighbor_boxes;
   GetMooreBoxes(&neighbor_boxes, idx);
 
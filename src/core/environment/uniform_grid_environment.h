@@ -46,6 +46,7 @@
 #include "core/param/param.h"
 #include "core/resource_manager.h"
 #include "core/util/log.h"
+#include "core/util/math.h"
 #include "core/util/spinlock.h"
 
 namespace bdm {
@@ -62,6 +63,8 @@ class UniformGridEnvironment : public Environment {
   friend struct MechanicalForcesOpCuda;
   friend struct ::bdm::detail::InitializeGPUData;
   friend struct MechanicalForcesOpOpenCL;
+  friend struct MechanicalForcesOpSimd;
+  friend class PairwiseMechanicalForcesOp;
   friend class SchedulerTest;
 
  public:
@@ -125,6 +128,31 @@ class UniformGridEnvironment : public Environment {
       }
     }
 
+    /// @brief      Removes an agent from this box
+    ///
+    /// Traverses the linked list to find the predecessor of `ah`.
+    void RemoveObject(AgentHandle ah, AgentVector<AgentHandle>* successors) {
+      std::lock_guard<Spinlock> lock_guard(lock_);
+      if (length_ == 0) {
+        return;
+      }
+      if (start_ == ah) {
+        start_ = (*successors)[ah];
+        length_--;
+        return;
+      }
+      auto current = start_;
+      for (uint16_t i = 1; i < length_; ++i) {
+        auto next = (*successors)[current];
+        if (next == ah) {
+          (*successors)[current] = (*successors)[ah];
+          length_--;
+          return;
+        }
+        current = next;
+      }
+    }
+
     /// An iterator that iterates over the cells in this box
     struct Iterator {
       Iterator(UniformGridEnvironment* grid, const Box* box)
@@ -252,6 +280,9 @@ class UniformGridEnvironment : public Environment {
     threshold_dimensions_ = {inf, -inf};
     successors_.clear();
     has_grown_ = false;
+    cell_list_valid_ = false;
+    size_classes_ = false;
+    verlet_valid_ = false;
   }
 
   struct AssignToBoxesFunctor : public Functor<void, Agent*, AgentHandle> {
@@ -279,6 +310,14 @@ class UniformGridEnvironment : public Environment {
 
   int32_t GetBoxLength() const { return box_length_; }
 
+  /// Returns true if the agents are split into a small and a large size
+  /// class. \see `Param::uniform_grid_large_agent_factor`
+  bool UsesSizeClasses() const { return size_classes_; }
+
+  /// Returns the diameter of the largest agent in the small size class.
+  /// Equals `GetLargestAgentSize()` if size classes are not used.
+  real_t GetLargestSmallAgentSize() const { return largest_small_agent_size_; }
+
   /// @brief      Calculates the squared euclidean distance between two points
   ///             in 3D
   ///
@@ -393,6 +432,19 @@ class UniformGridEnvironment : public Environment {
     return box_coord;
   }
 
+  /// Calls `functor` in parallel for all agents (for which `filter` returns
+  /// true). Agents are never processed concurrently if their boxes share
+  /// neighbor boxes. The boxes are partitioned into 27 colors by their box
+  /// coordinates modulo three. The boxes of the same color are at least
+  /// three boxes apart and are processed in parallel, one color after the
+  /// other.\n
+  /// Like `kAutomatic`, this only protects the neighbors in the surrounding
+  /// boxes (e.g. not the large agents of
+  /// `Param::uniform_grid_large_agent_factor`).
+  /// \see `Param::ThreadSafetyMechanism::kBoxColoring`
+  void ForEachAgentByBoxColor(Functor<void, Agent*, AgentHandle>& functor,
+                              Functor<bool, Agent*>* filter = nullptr);
+
   /// @brief      Applies the given lambda to each neighbor of the specified
   ///             agent is within the squared radius.
   ///
@@ -405,6 +457,10 @@ class UniformGridEnvironment : public Environment {
   ///
   void ForEachNeighbor(Functor<void, Agent*, real_t>& lambda,
                        const Agent& query, real_t squared_radius) override {
+    if (verlet_valid_ &&
+        ForEachNeighborInVerletList(lambda, query, squared_radius)) {
+      return;
+    }
     ForEachNeighbor(lambda, query.GetPosition(), squared_radius, &query);
   }
 
@@ -421,102 +477,24 @@ class UniformGridEnvironment : public Environment {
   void ForEachNeighbor(Functor<void, Agent*, real_t>& lambda,
                        const Real3& query_position, real_t squared_radius,
                        const Agent* query_agent = nullptr) override {
-    if (squared_radius > box_length_squared_) {
-      Log::Fatal(
-          "UniformGridEnvironment::ForEachNeighbor",
-          "The requested search radius (", std::sqrt(squared_radius), ")",
-          " of the neighborhood search exceeds the "
-          "box length (",
-          box_length_, "). The resulting neighborhood would be incomplete.");
-    }
-    const auto& position = query_position;
-    // Use uint32_t for compatibility with Agent::GetBoxIdx();
-    uint32_t idx{std::numeric_limits<uint32_t>::max()};
-    if (query_agent != nullptr) {
-      idx = query_agent->GetBoxIdx();
-    }
-    // If the point is not inside the inner grid (excluding the bounding boxes)
-    // as well as there was no previous box index assigned to the agent, we
-    // cannot reliably detect the neighbors and warn the user.
-    if (!ContainedInGrid(query_position) &&
-        idx == std::numeric_limits<uint32_t>::max()) {
-      Log::Warning(
-          "UniformGridEnvironment::ForEachNeighbor",
-          "You provided a query_position that is outside of the environment. ",
-          "Neighbor search is not supported in this case. \n",
-          "query_position: ", query_position,
-          "\ngrid_dimensions: ", grid_dimensions_[0] + box_length_, ", ",
-          grid_dimensions_[1] - box_length_, ", ",
-          grid_dimensions_[2] + box_length_, ", ",
-          grid_dimensions_[3] - box_length_, ", ",
-          grid_dimensions_[4] + box_length_, ", ",
-          grid_dimensions_[5] - box_length_);
+    uint32_t idx;
+    if (!GetQueryBoxIdx(query_position, squared_radius, query_agent, &idx)) {
       return;
     }
-    // Freshly created agents are initialized with the largest uint32_t number
-    // available. The above line assumes that the agent has already been located
-    // in the grid, but this assumption does not hold for new agents. Hence, for
-    // new agents, we manually compute the box index. This is also necessary if
-    // we want to find the neighbors of a arbitrary 3D coordinate rather than
-    // the neighbors of an agent.
-    if (idx == std::numeric_limits<uint32_t>::max()) {
-      size_t idx_tmp = GetBoxIndex(position);
-      // Check if conversion can be done without losing information
-      assert(idx_tmp <= std::numeric_limits<uint32_t>::max());
-      idx = static_cast<uint32_t>(idx_tmp);
-    }
-
-    FixedSizeVector<const Box*, 27> neighbor_boxes;
-    GetMooreBoxes(&neighbor_boxes, idx);
-
-    auto* rm = Simulation::GetActive()->GetResourceManager();
-
-    NeighborIterator ni(this, neighbor_boxes, timestamp_);
-    const unsigned batch_size = 64;
-    uint64_t size = 0;
-    Agent* agents[batch_size] __attribute__((aligned(64)));
-    real_t x[batch_size] __attribute__((aligned(64)));
-    real_t y[batch_size] __attribute__((aligned(64)));
-    real_t z[batch_size] __attribute__((aligned(64)));
-    real_t squared_distance[batch_size] __attribute__((aligned(64)));
-
-    auto process_batch = [&]() {
-#pragma omp simd
-      for (uint64_t i = 0; i < size; ++i) {
-        const real_t dx = x[i] - position[0];
-        const real_t dy = y[i] - position[1];
-        const real_t dz = z[i] - position[2];
-
-        squared_distance[i] = dx * dx + dy * dy + dz * dz;
-      }
+    ForEachNeighborInBoxes(
+        [&](AgentHandle, Agent* agent, real_t squared_distance) {
+          lambda(agent, squared_distance);
+        },
+        query_position, squared_radius, idx, query_agent);
+  }
 
-      for (uint64_t i = 0; i < size; ++i) {
-        if (squared_distance[i] < squared_radius) {
-          lambda(agents[i], squared_distance[i]);
-        }
-      }
-      size = 0;
-    };
-
-    while (!ni.IsAtEnd()) {
-      auto ah = *ni;
-      // increment iterator already here to hide memory latency
-      ++ni;
-      auto* agent = rm->GetAgent(ah);
-      if (agent != query_agent) {
-        agents[size] = agent;
-        const auto& pos = agent->GetPosition();
-        x[size] = pos[0];
-        y[size] = pos[1];
-        z[size] = pos[2];
-        size++;
-        if (size == batch_size) {
-          process_batch();
-        }
-      }
-    }
-    process_batch();
-  };
+  /// Like `ForEachNeighbor`, but passes the handle of each neighbor instead
+  /// of a pointer. Kernels that read the neighbor attributes from
+  /// `AgentColumns` use it to avoid accessing the neighbor objects.
+  /// If the Verlet lists are valid, the handles are looked up using the
+  /// uid of the neighbors.
+  void ForEachNeighborHandle(Functor<void, AgentHandle, real_t>& lambda,
+                             const Agent& query, real_t squared_radius);
 
   /// @brief      Applies the given functor to each neighbor of the specified
   ///             agent that is within the same box as the query agent
@@ -529,6 +507,10 @@ class UniformGridEnvironment : public Environment {
   /// @param[in]      query      The query object
   /// @param[in]      criteria   This parameter is ignored. Pass a nullptr.
   ///
+  /// Iterates over the agents in the surrounding boxes. With size classes
+  /// (`Param::uniform_grid_large_agent_factor`), large agents further away
+  /// are included if they are within the box length plus half the
+  /// difference between their diameter and the largest small agent.
   void ForEachNeighbor(Functor<void, Agent*>& functor, const Agent& query,
                        void* criteria) override;
 
@@ -624,22 +606,32 @@ class UniformGridEnvironment : public Environment {
     void CallHandleIteratorConsumer(
         uint64_t start, uint64_t end,
         Functor<void, Iterator<AgentHandle>*>& f) const override;
+    real_t GetTotalCost() const override;
+    uint64_t GetNumAgentsBelowCost(real_t cost) const override;
 
    private:
     UniformGridEnvironment* grid_;
     MortonOrder mo_;
     ParallelResizeVector<Box*> sorted_boxes_;
     ParallelResizeVector<uint64_t> cummulated_agents_;
+    /// Accumulated measured agent costs (see `AgentCosts`). Only valid if
+    /// `has_costs_` is true.
+    ParallelResizeVector<real_t> cummulated_costs_;
+    bool has_costs_ = false;
 
     struct InitializeVectorFunctor : public Functor<void, Iterator<uint64_t>*> {
       UniformGridEnvironment* grid;
       uint64_t start;
       ParallelResizeVector<Box*>& sorted_boxes;
       ParallelResizeVector<uint64_t>& cummulated_agents;
+      ParallelResizeVector<real_t>& cummulated_costs;
+      const AgentCosts* agent_costs;
 
       InitializeVectorFunctor(UniformGridEnvironment* grid, uint64_t start,
                               decltype(sorted_boxes) sorted_boxes,
-                              decltype(cummulated_agents) cummulated_agents);
+                              decltype(cummulated_agents) cummulated_agents,
+                              decltype(cummulated_costs) cummulated_costs,
+                              const AgentCosts* agent_costs);
       ~InitializeVectorFunctor() override;
 
       void operator()(Iterator<uint64_t>* it) override;
@@ -689,12 +681,373 @@ class UniformGridEnvironment : public Environment {
 
   LoadBalanceInfoUG lbi_;  //!
 
+  /// True if the cell list below reflects the current state of `boxes_`.
+  /// \see `Param::uniform_grid_cell_list`
+  bool cell_list_valid_ = false;
+  /// Cell list: the agents of box `i` are stored in the range
+  /// [`cl_box_start_[i]`, `cl_box_start_[i + 1]`) of the arrays below.
+  /// The arrays are sorted by box index (counting sort).
+  ParallelResizeVector<uint64_t> cl_box_start_;  //!
+  ParallelResizeVector<AgentHandle> cl_handles_;  //!
+  ParallelResizeVector<Agent*> cl_agents_;        //!
+  /// Diameters at the time of the last update. They determine the size
+  /// class of each agent (see `cl_large_`).
+  ParallelResizeVector<real_t> cl_diameter_;  //!
+
+  /// True if agents are split into size classes.
+  /// \see `Param::uniform_grid_large_agent_factor`
+  bool size_classes_ = false;
+  /// Agents with a larger diameter belong to the large size class
+  real_t largest_small_agent_size_ = 0;
+  /// Cell list indices of all agents in the large size class
+  std::vector<uint64_t> cl_large_;  //!
+
+  /// True if the Verlet lists below are up to date.
+  /// \see `Param::verlet_skin`
+  bool verlet_valid_ = false;
+  /// Largest squared search radius that can be answered with the Verlet lists
+  real_t verlet_squared_radius_ = 0;
+  /// Agents are identified by `verlet_offset_[numa_node] + element_idx`
+  std::vector<uint64_t> verlet_offset_;  //!
+  /// The neighbors of agent `i` are stored in the range
+  /// [`verlet_start_[i]`, `verlet_start_[i + 1]`) of `verlet_neighbors_`
+  ParallelResizeVector<uint64_t> verlet_start_;     //!
+  ParallelResizeVector<Agent*> verlet_neighbors_;  //!
+  /// Positions at the time the Verlet lists were built
+  ParallelResizeVector<Real3> verlet_position_;  //!
+
   /// Holds instance of NeighborMutexBuilder.
   /// NeighborMutexBuilder is updated if `Param::thread_safety_mechanism`
   /// is set to `kAutomatic`
   std::unique_ptr<GridNeighborMutexBuilder> nb_mutex_builder_ =
       std::make_unique<GridNeighborMutexBuilder>();
 
+  /// Number of agents per NUMA node at the time of the last update
+  std::vector<uint64_t> last_num_agents_;  //!
+
+  /// Only relinks agents that moved to a different box and inserts new
+  /// agents. Returns false if a full rebuild is required.
+  /// \see `Param::uniform_grid_incremental_update`
+  bool UpdateIncrementally();
+
+  /// Computes the box indices from the agent columns and adds all agents to
+  /// their boxes. \see `Param::agent_columns`
+  void AssignToBoxes(AgentColumns* columns);
+
+  /// Column version of the relocation step of `UpdateIncrementally`.
+  /// Only agents that moved to a different box (or are new) are accessed.
+  void RelocateAgents(AgentColumns* columns);
+
+  /// Sorts the boxes (deterministic mode) and builds the cell list and Verlet
+  /// lists (if enabled) from `boxes_`.
+  void UpdateDerivedDataStructures();
+
+  /// Orders the agents in each box by their canonical key, since the boxes
+  /// are filled in parallel. \see `Param::deterministic`
+  void SortBoxes();
+
+  /// Builds the cell list from the linked lists in `boxes_`.
+  /// \see `Param::uniform_grid_cell_list`
+  void UpdateCellList();
+
+  /// Sorts the agents by box index (counting sort): the agents of box `i` are
+  /// stored in the range [`box_start[i]`, `box_start[i + 1]`) of `agents`
+  /// (and `handles` if not null). Does not modify the cell list of the
+  /// environment; hence, operations can use it to build a private copy.
+  void SortAgentsByBox(ParallelResizeVector<uint64_t>* box_start,
+                       ParallelResizeVector<Agent*>* agents,
+                       ParallelResizeVector<AgentHandle>* handles = nullptr);
+
+  /// Builds the Verlet list of each agent. \see `Param::verlet_skin`
+  void UpdateVerletLists(real_t skin);
+
+  /// Returns true if an agent moved more than `skin / 2` since the Verlet
+  /// lists were built, or if an agent became too large for the lists.
+  /// Otherwise, updates the largest agent size.
+  bool IsVerletRebuildRequired(real_t skin);
+
+
+  void CheckVerletSearchRadius(real_t squared_radius) const {
+    if (squared_radius > verlet_squared_radius_) {
+      Log::Fatal("UniformGridEnvironment::ForEachNeighbor",
+                 "The requested search radius (", std::sqrt(squared_radius),
+                 ") exceeds the box length minus the Verlet skin (",
+                 std::sqrt(verlet_squared_radius_),
+                 "). The resulting neighborhood would be incomplete.");
+    }
+  }
+
+  /// Verlet list version of `ForEachNeighbor`.
+  /// Returns false if `query` is not part of the Verlet lists (e.g. agents
+  /// that have been created in this iteration).
+  bool ForEachNeighborInVerletList(Functor<void, Agent*, real_t>& lambda,
+                                   const Agent& query, real_t squared_radius) {
+    auto* rm = Simulation::GetActive()->GetResourceManager();
+    auto uid = query.GetUid();
+    if (!rm->ContainsAgent(uid)) {
+      return false;
+    }
+    auto ah = rm->GetAgentHandle(uid);
+    if (rm->GetAgent(ah) != &query) {
+      return false;
+    }
+    CheckVerletSearchRadius(squared_radius);
+
+    auto idx = verlet_offset_[ah.GetNumaNode()] + ah.GetElementIdx();
+    const auto& position = query.GetPosition();
+    for (uint64_t i = verlet_start_[idx]; i < verlet_start_[idx + 1]; ++i) {
+      auto* neighbor = verlet_neighbors_[i];
+      auto squared_distance =
+          SquaredEuclideanDistance(position, neighbor->GetPosition());
+      if (squared_distance < squared_radius) {
+        lambda(neighbor, squared_distance);
+      }
+    }
+    return true;
+  }
+
+  /// Determines `largest_small_agent_size_` and `size_classes_`.
+  /// \see `Param::uniform_grid_large_agent_factor`
+  void DetermineSizeClasses(real_t factor);
+
+  /// Determines the box of the query for `ForEachNeighbor`. Returns false if
+  /// the neighbors cannot be determined (i.e. the query is outside of the
+  /// grid).
+  bool GetQueryBoxIdx(const Real3& query_position, real_t squared_radius,
+                      const Agent* query_agent, uint32_t* box_idx) const {
+    if (squared_radius > box_length_squared_ && !size_classes_) {
+      Log::Fatal(
+          "UniformGridEnvironment::ForEachNeighbor",
+          "The requested search radius (", std::sqrt(squared_radius), ")",
+          " of the neighborhood search exceeds the "
+          "box length (",
+          box_length_, "). The resulting neighborhood would be incomplete.");
+    }
+    if (verlet_valid_) {
+      CheckVerletSearchRadius(squared_radius);
+    }
+    // Use uint32_t for compatibility with Agent::GetBoxIdx();
+    uint32_t idx{std::numeric_limits<uint32_t>::max()};
+    if (query_agent != nullptr) {
+      idx = query_agent->GetBoxIdx();
+    }
+    // If the point is not inside the inner grid (excluding the bounding boxes)
+    // as well as there was no previous box index assigned to the agent, we
+    // cannot reliably detect the neighbors and warn the user.
+    if (!ContainedInGrid(query_position) &&
+        idx == std::numeric_limits<uint32_t>::max()) {
+      Log::Warning(
+          "UniformGridEnvironment::ForEachNeighbor",
+          "You provided a query_position that is outside of the environment. ",
+          "Neighbor search is not supported in this case. \n",
+          "query_position: ", query_position,
+          "\ngrid_dimensions: ", grid_dimensions_[0] + box_length_, ", ",
+          grid_dimensions_[1] - box_length_, ", ",
+          grid_dimensions_[2] + box_length_, ", ",
+          grid_dimensions_[3] - box_length_, ", ",
+          grid_dimensions_[4] + box_length_, ", ",
+          grid_dimensions_[5] - box_length_);
+      return false;
+    }
+    // Freshly created agents are initialized with the largest uint32_t number
+    // available. The above line assumes that the agent has already been located
+    // in the grid, but this assumption does not hold for new agents. Hence, for
+    // new agents, we manually compute the box index. This is also necessary if
+    // we want to find the neighbors of a arbitrary 3D coordinate rather than
+    // the neighbors of an agent.
+    if (idx == std::numeric_limits<uint32_t>::max()) {
+      size_t idx_tmp = GetBoxIndex(query_position);
+      // Check if conversion can be done without losing information
+      assert(idx_tmp <= std::numeric_limits<uint32_t>::max());
+      idx = static_cast<uint32_t>(idx_tmp);
+    }
+    *box_idx = idx;
+    return true;
+  }
+
+  /// Calls `callback(handle, agent, squared_distance)` for each agent within
+  /// `squared_radius` around `position` in the boxes around `box_idx`.
+  /// Uses the cell list if it is valid, and the linked lists of the boxes
+  /// otherwise.
+  template <typename TCallback>
+  void ForEachNeighborInBoxes(TCallback&& callback, const Real3& position,
+                              real_t squared_radius, uint32_t box_idx,
+                              const Agent* query_agent) {
+    if (cell_list_valid_) {
+      ForEachNeighborInCellList(callback, position, squared_radius, box_idx,
+                                query_agent);
+      return;
+    }
+
+    FixedSizeVector<const Box*, 27> neighbor_boxes;
+    GetMooreBoxes(&neighbor_boxes, box_idx);
+
+    auto* rm = Simulation::GetActive()->GetResourceManager();
+    // With agent columns, candidates that are not within the search radius
+    // are not accessed. \see `Param::agent_columns`
+    const auto* columns = rm->GetAgentColumns();
+
+    NeighborIterator ni(this, neighbor_boxes, timestamp_);
+    const unsigned batch_size = 64;
+    uint64_t size = 0;
+    AgentHandle handles[batch_size];
+    Agent* agents[batch_size] __attribute__((aligned(64)));
+    real_t x[batch_size] __attribute__((aligned(64)));
+    real_t y[batch_size] __attribute__((aligned(64)));
+    real_t z[batch_size] __attribute__((aligned(64)));
+    real_t squared_distance[batch_size] __attribute__((aligned(64)));
+
+    auto process_batch = [&]() {
+#pragma omp simd
+      for (uint64_t i = 0; i < size; ++i) {
+        const real_t dx = x[i] - position[0];
+        const real_t dy = y[i] - position[1];
+        const real_t dz = z[i] - position[2];
+
+        squared_distance[i] = dx * dx + dy * dy + dz * dz;
+      }
+
+      for (uint64_t i = 0; i < size; ++i) {
+        if (squared_distance[i] < squared_radius) {
+          callback(handles[i], agents[i], squared_distance[i]);
+        }
+      }
+      size = 0;
+    };
+
+    while (!ni.IsAtEnd()) {
+      auto ah = *ni;
+      // increment iterator already here to hide memory latency
+      ++ni;
+      auto* agent = rm->GetAgent(ah);
+      if (agent != query_agent) {
+        handles[size] = ah;
+        agents[size] = agent;
+        if (columns) {
+          const auto pos = columns->GetPosition(ah);
+          x[size] = pos[0];
+          y[size] = pos[1];
+          z[size] = pos[2];
+        } else {
+          const auto& pos = agent->GetPosition();
+          x[size] = pos[0];
+          y[size] = pos[1];
+          z[size] = pos[2];
+        }
+        size++;
+        if (size == batch_size) {
+          process_batch();
+        }
+      }
+    }
+    process_batch();
+  }
+
+  /// Cell list version of `ForEachNeighbor`.
+  /// Boxes that are adjacent along the x-axis are stored next to each other
+  /// in the cell list. Therefore, the 27 Moore boxes collapse into 9
+  /// contiguous ranges.\n
+  /// If size classes are used, the search radius might exceed the box length.
+  /// In this case, more than one layer of boxes around the query box is
+  /// searched. Large agents are skipped in the boxes and processed
+  /// separately using `cl_large_`.\n
+  /// The cell list only determines the candidates. Their distance is
+  /// computed from their current position (see `GetCellListPosition`),
+  /// because agents might have moved since the last update.
+  /// Calls `callback(handle, agent, squared_distance)` for each neighbor.
+  template <typename TCallback>
+  void ForEachNeighborInCellList(TCallback&& callback, const Real3& position,
+                                 real_t squared_radius, uint32_t box_idx,
+                                 const Agent* query_agent) {
+    const unsigned batch_size = 64;
+    real_t x[batch_size] __attribute__((aligned(64)));
+    real_t y[batch_size] __attribute__((aligned(64)));
+    real_t z[batch_size] __attribute__((aligned(64)));
+    real_t squared_distance[batch_size] __attribute__((aligned(64)));
+    const auto* columns =
+        Simulation::GetActive()->GetResourceManager()->GetAgentColumns();
+    const auto* diameter = cl_diameter_.data();
+    auto* const* agents = cl_agents_.data();
+    const auto* handles = cl_handles_.data();
+    const auto nx = static_cast<int64_t>(num_boxes_axis_[0]);
+    const auto nxy = static_cast<int64_t>(num_boxes_xy_);
+    // Without size classes agents are never larger than this threshold.
+    const real_t max_diameter =
+        size_classes_ ? largest_small_agent_size_ : Math::kInfinity;
+
+    int64_t reach = 1;
+    if (squared_radius > box_length_squared_) {
+      reach = static_cast<int64_t>(
+          std::ceil(std::sqrt(squared_radius) / box_length_));
+    }
+    auto coord = GetBoxCoordinates(box_idx);
+    std::array<int64_t, 3> lo;
+    std::array<int64_t, 3> hi;
+    for (int i = 0; i < 3; ++i) {
+      lo[i] = std::max<int64_t>(static_cast<int64_t>(coord[i]) - reach, 0);
+      hi[i] = std::min<int64_t>(static_cast<int64_t>(coord[i]) + reach,
+                                num_boxes_axis_[i] - 1);
+    }
+
+    for (int64_t bz = lo[2]; bz <= hi[2]; ++bz) {
+      for (int64_t by = lo[1]; by <= hi[1]; ++by) {
+        auto row = bz * nxy + by * nx;
+        auto start = cl_box_start_[row + lo[0]];
+        auto end = cl_box_start_[row + hi[0] + 1];
+        for (uint64_t offset = start; offset < end; offset += batch_size) {
+          uint64_t size = std::min<uint64_t>(batch_size, end - offset);
+          for (uint64_t i = 0; i < size; ++i) {
+            const auto pos = GetCellListPosition(columns, offset + i);
+            x[i] = pos[0];
+            y[i] = pos[1];
+            z[i] = pos[2];
+          }
+#pragma omp simd
+          for (uint64_t i = 0; i < size; ++i) {
+            const real_t dx = x[i] - position[0];
+            const real_t dy = y[i] - position[1];
+            const real_t dz = z[i] - position[2];
+            squared_distance[i] = dx * dx + dy * dy + dz * dz;
+          }
+
+          for (uint64_t i = 0; i < size; ++i) {
+            if (squared_distance[i] < squared_radius &&
+                agents[offset + i] != query_agent &&
+                diameter[offset + i] <= max_diameter) {
+              callback(handles[offset + i], agents[offset + i],
+                       squared_distance[i]);
+            }
+          }
+        }
+      }
+    }
+
+    if (!size_classes_) {
+      return;
+    }
+    const real_t radius = std::sqrt(squared_radius);
+    for (auto i : cl_large_) {
+      if (agents[i] == query_agent) {
+        continue;
+      }
+      const auto diff = GetCellListPosition(columns, i) - position;
+      const real_t sq_dist = diff * diff;
+      const real_t r = radius + (diameter[i] - max_diameter) / 2;
+      if (sq_dist < r * r) {
+        callback(handles[i], agents[i], sq_dist);
+      }
+    }
+  }
+
+  /// Returns the current position of the agent at index `i` of the cell
+  /// list. Reads the agent columns if they are enabled.
+  Real3 GetCellListPosition(const AgentColumns* columns, uint64_t i) const {
+    if (columns) {
+      return columns->GetPosition(cl_handles_[i]);
+    }
+    return cl_agents_[i]->GetPosition();
+  }
+
   void CheckGridGrowth() {
     // Determine if the grid dimensions have changed (changed in the sense that
     // the grid has grown outwards)
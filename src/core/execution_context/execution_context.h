@@ -103,6 +103,18 @@ class ExecutionContext {
   virtual Agent* GetAgent(const AgentUid& uid) = 0;
 
   virtual const Agent* GetConstAgent(const AgentUid& uid) = 0;
+
+  /// Identifies a change to shared data that the operations of the agent
+  /// executed by this context make (e.g. a deferred concentration change).
+  /// Sets `agent_key` to the canonical key of this agent (see
+  /// `Agent::GetCanonicalKey`) and `change` to the number of changes that the
+  /// agent has made before. Outside of `Execute`, `agent_key` is zero.\n
+  /// Allows to apply such changes in agent order, independent of the thread
+  /// that executed the agent and of its storage location.
+  virtual void NextChange(uint64_t* agent_key, uint64_t* change) {
+    *agent_key = 0;
+    *change = 0;
+  }
 };
 
 }  // namespace bdm
@@ -23,6 +23,9 @@
 #include "core/functor.h"
 #include "core/resource_manager.h"
 #include "core/scheduler.h"
+#include "core/util/partition.h"
+#include "core/util/philox.h"
+#include "core/util/random.h"
 
 namespace bdm {
 
@@ -114,7 +117,10 @@ InPlaceExecutionContext::InPlaceExecutionContext(
     const std::shared_ptr<ThreadSafeAgentUidMap>& map)
     : new_agent_map_(map), tinfo_(ThreadInfo::GetInstance()) {
   new_agents_.reserve(1e3);
-  cache_neighbors_ = Simulation::GetActive()->GetParam()->cache_neighbors;
+  auto* param = Simulation::GetActive()->GetParam();
+  cache_neighbors_ = param->cache_neighbors;
+  agent_streams_ =
+      param->deterministic || param->random_generator == "philox";
 }
 
 InPlaceExecutionContext::~InPlaceExecutionContext() {
@@ -140,15 +146,69 @@ void InPlaceExecutionContext::TearDownIterationAll(
 }
 
 void InPlaceExecutionContext::SetupAgentOpsAll(
-    const std::vector<ExecutionContext*>& all_exec_ctxts) {}
+    const std::vector<ExecutionContext*>& all_exec_ctxts) {
+  if (!agent_streams_) {
+    return;
+  }
+  // Agents keep their handle during the agent operations. Entries of
+  // previous steps are reset in `Execute`.
+  if (!agent_stream_states_) {
+    agent_stream_states_ =
+        std::make_shared<std::vector<std::vector<AgentStreamState>>>();
+  }
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto& states = *agent_stream_states_;
+  states.resize(tinfo_->GetNumaNodes());
+  for (uint64_t n = 0; n < states.size(); ++n) {
+    auto num_agents = rm->GetNumAgents(n);
+    if (states[n].size() < num_agents) {
+      states[n].resize(num_agents);
+    }
+  }
+  for (auto* ctxt : all_exec_ctxts) {
+    bdm_static_cast<InPlaceExecutionContext*>(ctxt)->agent_stream_states_ =
+        agent_stream_states_;
+  }
+}
 
 void InPlaceExecutionContext::TearDownAgentOpsAll(
     const std::vector<ExecutionContext*>& all_exec_ctxts) {}
 
 void InPlaceExecutionContext::Execute(
     Agent* agent, AgentHandle ah, const std::vector<Operation*>& operations) {
-  auto* env = Simulation::GetActive()->GetEnvironment();
-  auto* param = Simulation::GetActive()->GetParam();
+  auto* sim = Simulation::GetActive();
+  auto* env = sim->GetEnvironment();
+  auto* param = sim->GetParam();
+
+  // With the counter-based generator, the operations draw from the stream of
+  // this agent and time step. If the agent has already been executed in this
+  // step, it continues where it stopped. Afterwards, the thread continues
+  // its own stream.
+  Random* random = nullptr;
+  uint64_t thread_stream = 0;
+  uint64_t thread_position = 0;
+  if (agent_streams_) {
+    random = sim->GetRandom();
+    thread_stream = random->GetStream();
+    thread_position = random->GetStreamPosition();
+    auto step = sim->GetScheduler()->GetSimulatedSteps();
+    agent_stream_state_ = &detached_stream_state_;
+    if (agent_stream_states_ &&
+        ah.GetNumaNode() < agent_stream_states_->size()) {
+      auto& states = (*agent_stream_states_)[ah.GetNumaNode()];
+      if (ah.GetElementIdx() < states.size()) {
+        agent_stream_state_ = &states[ah.GetElementIdx()];
+      }
+    }
+    if (agent_stream_state_ == &detached_stream_state_ ||
+        agent_stream_state_->step != step) {
+      *agent_stream_state_ = {step, 0, 0, 0};
+    }
+    agent_stream_ = Philox::HashCombine(agent->GetCanonicalKey(), step);
+    random->SetStream(agent_stream_, agent_stream_state_->position);
+  }
+  current_agent_ = agent;
+  num_changes_ = 0;
 
   if (param->thread_safety_mechanism ==
       Param::ThreadSafetyMechanism::kUserSpecified) {
@@ -216,7 +276,11 @@ void InPlaceExecutionContext::Execute(
       (*op)(agent);
     }
   } else if (param->thread_safety_mechanism ==
-             Param::ThreadSafetyMechanism::kNone) {
+                 Param::ThreadSafetyMechanism::kNone ||
+             param->thread_safety_mechanism ==
+                 Param::ThreadSafetyMechanism::kBoxColoring) {
+    // With box coloring, the scheduler never processes agents with shared
+    // neighbors in parallel
     neighbor_cache_.clear();
     cached_squared_search_radius_ = 0;
     for (auto* op : operations) {
@@ -227,9 +291,31 @@ void InPlaceExecutionContext::Execute(
                "Invalid value for parameter thread_safety_mechanism: ",
                param->thread_safety_mechanism);
   }
+
+  current_agent_ = nullptr;
+  num_changes_ = 0;
+  if (random != nullptr) {
+    agent_stream_state_->position = random->GetStreamPosition();
+    random->SetStream(thread_stream, thread_position);
+    agent_stream_ = 0;
+    agent_stream_state_ = nullptr;
+  }
+}
+
+void InPlaceExecutionContext::NextChange(uint64_t* agent_key,
+                                         uint64_t* change) {
+  *agent_key = current_agent_ ? current_agent_->GetCanonicalKey() : 0;
+  // An agent that is executed several times per step continues its count
+  *change = agent_stream_state_ ? agent_stream_state_->num_changes++
+                                : num_changes_++;
 }
 
 void InPlaceExecutionContext::AddAgent(Agent* new_agent) {
+  if (agent_stream_ != 0) {
+    // The key must not depend on the thread that executes the creating agent
+    new_agent->SetCanonicalKey(Philox::HashCombine(
+        agent_stream_, ++agent_stream_state_->num_created_agents));
+  }
   new_agents_.push_back(new_agent);
   new_agent_map_->Insert(new_agent->GetUid(), new_agent);
 }
@@ -318,6 +404,10 @@ void InPlaceExecutionContext::RemoveAgent(const AgentUid& uid) {
 
 void InPlaceExecutionContext::AddAgentsToRm(
     const std::vector<ExecutionContext*>& all_exec_ctxts) {
+  if (Simulation::GetActive()->GetParam()->deterministic) {
+    SortNewAgents(all_exec_ctxts);
+  }
+
   // group execution contexts by numa domain
   std::vector<uint64_t> new_agent_per_numa(tinfo_->GetNumaNodes());
   std::vector<uint64_t> thread_offsets(tinfo_->GetMaxThreads());
@@ -366,6 +456,9 @@ void InPlaceExecutionContext::RemoveAgentsFromRm(
 
   if (num_removals != 0) {
     auto* rm = Simulation::GetActive()->GetResourceManager();
+    if (Simulation::GetActive()->GetParam()->deterministic) {
+      SortRemovedAgents(all_exec_ctxts);
+    }
     rm->RemoveAgents(all_remove);
 
     for (int i = 0; i < tinfo_->GetMaxThreads(); i++) {
@@ -374,6 +467,49 @@ void InPlaceExecutionContext::RemoveAgentsFromRm(
     }
   }
 }
+void InPlaceExecutionContext::SortNewAgents(
+    const std::vector<ExecutionContext*>& all_exec_ctxts) {
+  std::vector<std::pair<uint64_t, Agent*>> sorted;
+  for (int tid = 0; tid < tinfo_->GetMaxThreads(); ++tid) {
+    auto* ctxt = bdm_static_cast<InPlaceExecutionContext*>(all_exec_ctxts[tid]);
+    for (auto* agent : ctxt->new_agents_) {
+      sorted.emplace_back(agent->GetCanonicalKey(), agent);
+    }
+    ctxt->new_agents_.clear();
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const std::pair<uint64_t, Agent*>& a,
+               const std::pair<uint64_t, Agent*>& b) {
+              return a.first < b.first;
+            });
+
+  for (int tid = 0; tid < tinfo_->GetMaxThreads(); ++tid) {
+    auto* ctxt = bdm_static_cast<InPlaceExecutionContext*>(all_exec_ctxts[tid]);
+    uint64_t start = 0;
+    uint64_t end = 0;
+    Partition(sorted.size(), tinfo_->GetMaxThreads(), tid, &start, &end);
+    for (uint64_t i = start; i < end; ++i) {
+      ctxt->new_agents_.push_back(sorted[i].second);
+    }
+  }
+}
+
+void InPlaceExecutionContext::SortRemovedAgents(
+    const std::vector<ExecutionContext*>& all_exec_ctxts) {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto* first = bdm_static_cast<InPlaceExecutionContext*>(all_exec_ctxts[0]);
+  for (int tid = 1; tid < tinfo_->GetMaxThreads(); ++tid) {
+    auto* ctxt = bdm_static_cast<InPlaceExecutionContext*>(all_exec_ctxts[tid]);
+    first->remove_.insert(first->remove_.end(), ctxt->remove_.begin(),
+                          ctxt->remove_.end());
+    ctxt->remove_.clear();
+  }
+  std::sort(first->remove_.begin(), first->remove_.end(),
+            [&](const AgentUid& a, const AgentUid& b) {
+              return rm->GetAgentHandle(a) < rm->GetAgentHandle(b);
+            });
+}
+
 // TODO(lukas) Add tests for caching mechanism in ForEachNeighbor*
 
 }  // namespace bdm
@@ -17,6 +17,7 @@
 
 #include <atomic>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -132,6 +133,8 @@ class InPlaceExecutionContext : public ExecutionContext {
 
   const Agent* GetConstAgent(const AgentUid& uid) override;
 
+  void NextChange(uint64_t* agent_key, uint64_t* change) override;
+
  protected:
   friend class Environment;
   friend class in_place_exec_ctxt_detail::
@@ -157,6 +160,44 @@ class InPlaceExecutionContext : public ExecutionContext {
   /// Cache the value of Param::cache_neighbors
   bool cache_neighbors_ = false;
 
+  /// Progress of an agent in its random stream of the current step
+  struct AgentStreamState {
+    /// Step to which `position` and `num_created_agents` belong
+    uint64_t step = std::numeric_limits<uint64_t>::max();
+    /// Number of random numbers that the agent has drawn
+    uint64_t position = 0;
+    /// Number of agents that the agent has created
+    uint64_t num_created_agents = 0;
+    /// Number of changes that the agent has made (see `NextChange`)
+    uint64_t num_changes = 0;
+  };
+
+  /// True if the agent operations draw from per-agent random streams, i.e.
+  /// if the counter-based generator is used (see `Param::random_generator`)
+  bool agent_streams_ = false;
+  /// Random stream of the agent whose operations are executed if
+  /// `agent_streams_` is true. Zero otherwise.
+  uint64_t agent_stream_ = 0;
+  /// Stream state of the agent whose operations are executed
+  AgentStreamState* agent_stream_state_ = nullptr;
+  /// An agent can be executed several times per step (e.g. with
+  /// `Param::ExecutionOrder::kForEachOpForEachAgent` or several agent
+  /// filters). It continues its stream and creation count from the previous
+  /// execution, instead of drawing the same numbers and creating agents with
+  /// the same keys again. Indexed by `AgentHandle` and shared by all
+  /// execution contexts (see `SetupAgentOpsAll`).
+  std::shared_ptr<std::vector<std::vector<AgentStreamState>>>
+      agent_stream_states_;
+  /// Used for agents that are executed outside of the agent operations
+  AgentStreamState detached_stream_state_;
+
+  /// Agent whose operations are executed. Nullptr outside of `Execute`.
+  /// \see `NextChange`
+  const Agent* current_agent_ = nullptr;
+  /// Number of changes that `current_agent_` has made during this execution
+  /// if `agent_stream_state_` is not set (see `NextChange`)
+  uint64_t num_changes_ = 0;
+
   /// Check whether or not the neighbors in `neighbor_cache_` were queried with
   /// the same squared radius (`cached_squared_search_radius_`) as currently
   /// being queried with (`query_squared_radius_`)
@@ -168,6 +209,15 @@ class InPlaceExecutionContext : public ExecutionContext {
   virtual void RemoveAgentsFromRm(
       const std::vector<ExecutionContext*>& all_exec_ctxts);
 
+  /// Deterministic mode: distributes the new agents of all threads sorted by
+  /// their canonical key. The size of the range that each thread adds does
+  /// not depend on the threads that created the agents.
+  void SortNewAgents(const std::vector<ExecutionContext*>& all_exec_ctxts);
+
+  /// Deterministic mode: moves the agents that will be removed to the first
+  /// thread sorted by their position in the `ResourceManager`.
+  void SortRemovedAgents(const std::vector<ExecutionContext*>& all_exec_ctxts);
+
  private:
   /// Used to determine which agents must not be updated from different threads.
   std::vector<AgentPointer<>> critical_region_;
@@ -14,17 +14,33 @@
 
 #include "core/exporter.h"
 
+#include <TClass.h>
+#include <TDataMember.h>
+#include <TDataType.h>
+#include <TRealData.h>
+#include <fcntl.h>
+#include <omp.h>
+#include <unistd.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <set>
 #include <sstream>
+#include <unordered_map>
+#include <utility>
 
 #include "core/agent/cell.h"
+#include "core/functor.h"
 #include "core/param/param.h"
 #include "core/resource_manager.h"
 #include "core/simulation.h"
 #include "core/util/log.h"
+#include "core/util/thread_info.h"
 
 namespace bdm {
 
@@ -322,6 +338,417 @@ void ParaviewExporter::ExportSummary(std::string filename,
   pvd << "</VTKFile>" << std::endl;
 }
 
+// -----------------------------------------------------------------------------
+namespace {
+
+/// Column of `ColumnarExporter`
+struct ExportColumn {
+  std::string name;
+  columnar::ColumnType type;
+  uint16_t components = 1;
+  columnar::Compression compression;
+  /// Bytes per agent
+  uint64_t row_size = 0;
+  /// The memory is not initialized, such that its pages are first touched by
+  /// the threads that gather the agents of the corresponding NUMA node.
+  std::unique_ptr<char[]> data;
+  /// Offset of the data member relative to the `Agent` base for each class
+  /// of the type table, or -1 if the class does not have the data member.
+  std::vector<int64_t> member_offsets;
+  /// Compressed blocks. Blocks that could not be compressed are empty and
+  /// are written from `data`.
+  std::vector<std::unique_ptr<char[]>> blocks;
+  std::vector<uint64_t> block_sizes;
+  uint64_t offset = 0;
+  uint64_t size = 0;
+};
+
+/// Contiguous range of the output file
+struct Segment {
+  const char* data;
+  uint64_t size;
+  uint64_t offset;
+};
+
+uint64_t Align(uint64_t offset) {
+  return (offset + columnar::kAlignment - 1) / columnar::kAlignment *
+         columnar::kAlignment;
+}
+
+/// Executes `function(task)` for all tasks in parallel. The tasks in
+/// `tasks[n]` are executed by the threads of NUMA node `n`, unless they run
+/// out of work and help the threads of other NUMA nodes.
+template <typename TTask, typename TFunction>
+void ForEachNumaTask(const std::vector<std::vector<TTask>>& tasks,
+                     const TFunction& function) {
+  auto num_numa_nodes = tasks.size();
+  std::unique_ptr<std::atomic<uint64_t>[]> next(
+      new std::atomic<uint64_t>[num_numa_nodes]);
+  for (uint64_t n = 0; n < num_numa_nodes; ++n) {
+    next[n] = 0;
+  }
+#pragma omp parallel
+  {
+    uint64_t my_numa_node = ThreadInfo::GetInstance()->GetMyNumaNode();
+    for (uint64_t i = 0; i < num_numa_nodes; ++i) {
+      auto n = (my_numa_node + i) % num_numa_nodes;
+      for (auto t = next[n]++; t < tasks[n].size(); t = next[n]++) {
+        function(tasks[n][t]);
+      }
+    }
+  }
+}
+
+/// Determines type and number of components of data member `name` of
+/// `tclass`.
+void GetDataMemberType(TClass* tclass, const std::string& name,
+                       TDataMember* dm, columnar::ColumnType* type,
+                       uint16_t* components) {
+  *components = 1;
+  if (dm->IsaPointer() || dm->GetArrayDim() != 0) {
+    Log::Fatal("ColumnarExporter", "Data member ", tclass->GetName(),
+               "::", name, " is a pointer or an array");
+  }
+  if (auto* data_type = dm->GetDataType()) {
+    switch (data_type->GetType()) {
+      case kChar_t:
+        *type = columnar::ColumnType::kInt8;
+        return;
+      case kUChar_t:
+      case kBool_t:
+        *type = columnar::ColumnType::kUInt8;
+        return;
+      case kShort_t:
+        *type = columnar::ColumnType::kInt16;
+        return;
+      case kUShort_t:
+        *type = columnar::ColumnType::kUInt16;
+        return;
+      case kInt_t:
+        *type = columnar::ColumnType::kInt32;
+        return;
+      case kUInt_t:
+        *type = columnar::ColumnType::kUInt32;
+        return;
+      case kLong_t:
+        *type = columnar::GetColumnType<long>();  // NOLINT
+        return;
+      case kULong_t:
+        *type = columnar::GetColumnType<unsigned long>();  // NOLINT
+        return;
+      case kLong64_t:
+        *type = columnar::ColumnType::kInt64;
+        return;
+      case kULong64_t:
+        *type = columnar::ColumnType::kUInt64;
+        return;
+      case kFloat_t:
+      case kFloat16_t:
+        *type = columnar::ColumnType::kFloat;
+        return;
+      case kDouble_t:
+      case kDouble32_t:
+        *type = columnar::ColumnType::kDouble;
+        return;
+      default:
+        break;
+    }
+  } else if (std::string(dm->GetTypeName()).find("MathArray<") !=
+             std::string::npos) {
+    auto* member_class = TClass::GetClass(dm->GetTypeName());
+    if (member_class != nullptr &&
+        member_class->Size() == static_cast<int>(sizeof(Real3))) {
+      *type = columnar::GetColumnType<real_t>();
+      *components = 3;
+      return;
+    }
+  }
+  Log::Fatal("ColumnarExporter", "Data member ", tclass->GetName(), "::", name,
+             " has the unsupported type ", dm->GetTypeName());
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+ColumnarExporter::ColumnarExporter(const std::vector<std::string>& data_members,
+                                   columnar::Compression compression, int level)
+    : data_members_(data_members), compression_(compression), level_(level) {}
+
+void ColumnarExporter::SetCompression(const std::string& column,
+                                      columnar::Compression compression) {
+  column_compression_[column] = compression;
+}
+
+void ColumnarExporter::ExportIteration(std::string filename,
+                                       uint64_t iteration) {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto* tinfo = ThreadInfo::GetInstance();
+  uint64_t num_numa_nodes = tinfo->GetNumaNodes();
+  std::vector<uint64_t> numa_offset(num_numa_nodes + 1, 0);
+  for (uint64_t n = 0; n < num_numa_nodes; ++n) {
+    numa_offset[n + 1] = numa_offset[n] + rm->GetNumAgents(n);
+  }
+  auto num_agents = numa_offset.back();
+  auto get_numa_node = [&](uint64_t row) -> uint64_t {
+    return std::upper_bound(numa_offset.begin(), numa_offset.end(), row) -
+           numa_offset.begin() - 1;
+  };
+
+  // Collect the classes of all agents for the type table
+  std::vector<std::set<TClass*>> thread_classes(tinfo->GetMaxThreads());
+  auto collect = L2F([&](Agent* agent, AgentHandle) {
+    thread_classes[tinfo->GetMyThreadId()].insert(agent->IsA());
+  });
+  rm->ForEachAgentParallel(1000, collect);
+  std::set<TClass*> class_set;
+  for (auto& el : thread_classes) {
+    class_set.insert(el.begin(), el.end());
+  }
+  std::vector<TClass*> classes(class_set.begin(), class_set.end());
+  std::sort(classes.begin(), classes.end(), [](TClass* lhs, TClass* rhs) {
+    return std::strcmp(lhs->GetName(), rhs->GetName()) < 0;
+  });
+  if (classes.size() > std::numeric_limits<uint16_t>::max()) {
+    Log::Fatal("ColumnarExporter::ExportIteration", "Too many agent classes");
+  }
+  std::unordered_map<TClass*, uint16_t> type_index;
+  for (uint64_t i = 0; i < classes.size(); ++i) {
+    type_index[classes[i]] = i;
+  }
+
+  // Define the columns
+  std::vector<ExportColumn> columns(4 + data_members_.size());
+  columns[0].name = "uid";
+  columns[0].type = columnar::ColumnType::kUInt64;
+  columns[1].name = "type";
+  columns[1].type = columnar::ColumnType::kUInt16;
+  columns[2].name = "position";
+  columns[2].type = columnar::GetColumnType<real_t>();
+  columns[2].components = 3;
+  columns[3].name = "diameter";
+  columns[3].type = columnar::GetColumnType<real_t>();
+  for (uint64_t i = 0; i < data_members_.size(); ++i) {
+    auto& column = columns[4 + i];
+    column.name = data_members_[i];
+    column.member_offsets.resize(classes.size(), -1);
+    bool found = false;
+    for (uint64_t t = 0; t < classes.size(); ++t) {
+      auto* rd = classes[t]->GetRealData(column.name.c_str());
+      if (rd == nullptr) {
+        continue;
+      }
+      columnar::ColumnType type;
+      uint16_t components;
+      GetDataMemberType(classes[t], column.name, rd->GetDataMember(), &type,
+                        &components);
+      if (found && (type != column.type || components != column.components)) {
+        Log::Fatal("ColumnarExporter::ExportIteration", "Data member ",
+                   column.name, " has different types in different classes");
+      }
+      found = true;
+      column.type = type;
+      column.components = components;
+      column.member_offsets[t] =
+          rd->GetThisOffset() - classes[t]->GetBaseClassOffset(Agent::Class());
+    }
+    if (!found) {
+      Log::Fatal("ColumnarExporter::ExportIteration",
+                 "Could not find data member ", column.name);
+    }
+  }
+  for (auto& column : columns) {
+    if (column.name.size() >= sizeof(columnar::ColumnEntry::name)) {
+      Log::Fatal("ColumnarExporter::ExportIteration", "Column name ",
+                 column.name, " is too long");
+    }
+    auto it = column_compression_.find(column.name);
+    column.compression =
+        it != column_compression_.end() ? it->second : compression_;
+    column.row_size = columnar::GetSize(column.type) * column.components;
+    column.data.reset(new char[num_agents * column.row_size]);
+  }
+
+  // Gather the columns
+  auto gather = L2F([&](Agent* agent, AgentHandle ah) {
+    auto idx = numa_offset[ah.GetNumaNode()] + ah.GetElementIdx();
+    auto type = type_index.find(agent->IsA())->second;
+    reinterpret_cast<uint64_t*>(columns[0].data.get())[idx] =
+        agent->GetUid();
+    reinterpret_cast<uint16_t*>(columns[1].data.get())[idx] = type;
+    const auto& position = agent->GetPosition();
+    auto* dst = reinterpret_cast<real_t*>(columns[2].data.get()) + 3 * idx;
+    dst[0] = position[0];
+    dst[1] = position[1];
+    dst[2] = position[2];
+    reinterpret_cast<real_t*>(columns[3].data.get())[idx] =
+        agent->GetDiameter();
+    const auto* agent_ptr = reinterpret_cast<const char*>(agent);
+    for (uint64_t c = 4; c < columns.size(); ++c) {
+      auto& column = columns[c];
+      auto* member_dst = column.data.get() + idx * column.row_size;
+      auto offset = column.member_offsets[type];
+      if (offset < 0) {
+        std::memset(member_dst, 0, column.row_size);
+      } else {
+        std::memcpy(member_dst, agent_ptr + offset, column.row_size);
+      }
+    }
+  });
+  rm->ForEachAgentParallel(1000, gather);
+
+  // Compress the blocks on the NUMA node of their first agent
+  std::vector<std::vector<std::pair<uint64_t, uint64_t>>> compress_tasks(
+      num_numa_nodes);
+  for (uint64_t c = 0; c < columns.size(); ++c) {
+    auto& column = columns[c];
+    if (column.compression == columnar::Compression::kNone) {
+      continue;
+    }
+    auto raw_size = num_agents * column.row_size;
+    auto num_blocks = (raw_size + columnar::kBlockSize - 1) /
+                      columnar::kBlockSize;
+    column.blocks.resize(num_blocks);
+    column.block_sizes.resize(num_blocks);
+    for (uint64_t b = 0; b < num_blocks; ++b) {
+      auto row = b * columnar::kBlockSize / column.row_size;
+      compress_tasks[get_numa_node(row)].push_back({c, b});
+    }
+  }
+  ForEachNumaTask(compress_tasks, [&](const std::pair<uint64_t, uint64_t>& t) {
+    auto& column = columns[t.first];
+    auto begin = t.second * columnar::kBlockSize;
+    auto size =
+        std::min(columnar::kBlockSize, num_agents * column.row_size - begin);
+    auto& block = column.blocks[t.second];
+    block.reset(new char[size]);
+    auto compressed_size = columnar::CompressBlock(
+        column.compression, level_, column.data.get() + begin, size,
+        block.get());
+    if (compressed_size == 0) {
+      block.reset();
+      column.block_sizes[t.second] = size;
+    } else {
+      column.block_sizes[t.second] = compressed_size;
+    }
+  });
+
+  // Compute the layout of the file and fill header, column table, and type
+  // table
+  uint64_t type_table_size = 0;
+  for (auto* tclass : classes) {
+    type_table_size += std::strlen(tclass->GetName()) + 1;
+  }
+  uint64_t column_table = sizeof(columnar::FileHeader);
+  uint64_t type_table =
+      column_table + columns.size() * sizeof(columnar::ColumnEntry);
+  uint64_t file_size = type_table + type_table_size;
+  for (auto& column : columns) {
+    file_size = Align(file_size);
+    column.offset = file_size;
+    if (column.compression == columnar::Compression::kNone) {
+      column.size = num_agents * column.row_size;
+    } else {
+      column.size = column.block_sizes.size() * sizeof(uint64_t);
+      for (auto block_size : column.block_sizes) {
+        column.size += block_size;
+      }
+    }
+    file_size += column.size;
+  }
+
+  std::vector<char> metadata(type_table + type_table_size, 0);
+  columnar::FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, columnar::kMagic, sizeof(header.magic));
+  header.version = columnar::kVersion;
+  header.byte_order = columnar::kByteOrderMark;
+  header.num_agents = num_agents;
+  header.iteration = iteration;
+  header.num_columns = columns.size();
+  header.column_table = column_table;
+  header.type_table = type_table;
+  header.type_table_size = type_table_size;
+  std::memcpy(metadata.data(), &header, sizeof(header));
+  for (uint64_t c = 0; c < columns.size(); ++c) {
+    auto& column = columns[c];
+    columnar::ColumnEntry entry;
+    std::memset(&entry, 0, sizeof(entry));
+    std::strncpy(entry.name, column.name.c_str(), sizeof(entry.name) - 1);
+    entry.type = column.type;
+    entry.compression = column.compression;
+    entry.components = column.components;
+    entry.num_blocks = column.blocks.size();
+    entry.offset = column.offset;
+    entry.size = column.size;
+    entry.raw_size = num_agents * column.row_size;
+    std::memcpy(metadata.data() + column_table + c * sizeof(entry), &entry,
+                sizeof(entry));
+  }
+  auto* type_names = metadata.data() + type_table;
+  for (auto* tclass : classes) {
+    std::strcpy(type_names, tclass->GetName());  // NOLINT
+    type_names += std::strlen(tclass->GetName()) + 1;
+  }
+
+  // Write the segments of the file on the NUMA node that gathered their data
+  std::vector<std::vector<Segment>> segments(num_numa_nodes);
+  segments[0].push_back({metadata.data(), metadata.size(), 0});
+  for (auto& column : columns) {
+    if (column.compression == columnar::Compression::kNone) {
+      for (uint64_t n = 0; n < num_numa_nodes; ++n) {
+        auto end = numa_offset[n + 1] * column.row_size;
+        for (auto begin = numa_offset[n] * column.row_size; begin < end;
+             begin += columnar::kBlockSize) {
+          auto size = std::min(columnar::kBlockSize, end - begin);
+          segments[n].push_back(
+              {column.data.get() + begin, size, column.offset + begin});
+        }
+      }
+      continue;
+    }
+    auto offset = column.offset;
+    auto block_sizes_size = column.block_sizes.size() * sizeof(uint64_t);
+    segments[0].push_back(
+        {reinterpret_cast<const char*>(column.block_sizes.data()),
+         block_sizes_size, offset});
+    offset += block_sizes_size;
+    for (uint64_t b = 0; b < column.blocks.size(); ++b) {
+      auto begin = b * columnar::kBlockSize;
+      const char* data = column.blocks[b] ? column.blocks[b].get()
+                                          : column.data.get() + begin;
+      auto n = get_numa_node(begin / column.row_size);
+      segments[n].push_back({data, column.block_sizes[b], offset});
+      offset += column.block_sizes[b];
+    }
+  }
+
+  int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    Log::Fatal("ColumnarExporter::ExportIteration", "Could not open file ",
+               filename);
+  }
+  std::atomic<bool> failed(ftruncate(fd, file_size) != 0);
+  ForEachNumaTask(segments, [&](const Segment& segment) {
+    uint64_t written = 0;
+    while (written < segment.size) {
+      auto ret = pwrite(fd, segment.data + written, segment.size - written,
+                        segment.offset + written);
+      if (ret <= 0) {
+        failed = true;
+        return;
+      }
+      written += ret;
+    }
+  });
+  if (close(fd) != 0 || failed) {
+    Log::Fatal("ColumnarExporter::ExportIteration", "Could not write file ",
+               filename);
+  }
+}
+
+void ColumnarExporter::ExportSummary(std::string filename,
+                                     uint64_t num_iterations) {}
+
 // -----------------------------------------------------------------------------
 std::unique_ptr<Exporter> ExporterFactory::GenerateExporter(ExporterType type) {
   switch (type) {
@@ -333,6 +760,8 @@ std::unique_ptr<Exporter> ExporterFactory::GenerateExporter(ExporterType type) {
       return std::unique_ptr<Exporter>(new NeuroMLExporter);
     case kParaview:
       return std::unique_ptr<Exporter>(new ParaviewExporter);
+    case kColumnar:
+      return std::unique_ptr<Exporter>(new ColumnarExporter);
     default:
       throw std::invalid_argument("export format not recognized");
   }
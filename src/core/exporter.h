@@ -17,6 +17,10 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/columnar_snapshot.h"
 
 namespace bdm {
 
@@ -66,7 +70,44 @@ class ParaviewExporter : public Exporter {
   void ExportSummary(std::string filename, uint64_t num_iterations) override;
 };
 
-enum ExporterType { kBasic, kMatlab, kNeuroML, kParaview };
+/// Writes the agents of one iteration to a binary file with one contiguous
+/// array per attribute (see `columnar` for the format): `uid`, `type` (index
+/// into the class names of the file), `position` (3 components), `diameter`,
+/// and the data members that have been passed to the constructor. Agents
+/// that do not have one of these data members get zeros.\n
+/// Rows follow the order of the agents in the resource manager. They are
+/// gathered by the threads of the NUMA node that owns the agents. Columns
+/// are compressed and written in parallel. `ColumnarSnapshotReader` reads
+/// the file.
+class ColumnarExporter : public Exporter {
+ public:
+  /// \param data_members names of additional data members that are
+  ///        exported (e.g. `{"adherence_", "tractor_force_"}`). Supported are
+  ///        arithmetic types and `Real3`.
+  /// \param compression default compression of all columns
+  /// \param level compression level
+  explicit ColumnarExporter(
+      const std::vector<std::string>& data_members = {},
+      columnar::Compression compression = columnar::Compression::kNone,
+      int level = 1);
+
+  /// Overrides the compression of column `column`.
+  void SetCompression(const std::string& column,
+                      columnar::Compression compression);
+
+  /// Writes the file `filename`.
+  void ExportIteration(std::string filename, uint64_t iteration) override;
+
+  void ExportSummary(std::string filename, uint64_t num_iterations) override;
+
+ private:
+  std::vector<std::string> data_members_;
+  columnar::Compression compression_;
+  int level_;
+  std::unordered_map<std::string, columnar::Compression> column_compression_;
+};
+
+enum ExporterType { kBasic, kMatlab, kNeuroML, kParaview, kColumnar };
 
 class ExporterFactory {
  public:
@@ -60,11 +60,16 @@ Real4 InteractionForce::Calculate(const Agent* lhs, const Agent* rhs) const {
 void InteractionForce::ForceBetweenSpheres(const Agent* sphere_lhs,
                                            const Agent* sphere_rhs,
                                            Real3* result) const {
-  const Real3& ref_mass_location = sphere_lhs->GetPosition();
-  real_t ref_diameter = sphere_lhs->GetDiameter();
+  *result = CalculateSphereForce(
+      sphere_lhs->GetPosition(), sphere_lhs->GetDiameter(),
+      sphere_rhs->GetPosition(), sphere_rhs->GetDiameter());
+}
+
+Real3 InteractionForce::CalculateSphereForce(const Real3& ref_mass_location,
+                                             real_t ref_diameter,
+                                             const Real3& nb_mass_location,
+                                             real_t nb_diameter) const {
   real_t ref_iof_coefficient = 0.15;
-  const Real3& nb_mass_location = sphere_rhs->GetPosition();
-  real_t nb_diameter = sphere_rhs->GetDiameter();
   real_t nb_iof_coefficient = 0.15;
 
   auto c1 = ref_mass_location;
@@ -87,16 +92,13 @@ void InteractionForce::ForceBetweenSpheres(const Agent* sphere_lhs,
   real_t delta = r1 + r2 - center_distance;
   // if no overlap : no force
   if (delta < 0) {
-    *result = {0.0, 0.0, 0.0};
-    return;
+    return {0.0, 0.0, 0.0};
   }
   // to avoid a division by 0 if the centers are (almost) at the same
   //  location
   if (center_distance < 0.00000001) {
     auto* random = Simulation::GetActive()->GetRandom();
-    auto force2on1 = random->template UniformArray<3>(-3.0, 3.0);
-    *result = force2on1;
-    return;
+    return random->template UniformArray<3>(-3.0, 3.0);
   }
   // the force itself
   real_t r = (r1 * r2) / (r1 + r2);
@@ -105,9 +107,7 @@ void InteractionForce::ForceBetweenSpheres(const Agent* sphere_lhs,
   real_t f = k * delta - gamma * std::sqrt(r * delta);
 
   real_t force_module = f / center_distance;
-  Real3 force2on1(
-      {force_module * comp1, force_module * comp2, force_module * comp3});
-  *result = force2on1;
+  return {force_module * comp1, force_module * comp2, force_module * comp3};
 }
 
 void InteractionForce::ForceOnACylinderFromASphere(const Agent* cylinder,
@@ -33,6 +33,16 @@ class InteractionForce {
     return new InteractionForce(*this);
   }
 
+  /// Force that a sphere with center `nb_mass_location` and diameter
+  /// `nb_diameter` exerts on a sphere with center `ref_mass_location` and
+  /// diameter `ref_diameter`. Used by `Calculate` for two spheres. Kernels
+  /// that read the position and diameter from `AgentColumns` can call it
+  /// directly.
+  Real3 CalculateSphereForce(const Real3& ref_mass_location,
+                             real_t ref_diameter,
+                             const Real3& nb_mass_location,
+                             real_t nb_diameter) const;
+
  private:
   void ForceBetweenSpheres(const Agent* sphere_lhs, const Agent* sphere_rhs,
                            Real3* result) const;
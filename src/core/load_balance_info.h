@@ -17,6 +17,7 @@
 
 #include "core/agent/agent_handle.h"
 #include "core/functor.h"
+#include "core/real_t.h"
 #include "core/util/iterator.h"
 
 namespace bdm {
@@ -27,6 +28,16 @@ class LoadBalanceInfo {
   virtual void CallHandleIteratorConsumer(
       uint64_t start, uint64_t end,
       Functor<void, Iterator<AgentHandle>*>& f) const = 0;
+
+  /// Returns the accumulated cost of all agents, or zero if no agent costs
+  /// are available.
+  /// \see `AgentCosts`
+  virtual real_t GetTotalCost() const { return 0; }
+
+  /// Returns the number of agents (in the order in which they are passed to
+  /// `CallHandleIteratorConsumer`), whose accumulated cost is closest to
+  /// `cost`.
+  virtual uint64_t GetNumAgentsBelowCost(real_t cost) const { return 0; }
 };
 
 }  // namespace bdm
@@ -13,9 +13,12 @@
 // -----------------------------------------------------------------------------
 
 #include "core/model_initializer.h"
+#include "core/diffusion/adi_grid.h"
 #include "core/diffusion/diffusion_grid.h"
 #include "core/diffusion/euler_depletion_grid.h"
 #include "core/diffusion/euler_grid.h"
+#include "core/diffusion/sparse_euler_grid.h"
+#include "core/diffusion/steady_state_grid.h"
 #include "core/util/log.h"
 
 namespace bdm {
@@ -56,6 +59,30 @@ void ModelInitializer::DefineSubstance(
       dgrid = new EulerGrid(substance_id, substance_name, diffusion_coeff,
                             decay_constant, resolution);
     }
+  } else if (param->diffusion_method == "adi") {
+    if (!binding_substances.empty()) {
+      Log::Fatal("ModelInitializer::DefineSubstance",
+                 "Substance depletion is not supported by the diffusion ",
+                 "method 'adi'. Please use 'euler' instead.");
+    }
+    dgrid = new ADIGrid(substance_id, substance_name, diffusion_coeff,
+                        decay_constant, resolution);
+  } else if (param->diffusion_method == "sparse_euler") {
+    if (!binding_substances.empty()) {
+      Log::Fatal("ModelInitializer::DefineSubstance",
+                 "Substance depletion is not supported by the diffusion ",
+                 "method 'sparse_euler'. Please use 'euler' instead.");
+    }
+    dgrid = new SparseEulerGrid(substance_id, substance_name, diffusion_coeff,
+                                decay_constant, resolution);
+  } else if (param->diffusion_method == "steady_state") {
+    if (!binding_substances.empty()) {
+      Log::Fatal("ModelInitializer::DefineSubstance",
+                 "Substance depletion is not supported by the diffusion ",
+                 "method 'steady_state'. Please use 'euler' instead.");
+    }
+    dgrid = new SteadyStateGrid(substance_id, substance_name, diffusion_coeff,
+                                decay_constant, resolution);
   } else {
     Log::Error("ModelInitializer::DefineSubstance", "Diffusion method '",
                param->diffusion_method,
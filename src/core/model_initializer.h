@@ -17,14 +17,17 @@
 
 #include <Math/DistFunc.h>
 #include <omp.h>
+#include <algorithm>
 #include <ctime>
 #include <string>
 #include <vector>
 
 #include "core/container/math_array.h"
 #include "core/diffusion/diffusion_grid.h"
+#include "core/param/param.h"
 #include "core/resource_manager.h"
 #include "core/simulation.h"
+#include "core/util/partition.h"
 #include "core/util/random.h"
 
 class EulerGrid;
@@ -52,7 +55,7 @@ struct ModelInitializer {
   template <typename Function>
   static void Grid3D(size_t agents_per_dim, real_t space,
                      Function agent_builder) {
-#pragma omp parallel
+#pragma omp parallel if (CreateInParallel())
     {
       auto* sim = Simulation::GetActive();
       auto* ctxt = sim->GetExecutionContext();
@@ -91,7 +94,7 @@ struct ModelInitializer {
   template <typename Function>
   static void Grid3D(const std::array<size_t, 3>& agents_per_dim, real_t space,
                      Function agent_builder) {
-#pragma omp parallel
+#pragma omp parallel if (CreateInParallel())
     {
       auto* sim = Simulation::GetActive();
       auto* ctxt = sim->GetExecutionContext();
@@ -121,7 +124,7 @@ struct ModelInitializer {
   template <typename Function>
   static void CreateAgents(const std::vector<Real3>& positions,
                            Function agent_builder) {
-#pragma omp parallel
+#pragma omp parallel if (CreateInParallel())
     {
       auto* sim = Simulation::GetActive();
       auto* ctxt = sim->GetExecutionContext();
@@ -151,15 +154,15 @@ struct ModelInitializer {
   static void CreateAgentsRandom(real_t min, real_t max, uint64_t num_agents,
                                  Function agent_builder,
                                  DistributionRng<real_t>* rng = nullptr) {
-#pragma omp parallel
+#pragma omp parallel if (CreateInParallel())
     {
       auto* sim = Simulation::GetActive();
       auto* ctxt = sim->GetExecutionContext();
       auto* random = sim->GetRandom();
 
+      if (rng != nullptr) {
 #pragma omp for
-      for (uint64_t i = 0; i < num_agents; i++) {
-        if (rng != nullptr) {
+        for (uint64_t i = 0; i < num_agents; i++) {
           Real3 pos;
           bool in_range = false;
           do {
@@ -169,9 +172,23 @@ struct ModelInitializer {
           } while (!in_range);
           auto* new_agent = agent_builder(pos);
           ctxt->AddAgent(new_agent);
-        } else {
-          auto* new_agent = agent_builder(random->UniformArray<3>(min, max));
-          ctxt->AddAgent(new_agent);
+        }
+      } else {
+        // Sample the coordinates of the agents of this thread in batches
+        uint64_t start = 0;
+        uint64_t end = 0;
+        Partition(num_agents, omp_get_num_threads(), omp_get_thread_num(),
+                  &start, &end);
+        constexpr uint64_t kBatch = 1024;
+        std::vector<real_t> coords(3 * kBatch);
+        for (uint64_t i = start; i < end; i += kBatch) {
+          auto size = std::min(kBatch, end - i);
+          random->UniformArray(3 * size, coords.data(), min, max);
+          for (uint64_t j = 0; j < size; j++) {
+            auto* new_agent = agent_builder(
+                {coords[3 * j], coords[3 * j + 1], coords[3 * j + 2]});
+            ctxt->AddAgent(new_agent);
+          }
         }
       }
     }
@@ -216,7 +233,7 @@ struct ModelInitializer {
       const FixedSizeVector<real_t, 10>& fn_params, real_t xmin, real_t xmax,
       real_t deltax, real_t ymin, real_t ymax, real_t deltay,
       Function agent_builder) {
-#pragma omp parallel
+#pragma omp parallel if (CreateInParallel())
     {
       auto* sim = Simulation::GetActive();
       auto* ctxt = sim->GetExecutionContext();
@@ -275,7 +292,7 @@ struct ModelInitializer {
       real_t (*f)(const real_t*, const real_t*),
       const FixedSizeVector<real_t, 10>& fn_params, real_t xmin, real_t xmax,
       real_t ymin, real_t ymax, uint64_t num_agents, Function agent_builder) {
-#pragma omp parallel
+#pragma omp parallel if (CreateInParallel())
     {
       auto* sim = Simulation::GetActive();
       auto* ctxt = sim->GetExecutionContext();
@@ -305,7 +322,7 @@ struct ModelInitializer {
   static void CreateAgentsOnSphereRndm(const Real3& center, real_t radius,
                                        uint64_t num_agents,
                                        Function agent_builder) {
-#pragma omp parallel
+#pragma omp parallel if (CreateInParallel())
     {
       auto* sim = Simulation::GetActive();
       auto* ctxt = sim->GetExecutionContext();
@@ -365,7 +382,7 @@ struct ModelInitializer {
     for (size_t i = 0; i < num_agents; i++) {
       random_radius[i] = rng.Sample();
     }
-#pragma omp parallel shared(random_radius)
+#pragma omp parallel shared(random_radius) if (CreateInParallel())
     {
       auto* ctxt_tl = Simulation::GetActive()->GetExecutionContext();
 #pragma omp for schedule(static)
@@ -417,6 +434,14 @@ struct ModelInitializer {
     diffusion_grid->SetBoundaryConditionType(bc_type);
     diffusion_grid->SetBoundaryCondition(std::move(bc));
   }
+
+ private:
+  /// In the deterministic mode (see `Param::deterministic`), the agents are
+  /// created serially, such that their uids and random numbers do not depend
+  /// on the threads.
+  static bool CreateInParallel() {
+    return !Simulation::GetActive()->GetParam()->deterministic;
+  }
 };
 
 }  // namespace bdm
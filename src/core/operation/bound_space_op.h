@@ -76,6 +76,10 @@ struct BoundSpace : public AgentOperationImpl {
                        param->max_bound);
     }
   }
+
+  OpDataAccess GetDataAccess() const override {
+    return OpDataAccess().ReadAgents().WriteAgents();
+  }
 };
 
 }  // namespace bdm
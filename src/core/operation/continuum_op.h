@@ -43,6 +43,14 @@ class ContinuumOp : public StandaloneOperationImpl {
     const auto* env = sim->GetEnvironment();
     const auto* param = sim->GetParam();
 
+    // Apply the concentration changes of the agent operations, even if the
+    // grids are not diffused in this iteration.
+    rm->ForEachContinuum([](Continuum* cm) {
+      if (auto* dgrid = dynamic_cast<DiffusionGrid*>(cm)) {
+        dgrid->ApplyDeferredUpdates();
+      }
+    });
+
     // Compute the passed time to update the diffusion grid accordingly.
     real_t current_time = sim->GetScheduler()->GetSimulatedTime();
     delta_t_ = current_time - last_time_run_;
@@ -53,22 +61,42 @@ class ContinuumOp : public StandaloneOperationImpl {
       return;
     }
 
-    rm->ForEachContinuum([this, &env, &param](Continuum* cm) {
-      // Update the diffusion grid dimension if the environment dimensions
-      // have changed. If the space is bound, we do not need to update the
-      // dimensions, because these should not be changing anyway
-      if (env->HasGrown() &&
-          param->bound_space == Param::BoundSpaceMode::kOpen) {
-        cm->Update();
+    // Update the diffusion grid dimension if the environment dimensions
+    // have changed. If the space is bound, we do not need to update the
+    // dimensions, because these should not be changing anyway. All continua
+    // are updated before the first one is integrated, because fused grids
+    // (see `MultiSpeciesEulerGrid`) are integrated together.
+    if (env->HasGrown() && param->bound_space == Param::BoundSpaceMode::kOpen) {
+      rm->ForEachContinuum([](Continuum* cm) { cm->Update(); });
+    }
+
+    rm->ForEachContinuum([this, &param](Continuum* cm) {
+      bool integrated = true;
+      if (param->continuum_multi_rate) {
+        integrated =
+            cm->IntegrateTimeMultiRate(delta_t_, param->continuum_max_interval);
+      } else {
+        cm->IntegrateTimeAsynchronously(delta_t_);
       }
-      cm->IntegrateTimeAsynchronously(delta_t_);
+      // The gradients only change if the continuum has been integrated
       auto* dgrid = dynamic_cast<DiffusionGrid*>(cm);
-      if (dgrid && param->calculate_gradients) {
+      if (dgrid && integrated && param->calculate_gradients) {
         dgrid->CalculateGradient();
       }
     });
   }
 
+  /// Combines the accesses of all continua. The deferred concentration
+  /// changes of the agent operations are applied to the continua that they
+  /// belong to.
+  OpDataAccess GetDataAccess() const override {
+    auto access = OpDataAccess().ReadEnvironment();
+    const auto* rm = Simulation::GetActive()->GetResourceManager();
+    rm->ForEachContinuum(
+        [&](Continuum* cm) { access.Merge(cm->GetDataAccess()); });
+    return access;
+  }
+
  private:
   /// Last time when the operation was executed
   real_t last_time_run_ = 0.0;
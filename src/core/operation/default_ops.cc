@@ -20,6 +20,7 @@
 #include "core/operation/mechanical_forces_op.h"
 #include "core/operation/mechanical_forces_op_cuda.h"
 #include "core/operation/mechanical_forces_op_opencl.h"
+#include "core/operation/mechanical_forces_op_simd.h"
 #include "core/operation/operation.h"
 #include "core/operation/visualization_op.h"
 
@@ -45,10 +46,18 @@ BDM_REGISTER_OP(DividingCellOp, "DividingCellOp", kCpu);
 BDM_REGISTER_OP(MechanicalForcesOpOpenCL, "mechanical forces", kOpenCl);
 #endif
 
+BDM_REGISTER_OP(MechanicalForcesOpSimd, "mechanical forces", kCpuSimd);
+
 struct UpdateStaticnessOp : public AgentOperationImpl {
   BDM_OP_HEADER(UpdateStaticnessOp);
 
   void operator()(Agent* agent) override { agent->UpdateStaticness(); }
+
+  OpDataAccess GetDataAccess() const override {
+    return OpDataAccess().ReadAgents().WriteAgents().ReadEnvironment();
+  }
+
+  bool RequiresGlobalBarrier() const override { return true; }
 };
 
 BDM_REGISTER_OP(UpdateStaticnessOp, "update staticness", kCpu);
@@ -57,6 +66,12 @@ struct PropagateStaticnessAgentOp : public AgentOperationImpl {
   BDM_OP_HEADER(PropagateStaticnessAgentOp);
 
   void operator()(Agent* agent) override { agent->PropagateStaticness(); }
+
+  OpDataAccess GetDataAccess() const override {
+    return OpDataAccess().ReadAgents().WriteAgents().ReadEnvironment();
+  }
+
+  bool RequiresGlobalBarrier() const override { return true; }
 };
 
 BDM_REGISTER_OP(PropagateStaticnessAgentOp, "propagate staticness agentop",
@@ -66,6 +81,18 @@ struct BehaviorOp : public AgentOperationImpl {
   BDM_OP_HEADER(BehaviorOp);
 
   void operator()(Agent* agent) override { agent->RunBehaviors(); }
+
+  /// Behaviors can modify the agent and its neighbors, create and remove
+  /// agents, and read and modify substances.
+  OpDataAccess GetDataAccess() const override {
+    return OpDataAccess()
+        .ReadAgents()
+        .WriteAgents()
+        .ReadEnvironment()
+        .ReadAllContinua()
+        .WriteAllContinua()
+        .UseThreadState();
+  }
 };
 
 BDM_REGISTER_OP(BehaviorOp, "behavior", kCpu);
@@ -74,6 +101,10 @@ struct DiscretizationOp : public AgentOperationImpl {
   BDM_OP_HEADER(DiscretizationOp);
 
   void operator()(Agent* agent) override { agent->RunDiscretization(); }
+
+  OpDataAccess GetDataAccess() const override {
+    return OpDataAccess().ReadAgents().WriteAgents();
+  }
 };
 
 BDM_REGISTER_OP(DiscretizationOp, "discretization", kCpu);
@@ -36,6 +36,10 @@ struct DividingCellOp : public AgentOperationImpl {
       }
     }
   }
+
+  OpDataAccess GetDataAccess() const override {
+    return OpDataAccess().ReadAgents().WriteAgents();
+  }
 };
 
 }  // namespace bdm
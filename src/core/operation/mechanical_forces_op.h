@@ -18,10 +18,14 @@
 #include <array>
 #include <cmath>
 #include <limits>
+#include <typeinfo>
 #include <vector>
 
 #include "core/agent/agent.h"
+#include "core/agent/cell.h"
+#include "core/agent_columns.h"
 #include "core/environment/environment.h"
+#include "core/environment/uniform_grid_environment.h"
 #include "core/interaction_force.h"
 #include "core/operation/bound_space_op.h"
 #include "core/operation/operation.h"
@@ -49,9 +53,11 @@ class MechanicalForcesOp : public AgentOperationImpl {
 
   MechanicalForcesOp(const MechanicalForcesOp& other)
       : squared_radius_(other.squared_radius_),
+        largest_small_agent_size_(other.largest_small_agent_size_),
         last_time_run_(other.last_time_run_),
         delta_time_(other.delta_time_),
-        last_iteration_(other.last_iteration_) {
+        last_iteration_(other.last_iteration_),
+        use_columns_(other.use_columns_) {
     if (other.force_) {
       force_ = other.force_->NewCopy();
     }
@@ -88,13 +94,42 @@ class MechanicalForcesOp : public AgentOperationImpl {
       auto* grid = sim->GetEnvironment();
       auto search_radius = grid->GetLargestAgentSize();
       squared_radius_ = search_radius * search_radius;
+      auto* uniform_grid = dynamic_cast<UniformGridEnvironment*>(grid);
+      if (uniform_grid && uniform_grid->UsesSizeClasses()) {
+        largest_small_agent_size_ = uniform_grid->GetLargestSmallAgentSize();
+      } else {
+        largest_small_agent_size_ = 0;
+      }
+      // The column path below reproduces the default force calculation.
+      use_columns_ = uniform_grid != nullptr &&
+                     sim->GetResourceManager()->GetAgentColumns() != nullptr &&
+                     typeid(*force_) == typeid(InteractionForce);
       auto current_time = (current_iteration + 1) * param->simulation_time_step;
       delta_time_[tid] = current_time - last_time_run_[tid];
       last_time_run_[tid] = current_time;
     }
 
-    const auto& displacement =
-        agent->CalculateDisplacement(force_, squared_radius_, delta_time_[tid]);
+    // With size classes, the search radius depends on the size of the agent.
+    // See `Param::uniform_grid_large_agent_factor`
+    auto squared_radius = squared_radius_;
+    if (largest_small_agent_size_ > 0) {
+      auto radius = (agent->GetDiameter() + largest_small_agent_size_) / 2;
+      squared_radius = radius * radius;
+    }
+
+    Cell* cell = nullptr;
+    if (use_columns_ && agent->GetShape() == Shape::kSphere) {
+      cell = dynamic_cast<Cell*>(agent);
+    }
+    Real3 displacement;
+    if (cell != nullptr) {
+      displacement = CalculateDisplacementFromColumns(
+          cell, static_cast<UniformGridEnvironment*>(sim->GetEnvironment()),
+          squared_radius, delta_time_[tid]);
+    } else {
+      displacement = agent->CalculateDisplacement(force_, squared_radius,
+                                                  delta_time_[tid]);
+    }
     agent->ApplyDisplacement(displacement);
     if (param->bound_space) {
       ApplyBoundingBox(agent, param->bound_space, param->min_bound,
@@ -102,12 +137,65 @@ class MechanicalForcesOp : public AgentOperationImpl {
     }
   }
 
+  OpDataAccess GetDataAccess() const override {
+    return OpDataAccess()
+        .ReadAgents()
+        .WriteAgents()
+        .ReadEnvironment()
+        .UseThreadState();
+  }
+
+  bool RequiresGlobalBarrier() const override { return true; }
+
  private:
   InteractionForce* force_ = nullptr;
   real_t squared_radius_ = 0;
+  /// Zero if the environment does not use size classes
+  real_t largest_small_agent_size_ = 0;
   std::vector<real_t> last_time_run_;
   std::vector<real_t> delta_time_;
   std::vector<uint64_t> last_iteration_;
+  /// True if `AgentColumns` are enabled, the environment is a
+  /// `UniformGridEnvironment`, and `force_` is the default `InteractionForce`
+  bool use_columns_ = false;
+
+  /// Same result as `Cell::CalculateDisplacement`, but reads the position
+  /// and diameter of spherical neighbors from `AgentColumns` instead of the
+  /// neighbor objects. Like `MechanicalForcesOpSimd`, this assumes that
+  /// subclasses of `Cell` do not override `CalculateDisplacement`.
+  Real3 CalculateDisplacementFromColumns(Cell* cell,
+                                         UniformGridEnvironment* grid,
+                                         real_t squared_radius, real_t dt) {
+    Real3 force{0, 0, 0};
+    uint64_t non_zero_neighbor_forces = 0;
+    if (!cell->IsStatic()) {
+      auto* rm = Simulation::GetActive()->GetResourceManager();
+      const auto* columns = rm->GetAgentColumns();
+      const auto& position = cell->GetPosition();
+      auto diameter = cell->GetDiameter();
+      auto calculate_neighbor_forces =
+          L2F([&](AgentHandle nh, real_t squared_distance) {
+            Real3 neighbor_force;
+            if (columns->GetShape(nh) == Shape::kSphere) {
+              neighbor_force = force_->CalculateSphereForce(
+                  position, diameter, columns->GetPosition(nh),
+                  columns->GetDiameter(nh));
+            } else {
+              auto f = force_->Calculate(cell, rm->GetAgent(nh));
+              neighbor_force = {f[0], f[1], f[2]};
+            }
+            if (neighbor_force[0] != 0 || neighbor_force[1] != 0 ||
+                neighbor_force[2] != 0) {
+              non_zero_neighbor_forces++;
+              force += neighbor_force;
+            }
+          });
+      grid->ForEachNeighborHandle(calculate_neighbor_forces, *cell,
+                                  squared_radius);
+    }
+    return cell->CalculateDisplacementFromForce(force,
+                                                non_zero_neighbor_forces, dt);
+  }
 };
 
 }  // namespace bdm
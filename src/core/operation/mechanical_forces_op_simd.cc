@@ -0,0 +1,330 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/operation/mechanical_forces_op_simd.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "core/agent/cell.h"
+#include "core/environment/uniform_grid_environment.h"
+#include "core/operation/bound_space_op.h"
+#include "core/resource_manager.h"
+#include "core/scheduler.h"
+#include "core/shape.h"
+#include "core/simulation.h"
+#include "core/util/log.h"
+#include "core/util/random.h"
+
+// Compile the kernel for several instruction sets and select the best one at
+// run time (function multiversioning).
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define BDM_SIMD_TARGET_CLONES \
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define BDM_SIMD_TARGET_CLONES
+#endif
+
+namespace bdm {
+
+namespace detail {
+
+/// Input and output arrays of `CalculateSimdForces` (cell list order)
+struct SimdForceArgs {
+  const uint64_t* box_start;
+  const real_t* x;
+  const real_t* y;
+  const real_t* z;
+  const real_t* diameter;
+  const uint8_t* is_static;
+  std::array<int64_t, 3> num_boxes_axis;
+  real_t squared_radius;
+
+  real_t* force_x;
+  real_t* force_y;
+  real_t* force_z;
+  uint32_t* num_forces;
+  /// Number of neighbors at (almost) the same location
+  uint32_t* num_coincident;
+};
+
+// -----------------------------------------------------------------------------
+/// Calculates the sum of the forces of all neighbors on each agent in `box`.
+/// Same calculation as `InteractionForce::ForceBetweenSpheres`, except for
+/// neighbors at (almost) the same location, which are only counted.
+BDM_SIMD_TARGET_CLONES
+void CalculateSimdForces(const SimdForceArgs& args, uint64_t box) {
+  // We take virtual bigger radii to have a distant interaction, to get a
+  // desired density.
+  constexpr real_t kAdditionalRadius = 10.0 * 0.15;
+  constexpr real_t kGamma = 1;  // attraction coeff
+  constexpr real_t kK = 2;      // repulsion coeff
+
+  const auto* box_start = args.box_start;
+  const auto* x = args.x;
+  const auto* y = args.y;
+  const auto* z = args.z;
+  const auto* diameter = args.diameter;
+  const auto nx = args.num_boxes_axis[0];
+  const auto nxy = nx * args.num_boxes_axis[1];
+
+  std::array<int64_t, 3> coord = {static_cast<int64_t>(box) % nx,
+                                  (static_cast<int64_t>(box) % nxy) / nx,
+                                  static_cast<int64_t>(box) / nxy};
+  std::array<int64_t, 3> lo;
+  std::array<int64_t, 3> hi;
+  for (int d = 0; d < 3; ++d) {
+    lo[d] = std::max<int64_t>(coord[d] - 1, 0);
+    hi[d] = std::min<int64_t>(coord[d] + 1, args.num_boxes_axis[d] - 1);
+  }
+
+  for (uint64_t i = box_start[box]; i < box_start[box + 1]; ++i) {
+    real_t fx = 0;
+    real_t fy = 0;
+    real_t fz = 0;
+    // Counters of the same type as the forces, such that all reductions
+    // use the same vector width
+    real_t num_forces = 0;
+    real_t num_coincident = 0;
+    if (!args.is_static[i]) {
+      const real_t xi = x[i];
+      const real_t yi = y[i];
+      const real_t zi = z[i];
+      const real_t r1 = 0.5 * diameter[i] + kAdditionalRadius;
+      // Boxes that are adjacent along the x-axis are stored next to each
+      // other. Hence, the Moore neighborhood consists of nine ranges.
+      for (int64_t bz = lo[2]; bz <= hi[2]; ++bz) {
+        for (int64_t by = lo[1]; by <= hi[1]; ++by) {
+          const auto row = bz * nxy + by * nx;
+          const auto start = box_start[row + lo[0]];
+          const auto end = box_start[row + hi[0] + 1];
+#pragma omp simd reduction(+ : fx, fy, fz, num_forces, num_coincident)
+          for (uint64_t j = start; j < end; ++j) {
+            const real_t cx = xi - x[j];
+            const real_t cy = yi - y[j];
+            const real_t cz = zi - z[j];
+            const real_t squared_distance = cx * cx + cy * cy + cz * cz;
+            const real_t center_distance = std::sqrt(squared_distance);
+            const real_t r2 = 0.5 * diameter[j] + kAdditionalRadius;
+            // the overlap distance (how much one penetrates in the other)
+            const real_t delta = r1 + r2 - center_distance;
+            const bool overlap = j != i &&
+                                 squared_distance < args.squared_radius &&
+                                 delta >= 0;
+            const bool coincident = overlap && center_distance < 0.00000001;
+            const bool interact = overlap && !coincident;
+
+            const real_t r = (r1 * r2) / (r1 + r2);
+            const real_t f =
+                kK * delta - kGamma * std::sqrt(r * std::max<real_t>(delta, 0));
+            const real_t module = interact ? f / center_distance : 0;
+            fx += module * cx;
+            fy += module * cy;
+            fz += module * cz;
+            num_forces += module != 0 ? 1 : 0;
+            num_coincident += coincident ? 1 : 0;
+          }
+        }
+      }
+    }
+    args.force_x[i] = fx;
+    args.force_y[i] = fy;
+    args.force_z[i] = fz;
+    args.num_forces[i] = static_cast<uint32_t>(num_forces);
+    args.num_coincident[i] = static_cast<uint32_t>(num_coincident);
+  }
+}
+
+}  // namespace detail
+
+// -----------------------------------------------------------------------------
+void MechanicalForcesOpSimd::SetUp() {
+  auto* sim = Simulation::GetActive();
+  auto* param = sim->GetParam();
+  auto* grid = dynamic_cast<UniformGridEnvironment*>(sim->GetEnvironment());
+
+  if (!grid) {
+    Log::Fatal("MechanicalForcesOpSimd::SetUp",
+               "MechanicalForcesOpSimd only works with "
+               "UniformGridEnvironment.");
+    return;
+  }
+  if (grid->UsesSizeClasses()) {
+    Log::Fatal("MechanicalForcesOpSimd::SetUp",
+               "MechanicalForcesOpSimd does not support size classes "
+               "(Param::uniform_grid_large_agent_factor).");
+    return;
+  }
+
+  auto current_time = (sim->GetScheduler()->GetSimulatedSteps() + 1) *
+                      param->simulation_time_step;
+  dt_ = current_time - last_time_run_;
+  last_time_run_ = current_time;
+
+  num_agents_ = 0;
+  if (sim->GetResourceManager()->GetNumAgents() == 0 ||
+      grid->total_num_boxes_ == 0) {
+    return;
+  }
+  // Use the cell list of the environment if it is up to date. Otherwise,
+  // build a private one, such that the environment's cell list remains
+  // disabled (see `Param::uniform_grid_cell_list`).
+  if (grid->cell_list_valid_) {
+    cl_box_start_ = grid->cl_box_start_.data();
+    cl_agents_ = grid->cl_agents_.data();
+  } else {
+    grid->SortAgentsByBox(&box_start_, &agents_);
+    cl_box_start_ = box_start_.data();
+    cl_agents_ = agents_.data();
+  }
+  auto* const* agents = cl_agents_;
+  const uint64_t num_agents = cl_box_start_[grid->total_num_boxes_];
+
+  bool unsupported = false;
+#pragma omp parallel for reduction(|| : unsupported)
+  for (uint64_t i = 0; i < num_agents; ++i) {
+    auto* cell = dynamic_cast<Cell*>(agents[i]);
+    unsupported =
+        unsupported || cell == nullptr || cell->GetShape() != Shape::kSphere;
+  }
+  if (unsupported) {
+    Log::Fatal("MechanicalForcesOpSimd::SetUp",
+               "MechanicalForcesOpSimd only supports spherical agents of "
+               "type Cell.");
+    return;
+  }
+
+  num_agents_ = num_agents;
+  x_.resize(num_agents);
+  y_.resize(num_agents);
+  z_.resize(num_agents);
+  diameter_.resize(num_agents);
+  tractor_x_.resize(num_agents);
+  tractor_y_.resize(num_agents);
+  tractor_z_.resize(num_agents);
+  adherence_.resize(num_agents);
+  mass_.resize(num_agents);
+  is_static_.resize(num_agents);
+  force_x_.resize(num_agents);
+  force_y_.resize(num_agents);
+  force_z_.resize(num_agents);
+  num_forces_.resize(num_agents);
+  num_coincident_.resize(num_agents);
+
+  // Agent operations might have moved or grown agents since the last grid
+  // update. The coordinates are stored in private arrays, because the
+  // agents move at the end of this operation.
+#pragma omp parallel for
+  for (uint64_t i = 0; i < num_agents; ++i) {
+    auto* cell = bdm_static_cast<Cell*>(agents[i]);
+    const auto& pos = cell->GetPosition();
+    const auto& tf = cell->GetTractorForce();
+    x_[i] = pos[0];
+    y_[i] = pos[1];
+    z_[i] = pos[2];
+    diameter_[i] = cell->GetDiameter();
+    tractor_x_[i] = tf[0];
+    tractor_y_[i] = tf[1];
+    tractor_z_[i] = tf[2];
+    adherence_[i] = cell->GetAdherence();
+    mass_[i] = cell->GetMass();
+    is_static_[i] = cell->IsStatic();
+  }
+}
+
+// -----------------------------------------------------------------------------
+void MechanicalForcesOpSimd::operator()() {
+  auto* sim = Simulation::GetActive();
+  auto* grid = dynamic_cast<UniformGridEnvironment*>(sim->GetEnvironment());
+  const uint64_t num_boxes = grid->total_num_boxes_;
+  if (num_agents_ == 0) {
+    return;
+  }
+
+  detail::SimdForceArgs args;
+  args.box_start = cl_box_start_;
+  args.x = x_.data();
+  args.y = y_.data();
+  args.z = z_.data();
+  args.diameter = diameter_.data();
+  args.is_static = is_static_.data();
+  for (int d = 0; d < 3; ++d) {
+    args.num_boxes_axis[d] = grid->num_boxes_axis_[d];
+  }
+  args.squared_radius = grid->GetLargestAgentSizeSquared();
+  args.force_x = force_x_.data();
+  args.force_y = force_y_.data();
+  args.force_z = force_z_.data();
+  args.num_forces = num_forces_.data();
+  args.num_coincident = num_coincident_.data();
+
+  // Most boxes are empty or contain only a few agents -> dynamic scheduling
+#pragma omp parallel for schedule(dynamic, 256)
+  for (uint64_t b = 0; b < num_boxes; ++b) {
+    if (args.box_start[b] != args.box_start[b + 1]) {
+      detail::CalculateSimdForces(args, b);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void MechanicalForcesOpSimd::TearDown() {
+  auto* sim = Simulation::GetActive();
+  auto* param = sim->GetParam();
+  if (num_agents_ == 0) {
+    return;
+  }
+  const uint64_t num_agents = num_agents_;
+  auto* const* agents = cl_agents_;
+  const real_t dt = dt_;
+
+  // Same integration as in `Cell::CalculateDisplacement`
+#pragma omp parallel for
+  for (uint64_t i = 0; i < num_agents; ++i) {
+    auto* cell = bdm_static_cast<Cell*>(agents[i]);
+    Real3 movement = {tractor_x_[i] * dt, tractor_y_[i] * dt,
+                      tractor_z_[i] * dt};
+    if (!is_static_[i]) {
+      Real3 force = {force_x_[i], force_y_[i], force_z_[i]};
+      // to avoid a division by 0 if the centers are (almost) at the same
+      // location
+      if (num_coincident_[i] != 0) {
+        auto* random = sim->GetRandom();
+        for (uint32_t k = 0; k < num_coincident_[i]; ++k) {
+          force += random->template UniformArray<3>(-3.0, 3.0);
+        }
+      }
+      if (num_forces_[i] + num_coincident_[i] > 1) {
+        cell->SetStaticnessNextTimestep(false);
+      }
+      real_t norm_of_force = std::sqrt(force * force);
+      if (norm_of_force > adherence_[i]) {
+        real_t mh = dt / mass_[i];
+        movement += force * mh;
+        if (norm_of_force * mh > param->simulation_max_displacement) {
+          movement.Normalize();
+          movement *= param->simulation_max_displacement;
+        }
+      }
+    }
+    cell->ApplyDisplacement(movement);
+    if (param->bound_space) {
+      ApplyBoundingBox(cell, param->bound_space, param->min_bound,
+                       param->max_bound);
+    }
+  }
+}
+
+}  // namespace bdm
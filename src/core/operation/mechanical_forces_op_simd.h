@@ -0,0 +1,106 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_OPERATION_MECHANICAL_FORCES_OP_SIMD_H_
+#define CORE_OPERATION_MECHANICAL_FORCES_OP_SIMD_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "core/container/parallel_resize_vector.h"
+#include "core/operation/operation.h"
+#include "core/operation/operation_registry.h"
+#include "core/real_t.h"
+
+namespace bdm {
+
+/// CPU counterpart of `MechanicalForcesOpCuda` and `MechanicalForcesOpOpenCL`.
+/// Like the GPU versions, this operation flattens the agent attributes into
+/// arrays in `SetUp`, computes all displacements in one batched kernel, and
+/// applies them in `TearDown`.\n
+/// The arrays are ordered like the cell list of the `UniformGridEnvironment`
+/// (see `Param::uniform_grid_cell_list`). If the cell list is disabled, a
+/// private one is built. Hence, the candidate neighbors of an agent form nine
+/// contiguous ranges, and the force calculation is vectorized over each range
+/// with OpenMP SIMD. Boxes are distributed among the threads.
+/// On x86-64 with GCC, the kernel is compiled for AVX-512, AVX2 and the
+/// baseline instruction set, and the best version is selected at run time.\n
+/// All displacements are calculated based on the positions at the beginning
+/// of the operation.\n
+/// Usage:
+///
+///     [experimental]
+///     compute_target = "cpu_simd"
+///
+/// Limitations: only supports the `UniformGridEnvironment` without size
+/// classes, spherical agents of type `Cell` (and subclasses), and the default
+/// `InteractionForce`.
+struct MechanicalForcesOpSimd : public StandaloneOperationImpl {
+  BDM_OP_HEADER(MechanicalForcesOpSimd);
+
+ public:
+  void SetUp() override;
+
+  void operator()() override;
+
+  void TearDown() override;
+
+  OpDataAccess GetDataAccess() const override {
+    return OpDataAccess()
+        .ReadAgents()
+        .WriteAgents()
+        .ReadEnvironment()
+        .UseThreadState();
+  }
+
+ private:
+  real_t last_time_run_ = 0;
+  real_t dt_ = 0;
+
+  /// Private cell list, which is used if the cell list of the environment is
+  /// disabled. \see `UniformGridEnvironment::SortAgentsByBox`
+  ParallelResizeVector<uint64_t> box_start_;
+  ParallelResizeVector<Agent*> agents_;
+  /// Cell list of this iteration (the one of the environment or the private
+  /// one)
+  const uint64_t* cl_box_start_ = nullptr;
+  Agent* const* cl_agents_ = nullptr;
+  uint64_t num_agents_ = 0;
+
+  // Flattened agent attributes in cell list order
+  std::vector<real_t> x_;
+  std::vector<real_t> y_;
+  std::vector<real_t> z_;
+  std::vector<real_t> diameter_;
+  std::vector<real_t> tractor_x_;
+  std::vector<real_t> tractor_y_;
+  std::vector<real_t> tractor_z_;
+  std::vector<real_t> adherence_;
+  std::vector<real_t> mass_;
+  std::vector<uint8_t> is_static_;
+
+  // Results of the kernel
+  std::vector<real_t> force_x_;
+  std::vector<real_t> force_y_;
+  std::vector<real_t> force_z_;
+  /// Number of neighbors that exert a non-zero force
+  std::vector<uint32_t> num_forces_;
+  /// Number of neighbors at (almost) the same location. Their force is
+  /// random and added in `TearDown`.
+  std::vector<uint32_t> num_coincident_;
+};
+
+}  // namespace bdm
+
+#endif  // CORE_OPERATION_MECHANICAL_FORCES_OP_SIMD_H_
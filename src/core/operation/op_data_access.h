@@ -0,0 +1,134 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_OPERATION_OP_DATA_ACCESS_H_
+#define CORE_OPERATION_OP_DATA_ACCESS_H_
+
+#include <set>
+#include <string>
+
+namespace bdm {
+
+/// Describes which simulation data an operation reads and writes.\n
+/// The scheduler uses this information to execute operations without
+/// conflicting data accesses concurrently (see
+/// `Param::concurrent_operations`). Operations that do not declare their
+/// data accesses conflict with all other operations. The agent operations
+/// always use thread state (see `UseThreadState`).
+///
+///     // diffusion of substance "A" reads the environment
+///     auto access = OpDataAccess().ReadEnvironment().WriteContinuum("A");
+///
+class OpDataAccess {
+ public:
+  /// Returns an access description that conflicts with all other
+  /// operations.
+  static OpDataAccess All() {
+    OpDataAccess access;
+    access.all_ = true;
+    return access;
+  }
+
+  OpDataAccess& ReadAgents() { return Read(kAgents); }
+  OpDataAccess& WriteAgents() { return Write(kAgents); }
+  OpDataAccess& ReadEnvironment() { return Read(kEnvironment); }
+  OpDataAccess& WriteEnvironment() { return Write(kEnvironment); }
+  OpDataAccess& ReadContinuum(const std::string& name) {
+    return Read(kContinuumPrefix + name);
+  }
+  OpDataAccess& WriteContinuum(const std::string& name) {
+    return Write(kContinuumPrefix + name);
+  }
+  OpDataAccess& ReadAllContinua() { return Read(kAllContinua); }
+  OpDataAccess& WriteAllContinua() { return Write(kAllContinua); }
+
+  /// The operation uses state that is indexed by the OpenMP thread id, e.g.
+  /// the execution contexts, the random number generators
+  /// (`Simulation::GetRandom`), or buffers indexed by
+  /// `ThreadInfo::GetMyThreadId`. Concurrent operations are executed by
+  /// different thread teams with overlapping thread ids. Hence, two
+  /// operations that use thread state are never executed concurrently.
+  OpDataAccess& UseThreadState() { return Write(kThreadState); }
+
+  /// Adds the accesses of `other` to this object.
+  OpDataAccess& Merge(const OpDataAccess& other) {
+    all_ = all_ || other.all_;
+    reads_.insert(other.reads_.begin(), other.reads_.end());
+    writes_.insert(other.writes_.begin(), other.writes_.end());
+    return *this;
+  }
+
+  /// Returns true if one of the two operations writes data that the other
+  /// one reads or writes.
+  bool ConflictsWith(const OpDataAccess& other) const {
+    if (all_ || other.all_) {
+      return true;
+    }
+    return Intersects(writes_, other.reads_) ||
+           Intersects(writes_, other.writes_) ||
+           Intersects(reads_, other.writes_);
+  }
+
+  /// Returns true if this object does not contain any access.
+  bool IsEmpty() const { return !all_ && reads_.empty() && writes_.empty(); }
+
+ private:
+  static constexpr const char* kAgents = "agents";
+  static constexpr const char* kEnvironment = "environment";
+  static constexpr const char* kContinuumPrefix = "continuum:";
+  static constexpr const char* kAllContinua = "continuum:*";
+  static constexpr const char* kThreadState = "thread state";
+
+  bool all_ = false;
+  std::set<std::string> reads_;
+  std::set<std::string> writes_;
+
+  OpDataAccess& Read(const std::string& data) {
+    reads_.insert(data);
+    return *this;
+  }
+
+  OpDataAccess& Write(const std::string& data) {
+    writes_.insert(data);
+    return *this;
+  }
+
+  static bool IsContinuum(const std::string& data) {
+    return data.rfind(kContinuumPrefix, 0) == 0;
+  }
+
+  static bool Matches(const std::string& lhs, const std::string& rhs) {
+    if (lhs == rhs) {
+      return true;
+    }
+    return (lhs == kAllContinua && IsContinuum(rhs)) ||
+           (rhs == kAllContinua && IsContinuum(lhs));
+  }
+
+  static bool Intersects(const std::set<std::string>& lhs,
+                         const std::set<std::string>& rhs) {
+    for (const auto& l : lhs) {
+      for (const auto& r : rhs) {
+        if (Matches(l, r)) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+};
+
+}  // namespace bdm
+
+#endif  // CORE_OPERATION_OP_DATA_ACCESS_H_
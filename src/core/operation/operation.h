@@ -22,13 +22,14 @@
 #include <vector>
 
 #include "core/functor.h"
+#include "core/operation/op_data_access.h"
 #include "core/util/log.h"
 
 namespace bdm {
 
 class Agent;
 
-enum OpComputeTarget { kCpu, kCuda, kOpenCl };
+enum OpComputeTarget { kCpu, kCuda, kOpenCl, kCpuSimd };
 
 inline std::string OpComputeTargetString(OpComputeTarget t) {
   switch (t) {
@@ -38,6 +39,8 @@ inline std::string OpComputeTargetString(OpComputeTarget t) {
       return "kCuda";
     case OpComputeTarget::kOpenCl:
       return "kOpenCl";
+    case OpComputeTarget::kCpuSimd:
+      return "kCpuSimd";
     default:
       return "Invalid";
   }
@@ -68,6 +71,18 @@ struct OperationImpl {
   /// Returns whether or not this operations is a stand-alone operation
   virtual bool IsStandalone() = 0;
 
+  /// Returns the simulation data that this operation reads and writes.
+  /// By default, an operation conflicts with all other operations.
+  /// \see `OpDataAccess`
+  virtual OpDataAccess GetDataAccess() const { return OpDataAccess::All(); }
+
+  /// Returns true if this agent operation reads or writes the state of other
+  /// agents (e.g. neighbors). Such an operation must not be fused with other
+  /// agent operations, because all agents have to finish the previous
+  /// operation before it starts.
+  /// \see `Param::agent_op_fusion`
+  virtual bool RequiresGlobalBarrier() const { return false; }
+
   /// The target that this operation implementation is supposed to run on
   OpComputeTarget target_ = kCpu;
 };
@@ -167,6 +182,39 @@ struct Operation {
     return implementations_[active_target_]->IsStandalone();
   }
 
+  /// Returns the data accesses set with `SetDataAccess`, or the ones
+  /// declared by the active implementation otherwise.
+  OpDataAccess GetDataAccess() const {
+    if (has_data_access_) {
+      return data_access_;
+    }
+    return implementations_[active_target_]->GetDataAccess();
+  }
+
+  /// Overrides the data accesses declared by the implementation. This is
+  /// useful for operations that run user-defined code (e.g. "behavior").
+  void SetDataAccess(const OpDataAccess& access) {
+    data_access_ = access;
+    has_data_access_ = true;
+  }
+
+  /// Returns the value set with `SetRequiresGlobalBarrier`, or the one
+  /// declared by the active implementation otherwise.
+  bool RequiresGlobalBarrier() const {
+    if (has_global_barrier_) {
+      return global_barrier_;
+    }
+    return implementations_[active_target_]->RequiresGlobalBarrier();
+  }
+
+  /// Overrides the value declared by the implementation. For example, if a
+  /// behavior of the model reads the state of neighbors, the "behavior"
+  /// operation should not be fused with other operations.
+  void SetRequiresGlobalBarrier(bool barrier) {
+    global_barrier_ = barrier;
+    has_global_barrier_ = true;
+  }
+
   /// Forwards call to implementation's Setup function
   void SetUp();
 
@@ -203,6 +251,12 @@ struct Operation {
 
   /// If this is an agent operation don't run it for this list of filters
   std::set<Functor<bool, Agent *> *> exclude_filters_;
+  /// Data accesses set with `SetDataAccess`
+  OpDataAccess data_access_;
+  bool has_data_access_ = false;
+  /// Value set with `SetRequiresGlobalBarrier`
+  bool global_barrier_ = false;
+  bool has_global_barrier_ = false;
 };
 
 }  // namespace bdm
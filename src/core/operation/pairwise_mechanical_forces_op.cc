@@ -0,0 +1,259 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/operation/pairwise_mechanical_forces_op.h"
+
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+
+#include "core/agent/cell.h"
+#include "core/container/fixed_size_vector.h"
+#include "core/environment/uniform_grid_environment.h"
+#include "core/operation/bound_space_op.h"
+#include "core/resource_manager.h"
+#include "core/scheduler.h"
+#include "core/simulation.h"
+#include "core/util/log.h"
+#include "core/util/type.h"
+
+namespace bdm {
+
+BDM_REGISTER_OP(PairwiseMechanicalForcesOp, "pairwise mechanical forces",
+                kCpu);
+
+// -----------------------------------------------------------------------------
+PairwiseMechanicalForcesOp::PairwiseMechanicalForcesOp()
+    : force_(new InteractionForce()) {}
+
+// -----------------------------------------------------------------------------
+PairwiseMechanicalForcesOp::PairwiseMechanicalForcesOp(
+    const PairwiseMechanicalForcesOp& other)
+    : last_time_run_(other.last_time_run_) {
+  if (other.force_) {
+    force_ = other.force_->NewCopy();
+  }
+}
+
+// -----------------------------------------------------------------------------
+PairwiseMechanicalForcesOp::~PairwiseMechanicalForcesOp() {
+  if (force_) {
+    delete force_;
+  }
+}
+
+// -----------------------------------------------------------------------------
+void PairwiseMechanicalForcesOp::SetInteractionForce(InteractionForce* force) {
+  if (force == force_) {
+    return;
+  }
+  if (force_) {
+    delete force_;
+  }
+  force_ = force;
+}
+
+// -----------------------------------------------------------------------------
+void PairwiseMechanicalForcesOp::operator()() {
+  auto* sim = Simulation::GetActive();
+  auto* param = sim->GetParam();
+  auto* rm = sim->GetResourceManager();
+  auto* grid = dynamic_cast<UniformGridEnvironment*>(sim->GetEnvironment());
+
+  if (!grid) {
+    Log::Fatal("PairwiseMechanicalForcesOp::operator()",
+               "PairwiseMechanicalForcesOp only works with "
+               "UniformGridEnvironment.");
+    return;
+  }
+
+  if (grid->UsesSizeClasses()) {
+    Log::Fatal("PairwiseMechanicalForcesOp::operator()",
+               "PairwiseMechanicalForcesOp does not support size classes "
+               "(Param::uniform_grid_large_agent_factor).");
+    return;
+  }
+
+  auto current_time = (sim->GetScheduler()->GetSimulatedSteps() + 1) *
+                      param->simulation_time_step;
+  real_t dt = current_time - last_time_run_;
+  last_time_run_ = current_time;
+
+  if (rm->GetNumAgents() == 0 || grid->total_num_boxes_ == 0) {
+    return;
+  }
+  // Use the cell list of the environment if it is up to date. Otherwise,
+  // build a private one, such that the environment's cell list remains
+  // disabled (see `Param::uniform_grid_cell_list`).
+  if (!grid->cell_list_valid_) {
+    grid->SortAgentsByBox(&box_start_, &agents_);
+  }
+  const uint64_t num_boxes = grid->total_num_boxes_;
+  const auto* box_start = grid->cell_list_valid_ ? grid->cl_box_start_.data()
+                                                 : box_start_.data();
+  auto* const* agents =
+      grid->cell_list_valid_ ? grid->cl_agents_.data() : agents_.data();
+  const uint64_t num_agents = box_start[num_boxes];
+
+  // Agent operations might have moved agents since the last grid update.
+  // The coordinates are stored in private arrays, because the agents move
+  // at the end of this operation.
+  x_.resize(num_agents);
+  y_.resize(num_agents);
+  z_.resize(num_agents);
+  auto* x = x_.data();
+  auto* y = y_.data();
+  auto* z = z_.data();
+  bool unsupported = false;
+#pragma omp parallel for reduction(|| : unsupported)
+  for (uint64_t i = 0; i < num_agents; ++i) {
+    unsupported = unsupported || dynamic_cast<Cell*>(agents[i]) == nullptr;
+    const auto& pos = agents[i]->GetPosition();
+    x[i] = pos[0];
+    y[i] = pos[1];
+    z[i] = pos[2];
+  }
+  if (unsupported) {
+    Log::Fatal("PairwiseMechanicalForcesOp::operator()",
+               "PairwiseMechanicalForcesOp only supports agents of type "
+               "Cell.");
+    return;
+  }
+
+  // Partition the boxes into contiguous ranges (one per thread).
+  // Forward neighbor boxes are at most `reach` boxes ahead. Since the cell
+  // list is sorted by box index, the agents a thread writes to form a
+  // contiguous window.
+  const uint64_t reach = grid->num_boxes_xy_ + grid->num_boxes_axis_[0] + 1;
+  std::vector<uint64_t> box_begin;
+  std::vector<uint64_t> window_begin;
+  std::vector<uint64_t> window_end;
+
+  const auto squared_radius = grid->GetLargestAgentSizeSquared();
+
+#pragma omp parallel
+  {
+    // The partition is based on the size of the team that actually executes
+    // this region, which might be smaller than `ThreadInfo::GetMaxThreads()`
+    const uint64_t tid = omp_get_thread_num();
+#pragma omp single
+    {
+      const uint64_t num_threads = omp_get_num_threads();
+      box_begin.resize(num_threads + 1);
+      window_begin.resize(num_threads);
+      window_end.resize(num_threads);
+      for (uint64_t t = 0; t <= num_threads; ++t) {
+        box_begin[t] = num_boxes * t / num_threads;
+      }
+      for (uint64_t t = 0; t < num_threads; ++t) {
+        window_begin[t] = box_start[box_begin[t]];
+        window_end[t] =
+            box_start[std::min(box_begin[t + 1] + reach, num_boxes)];
+      }
+      thread_forces_.resize(num_threads);
+    }
+
+    auto& forces = thread_forces_[tid];
+    forces.assign(window_end[tid] - window_begin[tid], {0, 0, 0, 0});
+    const auto wb = window_begin[tid];
+
+    FixedSizeVector<size_t, 14> forward_boxes;
+    for (uint64_t b = box_begin[tid]; b < box_begin[tid + 1]; ++b) {
+      if (box_start[b] == box_start[b + 1]) {
+        continue;
+      }
+      forward_boxes.clear();
+      grid->GetHalfMooreBoxIndices(&forward_boxes, b);
+
+      for (uint64_t i = box_start[b]; i < box_start[b + 1]; ++i) {
+        auto* lhs = agents[i];
+        bool lhs_static = lhs->IsStatic();
+        for (uint64_t k = 0; k < forward_boxes.size(); ++k) {
+          auto nb = forward_boxes[k];
+          // within the same box, only consider each pair once
+          uint64_t j = k == 0 ? i + 1 : box_start[nb];
+          uint64_t end = box_start[nb + 1];
+          for (; j < end; ++j) {
+            const real_t dx = x[j] - x[i];
+            const real_t dy = y[j] - y[i];
+            const real_t dz = z[j] - z[i];
+            if (dx * dx + dy * dy + dz * dz >= squared_radius) {
+              continue;
+            }
+            auto* rhs = agents[j];
+            if (lhs_static && rhs->IsStatic()) {
+              continue;
+            }
+            auto f = force_->Calculate(lhs, rhs);
+            if (f[0] != 0 || f[1] != 0 || f[2] != 0) {
+              forces[i - wb][0] += f[0];
+              forces[i - wb][1] += f[1];
+              forces[i - wb][2] += f[2];
+              forces[i - wb][3] += 1;
+              forces[j - wb][0] -= f[0];
+              forces[j - wb][1] -= f[1];
+              forces[j - wb][2] -= f[2];
+              forces[j - wb][3] += 1;
+            }
+          }
+        }
+      }
+    }
+
+#pragma omp barrier
+
+    // Reduce the per-thread buffers and apply the displacement. Windows only
+    // extend forward; therefore, only buffers of previous threads can
+    // contain contributions for the agents owned by this thread.
+    for (uint64_t i = box_start[box_begin[tid]];
+         i < box_start[box_begin[tid + 1]]; ++i) {
+      Accumulator total = forces[i - wb];
+      for (int64_t t = static_cast<int64_t>(tid) - 1; t >= 0; --t) {
+        if (i >= window_end[t]) {
+          break;
+        }
+        const auto& other = thread_forces_[t][i - window_begin[t]];
+        for (int d = 0; d < 4; ++d) {
+          total[d] += other[d];
+        }
+      }
+
+      // Same integration as in `Cell::CalculateDisplacement`
+      auto* cell = bdm_static_cast<Cell*>(agents[i]);
+      Real3 movement = cell->GetTractorForce() * dt;
+      if (!cell->IsStatic()) {
+        if (total[3] > 1) {
+          cell->SetStaticnessNextTimestep(false);
+        }
+        Real3 force = {total[0], total[1], total[2]};
+        real_t norm_of_force = std::sqrt(force * force);
+        if (norm_of_force > cell->GetAdherence()) {
+          real_t mh = dt / cell->GetMass();
+          movement += force * mh;
+          if (norm_of_force * mh > param->simulation_max_displacement) {
+            movement.Normalize();
+            movement *= param->simulation_max_displacement;
+          }
+        }
+      }
+      cell->ApplyDisplacement(movement);
+      if (param->bound_space) {
+        ApplyBoundingBox(cell, param->bound_space, param->min_bound,
+                         param->max_bound);
+      }
+    }
+  }
+}
+
+}  // namespace bdm
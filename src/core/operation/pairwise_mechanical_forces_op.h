@@ -0,0 +1,92 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_OPERATION_PAIRWISE_MECHANICAL_FORCES_OP_H_
+#define CORE_OPERATION_PAIRWISE_MECHANICAL_FORCES_OP_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "core/container/parallel_resize_vector.h"
+#include "core/interaction_force.h"
+#include "core/operation/operation.h"
+#include "core/operation/operation_registry.h"
+
+namespace bdm {
+
+/// Standalone version of `MechanicalForcesOp` that makes use of Newton's
+/// third law. Each grid box is only paired with its 13 "forward" neighbor
+/// boxes (see `UniformGridEnvironment::GetHalfMooreBoxIndices`). Therefore,
+/// the force between two agents is calculated only once and added with
+/// opposite signs to both agents.\n
+/// Forces are accumulated in per-thread buffers, which are reduced before the
+/// displacements are applied. Hence, all forces are calculated based on the
+/// positions at the beginning of this operation.\n
+/// Usage: replace the default agent operation "mechanical forces" with
+/// "pairwise mechanical forces".
+///
+///     [simulation]
+///     unschedule_default_operations = ["mechanical forces"]
+///
+///     scheduler->ScheduleOp(NewOperation("pairwise mechanical forces"));
+///
+/// Limitations: only supports the `UniformGridEnvironment` and agents of
+/// type `Cell` (and subclasses). The `InteractionForce` must be
+/// antisymmetric, i.e. `Calculate(a, b) == -Calculate(b, a)`.
+class PairwiseMechanicalForcesOp : public StandaloneOperationImpl {
+  BDM_OP_HEADER(PairwiseMechanicalForcesOp);
+
+ public:
+  PairwiseMechanicalForcesOp();
+
+  PairwiseMechanicalForcesOp(const PairwiseMechanicalForcesOp& other);
+
+  ~PairwiseMechanicalForcesOp() override;
+
+  void SetInteractionForce(InteractionForce* force);
+
+  void operator()() override;
+
+  OpDataAccess GetDataAccess() const override {
+    return OpDataAccess()
+        .ReadAgents()
+        .WriteAgents()
+        .ReadEnvironment()
+        .UseThreadState();
+  }
+
+ private:
+  /// Accumulated force (x, y, z) and number of non-zero neighbor forces
+  using Accumulator = std::array<real_t, 4>;
+
+  InteractionForce* force_ = nullptr;
+  real_t last_time_run_ = 0;
+  /// One buffer per thread. Thread `t` processes a contiguous range of boxes
+  /// and its buffer covers all agents that can be reached from this range
+  /// with forward neighbor boxes.
+  std::vector<std::vector<Accumulator>> thread_forces_;
+  /// Private cell list, which is used if the cell list of the environment is
+  /// disabled. \see `UniformGridEnvironment::SortAgentsByBox`
+  ParallelResizeVector<uint64_t> box_start_;
+  ParallelResizeVector<Agent*> agents_;
+  /// Agent positions at the beginning of the operation in cell list order
+  std::vector<real_t> x_;
+  std::vector<real_t> y_;
+  std::vector<real_t> z_;
+};
+
+}  // namespace bdm
+
+#endif  // CORE_OPERATION_PAIRWISE_MECHANICAL_FORCES_OP_H_
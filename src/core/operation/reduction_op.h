@@ -15,7 +15,9 @@
 #ifndef CORE_OPERATION_REDUCTION_OP_H_
 #define CORE_OPERATION_REDUCTION_OP_H_
 
+#include <algorithm>
 #include <array>
+#include <utility>
 #include <vector>
 
 #include "core/agent/agent.h"
@@ -23,13 +25,80 @@
 #include "core/functor.h"
 #include "core/operation/operation.h"
 #include "core/operation/operation_registry.h"
+#include "core/param/param.h"
+#include "core/simulation.h"
 #include "core/util/thread_info.h"
 
 namespace bdm {
 
+/// Partial results of single agents for reductions in the deterministic mode
+/// (see `Param::deterministic`). They are combined in the order of the
+/// canonical agent keys. Hence, floating point results depend neither on the
+/// number of threads nor on the order in which the agents are processed.
+template <typename T>
+class CanonicalPartialResults {
+ public:
+  CanonicalPartialResults() { Clear(); }
+
+  void Clear() {
+    tl_partials_.resize(ThreadInfo::GetInstance()->GetMaxThreads());
+    for (auto& el : tl_partials_) {
+      el.clear();
+    }
+  }
+
+  /// Returns the (default-initialized) partial result of `agent`.
+  /// Thread-safe.
+  T* Add(const Agent* agent) {
+    auto tid = ThreadInfo::GetInstance()->GetMyThreadId();
+    auto& partials = tl_partials_[tid];
+    partials.emplace_back(agent->GetCanonicalKey(), T());
+    return &partials.back().second;
+  }
+
+  /// Combines the partial results with `reduce`, which has the signature of
+  /// a function that combines thread-local results
+  /// (`T(const SharedData<T>&)`).
+  template <typename TReduce>
+  T Reduce(TReduce&& reduce) const {
+    std::vector<std::pair<uint64_t, T>> sorted;
+    for (const auto& el : tl_partials_) {
+      sorted.insert(sorted.end(), el.begin(), el.end());
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::pair<uint64_t, T>& a,
+                 const std::pair<uint64_t, T>& b) {
+                return a.first < b.first;
+              });
+
+    // Blocks of partial results. The first element carries the result of the
+    // previous blocks.
+    SharedData<T> block;
+    T result = T();
+    uint64_t start = 0;
+    do {
+      auto end = std::min<uint64_t>(sorted.size(), start + kBlockSize);
+      block.resize(end - start + 1);
+      block[0] = result;
+      for (uint64_t i = start; i < end; ++i) {
+        block[i - start + 1] = sorted[i].second;
+      }
+      result = reduce(block);
+      start = end;
+    } while (start < sorted.size());
+    return result;
+  }
+
+ private:
+  static constexpr uint64_t kBlockSize = 64;
+  SharedData<std::vector<std::pair<uint64_t, T>>> tl_partials_;
+};
+
 /// A template struct for any type of operation implementation that wishes to
 /// implement a reduction operation (e.g. counting, averaging, finding minimum
-/// and maximum values, etc.)
+/// and maximum values, etc.)\n
+/// In the deterministic mode, the partial results are combined in the order
+/// of the canonical agent keys (see `CanonicalPartialResults`).
 template <typename T>
 class ReductionOp : public AgentOperationImpl {
   BDM_OP_HEADER(ReductionOp);
@@ -48,6 +117,8 @@ class ReductionOp : public AgentOperationImpl {
     for (auto& el : tl_results_) {
       el = T();
     }
+    deterministic_ = Simulation::GetActive()->GetParam()->deterministic;
+    partials_.Clear();
   }
 
   void Initialize(Functor<void, Agent*, T*>* agent_functor,
@@ -58,6 +129,10 @@ class ReductionOp : public AgentOperationImpl {
 
   // This operator will be called for each agent in a parallel loop
   void operator()(Agent* agent) override {
+    if (deterministic_) {
+      (*agent_functor_)(agent, partials_.Add(agent));
+      return;
+    }
     auto tid = ThreadInfo::GetInstance()->GetMyThreadId();
     (*agent_functor_)(agent, &(tl_results_[tid]));
   }
@@ -67,7 +142,11 @@ class ReductionOp : public AgentOperationImpl {
   // At the end of each timestep we collect the partial result of each thread
   // and reduce it to one single value
   void TearDown() override {
-    results_.push_back((*reduce_functor_)(tl_results_));
+    if (deterministic_) {
+      results_.push_back(partials_.Reduce(*reduce_functor_));
+    } else {
+      results_.push_back((*reduce_functor_)(tl_results_));
+    }
   }
 
  private:
@@ -75,6 +154,9 @@ class ReductionOp : public AgentOperationImpl {
   std::vector<T> results_;
   // The thread-local (partial) results
   SharedData<T> tl_results_;
+  // The partial results of the agents in the deterministic mode
+  CanonicalPartialResults<T> partials_;
+  bool deterministic_ = false;
 
   // The functor containing the logic on what to execute for each agent
   Functor<void, Agent*, T*>* agent_functor_ = nullptr;
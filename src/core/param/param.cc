@@ -162,6 +162,9 @@ void AssignThreadSafetyMechanism(const std::shared_ptr<cpptoml::table>& config,
           Param::ThreadSafetyMechanism::kUserSpecified;
     } else if (str_value == "automatic") {
       param->thread_safety_mechanism = Param::ThreadSafetyMechanism::kAutomatic;
+    } else if (str_value == "box-coloring") {
+      param->thread_safety_mechanism =
+          Param::ThreadSafetyMechanism::kBoxColoring;
     }
   }
 }
@@ -225,6 +228,8 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
 
   // simulation group
   BDM_ASSIGN_CONFIG_VALUE(random_seed, "simulation.random_seed");
+  BDM_ASSIGN_CONFIG_VALUE(random_generator, "simulation.random_generator");
+  BDM_ASSIGN_CONFIG_VALUE(deterministic, "simulation.deterministic");
   BDM_ASSIGN_CONFIG_VALUE(output_dir, "simulation.output_dir");
   BDM_ASSIGN_CONFIG_VALUE(environment, "simulation.environment");
   BDM_ASSIGN_CONFIG_VALUE(nanoflann_depth, "simulation.nanoflann_depth");
@@ -240,6 +245,10 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
   BDM_ASSIGN_CONFIG_VALUE(diffusion_boundary_condition,
                           "simulation.diffusion_boundary_condition");
   BDM_ASSIGN_CONFIG_VALUE(diffusion_method, "simulation.diffusion_method");
+  BDM_ASSIGN_CONFIG_VALUE(multigrid_max_v_cycles,
+                          "simulation.multigrid_max_v_cycles");
+  BDM_ASSIGN_CONFIG_VALUE(multigrid_tolerance,
+                          "simulation.multigrid_tolerance");
   BDM_ASSIGN_CONFIG_VALUE(calculate_gradients,
                           "simulation.calculate_gradients");
   AssignBoundSpaceMode(config, this);
@@ -259,6 +268,12 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
                           "visualization.export_generate_pvsm");
   BDM_ASSIGN_CONFIG_VALUE(visualization_compress_pv_files,
                           "visualization.compress_pv_files");
+  BDM_ASSIGN_CONFIG_VALUE(visualization_export_async,
+                          "visualization.export_async");
+  BDM_ASSIGN_CONFIG_VALUE(visualization_export_threads,
+                          "visualization.export_threads");
+  BDM_ASSIGN_CONFIG_VALUE(visualization_export_queue_depth,
+                          "visualization.export_queue_depth");
 
   //   visualize_agents
   auto visualize_agentstarr = config->get_table_array("visualize_agent");
@@ -338,9 +353,29 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
   // performance group
   BDM_ASSIGN_CONFIG_VALUE(scheduling_batch_size,
                           "performance.scheduling_batch_size");
+  BDM_ASSIGN_CONFIG_VALUE(work_stealing_runtime,
+                          "performance.work_stealing_runtime");
+  BDM_ASSIGN_CONFIG_VALUE(concurrent_operations,
+                          "performance.concurrent_operations");
+  BDM_ASSIGN_CONFIG_VALUE(agent_op_fusion, "performance.agent_op_fusion");
+  BDM_ASSIGN_CONFIG_VALUE(deferred_concentration_updates,
+                          "performance.deferred_concentration_updates");
+  BDM_ASSIGN_CONFIG_VALUE(lazy_gradients, "performance.lazy_gradients");
+  BDM_ASSIGN_CONFIG_VALUE(continuum_multi_rate,
+                          "performance.continuum_multi_rate");
+  BDM_ASSIGN_CONFIG_VALUE(continuum_max_interval,
+                          "performance.continuum_max_interval");
   BDM_ASSIGN_CONFIG_VALUE(detect_static_agents,
                           "performance.detect_static_agents");
   BDM_ASSIGN_CONFIG_VALUE(cache_neighbors, "performance.cache_neighbors");
+  BDM_ASSIGN_CONFIG_VALUE(uniform_grid_cell_list,
+                          "performance.uniform_grid_cell_list");
+  BDM_ASSIGN_CONFIG_VALUE(uniform_grid_large_agent_factor,
+                          "performance.uniform_grid_large_agent_factor");
+  BDM_ASSIGN_CONFIG_VALUE(verlet_skin, "performance.verlet_skin");
+  BDM_ASSIGN_CONFIG_VALUE(uniform_grid_incremental_update,
+                          "performance.uniform_grid_incremental_update");
+  BDM_ASSIGN_CONFIG_VALUE(agent_columns, "performance.agent_columns");
   BDM_ASSIGN_CONFIG_VALUE(use_bdm_mem_mgr, "performance.use_bdm_mem_mgr");
   BDM_ASSIGN_CONFIG_VALUE(mem_mgr_aligned_pages_shift,
                           "performance.mem_mgr_aligned_pages_shift");
@@ -350,10 +385,19 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
                           "performance.mem_mgr_max_mem_per_thread_factor");
   BDM_ASSIGN_CONFIG_VALUE(minimize_memory_while_rebalancing,
                           "performance.minimize_memory_while_rebalancing");
+  BDM_ASSIGN_CONFIG_VALUE(cost_weighted_load_balancing,
+                          "performance.cost_weighted_load_balancing");
   AssignMappedDataArrayMode(config, this);
 
   // development group
   BDM_ASSIGN_CONFIG_VALUE(statistics, "development.statistics");
+  BDM_ASSIGN_CONFIG_VALUE(profiling, "development.profiling");
+  BDM_ASSIGN_CONFIG_VALUE(profiling_buffer_size,
+                          "development.profiling_buffer_size");
+  BDM_ASSIGN_CONFIG_VALUE(profiling_max_trace_events,
+                          "development.profiling_max_trace_events");
+  BDM_ASSIGN_CONFIG_VALUE(cost_accounting_sampling_interval,
+                          "development.cost_accounting_sampling_interval");
   BDM_ASSIGN_CONFIG_VALUE(debug_numa, "development.debug_numa");
   BDM_ASSIGN_CONFIG_VALUE(show_simulation_step,
                           "development.show_simulation_step");
@@ -89,6 +89,23 @@ struct Param {
   ///     random_seed = 4357
   uint64_t random_seed = 4357;
 
+  /// Random number generator of each thread.\n
+  /// Possible values are: "TRandom3" (ROOT's Mersenne twister seeded as
+  /// described for `random_seed`) and "philox" (counter-based generator
+  /// `PhiloxRandom` with key `random_seed`; thread `tid` draws from stream
+  /// `tid`).\n
+  /// With "philox", `Random` calls the engine without virtual function calls,
+  /// the batch functions (e.g. `Random::UniformArray`) fill buffers with SIMD
+  /// code, and the agent operations of each agent draw from their own
+  /// substream of the agent and time step. The deterministic mode (see
+  /// `deterministic`) always uses "philox".\n
+  /// Default value: `"TRandom3"`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     random_generator = "TRandom3"
+  std::string random_generator = "TRandom3";
+
   /// List of default operation names that should not be scheduled by default
   /// Default value: `{}`\n
   /// TOML config file:
@@ -244,9 +261,19 @@ struct Param {
   std::string diffusion_boundary_condition = "Neumann";
 
   /// A string for determining diffusion type within the simulation space.
-  /// Currently, only the method "euler" implementing a FTCS scheme is
-  /// supported. See for instance here:
-  /// https://en.wikipedia.org/wiki/FTCS_scheme (accessed 2023-07-17)
+  /// Supported methods:\n
+  /// "euler": explicit FTCS scheme (`EulerGrid`). See for instance here:
+  /// https://en.wikipedia.org/wiki/FTCS_scheme (accessed 2023-07-17).
+  /// The time step is limited by a stability condition.\n
+  /// "adi": unconditionally stable alternating direction implicit scheme
+  /// (`ADIGrid`). Suited for substances with high diffusion coefficients or
+  /// fine resolutions.\n
+  /// "sparse_euler": explicit scheme that only stores and updates the regions
+  /// of the grid that contain the substance (`SparseEulerGrid`). Suited for
+  /// localized sources in large simulation spaces.\n
+  /// "steady_state": solves for the equilibrium of the current sources and
+  /// sinks with a multigrid method (`SteadyStateGrid`). Suited for substances
+  /// that equilibrate much faster than the agents change.\n
   /// Default value: `"euler"`\n TOML
   /// config file:
   ///
@@ -256,6 +283,25 @@ struct Param {
 
   std::string diffusion_method = "euler";
 
+  /// Maximum number of multigrid V-cycles per step of the diffusion method
+  /// "steady_state".\n
+  /// Default value: `20`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     multigrid_max_v_cycles = 20
+  uint64_t multigrid_max_v_cycles = 20;
+
+  /// The diffusion method "steady_state" stops the V-cycles of a step if the
+  /// residual is smaller than this tolerance times the norm of the right hand
+  /// side.\n
+  /// Default value: `1e-6`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     multigrid_tolerance = 1e-6
+  real_t multigrid_tolerance = 1e-6;
+
   /// Calculate the diffusion gradient for each substance.\n
   /// TOML config file:
   /// Default value: `true`\n
@@ -269,11 +315,21 @@ struct Param {
   /// `kUserSpecified`: The user has to define all agent that must
   /// not be processed in parallel. \see `Agent::CriticalRegion`.\n
   /// `kAutomatic`: The simulation automatically locks all agents
-  /// of the microenvironment.
-  enum ThreadSafetyMechanism { kNone = 0, kUserSpecified, kAutomatic };
+  /// of the microenvironment.\n
+  /// `kBoxColoring`: Same guarantee as `kAutomatic`, but without locks.
+  /// The boxes of the `UniformGridEnvironment` are partitioned into 27
+  /// colors such that boxes of the same color do not share neighbor boxes.
+  /// The agent operations are executed color by color.
+  /// \see `UniformGridEnvironment::ForEachAgentByBoxColor`
+  enum ThreadSafetyMechanism {
+    kNone = 0,
+    kUserSpecified,
+    kAutomatic,
+    kBoxColoring
+  };
 
   /// Select the thread-safety mechanism.\n
-  /// Possible values are: none, user-specified, automatic.\n
+  /// Possible values are: none, user-specified, automatic, box-coloring.\n
   /// TOML config file:
   ///
   ///     [simulation]
@@ -281,6 +337,35 @@ struct Param {
   ThreadSafetyMechanism thread_safety_mechanism =
       ThreadSafetyMechanism::kUserSpecified;
 
+  /// Produce bit-identical results independent of the number of threads and
+  /// of the thread scheduling.\n
+  /// Requires the `UniformGridEnvironment`. The agent operations are executed
+  /// by box color (see `ThreadSafetyMechanism::kBoxColoring`) and the agents
+  /// in each box are ordered by `Agent::GetCanonicalKey`. In each time step,
+  /// the agent operations of an agent draw random numbers from their own
+  /// counter-based stream (`PhiloxRandom`), which is derived from the seed,
+  /// the key of the agent and the time step. If an agent is executed several
+  /// times per step (e.g. `kForEachOpForEachAgent`), each execution continues
+  /// the stream of the previous one. New agents are added to the
+  /// `ResourceManager` sorted by their key, removed agents are removed sorted
+  /// by their position in the `ResourceManager`, and floating point
+  /// reductions (`ReductionOp`, `experimental::GenericReducer`,
+  /// `experimental::Reduce`, and thus `TimeSeries`) combine the contributions
+  /// of the agents in the order of their keys. The `ModelInitializer` creates
+  /// agents serially. Concentration changes are deferred (see
+  /// `deferred_concentration_updates`) and applied in the order of the agent
+  /// keys.\n
+  /// Not covered: random numbers drawn, agents created and concentrations
+  /// changed in other parallel regions. The agent uids of agents that are
+  /// created in parallel depend on the thread scheduling. Uids only identify
+  /// agents; use `Agent::GetCanonicalKey` to match agents between runs.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     deterministic = false
+  bool deterministic = false;
+
   // visualization values ------------------------------------------------------
 
   /// Name of the visualization engine to use for visualizaing BioDynaMo
@@ -426,6 +511,40 @@ struct Param {
   ///
   bool visualization_compress_pv_files = true;
 
+  /// If `export_visualization` is set to true, this parameter specifies if
+  /// the files are written asynchronously.\n
+  /// At each export, the visualized data is copied into a staging buffer and
+  /// handed to `visualization_export_threads` dedicated I/O threads, which
+  /// compress and write it while the simulation continues. The files of the
+  /// last exports are complete once the `Simulation` has been destroyed.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [visualization]
+  ///     export_async = false
+  bool visualization_export_async = false;
+
+  /// Number of I/O threads that write the files of
+  /// `visualization_export_async`.\n
+  /// Default value: `2`\n
+  /// TOML config file:
+  ///
+  ///     [visualization]
+  ///     export_threads = 2
+  uint64_t visualization_export_threads = 2;
+
+  /// Maximum number of exports of `visualization_export_async` that are
+  /// staged but not yet written. If the limit is reached, the next export
+  /// blocks the simulation until the oldest one has been written. The
+  /// default value of one corresponds to double buffering: the simulation
+  /// stages the next export while the previous one is written.\n
+  /// Default value: `1`\n
+  /// TOML config file:
+  ///
+  ///     [visualization]
+  ///     export_queue_depth = 1
+  uint64_t visualization_export_queue_depth = 1;
+
   // performance values --------------------------------------------------------
 
   /// Batch size used by the `Scheduler` to iterate over agents\n
@@ -436,6 +555,36 @@ struct Param {
   ///     scheduling_batch_size = 1000
   uint64_t scheduling_batch_size = 1000;
 
+  /// If set to true, `ResourceManager::ForEachAgentParallel(chunk, ...)`
+  /// executes the batches with the `WorkStealingRuntime` (per-thread deques,
+  /// randomized NUMA-aware stealing) instead of the default scheduling loop,
+  /// in which idle threads scan the counters of all other threads.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     work_stealing_runtime = false
+  bool work_stealing_runtime = false;
+
+  /// If set to true, the scheduler builds a dependency graph of the agent
+  /// operations and standalone operations in each iteration, based on the
+  /// data that they read and write (see `OpDataAccess`). Operations without
+  /// conflicting data accesses are executed concurrently. For example,
+  /// the diffusion of a substance can overlap with agent operations that do
+  /// not access this substance.\n
+  /// Operations that do not declare their data accesses conflict with all
+  /// other operations. Use `Operation::SetDataAccess` to declare them for a
+  /// specific model. Operations that use state indexed by the thread id
+  /// (e.g. the agent operations) are not executed concurrently with each
+  /// other. Concurrent operations start their own OpenMP thread teams and
+  /// thus share the cores.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     concurrent_operations = false
+  bool concurrent_operations = false;
+
   enum ExecutionOrder { kForEachAgentForEachOp = 0, kForEachOpForEachAgent };
 
   /// This parameter determines whether to execute  `kForEachAgentForEachOp`
@@ -456,6 +605,83 @@ struct Param {
   /// \endcode
   ExecutionOrder execution_order = ExecutionOrder::kForEachAgentForEachOp;
 
+  /// Only used if `execution_order == kForEachOpForEachAgent`.\n
+  /// If set to true, consecutive agent operations are fused: the scheduler
+  /// runs all operations of a group on a batch of agents before it moves on
+  /// to the next batch, instead of traversing all agents once per operation.
+  /// Since the agents are sorted along a space-filling curve during load
+  /// balancing, a batch corresponds to a spatially compact tile of the
+  /// simulation space.\n
+  /// Operations that return true for `Operation::RequiresGlobalBarrier`
+  /// (e.g. "mechanical forces", which reads the state of neighbors) are
+  /// never fused and keep the op-by-op semantics.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     agent_op_fusion = false
+  bool agent_op_fusion = false;
+
+  /// If set to true, `DiffusionGrid::ChangeConcentrationBy` records the
+  /// changes in per-thread buffers instead of modifying the grid under a
+  /// per-box lock. The recorded changes are sorted by box and applied in one
+  /// parallel pass before the next diffusion step (see `ContinuumOp`).
+  /// Hence, `GetConcentration` reads the grid without locks, and the lock
+  /// array, which is as large as the grid, is not allocated. The changes of a
+  /// box are applied in the order of the keys of the agents that made them
+  /// (see `ExecutionContext::NextChange`), independent of the threads that
+  /// executed the agents. Always enabled in `deterministic` mode.\n
+  /// Note that changes become visible only after they have been applied,
+  /// i.e. agents read the concentrations of the previous diffusion step.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     deferred_concentration_updates = false
+  bool deferred_concentration_updates = false;
+
+  /// If set to true (and `calculate_gradients` is set), the gradients of the
+  /// diffusion grids are not computed for all boxes after each diffusion
+  /// step. Instead, `DiffusionGrid::GetGradient` computes the gradient of a
+  /// box on its first access after the diffusion step and caches it until
+  /// the next step. The cache is allocated in pages of boxes on first
+  /// access. This is beneficial if only a small fraction of the boxes is
+  /// queried, e.g. by a few chemotactic agents.\n
+  /// NB: The gradient is computed from the concentrations at the time of the
+  /// first access. Use `deferred_concentration_updates` if agents change the
+  /// concentrations in the same iteration.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     lazy_gradients = false
+  bool lazy_gradients = false;
+
+  /// If set to true, `ContinuumOp` integrates each continuum at its own rate
+  /// (see `Continuum::IntegrateTimeMultiRate`). The cadence is derived from
+  /// the stability limit of each continuum (`Continuum::GetStableTimeStep`):
+  /// continua whose stable time step is larger than the time step of the
+  /// agents are only integrated every few steps with a correspondingly larger
+  /// time step, and continua whose stable time step is smaller subcycle with
+  /// it. Continua with a time step set via `Continuum::SetTimeStep` are not
+  /// affected.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     continuum_multi_rate = false
+  bool continuum_multi_rate = false;
+
+  /// Maximum number of `ContinuumOp` executions between two integrations of
+  /// a continuum if `continuum_multi_rate` is set. Limits the time step of
+  /// continua without (or with a very large) stability limit, e.g. `ADIGrid`.\n
+  /// Default value: `10`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     continuum_max_interval = 10
+  uint64_t continuum_max_interval = 10;
+
   /// Calculation of the displacement (mechanical interaction) is an
   /// expensive operation. If agents do not move or grow,
   /// displacement calculation is omitted if detect_static_agents is turned
@@ -479,6 +705,94 @@ struct Param {
   ///     cache_neighbors = false
   bool cache_neighbors = false;
 
+  /// If set to true, the `UniformGridEnvironment` additionally builds a cell
+  /// list during each update: the agents of each box are stored contiguously
+  /// (sorted by box index). Neighbor searches then iterate over contiguous
+  /// ranges instead of following the linked list of each box. The distances
+  /// are computed from the current positions, which are read from the agent
+  /// columns if `agent_columns` is set.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     uniform_grid_cell_list = false
+  bool uniform_grid_cell_list = false;
+
+  /// If set to a value larger than zero, the `UniformGridEnvironment` splits
+  /// the agents into two size classes. Agents with a diameter larger than
+  /// `uniform_grid_large_agent_factor` times the mean diameter are large
+  /// agents. The box length is determined by the largest small agent and
+  /// not by the largest agent overall. Large agents are kept in a separate
+  /// list.\n
+  /// In this mode, neighbor searches may exceed the box length, and
+  /// the search radius is interpreted as the radius for small neighbors.
+  /// Large neighbors are returned if they are within the search radius
+  /// plus half the difference between their diameter and the diameter of
+  /// the largest small agent. Hence, `MechanicalForcesOp` can use
+  /// `own_diameter + largest_small_diameter` as search diameter for each
+  /// agent. This assumes that the interaction range of an agent is given by
+  /// its diameter.\n
+  /// Implies `uniform_grid_cell_list`.\n
+  /// Incompatibilities: size classes are not used if `verlet_skin` is larger
+  /// than zero, or if the box length or the simulation space are fixed.
+  /// `uniform_grid_incremental_update` is ignored in this mode. The thread
+  /// safety mechanisms `automatic` and `box-coloring` only protect the
+  /// surrounding boxes and are therefore rejected.\n
+  /// Default value: `0` (disabled)\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     uniform_grid_large_agent_factor = 0
+  real_t uniform_grid_large_agent_factor = 0;
+
+  /// If set to a value larger than zero, the `UniformGridEnvironment` builds
+  /// a Verlet neighbor list for each agent. The lists contain all agents
+  /// within the box length, which is increased by `verlet_skin`.
+  /// Afterwards, the grid and the lists are only rebuilt if agents were
+  /// added, removed, or reordered, if an agent moved more than
+  /// `verlet_skin / 2` since the last build, or if an agent has grown
+  /// beyond the box length minus the skin. Otherwise, neighbor searches of
+  /// agents iterate over their Verlet list.\n
+  /// Recommended for simulations in which agents move far less than the
+  /// box length per iteration. Takes precedence over
+  /// `uniform_grid_large_agent_factor`.\n
+  /// Default value: `0` (disabled)\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     verlet_skin = 0
+  real_t verlet_skin = 0;
+
+  /// If set to true, the `UniformGridEnvironment` keeps its boxes between
+  /// updates and only relinks agents that moved to a different box, as well
+  /// as agents that have been added since the last update.
+  /// A full rebuild is performed if agents have been removed or reordered
+  /// (e.g. load balancing), if the agents leave the current grid, or if the
+  /// largest agent no longer fits into a box. Not used together with
+  /// `uniform_grid_large_agent_factor`.\n
+  /// NB: In contrast to a full rebuild, the grid does not shrink if the
+  /// agents occupy a smaller space.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     uniform_grid_incremental_update = false
+  bool uniform_grid_incremental_update = false;
+
+  /// If set to true, the `ResourceManager` maintains a structure-of-arrays
+  /// copy of the agent positions, diameters, tractor forces, staticness, and
+  /// box indices (see `AgentColumns`). The agent setters write through to
+  /// the columns. The `UniformGridEnvironment` uses them to build the grid
+  /// and to filter neighbor candidates, `MechanicalForcesOp` computes the
+  /// forces between spheres from them, and the ParaView export reads the
+  /// position and diameter of cells from them.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     agent_columns = false
+  bool agent_columns = false;
+
   /// Default value: `true`\n
   /// TOML config file:
   ///
@@ -535,6 +849,22 @@ struct Param {
   ///     minimize_memory_while_rebalancing = true
   bool minimize_memory_while_rebalancing = true;
 
+  /// If set to true, the execution time of the agent operations is measured
+  /// for each agent (see `AgentCosts`). `ResourceManager::LoadBalance`
+  /// distributes agents to NUMA nodes and threads such that each thread
+  /// receives the same share of the measured cost instead of the same number
+  /// of agents. `ResourceManager::ForEachAgentParallel` uses the costs to
+  /// determine the initial chunk ranges of each thread.\n
+  /// Since load balancing is only executed in the first iteration by default,
+  /// the frequency of the operation "load balancing" should be adjusted.\n
+  /// Requires the `UniformGridEnvironment`.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     cost_weighted_load_balancing = false
+  bool cost_weighted_load_balancing = false;
+
   /// MappedDataArrayMode options:
   ///   `kZeroCopy`: access agent data directly only if it is
   ///                requested. \n
@@ -567,6 +897,50 @@ struct Param {
   ///     statistics = false
   bool statistics = false;
 
+  /// Enables the hierarchical profiler (see `Profiler`). It records
+  /// operations, batches of agent operations, behaviors and the phases of the
+  /// environment update with nanosecond resolution and per thread. At the end
+  /// of the simulation, the results are written to the output directory:
+  /// `profile.json` (Chrome trace format, open with chrome://tracing or
+  /// https://ui.perfetto.dev) and `profile.folded` (input for flamegraph.pl).
+  /// If `statistics` is enabled as well, the aggregated call tree is printed.\n
+  /// Default Value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [development]
+  ///     profiling = false
+  bool profiling = false;
+
+  /// Number of profiler events per thread and iteration that are kept for
+  /// the trace. If a thread records more events, the oldest ones are dropped.
+  /// The aggregated call tree is not affected.\n
+  /// Default Value: `65536`\n
+  /// TOML config file:
+  ///
+  ///     [development]
+  ///     profiling_buffer_size = 65536
+  uint64_t profiling_buffer_size = 65536;
+
+  /// Maximum number of events in the profiler trace of the whole simulation.
+  /// \see `profiling_buffer_size`\n
+  /// Default Value: `1000000`\n
+  /// TOML config file:
+  ///
+  ///     [development]
+  ///     profiling_max_trace_events = 1000000
+  uint64_t profiling_max_trace_events = 1000000;
+
+  /// Measures the execution time of every n-th agent operation call of each
+  /// thread and attributes it to the agent type and to the behaviors that
+  /// it runs (see `CostAccounting`). The results are shown in
+  /// `Scheduler::PrintInfo`. A value of zero disables the measurement.\n
+  /// Default Value: `0`\n
+  /// TOML config file:
+  ///
+  ///     [development]
+  ///     cost_accounting_sampling_interval = 0
+  uint64_t cost_accounting_sampling_interval = 0;
+
   /// Automatically track changes in the simulation and BioDynaMo repository.
   /// If set to true, BioDynaMo scans the simulation directory and the BioDynaMo
   /// repository for changes and saves the information of the git repositories
@@ -617,7 +991,9 @@ struct Param {
   // experimental group
 
   /// Run the simulation partially on the GPU for improved performance.
-  /// Possible values: "cpu", "cuda", "opencl"
+  /// "cpu_simd" selects the batched and vectorized CPU implementations of
+  /// the GPU operations instead (e.g. `MechanicalForcesOpSimd`).
+  /// Possible values: "cpu", "cuda", "opencl", "cpu_simd"
   /// Default value: `"cpu"`\n
   /// TOML config file:
   ///     [experimental]
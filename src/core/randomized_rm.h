@@ -83,9 +83,13 @@ void RandomizedRm<TBaseRm>::RandomizeAgentsOrder() {
 #endif  // LINUX
   }
 
-  // update uid_ah_map_
-  auto update_agent_map = L2F([this](Agent* a, AgentHandle ah) {
+  // update uid_ah_map_ and the agent columns
+  auto* agent_columns = this->agent_columns_;
+  auto update_agent_map = L2F([this, agent_columns](Agent* a, AgentHandle ah) {
     this->uid_ah_map_.Insert(a->GetUid(), ah);
+    if (agent_columns) {
+      agent_columns->Set(ah, a);
+    }
   });
   TBaseRm::ForEachAgentParallel(update_agent_map);
 }
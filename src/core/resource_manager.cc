@@ -23,7 +23,9 @@
 #include "core/simulation.h"
 #include "core/util/partition.h"
 #include "core/util/plot_memory_layout.h"
+#include "core/util/profiler.h"
 #include "core/util/timing.h"
+#include "core/util/work_stealing_runtime.h"
 
 namespace bdm {
 
@@ -40,6 +42,12 @@ ResourceManager::ResourceManager() {
   if (param->export_visualization || param->insitu_visualization) {
     type_index_ = new TypeIndex();
   }
+  if (param->cost_weighted_load_balancing) {
+    agent_costs_ = new AgentCosts();
+  }
+  if (param->agent_columns) {
+    agent_columns_ = new AgentColumns(agents_.size());
+  }
 }
 
 ResourceManager::~ResourceManager() {
@@ -54,6 +62,12 @@ ResourceManager::~ResourceManager() {
   if (type_index_) {
     delete type_index_;
   }
+  if (agent_costs_) {
+    delete agent_costs_;
+  }
+  if (agent_columns_) {
+    delete agent_columns_;
+  }
 }
 
 void ResourceManager::ForEachAgentParallel(
@@ -104,6 +118,24 @@ void ResourceManager::ForEachAgentParallel(Operation& op,
 void ResourceManager::ForEachAgentParallel(
     uint64_t chunk, Functor<void, Agent*, AgentHandle>& function,
     Functor<bool, Agent*>* filter) {
+  auto process_batch = L2F([&](AgentHandle::NumaNode_t nid,
+                               AgentHandle::ElementIdx_t start,
+                               AgentHandle::ElementIdx_t end) {
+    auto& numa_agents = agents_[nid];
+    for (AgentHandle::ElementIdx_t i = start; i < end; ++i) {
+      auto* a = numa_agents[i];
+      if (!filter || (filter && (*filter)(a))) {
+        function(a, AgentHandle(nid, i));
+      }
+    }
+  });
+  ForEachAgentBatchParallel(chunk, process_batch);
+}
+
+void ResourceManager::ForEachAgentBatchParallel(
+    uint64_t chunk,
+    Functor<void, AgentHandle::NumaNode_t, AgentHandle::ElementIdx_t,
+            AgentHandle::ElementIdx_t>& function) {
   // adapt chunk size
   auto num_agents = GetNumAgents();
   uint64_t factor = (num_agents / thread_info_->GetMaxThreads()) / chunk;
@@ -122,28 +154,93 @@ void ResourceManager::ForEachAgentParallel(
     num_chunks_per_numa[n] = agents_[n].size() / chunk + correction;
   }
 
-  std::vector<std::atomic<uint64_t>*> counters(max_threads, nullptr);
-  std::vector<uint64_t> max_counters(max_threads);
+  // If agent costs have been measured, the initial chunk ranges are chosen
+  // such that each thread receives the same share of the cost measured in
+  // the previous iteration.
+  const bool measure_costs = agent_costs_ && agent_costs_->IsMeasuring();
+  const bool use_costs = agent_costs_ && agent_costs_->HasCosts();
+  auto cost_weighted_boundary = [&](uint64_t nid,
+                                    uint64_t numa_tid) -> uint64_t {
+    auto threads_in_numa = thread_info_->GetThreadsInNumaNode(nid);
+    auto size = agents_[nid].size();
+    auto total_cost = agent_costs_->GetCummulatedCost(nid, size);
+    if (numa_tid == 0 || total_cost <= 0) {
+      return num_chunks_per_numa[nid] * numa_tid / threads_in_numa;
+    }
+    auto agent_idx = agent_costs_->FindAgent(
+        nid, size, total_cost * numa_tid / threads_in_numa);
+    return std::min(num_chunks_per_numa[nid], agent_idx / chunk);
+  };
+
+  // initial chunk range of each thread (within its numa node)
+  std::vector<uint64_t> thread_begin(max_threads);
+  std::vector<uint64_t> thread_end(max_threads);
   for (int thread_cnt = 0; thread_cnt < max_threads; thread_cnt++) {
     uint64_t current_nid = thread_info_->GetNumaNode(thread_cnt);
 
-    auto correction =
-        num_chunks_per_numa[current_nid] %
-                    thread_info_->GetThreadsInNumaNode(current_nid) ==
-                0
-            ? 0
-            : 1;
-    uint64_t num_chunks_per_thread =
-        num_chunks_per_numa[current_nid] /
-            thread_info_->GetThreadsInNumaNode(current_nid) +
-        correction;
-    auto start =
-        num_chunks_per_thread * thread_info_->GetNumaThreadId(thread_cnt);
-    auto end = std::min(num_chunks_per_numa[current_nid],
-                        start + num_chunks_per_thread);
-
-    counters[thread_cnt] = new std::atomic<uint64_t>(start);
-    max_counters[thread_cnt] = end;
+    uint64_t start = 0;
+    uint64_t end = 0;
+    if (use_costs) {
+      auto numa_tid = thread_info_->GetNumaThreadId(thread_cnt);
+      start = cost_weighted_boundary(current_nid, numa_tid);
+      end = numa_tid + 1 == thread_info_->GetThreadsInNumaNode(current_nid)
+                ? num_chunks_per_numa[current_nid]
+                : cost_weighted_boundary(current_nid, numa_tid + 1);
+    } else {
+      auto correction =
+          num_chunks_per_numa[current_nid] %
+                      thread_info_->GetThreadsInNumaNode(current_nid) ==
+                  0
+              ? 0
+              : 1;
+      uint64_t num_chunks_per_thread =
+          num_chunks_per_numa[current_nid] /
+              thread_info_->GetThreadsInNumaNode(current_nid) +
+          correction;
+      start = num_chunks_per_thread * thread_info_->GetNumaThreadId(thread_cnt);
+      end = std::min(num_chunks_per_numa[current_nid],
+                     start + num_chunks_per_thread);
+    }
+
+    thread_begin[thread_cnt] = start;
+    thread_end[thread_cnt] = end;
+  }
+
+  // The scopes of the worker threads are recorded below the scope of the
+  // calling thread (e.g. "agent ops")
+  const auto profile_path = ProfilePathScope::GetPath();
+  auto process_chunk = [&](int current_nid, uint64_t chunk_idx) {
+    ProfilePathScope profile_scope(profile_path);
+    auto& numa_agents = agents_[current_nid];
+    uint64_t start = chunk_idx * chunk;
+    uint64_t end =
+        std::min(static_cast<uint64_t>(numa_agents.size()), start + chunk);
+
+    int64_t chunk_start_time = 0;
+    if (measure_costs) {
+      chunk_start_time = AgentCosts::Now();
+    }
+    if (start < end) {
+      function(current_nid, start, end);
+    }
+    if (measure_costs) {
+      agent_costs_->AddChunkCost(current_nid, start, end,
+                                 AgentCosts::Now() - chunk_start_time);
+    }
+  };
+
+  if (Simulation::GetActive()->GetParam()->work_stealing_runtime) {
+    auto task = L2F(process_chunk);
+    WorkStealingRuntime::GetInstance()->ParallelForNuma(
+        num_chunks_per_numa, task, thread_begin, thread_end);
+    return;
+  }
+
+  std::vector<std::atomic<uint64_t>*> counters(max_threads, nullptr);
+  std::vector<uint64_t> max_counters(max_threads);
+  for (int thread_cnt = 0; thread_cnt < max_threads; thread_cnt++) {
+    counters[thread_cnt] = new std::atomic<uint64_t>(thread_begin[thread_cnt]);
+    max_counters[thread_cnt] = thread_end[thread_cnt];
   }
 
 #pragma omp parallel
@@ -155,13 +252,8 @@ void ResourceManager::ForEachAgentParallel(
     // firstprivate(chunk, numa_node_) with some openmp versions clause)
     auto p_numa_nodes = thread_info_->GetNumaNodes();
     auto p_max_threads = omp_get_max_threads();
-    auto p_chunk = chunk;
     assert(thread_info_->GetNumaNode(tid) == numa_node_of_cpu(sched_getcpu()));
 
-    // dynamic scheduling
-    uint64_t start = 0;
-    uint64_t end = 0;
-
     // this loop implements work stealing from other NUMA nodes if there
     // are imbalances. Each thread starts with its NUMA domain. Once, it
     // is finished the thread looks for tasks on other domains
@@ -173,20 +265,9 @@ void ResourceManager::ForEachAgentParallel(
           continue;
         }
 
-        auto& numa_agents = agents_[current_nid];
         uint64_t old_count = (*(counters[current_tid]))++;
         while (old_count < max_counters[current_tid]) {
-          start = old_count * p_chunk;
-          end = std::min(static_cast<uint64_t>(numa_agents.size()),
-                         start + p_chunk);
-
-          for (uint64_t i = start; i < end; ++i) {
-            auto* a = numa_agents[i];
-            if (!filter || (filter && (*filter)(a))) {
-              function(a, AgentHandle(current_nid, i));
-            }
-          }
-
+          process_chunk(current_nid, old_count);
           old_count = (*(counters[current_tid]))++;
         }
       }  // work stealing loop numa_nodes_
@@ -206,17 +287,22 @@ struct LoadBalanceFunctor : public Functor<void, Iterator<AgentHandle>*> {
   std::vector<Agent*>& dest;
   AgentUidMap<AgentHandle>& uid_ah_map;
   TypeIndex* type_index;
+  AgentCosts* agent_costs;
+  AgentColumns* agent_columns;
 
   LoadBalanceFunctor(bool minimize_memory, uint64_t offset, uint64_t nid,
                      decltype(agents) agents, decltype(dest) dest,
-                     decltype(uid_ah_map) uid_ah_map, TypeIndex* type_index)
+                     decltype(uid_ah_map) uid_ah_map, TypeIndex* type_index,
+                     AgentCosts* agent_costs, AgentColumns* agent_columns)
       : minimize_memory(minimize_memory),
         offset(offset),
         nid(nid),
         agents(agents),
         dest(dest),
         uid_ah_map(uid_ah_map),
-        type_index(type_index) {}
+        type_index(type_index),
+        agent_costs(agent_costs),
+        agent_columns(agent_columns) {}
 
   void operator()(Iterator<AgentHandle>* it) override {
     while (it->HasNext()) {
@@ -229,6 +315,13 @@ struct LoadBalanceFunctor : public Functor<void, Iterator<AgentHandle>*> {
       if (type_index) {
         type_index->Update(copy);
       }
+      if (agent_costs) {
+        agent_costs->SetReorderedCost(nid, el_idx,
+                                      agent_costs->GetCost(handle));
+      }
+      if (agent_columns) {
+        agent_columns->SetReordered(nid, el_idx, handle);
+      }
       if (minimize_memory) {
         delete agent;
       }
@@ -246,23 +339,58 @@ void ResourceManager::LoadBalance() {
     PlotNeighborMemoryHistogram(true);
   }
 
+  auto* env = Simulation::GetActive()->GetEnvironment();
+  auto lbi = env->GetLoadBalanceInfo();
+
   // balance agents per numa node according to the number of
   // threads associated with each numa domain
   auto numa_nodes = thread_info_->GetNumaNodes();
   std::vector<uint64_t> agent_per_numa(numa_nodes);
   std::vector<uint64_t> agent_per_numa_cumm(numa_nodes);
-  uint64_t cummulative = 0;
   auto max_threads = thread_info_->GetMaxThreads();
-  for (int n = 1; n < numa_nodes; ++n) {
-    auto threads_in_numa = thread_info_->GetThreadsInNumaNode(n);
-    uint64_t num_agents = GetNumAgents() * threads_in_numa / max_threads;
-    agent_per_numa[n] = num_agents;
-    cummulative += num_agents;
+
+  // If agent costs have been measured, each thread receives the same share of
+  // the total cost instead of the same number of agents.
+  // `thread_start[first_thread[n] + i]` is the first agent (in load
+  // balancing order) of the i-th thread in numa node n.
+  AgentCosts* agent_costs =
+      agent_costs_ && agent_costs_->HasCosts() ? agent_costs_ : nullptr;
+  auto total_cost = agent_costs ? lbi->GetTotalCost() : 0;
+  std::vector<uint64_t> thread_start;
+  std::vector<uint64_t> first_thread(numa_nodes + 1);
+  for (int n = 0; n < numa_nodes; ++n) {
+    first_thread[n + 1] =
+        first_thread[n] + thread_info_->GetThreadsInNumaNode(n);
   }
-  agent_per_numa[0] = GetNumAgents() - cummulative;
-  agent_per_numa_cumm[0] = 0;
-  for (int n = 1; n < numa_nodes; ++n) {
-    agent_per_numa_cumm[n] = agent_per_numa_cumm[n - 1] + agent_per_numa[n - 1];
+
+  if (total_cost > 0) {
+    thread_start.resize(max_threads + 1);
+    thread_start[0] = 0;
+    thread_start[max_threads] = GetNumAgents();
+    for (int t = 1; t < max_threads; ++t) {
+      thread_start[t] = std::min(
+          lbi->GetNumAgentsBelowCost(total_cost * t / max_threads),
+          GetNumAgents());
+    }
+    for (int n = 0; n < numa_nodes; ++n) {
+      agent_per_numa_cumm[n] = thread_start[first_thread[n]];
+      agent_per_numa[n] =
+          thread_start[first_thread[n + 1]] - agent_per_numa_cumm[n];
+    }
+  } else {
+    uint64_t cummulative = 0;
+    for (int n = 1; n < numa_nodes; ++n) {
+      auto threads_in_numa = thread_info_->GetThreadsInNumaNode(n);
+      uint64_t num_agents = GetNumAgents() * threads_in_numa / max_threads;
+      agent_per_numa[n] = num_agents;
+      cummulative += num_agents;
+    }
+    agent_per_numa[0] = GetNumAgents() - cummulative;
+    agent_per_numa_cumm[0] = 0;
+    for (int n = 1; n < numa_nodes; ++n) {
+      agent_per_numa_cumm[n] =
+          agent_per_numa_cumm[n - 1] + agent_per_numa[n - 1];
+    }
   }
 
   // using first touch policy - page will be allocated to the numa domain of
@@ -273,9 +401,6 @@ void ResourceManager::LoadBalance() {
     Log::Fatal("ResourceManager",
                "Run on numa node failed. Return code: ", ret);
   }
-  auto* env = Simulation::GetActive()->GetEnvironment();
-  auto lbi = env->GetLoadBalanceInfo();
-
   const bool minimize_memory = param->minimize_memory_while_rebalancing;
 
 // create new agents
@@ -290,6 +415,12 @@ void ResourceManager::LoadBalance() {
         dest.reserve(agent_per_numa[nid] * 1.5);
       }
       dest.resize(agent_per_numa[nid]);
+      if (agent_costs) {
+        agent_costs->ResizeReordered(nid, agent_per_numa[nid]);
+      }
+      if (agent_columns_) {
+        agent_columns_->ResizeReordered(nid, agent_per_numa[nid]);
+      }
     }
 
 #pragma omp barrier
@@ -298,15 +429,24 @@ void ResourceManager::LoadBalance() {
     assert(thread_info_->GetNumaNode(tid) == numa_node_of_cpu(sched_getcpu()));
 
     // use static scheduling
-    auto correction = agent_per_numa[nid] % threads_in_numa == 0 ? 0 : 1;
-    auto chunk = agent_per_numa[nid] / threads_in_numa + correction;
-    auto start =
-        thread_info_->GetNumaThreadId(tid) * chunk + agent_per_numa_cumm[nid];
-    auto end =
-        std::min(agent_per_numa_cumm[nid] + agent_per_numa[nid], start + chunk);
+    uint64_t start = 0;
+    uint64_t end = 0;
+    if (!thread_start.empty()) {
+      auto t = first_thread[nid] + thread_info_->GetNumaThreadId(tid);
+      start = thread_start[t];
+      end = thread_start[t + 1];
+    } else {
+      auto correction = agent_per_numa[nid] % threads_in_numa == 0 ? 0 : 1;
+      auto chunk = agent_per_numa[nid] / threads_in_numa + correction;
+      start = thread_info_->GetNumaThreadId(tid) * chunk +
+              agent_per_numa_cumm[nid];
+      end = std::min(agent_per_numa_cumm[nid] + agent_per_numa[nid],
+                     start + chunk);
+    }
 
     LoadBalanceFunctor f(minimize_memory, start - agent_per_numa_cumm[nid], nid,
-                         agents_, dest, uid_ah_map_, type_index_);
+                         agents_, dest, uid_ah_map_, type_index_, agent_costs,
+                         agent_columns_);
     lbi->CallHandleIteratorConsumer(start, end, f);
   }
 
@@ -319,6 +459,13 @@ void ResourceManager::LoadBalance() {
     ForEachAgentParallel(delete_functor);
   }
 
+  if (agent_costs) {
+    agent_costs->FinishReorder();
+  }
+  if (agent_columns_) {
+    agent_columns_->FinishReorder();
+  }
+
   for (int n = 0; n < numa_nodes; n++) {
     agents_[n].swap(agents_lb_[n]);
     if (param->plot_memory_layout) {
@@ -349,6 +496,10 @@ void ResourceManager::RemoveAgents(
 
   std::vector<uint64_t> remove(numa_nodes);
   std::vector<uint64_t> lowest(numa_nodes);
+  // The costs are indexed by the element index of the agents and must
+  // follow the agents that are moved into the gaps.
+  AgentCosts* agent_costs =
+      agent_costs_ && agent_costs_->HasCosts() ? agent_costs_ : nullptr;
   parallel_remove_.to_right.resize(numa_nodes);
   parallel_remove_.not_to_left.resize(numa_nodes);
   // thread offsets into to_right and not_to_left
@@ -512,6 +663,12 @@ void ResourceManager::RemoveAgents(
             agents_[nid][tl_eidx] = agents_[nid][tr_eidx];
             agents_[nid][tr_eidx] = reordered;
             uid_ah_map_.Insert(reordered->GetUid(), AgentHandle(nid, tr_eidx));
+            if (agent_costs) {
+              agent_costs->MoveCost(nid, tl_eidx, tr_eidx);
+            }
+            if (agent_columns_) {
+              agent_columns_->Move(nid, tl_eidx, tr_eidx);
+            }
 
             // find next pair
             if (swap_end - s > 1) {
@@ -572,6 +729,12 @@ void ResourceManager::RemoveAgents(
   for (uint64_t n = 0; n < agents_.size(); ++n) {
     agents_[n].resize(lowest[n]);
   }
+  if (agent_costs) {
+    agent_costs->FinishRemoval(lowest);
+  }
+  if (agent_columns_) {
+    agent_columns_->FinishRemoval(lowest);
+  }
   MarkEnvironmentOutOfSync();
 }
 
@@ -583,6 +746,9 @@ size_t ResourceManager::GetAgentVectorCapacity(int numa_node) {
 // -----------------------------------------------------------------------------
 void ResourceManager::SwapAgents(std::vector<std::vector<Agent*>>* agents) {
   agents_.swap(*agents);
+  if (agent_columns_) {
+    agent_columns_->Update(this);
+  }
 }
 
 void ResourceManager::MarkEnvironmentOutOfSync() const {
@@ -590,4 +756,9 @@ void ResourceManager::MarkEnvironmentOutOfSync() const {
   env->MarkAsOutOfSync();
 }
 
+void ResourceManager::MarkEnvironmentAgentsAdded() const {
+  auto* env = Simulation::GetActive()->GetEnvironment();
+  env->MarkAgentsAdded();
+}
+
 }  // namespace bdm
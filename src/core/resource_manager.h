@@ -32,6 +32,8 @@
 #include "core/agent/agent_handle.h"
 #include "core/agent/agent_uid.h"
 #include "core/agent/agent_uid_generator.h"
+#include "core/agent_columns.h"
+#include "core/agent_costs.h"
 #include "core/container/agent_uid_map.h"
 #include "core/diffusion/continuum_interface.h"
 #include "core/diffusion/diffusion_grid.h"
@@ -76,6 +78,12 @@ class ResourceManager {
     continuum_models_ = std::move(other.continuum_models_);
 
     RebuildAgentUidMap();
+    if (agent_costs_) {
+      agent_costs_->Clear();
+    }
+    if (agent_columns_) {
+      agent_columns_->Update(this);
+    }
     // restore type_index_
     if (type_index_) {
       for (auto& numa_agents : agents_) {
@@ -334,6 +342,16 @@ class ResourceManager {
       uint64_t chunk, Functor<void, Agent*, AgentHandle>& function,
       Functor<bool, Agent*>* filter = nullptr);
 
+  /// Same as `ForEachAgentParallel(chunk, ...)`, but `function` is called
+  /// once for each batch of agents instead of once for each agent.
+  /// `function(nid, start, end)` must process the agents [start, end) of
+  /// NUMA node `nid`. This allows callers to execute several passes over a
+  /// batch while its agents are still in the cache.
+  virtual void ForEachAgentBatchParallel(
+      uint64_t chunk,
+      Functor<void, AgentHandle::NumaNode_t, AgentHandle::ElementIdx_t,
+              AgentHandle::ElementIdx_t>& function);
+
   /// Reserves enough memory to hold `capacity` number of agents for
   /// each numa domain.
   void Reserve(size_t capacity) {
@@ -357,6 +375,9 @@ class ResourceManager {
       agents_[numa_node].reserve((current + additional) * 1.5);
     }
     agents_[numa_node].resize(current + additional);
+    if (agent_columns_) {
+      agent_columns_->Resize(numa_node, current + additional);
+    }
     return current;
   }
 
@@ -381,6 +402,12 @@ class ResourceManager {
     if (type_index_) {
       type_index_->Clear();
     }
+    if (agent_costs_) {
+      agent_costs_->Clear();
+    }
+    if (agent_columns_) {
+      agent_columns_->Clear();
+    }
   }
 
   /// Reorder agents such that, agents are distributed to NUMA
@@ -402,13 +429,17 @@ class ResourceManager {
       uid_ah_map_.resize(uid.GetIndex() + 1);
     }
     agents_[numa_node].push_back(agent);
-    uid_ah_map_.Insert(
-        uid, AgentHandle(numa_node, static_cast<AgentHandle::ElementIdx_t>(
-                                        agents_[numa_node].size() - 1u)));
+    AgentHandle ah(numa_node, static_cast<AgentHandle::ElementIdx_t>(
+                                  agents_[numa_node].size() - 1u));
+    uid_ah_map_.Insert(uid, ah);
     if (type_index_) {
       type_index_->Add(agent);
     }
-    MarkEnvironmentOutOfSync();
+    if (agent_columns_) {
+      agent_columns_->Resize(numa_node, agents_[numa_node].size());
+      agent_columns_->Set(ah, agent);
+    }
+    MarkEnvironmentAgentsAdded();
   }
 
   void ResizeAgentUidMap() {
@@ -435,10 +466,13 @@ class ResourceManager {
     uint64_t i = 0;
     for (auto* agent : new_agents) {
       auto uid = agent->GetUid();
-      uid_ah_map_.Insert(
-          uid, AgentHandle(numa_node,
-                           static_cast<AgentHandle::ElementIdx_t>(offset + i)));
+      AgentHandle ah(numa_node,
+                     static_cast<AgentHandle::ElementIdx_t>(offset + i));
+      uid_ah_map_.Insert(uid, ah);
       agents_[numa_node][offset + i] = agent;
+      if (agent_columns_) {
+        agent_columns_->Set(ah, agent);
+      }
       i++;
     }
     if (type_index_) {
@@ -449,7 +483,7 @@ class ResourceManager {
     }
 #pragma omp single
     if (new_agents.size() != 0) {
-      MarkEnvironmentOutOfSync();
+      MarkEnvironmentAgentsAdded();
     }
   }
 
@@ -475,10 +509,21 @@ class ResourceManager {
         numa_agents[ah.GetElementIdx()] = reordered;
         numa_agents.pop_back();
         uid_ah_map_.Insert(reordered->GetUid(), ah);
+        if (agent_columns_) {
+          agent_columns_->Move(ah.GetNumaNode(), numa_agents.size(),
+                               ah.GetElementIdx());
+        }
+      }
+      if (agent_columns_) {
+        agent_columns_->Resize(ah.GetNumaNode(), numa_agents.size());
       }
       if (type_index_) {
         type_index_->Remove(agent);
       }
+      // The measured costs are indexed by the element index.
+      if (agent_costs_) {
+        agent_costs_->Clear();
+      }
       delete agent;
       MarkEnvironmentOutOfSync();
     }
@@ -491,12 +536,25 @@ class ResourceManager {
 
   const TypeIndex* GetTypeIndex() const { return type_index_; }
 
+  /// Returns the measured agent costs, or a nullptr if
+  /// `Param::cost_weighted_load_balancing` is disabled.
+  AgentCosts* GetAgentCosts() { return agent_costs_; }
+
+  /// Returns the structure-of-arrays copy of the agent attributes, or a
+  /// nullptr if `Param::agent_columns` is disabled.
+  AgentColumns* GetAgentColumns() { return agent_columns_; }
+  const AgentColumns* GetAgentColumns() const { return agent_columns_; }
+
  protected:
   /// Adding and removing agents does not immediately reflect in the state of
   /// the environment. This function sets a flag in the environment such that
   /// it is aware of the changes.
   void MarkEnvironmentOutOfSync() const;
 
+  /// Same as `MarkEnvironmentOutOfSync`, but for the case that agents have
+  /// only been appended.
+  void MarkEnvironmentAgentsAdded() const;
+
   /// Maps an AgentUid to its storage location in `agents_` \n
   AgentUidMap<AgentHandle> uid_ah_map_ = AgentUidMap<AgentHandle>(100u);  //!
   /// Pointer container for all agents
@@ -508,6 +566,10 @@ class ResourceManager {
 
   TypeIndex* type_index_ = nullptr;
 
+  AgentCosts* agent_costs_ = nullptr;  //!
+
+  AgentColumns* agent_columns_ = nullptr;  //!
+
   struct ParallelRemovalAuxData {
     std::vector<std::vector<uint64_t>> to_right;
     std::vector<std::vector<uint64_t>> not_to_left;
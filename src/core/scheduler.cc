@@ -14,9 +14,11 @@
 
 #include "core/scheduler.h"
 #include <chrono>
+#include <future>
 #include <iomanip>
 #include <string>
 #include <utility>
+#include "core/environment/uniform_grid_environment.h"
 #include "core/execution_context/in_place_exec_ctxt.h"
 #include "core/operation/bound_space_op.h"
 #include "core/operation/continuum_op.h"
@@ -40,6 +42,14 @@ Scheduler::Scheduler() {
     restore_point_ = backup_->GetSimulationStepsFromBackup();
   }
   root_visualization_ = new RootAdaptor();
+  if (param->profiling) {
+    profiler_ = new Profiler(param->profiling_buffer_size,
+                             param->profiling_max_trace_events);
+  }
+  if (param->cost_accounting_sampling_interval != 0) {
+    cost_accounting_ =
+        new CostAccounting(param->cost_accounting_sampling_interval);
+  }
 
   // Operations are scheduled in the following order (sub categorated by their
   // operation implementation type, so that actual order may vary)
@@ -125,6 +135,8 @@ Scheduler::~Scheduler() {
   delete backup_;
   delete root_visualization_;
   delete progress_bar_;
+  delete profiler_;
+  delete cost_accounting_;
 }
 
 void Scheduler::Simulate(uint64_t steps) {
@@ -250,16 +262,72 @@ struct RunAllScheduledOps : Functor<void, Agent*, AgentHandle> {
   explicit RunAllScheduledOps(std::vector<Operation*>& scheduled_ops)
       : scheduled_ops_(scheduled_ops) {
     sim_ = Simulation::GetActive();
+    cost_accounting_ = CostAccounting::GetActive();
   }
 
   void operator()(Agent* agent, AgentHandle ah) override {
-    sim_->GetExecutionContext()->Execute(agent, ah, scheduled_ops_);
+    auto* ctxt = sim_->GetExecutionContext();
+    if (cost_accounting_ && cost_accounting_->StartSample()) {
+      auto start = CostAccounting::Now();
+      ctxt->Execute(agent, ah, scheduled_ops_);
+      cost_accounting_->StopSample(typeid(*agent),
+                                   CostAccounting::Now() - start);
+    } else {
+      ctxt->Execute(agent, ah, scheduled_ops_);
+    }
   }
 
   Simulation* sim_;
+  CostAccounting* cost_accounting_;
   std::vector<Operation*>& scheduled_ops_;
 };
 
+/// Executes a group of fused agent operations for a batch of agents.
+/// All operations of the group are executed for all agents of the batch,
+/// one operation after the other, while the agents are still in the cache.
+struct RunFusedOps
+    : Functor<void, AgentHandle::NumaNode_t, AgentHandle::ElementIdx_t,
+              AgentHandle::ElementIdx_t> {
+  RunFusedOps(std::vector<Operation*>& ops, Functor<bool, Agent*>* filter,
+              const std::string& name)
+      : ops_(ops), filter_(filter), profile_id_(Profiler::Intern(name)) {
+    sim_ = Simulation::GetActive();
+    cost_accounting_ = CostAccounting::GetActive();
+  }
+
+  void operator()(AgentHandle::NumaNode_t nid, AgentHandle::ElementIdx_t start,
+                  AgentHandle::ElementIdx_t end) override {
+    // The batches of each thread show the load imbalance in the profile
+    ProfileScope scope(profile_id_);
+    auto* rm = sim_->GetResourceManager();
+    auto* ctxt = sim_->GetExecutionContext();
+    std::vector<Operation*> op(1);
+    for (auto* fused_op : ops_) {
+      op[0] = fused_op;
+      for (AgentHandle::ElementIdx_t i = start; i < end; ++i) {
+        AgentHandle ah(nid, i);
+        auto* agent = rm->GetAgent(ah);
+        if (!filter_ || (*filter_)(agent)) {
+          if (cost_accounting_ && cost_accounting_->StartSample()) {
+            auto start_time = CostAccounting::Now();
+            ctxt->Execute(agent, ah, op);
+            cost_accounting_->StopSample(typeid(*agent),
+                                         CostAccounting::Now() - start_time);
+          } else {
+            ctxt->Execute(agent, ah, op);
+          }
+        }
+      }
+    }
+  }
+
+  Simulation* sim_;
+  CostAccounting* cost_accounting_;
+  std::vector<Operation*>& ops_;
+  Functor<bool, Agent*>* filter_;
+  uint32_t profile_id_;
+};
+
 void Scheduler::SetUpOps() {
   ForEachScheduledOperation([&](Operation* op) {
     if (op->frequency_ != 0 && total_steps_ % op->frequency_ == 0) {
@@ -299,20 +367,63 @@ void Scheduler::RunAgentOps(Functor<bool, Agent*>* filter) const {
     }
   }
 
+  // With box coloring, agents with shared neighbors are processed one after
+  // the other instead of in parallel. The deterministic mode relies on the
+  // fixed order of the colors.
+  UniformGridEnvironment* colored_grid = nullptr;
+  if (param->thread_safety_mechanism ==
+          Param::ThreadSafetyMechanism::kBoxColoring ||
+      param->deterministic) {
+    colored_grid = dynamic_cast<UniformGridEnvironment*>(sim->GetEnvironment());
+    if (colored_grid == nullptr) {
+      Log::Fatal("Scheduler::RunAgentOps",
+                 "The thread-safety mechanism 'box-coloring' and the ",
+                 "deterministic mode require the uniform grid environment.");
+    }
+  }
+  auto for_each_agent = [&](Functor<void, Agent*, AgentHandle>& functor) {
+    if (colored_grid) {
+      colored_grid->ForEachAgentByBoxColor(functor, filter);
+    } else {
+      rm->ForEachAgentParallel(batch_size, functor, filter);
+    }
+  };
+
   const auto& all_exec_ctxts = sim->GetAllExecCtxts();
   all_exec_ctxts[0]->SetupAgentOpsAll(all_exec_ctxts);
 
   if (param->execution_order == Param::ExecutionOrder::kForEachAgentForEachOp) {
     RunAllScheduledOps functor(agent_ops);
-    Timing::Time("agent ops", [&]() {
-      rm->ForEachAgentParallel(batch_size, functor, filter);
-    });
+    Timing::Time("agent ops", [&]() { for_each_agent(functor); });
   } else {
+    // Group consecutive operations that can be fused. An operation that
+    // requires a global barrier always forms a group of its own. Fused
+    // groups process batches of agents, which box coloring does not support.
+    std::vector<std::vector<Operation*>> groups;
     for (auto* op : agent_ops) {
-      decltype(agent_ops) ops = {op};
-      RunAllScheduledOps functor(ops);
-      Timing::Time(op->name_, [&]() {
-        rm->ForEachAgentParallel(batch_size, functor, filter);
+      if (groups.empty() || !param->agent_op_fusion || colored_grid ||
+          op->RequiresGlobalBarrier() ||
+          groups.back().back()->RequiresGlobalBarrier()) {
+        groups.emplace_back();
+      }
+      groups.back().push_back(op);
+    }
+
+    for (auto& ops : groups) {
+      // A single operation is executed like a fused group if the profiler
+      // records the batches (unless box coloring is enabled).
+      if (ops.size() == 1 && (!profiler_ || colored_grid)) {
+        RunAllScheduledOps functor(ops);
+        Timing::Time(ops[0]->name_, [&]() { for_each_agent(functor); });
+        continue;
+      }
+      std::string name = ops[0]->name_;
+      for (uint64_t i = 1; i < ops.size(); ++i) {
+        name += " + " + ops[i]->name_;
+      }
+      RunFusedOps functor(ops, filter, name);
+      Timing::Time(name, [&]() {
+        rm->ForEachAgentBatchParallel(batch_size, functor);
       });
     }
   }
@@ -324,6 +435,31 @@ void Scheduler::RunAgentOps(Functor<bool, Agent*>* filter) const {
 void Scheduler::RunScheduledOps() {
   SetUpOps();
 
+  if (Simulation::GetActive()->GetParam()->concurrent_operations) {
+    RunScheduledOpsConcurrently();
+  } else {
+    RunAllAgentOps();
+
+    // Run the column-wise operations
+    for (auto* op : scheduled_standalone_ops_) {
+      if (op->frequency_ != 0 && total_steps_ % op->frequency_ == 0) {
+        Timing::Time(op->name_, [&]() { (*op)(); });
+      }
+    }
+  }
+
+  TearDownOps();
+}
+
+// -----------------------------------------------------------------------------
+void Scheduler::RunAllAgentOps() const {
+  // Measure the agent costs for cost-weighted load balancing
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto* agent_costs = rm->GetAgentCosts();
+  if (agent_costs) {
+    agent_costs->StartMeasurement(rm);
+  }
+
   // Run the agent operations
   if (agent_filters_.size() == 0) {
     RunAgentOps(nullptr);
@@ -333,14 +469,81 @@ void Scheduler::RunScheduledOps() {
     }
   }
 
-  // Run the column-wise operations
+  if (agent_costs) {
+    agent_costs->StopMeasurement();
+  }
+}
+
+// -----------------------------------------------------------------------------
+void Scheduler::RunScheduledOpsConcurrently() {
+  // Build the dependency graph of this iteration. Node 0 represents all
+  // agent operations, and the remaining nodes represent the standalone
+  // operations in the order in which they have been scheduled. A node
+  // depends on all previous nodes whose data accesses conflict with its own.
+  std::vector<Operation*> standalone_ops;
   for (auto* op : scheduled_standalone_ops_) {
     if (op->frequency_ != 0 && total_steps_ % op->frequency_ == 0) {
-      Timing::Time(op->name_, [&]() { (*op)(); });
+      standalone_ops.push_back(op);
     }
   }
+  auto num_nodes = standalone_ops.size() + 1;
 
-  TearDownOps();
+  // The agent operations use the execution contexts, which are indexed by
+  // the thread id.
+  std::vector<OpDataAccess> access(num_nodes);
+  access[0].UseThreadState();
+  for (auto* op : scheduled_agent_ops_) {
+    if (op->frequency_ != 0 && total_steps_ % op->frequency_ == 0) {
+      access[0].Merge(op->GetDataAccess());
+    }
+  }
+  for (size_t i = 1; i < num_nodes; ++i) {
+    access[i] = standalone_ops[i - 1]->GetDataAccess();
+  }
+
+  std::vector<std::vector<size_t>> dependencies(num_nodes);
+  for (size_t j = 1; j < num_nodes; ++j) {
+    for (size_t i = 0; i < j; ++i) {
+      if (access[i].ConflictsWith(access[j])) {
+        dependencies[j].push_back(i);
+      }
+    }
+  }
+
+  // Standalone operations are executed by separate threads as soon as all
+  // their dependencies have finished. The agent operations are executed by
+  // the calling thread, because they rely on the thread-local execution
+  // contexts and the OpenMP thread team of this thread. Each thread starts
+  // its own OpenMP team, whose thread ids overlap with the ones of the other
+  // teams. Therefore, operations that use thread state always depend on
+  // each other (see `OpDataAccess::UseThreadState`).
+  std::promise<void> agent_ops_done;
+  std::vector<std::shared_future<void>> done(num_nodes);
+  done[0] = agent_ops_done.get_future().share();
+  for (size_t j = 1; j < num_nodes; ++j) {
+    done[j] = std::async(std::launch::async, [this, j, &done, &dependencies,
+                                              &standalone_ops]() {
+                for (auto d : dependencies[j]) {
+                  done[d].get();
+                }
+                auto* op = standalone_ops[j - 1];
+                Timing::Time(op->name_, [&]() { (*op)(); });
+              }).share();
+  }
+
+  try {
+    RunAllAgentOps();
+    agent_ops_done.set_value();
+  } catch (...) {
+    agent_ops_done.set_exception(std::current_exception());
+    for (size_t j = 1; j < num_nodes; ++j) {
+      done[j].wait();
+    }
+    throw;
+  }
+  for (size_t j = 1; j < num_nodes; ++j) {
+    done[j].get();
+  }
 }
 
 void Scheduler::RunPostScheduledOps() const {
@@ -366,6 +569,10 @@ void Scheduler::Execute() {
   RunPreScheduledOps();
   RunScheduledOps();
   RunPostScheduledOps();
+
+  if (profiler_) {
+    profiler_->EndIteration();
+  }
 }
 
 void Scheduler::PrintInfo(std::ostream& out) const {
@@ -414,6 +621,10 @@ void Scheduler::PrintInfo(std::ostream& out) const {
           << schedule_op.second->frequency_ << "\n";
     }
   }
+  if (cost_accounting_) {
+    out << "\n";
+    cost_accounting_->Print(out);
+  }
   out << "\n" << std::string(80, '-') << "\n";
 }
 
@@ -461,6 +672,10 @@ void Scheduler::Initialize(uint64_t steps) {
   auto* rm = sim->GetResourceManager();
   auto* param = sim->GetParam();
 
+  // Record the scopes of this simulation (or none if profiling is disabled)
+  Profiler::SetActive(profiler_);
+  CostAccounting::SetActive(cost_accounting_);
+
   // commit all changes
   const auto& all_exec_ctxts = sim->GetAllExecCtxts();
   all_exec_ctxts[0]->SetupIterationAll(all_exec_ctxts);
@@ -509,14 +724,17 @@ void Scheduler::ScheduleOps() {
     auto op_type = it->first;
     auto* op = it->second;
 
-    // Enable GPU operation implementations (if available) if CUDA or OpenCL
-    // flags are set
+    // Enable GPU or vectorized CPU operation implementations (if available)
+    // if CUDA, OpenCL or SIMD flags are set
     if (param->compute_target == "cuda" &&
         op->IsComputeTargetSupported(kCuda)) {
       op->SelectComputeTarget(kCuda);
     } else if (param->compute_target == "opencl" &&
                op->IsComputeTargetSupported(kOpenCl)) {
       op->SelectComputeTarget(kOpenCl);
+    } else if (param->compute_target == "cpu_simd" &&
+               op->IsComputeTargetSupported(kCpuSimd)) {
+      op->SelectComputeTarget(kCpuSimd);
     } else {
       op->SelectComputeTarget(kCpu);
     }
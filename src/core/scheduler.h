@@ -26,6 +26,8 @@
 #include "core/functor.h"
 #include "core/operation/operation.h"
 #include "core/param/param.h"
+#include "core/util/cost_accounting.h"
+#include "core/util/profiler.h"
 #include "core/util/progress_bar.h"
 #include "core/util/timing_aggregator.h"
 
@@ -103,12 +105,22 @@ class Scheduler {
 
   TimingAggregator* GetOpTimes();
 
+  /// Returns the hierarchical profiler, or nullptr if `Param::profiling` is
+  /// disabled.
+  Profiler* GetProfiler() { return profiler_; }
+
+  /// Returns the costs per agent and behavior type, or nullptr if
+  /// `Param::cost_accounting_sampling_interval` is zero.
+  CostAccounting* GetCostAccounting() { return cost_accounting_; }
+
   /// Prints an overview of all pre-scheduled, agent, standalone, and
   /// post-scheduled operations. For each iteration, the scheduler executes
   /// these operations in the order that they appear in the output.
   /// Additionally, the output shows a column "frequency" with values \f$n_i\f$
   /// indicating that a certain operation \f$i\f$ is only executed every
-  /// \f$n_i\f$-th time.
+  /// \f$n_i\f$-th time.\n
+  /// If cost accounting is enabled, the output also contains the costs per
+  /// agent and behavior type (see `CostAccounting`).
   void PrintInfo(std::ostream& out) const;
 
  protected:
@@ -152,6 +164,11 @@ class Scheduler {
   std::vector<Operation*> post_scheduled_ops_;
   /// Tracks operations' execution times
   TimingAggregator op_times_;
+  /// Hierarchical profiler (see `Param::profiling`)
+  Profiler* profiler_ = nullptr;  //!
+  /// Costs per agent and behavior type
+  /// (see `Param::cost_accounting_sampling_interval`)
+  CostAccounting* cost_accounting_ = nullptr;  //!
 
   /// Agent operations are executed for each filter in agent_filters_.\n
   /// By default no filter is specified which means that all
@@ -211,6 +228,13 @@ class Scheduler {
   // Run the operations in scheduled_*_ops_
   void RunScheduledOps();
 
+  // Run all agent operations (for each agent filter)
+  void RunAllAgentOps() const;
+
+  // Run the operations in scheduled_*_ops_ concurrently if their data
+  // accesses do not conflict (see `Param::concurrent_operations`)
+  void RunScheduledOpsConcurrently();
+
   // Run the operations in pre_scheduled_ops_ (executed before RunScheduledOps)
   void RunPreScheduledOps() const;
 
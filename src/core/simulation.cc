@@ -44,6 +44,7 @@
 #include "core/util/filesystem.h"
 #include "core/util/io.h"
 #include "core/util/log.h"
+#include "core/util/philox_random.h"
 #include "core/util/string.h"
 #include "core/util/thread_info.h"
 #include "core/util/timing.h"
@@ -169,6 +170,12 @@ std::ostream& operator<<(std::ostream& os, Simulation& sim) {
   os << "***********************************************" << std::endl;
   os << *(sim.scheduler_->GetOpTimes()) << std::endl;
   os << "***********************************************" << std::endl;
+  if (auto* profiler = sim.scheduler_->GetProfiler()) {
+    os << std::endl;
+    profiler->Print(os);
+    os << std::endl;
+    os << "***********************************************" << std::endl;
+  }
   os << std::endl;
   os << "\033[1mThread Info\033[0m" << std::endl;
   os << *ThreadInfo::GetInstance();
@@ -191,6 +198,12 @@ std::ostream& operator<<(std::ostream& os, Simulation& sim) {
 Simulation::~Simulation() {
   dtor_ts_ = bdm::Timing::Timestamp();
 
+  if (scheduler_ != nullptr && scheduler_->GetProfiler() != nullptr) {
+    auto* profiler = scheduler_->GetProfiler();
+    profiler->WriteChromeTrace(Concat(output_dir_, "/profile.json"));
+    profiler->WriteFoldedStacks(Concat(output_dir_, "/profile.folded"));
+  }
+
   if (param_ != nullptr && param_->statistics) {
     std::stringstream sstr;
     sstr << *this << std::endl;
@@ -311,6 +324,30 @@ void Simulation::Initialize(CommandLineOptions* clo,
   InitializeMembers();
 }
 
+void Simulation::CheckSizeClassParams() const {
+  if (param_->uniform_grid_large_agent_factor <= 0) {
+    return;
+  }
+  using TSM = Param::ThreadSafetyMechanism;
+  if (param_->thread_safety_mechanism == TSM::kAutomatic ||
+      param_->thread_safety_mechanism == TSM::kBoxColoring) {
+    Log::Fatal("Simulation::Initialize",
+               "Param::uniform_grid_large_agent_factor cannot be combined "
+               "with the thread-safety mechanisms 'automatic' and "
+               "'box-coloring', because they do not protect large "
+               "neighbors outside the surrounding boxes.");
+  }
+  if (param_->verlet_skin > 0) {
+    Log::Warning("Simulation::Initialize",
+                 "Param::uniform_grid_large_agent_factor is ignored, because "
+                 "Param::verlet_skin takes precedence.");
+  } else if (param_->uniform_grid_incremental_update) {
+    Log::Warning("Simulation::Initialize",
+                 "Param::uniform_grid_incremental_update is ignored, because "
+                 "Param::uniform_grid_large_agent_factor is set.");
+  }
+}
+
 void Simulation::InitializeMembers() {
   if (param_->use_bdm_mem_mgr) {
     mem_mgr_ = new MemoryManager(param_->mem_mgr_aligned_pages_shift,
@@ -322,11 +359,24 @@ void Simulation::InitializeMembers() {
     std::cout << "ThreadInfo:\n" << *ThreadInfo::GetInstance() << std::endl;
   }
 
+  bool philox =
+      param_->deterministic || param_->random_generator == "philox";
+  if (!philox && param_->random_generator != "TRandom3") {
+    Log::Error("Simulation::Initialize", "No such random number generator '",
+               param_->random_generator, "'. Defaulting to 'TRandom3'");
+  }
   random_.resize(omp_get_max_threads());
 #pragma omp parallel for schedule(static, 1)
   for (uint64_t i = 0; i < random_.size(); i++) {
     random_[i] = new Random();
-    random_[i]->SetSeed(param_->random_seed * (i + 1));
+    if (philox) {
+      // All threads must derive the same agent streams from the seed. Outside
+      // of agent operations, each thread draws from the stream of its id.
+      random_[i]->SetGenerator(new PhiloxRandom(param_->random_seed));
+      random_[i]->SetStream(i);
+    } else {
+      random_[i]->SetSeed(param_->random_seed * (i + 1));
+    }
   }
   exec_ctxt_.resize(omp_get_max_threads());
   auto map = std::make_shared<
@@ -344,6 +394,7 @@ void Simulation::InitializeMembers() {
     environment_ = new OctreeEnvironment();
   } else if (param_->environment == "uniform_grid") {
     environment_ = new UniformGridEnvironment();
+    CheckSizeClassParams();
   } else {
     Log::Error("Simulation::Initialize", "No such neighboring method '",
                param_->environment, "'. Defaulting to 'uniform_grid'");
@@ -445,7 +496,9 @@ void Simulation::InitializeRuntimeParams(
 
   set_param(param_);
 
-  if (!is_gpu_environment_initialized_ && param_->compute_target != "cpu") {
+  if (!is_gpu_environment_initialized_ &&
+      (param_->compute_target == "cuda" ||
+       param_->compute_target == "opencl")) {
     GpuHelper::GetInstance()->InitializeGPUEnvironment();
     is_gpu_environment_initialized_ = true;
   }
@@ -192,6 +192,10 @@ class Simulation {
   /// Initialize data members that have a dependency on Simulation
   void InitializeMembers();
 
+  /// Rejects or reports parameters that are incompatible with
+  /// `Param::uniform_grid_large_agent_factor`.
+  void CheckSizeClassParams() const;
+
   /// This function parses command line parameters and the configuration file.
   void InitializeRuntimeParams(CommandLineOptions* clo,
                                const std::function<void(Param*)>& set_param,
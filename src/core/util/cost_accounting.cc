@@ -0,0 +1,164 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/util/cost_accounting.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+
+#include "core/util/log.h"
+#include "core/util/profiler.h"
+
+namespace bdm {
+
+namespace {
+std::atomic<uint64_t> gCostAccountingCounter(0);
+}  // namespace
+
+CostAccounting* CostAccounting::active_ = nullptr;
+
+// -----------------------------------------------------------------------------
+CostAccounting::CostAccounting(uint64_t sampling_interval)
+    : id_(++gCostAccountingCounter), sampling_interval_(sampling_interval) {
+  if (sampling_interval_ == 0) {
+    Log::Fatal("CostAccounting::CostAccounting",
+               "The sampling interval must be greater than zero.");
+  }
+}
+
+// -----------------------------------------------------------------------------
+CostAccounting::~CostAccounting() {
+  if (active_ == this) {
+    active_ = nullptr;
+  }
+}
+
+// -----------------------------------------------------------------------------
+CostAccounting::ThreadData* CostAccounting::GetThreadData() {
+  thread_local uint64_t cost_accounting_id = 0;
+  thread_local ThreadData* data = nullptr;
+  if (cost_accounting_id != id_) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    threads_.emplace_back(new ThreadData());
+    data = threads_.back().get();
+    // Different seeds for all threads; xorshift requires a non-zero state
+    data->rng = 0x9E3779B97F4A7C15ull * threads_.size();
+    cost_accounting_id = id_;
+  }
+  return data;
+}
+
+// -----------------------------------------------------------------------------
+void CostAccounting::StopSample(const std::type_info& type, uint64_t time_ns) {
+  auto* thread = GetThreadData();
+  thread->sampling = false;
+  thread->num_samples++;
+  auto& sample = thread->agents[type];
+  sample.type = &type;
+  sample.calls++;
+  sample.time_ns += time_ns;
+}
+
+// -----------------------------------------------------------------------------
+void CostAccounting::AddBehaviorCost(const std::type_info& type,
+                                     uint64_t time_ns) {
+  auto& sample = GetThreadData()->behaviors[type];
+  sample.type = &type;
+  sample.calls++;
+  sample.time_ns += time_ns;
+}
+
+// -----------------------------------------------------------------------------
+std::vector<CostAccounting::Cost> CostAccounting::GetCosts(
+    SampleMap ThreadData::*samples) const {
+  uint64_t num_calls = 0;
+  uint64_t num_samples = 0;
+  SampleMap merged;
+  for (const auto& thread : threads_) {
+    num_calls += thread->num_calls;
+    num_samples += thread->num_samples;
+    for (const auto& el : (*thread).*samples) {
+      auto& sample = merged[el.first];
+      sample.type = el.second.type;
+      sample.calls += el.second.calls;
+      sample.time_ns += el.second.time_ns;
+    }
+  }
+
+  // Extrapolate with the actual ratio of calls and samples
+  double scale = num_samples != 0 ? static_cast<double>(num_calls) /
+                                        static_cast<double>(num_samples)
+                                  : 0;
+  std::vector<Cost> costs;
+  costs.reserve(merged.size());
+  for (const auto& el : merged) {
+    Cost cost;
+    cost.name = Profiler::GetName(Profiler::Intern(*el.second.type));
+    cost.calls = static_cast<uint64_t>(el.second.calls * scale + 0.5);
+    cost.time_ns = static_cast<uint64_t>(el.second.time_ns * scale + 0.5);
+    cost.sampled_calls = el.second.calls;
+    costs.push_back(cost);
+  }
+  std::sort(costs.begin(), costs.end(), [](const Cost& a, const Cost& b) {
+    return a.time_ns != b.time_ns ? a.time_ns > b.time_ns : a.name < b.name;
+  });
+  return costs;
+}
+
+// -----------------------------------------------------------------------------
+std::vector<CostAccounting::Cost> CostAccounting::GetAgentCosts() const {
+  return GetCosts(&ThreadData::agents);
+}
+
+// -----------------------------------------------------------------------------
+std::vector<CostAccounting::Cost> CostAccounting::GetBehaviorCosts() const {
+  return GetCosts(&ThreadData::behaviors);
+}
+
+// -----------------------------------------------------------------------------
+void CostAccounting::Reset() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (auto& thread : threads_) {
+    thread->num_calls = 0;
+    thread->num_samples = 0;
+    thread->countdown = 1;
+    thread->agents.clear();
+    thread->behaviors.clear();
+  }
+}
+
+// -----------------------------------------------------------------------------
+void CostAccounting::Print(std::ostream& out) const {
+  auto print = [&](const std::string& title, const std::vector<Cost>& costs) {
+    out << std::left << std::setw(44) << title << std::right << std::setw(12)
+        << "time [ms]" << std::setw(12) << "calls" << std::setw(12)
+        << "ns/call"
+        << "\n";
+    for (const auto& cost : costs) {
+      auto ns_per_call = cost.calls != 0 ? cost.time_ns / cost.calls : 0;
+      out << std::left << std::setw(44) << cost.name << std::right
+          << std::fixed << std::setprecision(3) << std::setw(12)
+          << cost.time_ns / 1e6 << std::setw(12) << cost.calls << std::setw(12)
+          << ns_per_call << "\n";
+    }
+  };
+  out << "Cost accounting (on average every " << sampling_interval_
+      << ". call of the agent operations is measured):\n";
+  print("Agent type", GetAgentCosts());
+  out << "\n";
+  print("Behavior type", GetBehaviorCosts());
+}
+
+}  // namespace bdm
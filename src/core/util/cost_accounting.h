@@ -0,0 +1,158 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_UTIL_COST_ACCOUNTING_H_
+#define CORE_UTIL_COST_ACCOUNTING_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace bdm {
+
+/// Attributes the execution time of the agent operations to the agent types
+/// and to the behavior types.\n
+/// Each thread measures on average every `sampling_interval`-th call of the
+/// agent operations. The distance between two samples is random to avoid
+/// aliasing with regular agent orders (e.g. alternating agent types).
+/// The time of a sampled call is attributed to the type of the agent, and the
+/// time of each behavior that the agent runs during this call to the type of
+/// the behavior. Calls and times are extrapolated from the samples.\n
+/// Enable with `Param::cost_accounting_sampling_interval`.
+class CostAccounting {
+ public:
+  /// Extrapolated cost of one agent or behavior type
+  struct Cost {
+    std::string name;
+    uint64_t calls = 0;
+    uint64_t time_ns = 0;
+    /// Number of measured calls
+    uint64_t sampled_calls = 0;
+  };
+
+  explicit CostAccounting(uint64_t sampling_interval);
+
+  CostAccounting(const CostAccounting&) = delete;
+  CostAccounting& operator=(const CostAccounting&) = delete;
+
+  ~CostAccounting();
+
+  /// Returns the instance that records the costs, or nullptr if cost
+  /// accounting is disabled.
+  static CostAccounting* GetActive() { return active_; }
+
+  static void SetActive(CostAccounting* cost_accounting) {
+    active_ = cost_accounting;
+  }
+
+  static uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  uint64_t GetSamplingInterval() const { return sampling_interval_; }
+
+  /// Must be called before each call of the agent operations. Returns true
+  /// if this call should be measured. In this case, `StopSample` must be
+  /// called afterwards.
+  bool StartSample() {
+    auto* thread = GetThreadData();
+    thread->num_calls++;
+    if (--thread->countdown != 0) {
+      return false;
+    }
+    thread->countdown = NextDistance(thread);
+    thread->sampling = true;
+    return true;
+  }
+
+  /// Attributes `time_ns` to the agent type `type`.
+  void StopSample(const std::type_info& type, uint64_t time_ns);
+
+  /// Returns true if the calling thread measures the current call.
+  bool IsSampling() { return GetThreadData()->sampling; }
+
+  /// Attributes `time_ns` to the behavior type `type`.
+  void AddBehaviorCost(const std::type_info& type, uint64_t time_ns);
+
+  /// Returns the costs of all agent types sorted by decreasing time.
+  /// Must not be called while agent operations are executed.
+  std::vector<Cost> GetAgentCosts() const;
+
+  /// Returns the costs of all behavior types sorted by decreasing time.
+  /// Must not be called while agent operations are executed.
+  std::vector<Cost> GetBehaviorCosts() const;
+
+  /// Discards all measurements.
+  void Reset();
+
+  void Print(std::ostream& out) const;
+
+ private:
+  struct Sample {
+    const std::type_info* type = nullptr;
+    uint64_t calls = 0;
+    uint64_t time_ns = 0;
+  };
+
+  using SampleMap = std::unordered_map<std::type_index, Sample>;
+
+  /// Recording state of one thread
+  struct ThreadData {
+    uint64_t num_calls = 0;
+    uint64_t num_samples = 0;
+    /// Number of calls until the next sample
+    uint64_t countdown = 1;
+    /// State of the random number generator (xorshift64)
+    uint64_t rng;
+    bool sampling = false;
+    SampleMap agents;
+    SampleMap behaviors;
+  };
+
+  static CostAccounting* active_;
+
+  /// Distinguishes instances in the thread-local cache of `GetThreadData`
+  uint64_t id_;
+  uint64_t sampling_interval_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<ThreadData>> threads_;
+
+  /// Returns the data of the calling thread and creates it if necessary.
+  ThreadData* GetThreadData();
+
+  /// Returns a random number of calls in [1, 2 * sampling_interval - 1].
+  uint64_t NextDistance(ThreadData* thread) const {
+    auto& x = thread->rng;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return 1 + x % (2 * sampling_interval_ - 1);
+  }
+
+  /// Merges the samples of all threads.
+  std::vector<Cost> GetCosts(SampleMap ThreadData::*samples) const;
+};
+
+}  // namespace bdm
+
+#endif  // CORE_UTIL_COST_ACCOUNTING_H_
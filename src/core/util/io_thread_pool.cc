@@ -0,0 +1,108 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/util/io_thread_pool.h"
+#include <algorithm>
+#include <utility>
+
+namespace bdm {
+
+// -----------------------------------------------------------------------------
+IoThreadPool::IoThreadPool(uint64_t num_threads, uint64_t max_pending_jobs)
+    : max_pending_jobs_(std::max<uint64_t>(max_pending_jobs, 1)) {
+  num_threads = std::max<uint64_t>(num_threads, 1);
+  threads_.reserve(num_threads);
+  for (uint64_t i = 0; i < num_threads; ++i) {
+    threads_.emplace_back([this]() { Run(); });
+  }
+}
+
+// -----------------------------------------------------------------------------
+IoThreadPool::~IoThreadPool() {
+  Wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  task_added_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+// -----------------------------------------------------------------------------
+void IoThreadPool::Submit(std::vector<std::function<void()>> tasks) {
+  if (tasks.empty()) {
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_finished_.wait(lock,
+                       [this]() { return pending_jobs_ < max_pending_jobs_; });
+    pending_jobs_++;
+    auto remaining = std::make_shared<uint64_t>(tasks.size());
+    for (auto& task : tasks) {
+      tasks_.push_back({std::move(task), remaining});
+    }
+  }
+  task_added_.notify_all();
+}
+
+// -----------------------------------------------------------------------------
+void IoThreadPool::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  job_finished_.wait(lock, [this]() { return pending_jobs_ == 0; });
+}
+
+// -----------------------------------------------------------------------------
+uint64_t IoThreadPool::GetNumPendingJobs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_jobs_;
+}
+
+// -----------------------------------------------------------------------------
+void IoThreadPool::Run() {
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_added_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        // stop_ is set and all tasks have been executed
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+
+    task.function();
+    // Release the resources of the task before the job is reported as
+    // finished
+    task.function = nullptr;
+
+    bool job_finished = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--(*task.remaining) == 0) {
+        pending_jobs_--;
+        job_finished = true;
+      }
+    }
+    if (job_finished) {
+      job_finished_.notify_all();
+    }
+  }
+}
+
+}  // namespace bdm
@@ -0,0 +1,84 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_UTIL_IO_THREAD_POOL_H_
+#define CORE_UTIL_IO_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bdm {
+
+/// Executes I/O jobs (e.g. compressing and writing files) on dedicated
+/// threads, such that the simulation can continue while they run.\n
+/// A job consists of tasks that may run in parallel. At most
+/// `max_pending_jobs` jobs can be queued or running. `Submit` blocks until a
+/// job has been finished if this limit is reached (backpressure). Hence, the
+/// memory of the data that the jobs keep alive is bounded.\n
+/// The threads are not OpenMP threads. Tasks must therefore not access
+/// thread-local data of BioDynaMo (e.g. `Simulation::GetRandom`) and should
+/// not rely on `Simulation::GetActive`.
+class IoThreadPool {
+ public:
+  IoThreadPool(uint64_t num_threads, uint64_t max_pending_jobs);
+
+  IoThreadPool(const IoThreadPool&) = delete;
+  IoThreadPool& operator=(const IoThreadPool&) = delete;
+
+  /// Waits until all jobs have been finished.
+  ~IoThreadPool();
+
+  /// Adds a job that consists of `tasks`. Blocks while `max_pending_jobs`
+  /// jobs are queued or running.
+  void Submit(std::vector<std::function<void()>> tasks);
+
+  /// Blocks until all submitted jobs have been finished.
+  void Wait();
+
+  /// Returns the number of jobs that are queued or running.
+  uint64_t GetNumPendingJobs() const;
+
+  uint64_t GetNumThreads() const { return threads_.size(); }
+
+ private:
+  struct Task {
+    std::function<void()> function;
+    /// Number of unfinished tasks of the job this task belongs to
+    std::shared_ptr<uint64_t> remaining;
+  };
+
+  std::vector<std::thread> threads_;
+  std::deque<Task> tasks_;
+  uint64_t max_pending_jobs_;
+  uint64_t pending_jobs_ = 0;
+  bool stop_ = false;
+  mutable std::mutex mutex_;
+  /// Signals new tasks and `stop_` to the threads
+  std::condition_variable task_added_;
+  /// Signals finished jobs to `Submit` and `Wait`
+  std::condition_variable job_finished_;
+
+  /// Main loop of each thread.
+  void Run();
+};
+
+}  // namespace bdm
+
+#endif  // CORE_UTIL_IO_THREAD_POOL_H_
@@ -0,0 +1,202 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_UTIL_PHILOX_H_
+#define CORE_UTIL_PHILOX_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "core/util/root.h"
+
+namespace bdm {
+
+/// Engine of the counter-based random number generator Philox4x32-10
+/// (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC'11).\n
+/// Each 32 bit number is a word of the encrypted counter
+/// {position / 4, stream}; the seed is the key. Hence, the engine only stores
+/// seed, stream, and position, and `Generate` computes independent blocks in
+/// parallel SIMD lanes.
+class Philox {
+ public:
+  /// 2^-32
+  static constexpr double kWordToUnit = 2.3283064365386963e-10;
+
+  explicit Philox(uint64_t seed = 0) : seed_(seed) {}
+
+  /// Sets the key and continues at the beginning of stream zero.
+  void SetSeed(uint64_t seed) {
+    seed_ = seed;
+    SetStream(0);
+    cached_block_ = std::numeric_limits<uint64_t>::max();
+  }
+
+  uint64_t GetSeed() const { return seed_; }
+
+  /// Continues at draw `position` of the stream `stream`.
+  void SetStream(uint64_t stream, uint64_t position = 0) {
+    stream_ = stream;
+    position_ = position;
+  }
+
+  uint64_t GetStream() const { return stream_; }
+
+  /// Returns the number of 32 bit numbers that have been drawn from the
+  /// current stream.
+  uint64_t GetPosition() const { return position_; }
+
+  /// Returns the next 32 bit number of the current stream.
+  uint32_t Next() {
+    auto block = position_ >> 2;
+    if (block != cached_block_ || stream_ != cached_stream_) {
+      block_ = Block(Counter(block), Key());
+      cached_block_ = block;
+      cached_stream_ = stream_;
+    }
+    return block_[position_++ & 3];
+  }
+
+  /// Returns a uniform deviate on the interval (0, 1).
+  double Uniform() {
+    // Shift by half a step to exclude zero and one
+    return (Next() + 0.5) * kWordToUnit;
+  }
+
+  /// Writes the next `n` numbers of the current stream to `words`. The result
+  /// is the same as for `n` calls of `Next()`.
+  void Generate(uint64_t n, uint32_t* words) {
+    uint64_t i = 0;
+    // Finish the current block
+    for (; i < n && (position_ & 3) != 0; ++i) {
+      words[i] = Next();
+    }
+    uint64_t num_blocks = (n - i) >> 2;
+    GenerateBlocks(position_ >> 2, num_blocks, words + i);
+    i += num_blocks << 2;
+    position_ += num_blocks << 2;
+    for (; i < n; ++i) {
+      words[i] = Next();
+    }
+  }
+
+  /// Encrypts `counter` with `key` (ten rounds).
+  static std::array<uint32_t, 4> Block(std::array<uint32_t, 4> counter,
+                                       std::array<uint32_t, 2> key) {
+    for (int round = 0; round < 10; ++round) {
+      if (round != 0) {
+        key[0] += kW0;
+        key[1] += kW1;
+      }
+      uint64_t p0 = static_cast<uint64_t>(kM0) * counter[0];
+      uint64_t p1 = static_cast<uint64_t>(kM1) * counter[2];
+      counter = {static_cast<uint32_t>(p1 >> 32) ^ counter[1] ^ key[0],
+                 static_cast<uint32_t>(p1),
+                 static_cast<uint32_t>(p0 >> 32) ^ counter[3] ^ key[1],
+                 static_cast<uint32_t>(p0)};
+    }
+    return counter;
+  }
+
+  /// Mixes `value` into `seed` (splitmix64 finalizer). Used to derive stream
+  /// ids that are uncorrelated for consecutive inputs.
+  static uint64_t HashCombine(uint64_t seed, uint64_t value) {
+    uint64_t x =
+        seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+ private:
+  static constexpr uint32_t kM0 = 0xD2511F53;
+  static constexpr uint32_t kM1 = 0xCD9E8D57;
+  static constexpr uint32_t kW0 = 0x9E3779B9;
+  static constexpr uint32_t kW1 = 0xBB67AE85;
+  /// Number of blocks that `GenerateBlocks` encrypts at once
+  static constexpr uint64_t kLanes = 16;
+
+  uint64_t seed_ = 0;
+  uint64_t stream_ = 0;
+  uint64_t position_ = 0;
+  /// Block that contains the numbers of `cached_block_`
+  std::array<uint32_t, 4> block_;                                 //!
+  uint64_t cached_block_ = std::numeric_limits<uint64_t>::max();  //!
+  uint64_t cached_stream_ = 0;                                    //!
+
+  std::array<uint32_t, 4> Counter(uint64_t block) const {
+    return {static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32),
+            static_cast<uint32_t>(stream_),
+            static_cast<uint32_t>(stream_ >> 32)};
+  }
+
+  std::array<uint32_t, 2> Key() const {
+    return {static_cast<uint32_t>(seed_), static_cast<uint32_t>(seed_ >> 32)};
+  }
+
+  /// Writes the blocks [first, first + num_blocks) of the current stream to
+  /// `words`. The rounds are computed for `kLanes` blocks side by side in
+  /// structure-of-arrays layout, such that the compiler can map the lanes to
+  /// SIMD registers.
+  void GenerateBlocks(uint64_t first, uint64_t num_blocks,
+                      uint32_t* words) const {
+    alignas(64) uint32_t c0[kLanes];
+    alignas(64) uint32_t c1[kLanes];
+    alignas(64) uint32_t c2[kLanes];
+    alignas(64) uint32_t c3[kLanes];
+    const auto s0 = static_cast<uint32_t>(stream_);
+    const auto s1 = static_cast<uint32_t>(stream_ >> 32);
+    for (uint64_t b = 0; b < num_blocks; b += kLanes) {
+#pragma omp simd
+      for (uint64_t l = 0; l < kLanes; ++l) {
+        uint64_t block = first + b + l;
+        c0[l] = static_cast<uint32_t>(block);
+        c1[l] = static_cast<uint32_t>(block >> 32);
+        c2[l] = s0;
+        c3[l] = s1;
+      }
+      auto key = Key();
+      for (int round = 0; round < 10; ++round) {
+        const auto k0 = key[0];
+        const auto k1 = key[1];
+#pragma omp simd
+        for (uint64_t l = 0; l < kLanes; ++l) {
+          uint64_t p0 = static_cast<uint64_t>(kM0) * c0[l];
+          uint64_t p1 = static_cast<uint64_t>(kM1) * c2[l];
+          c0[l] = static_cast<uint32_t>(p1 >> 32) ^ c1[l] ^ k0;
+          c1[l] = static_cast<uint32_t>(p1);
+          c2[l] = static_cast<uint32_t>(p0 >> 32) ^ c3[l] ^ k1;
+          c3[l] = static_cast<uint32_t>(p0);
+        }
+        key[0] += kW0;
+        key[1] += kW1;
+      }
+      auto lanes = std::min(kLanes, num_blocks - b);
+      for (uint64_t l = 0; l < lanes; ++l) {
+        auto* out = words + 4 * (b + l);
+        out[0] = c0[l];
+        out[1] = c1[l];
+        out[2] = c2[l];
+        out[3] = c3[l];
+      }
+    }
+  }
+
+  BDM_CLASS_DEF_NV(Philox, 1);
+};
+
+}  // namespace bdm
+
+#endif  // CORE_UTIL_PHILOX_H_
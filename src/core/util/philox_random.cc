@@ -0,0 +1,50 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/util/philox_random.h"
+
+namespace bdm {
+
+// -----------------------------------------------------------------------------
+PhiloxRandom::PhiloxRandom(uint64_t seed) : engine_(seed) {
+  SetName("PhiloxRandom");
+  SetTitle("Counter-based random number generator Philox4x32-10");
+}
+
+// -----------------------------------------------------------------------------
+Double_t PhiloxRandom::Rndm() { return engine_.Uniform(); }
+
+// -----------------------------------------------------------------------------
+void PhiloxRandom::RndmArray(Int_t n, Float_t* array) {
+  for (Int_t i = 0; i < n; ++i) {
+    array[i] = static_cast<Float_t>(engine_.Uniform());
+  }
+}
+
+// -----------------------------------------------------------------------------
+void PhiloxRandom::RndmArray(Int_t n, Double_t* array) {
+  for (Int_t i = 0; i < n; ++i) {
+    array[i] = engine_.Uniform();
+  }
+}
+
+// -----------------------------------------------------------------------------
+void PhiloxRandom::SetSeed(ULong_t seed) { engine_.SetSeed(seed); }
+
+// -----------------------------------------------------------------------------
+UInt_t PhiloxRandom::GetSeed() const {
+  return static_cast<UInt_t>(engine_.GetSeed());
+}
+
+}  // namespace bdm
@@ -0,0 +1,74 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_UTIL_PHILOX_RANDOM_H_
+#define CORE_UTIL_PHILOX_RANDOM_H_
+
+#include <TRandom.h>
+#include <cstdint>
+
+#include "core/util/philox.h"
+#include "core/util/root.h"
+
+namespace bdm {
+
+/// ROOT `TRandom` interface of the counter-based random number generator
+/// `Philox`.\n
+/// The numbers are the encrypted values of a counter that consists of the
+/// stream and the position in the stream. Hence, there is an independent
+/// stream for each 64 bit stream id, which does not need any state and can be
+/// positioned at an arbitrary draw in constant time. The seed is the key of
+/// the encryption. In contrast to `TRandom3`, the seed zero is a valid seed.\n
+/// `Random` bypasses the virtual `TRandom` functions and uses the engine
+/// directly if the generator is a `PhiloxRandom` (see
+/// `Param::random_generator`). The deterministic mode (see
+/// `Param::deterministic`) uses one stream for each agent and time step.
+class PhiloxRandom : public TRandom {
+ public:
+  explicit PhiloxRandom(uint64_t seed = 4357);
+
+  ~PhiloxRandom() override = default;
+
+  /// Returns a uniform deviate on the interval (0, 1).
+  Double_t Rndm() override;
+  void RndmArray(Int_t n, Float_t* array) override;
+  void RndmArray(Int_t n, Double_t* array) override;
+
+  /// Sets the key and continues at the beginning of stream zero.
+  void SetSeed(ULong_t seed = 0) override;
+  /// Returns the lower 32 bits of the seed.
+  UInt_t GetSeed() const override;
+
+  /// Continues at draw `position` of the stream `stream`.
+  void SetStream(uint64_t stream, uint64_t position = 0) {
+    engine_.SetStream(stream, position);
+  }
+
+  uint64_t GetStream() const { return engine_.GetStream(); }
+
+  /// Returns the number of 32 bit numbers that have been drawn from the
+  /// current stream.
+  uint64_t GetPosition() const { return engine_.GetPosition(); }
+
+  Philox* GetEngine() { return &engine_; }
+
+ private:
+  Philox engine_;
+
+  BDM_CLASS_DEF_OVERRIDE(PhiloxRandom, 2);
+};
+
+}  // namespace bdm
+
+#endif  // CORE_UTIL_PHILOX_RANDOM_H_
@@ -0,0 +1,393 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/util/profiler.h"
+
+#include <cxxabi.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <typeindex>
+#include <unordered_map>
+
+#include "core/util/log.h"
+
+namespace bdm {
+
+namespace {
+
+/// Names of all profiler scopes
+struct NameRegistry {
+  std::mutex mutex;
+  std::vector<std::string> names;
+  std::unordered_map<std::string, uint32_t> ids;
+  std::unordered_map<std::type_index, uint32_t> type_ids;
+};
+
+NameRegistry& GetNameRegistry() {
+  static NameRegistry registry;
+  return registry;
+}
+
+uint32_t InternLocked(NameRegistry* registry, const std::string& name) {
+  auto it = registry->ids.find(name);
+  if (it != registry->ids.end()) {
+    return it->second;
+  }
+  auto id = static_cast<uint32_t>(registry->names.size());
+  registry->names.push_back(name);
+  registry->ids[name] = id;
+  return id;
+}
+
+std::string Demangle(const char* name) {
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if (status != 0 || demangled == nullptr) {
+    return name;
+  }
+  std::string result(demangled);
+  free(demangled);
+  return result;
+}
+
+/// Escapes `str` for a JSON string literal.
+std::string EscapeJson(const std::string& str) {
+  std::string result;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      result += ' ';
+    } else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+std::atomic<uint64_t> gProfilerCounter(0);
+
+}  // namespace
+
+Profiler* Profiler::active_ = nullptr;
+
+// -----------------------------------------------------------------------------
+Profiler::ThreadProfile::ThreadProfile(uint32_t tid, uint64_t buffer_size)
+    : tid(tid), events(std::max<uint64_t>(buffer_size, 1)) {
+  nodes.push_back({0, {}, {}});
+  stack.push_back(0);
+  start_times.push_back(0);
+}
+
+// -----------------------------------------------------------------------------
+Profiler::Profiler(uint64_t buffer_size, uint64_t max_trace_events)
+    : id_(++gProfilerCounter),
+      epoch_(Clock::now()),
+      buffer_size_(buffer_size),
+      max_trace_events_(max_trace_events) {
+  nodes_.push_back({0, {}, {}});
+}
+
+// -----------------------------------------------------------------------------
+Profiler::~Profiler() {
+  if (active_ == this) {
+    active_ = nullptr;
+  }
+}
+
+// -----------------------------------------------------------------------------
+uint32_t Profiler::Intern(const std::string& name) {
+  auto& registry = GetNameRegistry();
+  std::lock_guard<std::mutex> guard(registry.mutex);
+  return InternLocked(&registry, name);
+}
+
+// -----------------------------------------------------------------------------
+uint32_t Profiler::Intern(const std::type_info& type) {
+  // Called for each behavior of each agent -> avoid the lock
+  thread_local std::unordered_map<std::type_index, uint32_t> cache;
+  auto it = cache.find(type);
+  if (it != cache.end()) {
+    return it->second;
+  }
+  auto& registry = GetNameRegistry();
+  std::lock_guard<std::mutex> guard(registry.mutex);
+  auto tit = registry.type_ids.find(type);
+  uint32_t id = 0;
+  if (tit != registry.type_ids.end()) {
+    id = tit->second;
+  } else {
+    id = InternLocked(&registry, Demangle(type.name()));
+    registry.type_ids[type] = id;
+  }
+  cache[type] = id;
+  return id;
+}
+
+// -----------------------------------------------------------------------------
+std::string Profiler::GetName(uint32_t id) {
+  auto& registry = GetNameRegistry();
+  std::lock_guard<std::mutex> guard(registry.mutex);
+  if (id >= registry.names.size()) {
+    return "";
+  }
+  return registry.names[id];
+}
+
+// -----------------------------------------------------------------------------
+Profiler::ThreadProfile* Profiler::GetThreadProfile() {
+  thread_local uint64_t profiler_id = 0;
+  thread_local ThreadProfile* profile = nullptr;
+  if (profiler_id != id_) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto tid = static_cast<uint32_t>(threads_.size());
+    threads_.emplace_back(new ThreadProfile(tid, buffer_size_));
+    profile = threads_.back().get();
+    profiler_id = id_;
+  }
+  return profile;
+}
+
+// -----------------------------------------------------------------------------
+uint32_t Profiler::GetChild(std::vector<Node>* nodes, uint32_t parent,
+                            uint32_t name) {
+  for (auto child : (*nodes)[parent].children) {
+    if ((*nodes)[child].name == name) {
+      return child;
+    }
+  }
+  auto child = static_cast<uint32_t>(nodes->size());
+  nodes->push_back({name, {}, {}});
+  (*nodes)[parent].children.push_back(child);
+  return child;
+}
+
+// -----------------------------------------------------------------------------
+void Profiler::Begin(uint32_t id) {
+  auto* thread = GetThreadProfile();
+  auto parent = thread->stack.back();
+  if (parent != 0 && thread->nodes[parent].name == id) {
+    thread->stack.push_back(parent);
+    thread->start_times.push_back(kCollapsed);
+    return;
+  }
+  thread->stack.push_back(GetChild(&thread->nodes, parent, id));
+  thread->start_times.push_back(Now());
+}
+
+// -----------------------------------------------------------------------------
+void Profiler::End() {
+  auto end = Now();
+  auto* thread = GetThreadProfile();
+  if (thread->stack.size() <= 1) {
+    Log::Error("Profiler::End", "No open scope.");
+    return;
+  }
+  auto node_idx = thread->stack.back();
+  auto start = thread->start_times.back();
+  thread->stack.pop_back();
+  thread->start_times.pop_back();
+  if (start == kCollapsed) {
+    return;
+  }
+
+  auto& node = thread->nodes[node_idx];
+  node.stats.total_ns += end - start;
+  node.stats.count++;
+  auto& events = thread->events;
+  events[thread->num_events % events.size()] = {node.name, start, end};
+  thread->num_events++;
+}
+
+// -----------------------------------------------------------------------------
+Profiler::ScopePath Profiler::GetScopePath() {
+  auto* thread = GetThreadProfile();
+  ScopePath path;
+  path.owner = thread;
+  // Skip the root and the scopes that have been collapsed into their parent
+  for (uint64_t i = 1; i < thread->stack.size(); ++i) {
+    if (thread->start_times[i] != kCollapsed) {
+      path.names.push_back(thread->nodes[thread->stack[i]].name);
+    }
+  }
+  return path;
+}
+
+// -----------------------------------------------------------------------------
+bool Profiler::BeginPath(const ScopePath& path) {
+  auto* thread = GetThreadProfile();
+  if (path.owner == thread) {
+    return false;
+  }
+  for (auto name : path.names) {
+    Begin(name);
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+void Profiler::Merge(ThreadProfile* thread, uint32_t tnode, uint32_t node) {
+  for (auto tchild : thread->nodes[tnode].children) {
+    auto& tstats = thread->nodes[tchild].stats;
+    auto child = GetChild(&nodes_, node, thread->nodes[tchild].name);
+    // `nodes_` might be reallocated by the recursive call below
+    auto& stats = nodes_[child].stats;
+    if (tstats.count != 0) {
+      stats.total_ns += tstats.total_ns;
+      stats.count += tstats.count;
+      if (stats.thread_ns.size() <= thread->tid) {
+        stats.thread_ns.resize(thread->tid + 1, 0);
+      }
+      stats.thread_ns[thread->tid] += tstats.total_ns;
+      tstats.total_ns = 0;
+      tstats.count = 0;
+    }
+    Merge(thread, tchild, child);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void Profiler::EndIteration() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (auto& thread : threads_) {
+    Merge(thread.get(), 0, 0);
+
+    auto capacity = thread->events.size();
+    auto num_events = thread->num_events;
+    auto first = num_events > capacity ? num_events - capacity : 0;
+    dropped_events_ += first;
+    for (uint64_t i = first; i < num_events; ++i) {
+      if (trace_.size() >= max_trace_events_) {
+        dropped_events_ += num_events - i;
+        break;
+      }
+      const auto& e = thread->events[i % capacity];
+      trace_.push_back({e.name, thread->tid, e.start, e.end});
+    }
+    thread->num_events = 0;
+  }
+}
+
+// -----------------------------------------------------------------------------
+template <typename TFunction>
+void Profiler::ForEachNode(uint32_t node, const std::string& path, int depth,
+                           TFunction&& f) const {
+  for (auto child : nodes_[node].children) {
+    auto name = GetName(nodes_[child].name);
+    std::replace(name.begin(), name.end(), ';', ':');
+    auto child_path = path.empty() ? name : path + ";" + name;
+    f(child, child_path, depth);
+    ForEachNode(child, child_path, depth + 1, f);
+  }
+}
+
+// -----------------------------------------------------------------------------
+const Profiler::Stats* Profiler::GetStats(const std::string& path) const {
+  const Stats* result = nullptr;
+  ForEachNode(0, "", 0, [&](uint32_t node, const std::string& p, int) {
+    if (p == path) {
+      result = &nodes_[node].stats;
+    }
+  });
+  return result;
+}
+
+// -----------------------------------------------------------------------------
+void Profiler::WriteChromeTrace(const std::string& filename) const {
+  std::ofstream out(filename);
+  if (!out) {
+    Log::Error("Profiler::WriteChromeTrace", "Could not open file ", filename);
+    return;
+  }
+  out << "{\"traceEvents\":[\n";
+  bool first = true;
+  for (const auto& thread : threads_) {
+    out << (first ? "" : ",\n")
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+        << thread->tid << ",\"args\":{\"name\":\"thread " << thread->tid
+        << "\"}}";
+    first = false;
+  }
+  out << std::fixed << std::setprecision(3);
+  for (const auto& e : trace_) {
+    out << (first ? "" : ",\n") << "{\"name\":\""
+        << EscapeJson(GetName(e.name)) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+        << e.tid << ",\"ts\":" << e.start / 1e3
+        << ",\"dur\":" << (e.end - e.start) / 1e3 << "}";
+    first = false;
+  }
+  out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+// -----------------------------------------------------------------------------
+void Profiler::WriteFoldedStacks(const std::string& filename) const {
+  std::ofstream out(filename);
+  if (!out) {
+    Log::Error("Profiler::WriteFoldedStacks", "Could not open file ",
+               filename);
+    return;
+  }
+  ForEachNode(0, "", 0, [&](uint32_t node, const std::string& path, int) {
+    const auto& n = nodes_[node];
+    uint64_t children_ns = 0;
+    for (auto child : n.children) {
+      children_ns += nodes_[child].stats.total_ns;
+    }
+    // Children on other threads can exceed the time of the parent
+    auto self_ns = n.stats.total_ns > children_ns
+                       ? n.stats.total_ns - children_ns
+                       : 0;
+    if (self_ns != 0) {
+      out << path << " " << self_ns << "\n";
+    }
+  });
+}
+
+// -----------------------------------------------------------------------------
+void Profiler::Print(std::ostream& out) const {
+  out << "\033[1mProfile (time summed over threads)\033[0m" << std::endl;
+  out << std::left << std::setw(50) << "scope" << std::right << std::setw(14)
+      << "time [ms]" << std::setw(10) << "count" << std::setw(12)
+      << "imbalance" << std::endl;
+  ForEachNode(0, "", 0, [&](uint32_t node, const std::string&, int depth) {
+    const auto& stats = nodes_[node].stats;
+    // Maximum time of a thread divided by the average time of all threads
+    // that executed this scope
+    uint64_t max_ns = 0;
+    uint64_t num_threads = 0;
+    for (auto ns : stats.thread_ns) {
+      max_ns = std::max(max_ns, ns);
+      num_threads += ns != 0 ? 1 : 0;
+    }
+    double imbalance = 0;
+    if (stats.total_ns != 0) {
+      imbalance = static_cast<double>(max_ns) * num_threads / stats.total_ns;
+    }
+    auto name = std::string(2 * depth, ' ') + GetName(nodes_[node].name);
+    out << std::left << std::setw(50) << name << std::right << std::fixed
+        << std::setprecision(3) << std::setw(14) << stats.total_ns / 1e6
+        << std::setw(10) << stats.count << std::setprecision(2)
+        << std::setw(12) << imbalance << std::endl;
+  });
+  if (dropped_events_ != 0) {
+    out << dropped_events_ << " events have been dropped from the trace."
+        << std::endl;
+  }
+}
+
+}  // namespace bdm
@@ -0,0 +1,295 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_UTIL_PROFILER_H_
+#define CORE_UTIL_PROFILER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace bdm {
+
+/// Hierarchical profiler with nanosecond resolution.\n
+/// Code regions are measured with `ProfileScope` (or `BDM_PROFILE_SCOPE`).
+/// Each thread records its scopes into its own call tree and into a ring
+/// buffer of the `buffer_size` most recent events. Hence, recording does not
+/// require any synchronization. `EndIteration` aggregates the call trees of
+/// all threads and moves the events into the trace.\n
+/// The scheduler records operations, batches of agent operations, behaviors
+/// (by type) and the phases of the environment update. Parallel loops over
+/// the agents record the scopes of the worker threads below the scope of the
+/// calling thread (see `ProfilePathScope`).
+/// Directly nested scopes with the same name are collapsed into one, e.g. an
+/// agent operation and the batches that the calling thread processes.
+/// The time of a call tree node is the sum over all threads; the time per
+/// thread shows the load imbalance.\n
+/// Enable with `Param::profiling`. The results are written to the output
+/// directory at the end of the simulation.
+class Profiler {
+ public:
+  /// Statistics of one node of the aggregated call tree
+  struct Stats {
+    uint64_t total_ns = 0;
+    uint64_t count = 0;
+    /// Time per thread (indexed by the thread id of the profiler)
+    std::vector<uint64_t> thread_ns;
+  };
+
+  /// @param buffer_size Number of events per thread and iteration that are
+  ///        kept for the trace
+  /// @param max_trace_events Events are dropped once the trace contains
+  ///        this many events.
+  Profiler(uint64_t buffer_size, uint64_t max_trace_events);
+
+  ~Profiler();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  /// Returns the profiler that records the scopes, or nullptr if profiling
+  /// is disabled.
+  static Profiler* GetActive() { return active_; }
+
+  static void SetActive(Profiler* profiler) { active_ = profiler; }
+
+  /// Returns the id of `name`. Ids are shared between all profilers.
+  static uint32_t Intern(const std::string& name);
+
+  /// Returns the id of the demangled name of `type`.
+  static uint32_t Intern(const std::type_info& type);
+
+  static std::string GetName(uint32_t id);
+
+  /// Nanoseconds since the creation of this profiler
+  uint64_t Now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                                epoch_)
+        .count();
+  }
+
+  /// Opens a scope with name `id` on the calling thread.
+  void Begin(uint32_t id);
+
+  /// Closes the innermost scope of the calling thread.
+  void End();
+
+  /// Names of the open scopes of a thread (outermost first)
+  struct ScopePath {
+    /// Thread the path has been taken from
+    const void* owner = nullptr;
+    std::vector<uint32_t> names;
+  };
+
+  /// Returns the open scopes of the calling thread.
+  ScopePath GetScopePath();
+
+  /// Opens the scopes of `path` on the calling thread, unless it is the
+  /// thread that `path` has been taken from. Returns true if the scopes have
+  /// been opened. \see `ProfilePathScope`
+  bool BeginPath(const ScopePath& path);
+
+  /// Aggregates the data of all threads. Must not be called while other
+  /// threads record scopes.
+  void EndIteration();
+
+  /// Returns the statistics of the call tree node with the given path
+  /// (names separated by ';'), or nullptr if the node does not exist.
+  const Stats* GetStats(const std::string& path) const;
+
+  /// Returns the number of events that did not fit into the ring buffers or
+  /// the trace.
+  uint64_t GetNumDroppedEvents() const { return dropped_events_; }
+
+  /// Writes the trace in the Chrome trace event format (JSON). It can be
+  /// opened with chrome://tracing or https://ui.perfetto.dev
+  void WriteChromeTrace(const std::string& filename) const;
+
+  /// Writes the self time of each call tree node in nanoseconds in the
+  /// folded stack format (input for flamegraph.pl), e.g.
+  ///
+  ///     behavior;bdm::GrowthDivision 123456
+  void WriteFoldedStacks(const std::string& filename) const;
+
+  /// Prints the aggregated call tree.
+  void Print(std::ostream& out) const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Event {
+    uint32_t name;
+    uint64_t start;
+    uint64_t end;
+  };
+
+  struct TraceEvent {
+    uint32_t name;
+    uint32_t tid;
+    uint64_t start;
+    uint64_t end;
+  };
+
+  struct Node {
+    uint32_t name;
+    std::vector<uint32_t> children;
+    Stats stats;
+  };
+
+  /// Recording state of one thread
+  struct ThreadProfile {
+    uint32_t tid;
+    /// Call tree of this thread; node 0 is the root
+    std::vector<Node> nodes;
+    /// Open scopes (node index and start time). A start time of
+    /// `kCollapsed` marks a scope that has been merged into its parent.
+    std::vector<uint32_t> stack;
+    std::vector<uint64_t> start_times;
+    /// Ring buffer of the most recent events
+    std::vector<Event> events;
+    uint64_t num_events = 0;
+
+    ThreadProfile(uint32_t tid, uint64_t buffer_size);
+  };
+
+  static constexpr uint64_t kCollapsed = UINT64_MAX;
+
+  static Profiler* active_;
+
+  /// Distinguishes profilers in the thread-local cache of `GetThreadProfile`
+  uint64_t id_;
+  Clock::time_point epoch_;
+  uint64_t buffer_size_;
+  uint64_t max_trace_events_;
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<ThreadProfile>> threads_;
+
+  /// Aggregated call tree; node 0 is the root
+  std::vector<Node> nodes_;
+  std::vector<TraceEvent> trace_;
+  uint64_t dropped_events_ = 0;
+
+  /// Returns the profile of the calling thread and creates it if necessary.
+  ThreadProfile* GetThreadProfile();
+
+  /// Returns the index of the child of `parent` with `name` and adds it if
+  /// necessary.
+  static uint32_t GetChild(std::vector<Node>* nodes, uint32_t parent,
+                           uint32_t name);
+
+  /// Adds the statistics of the subtree `tnode` of `thread` to the subtree
+  /// `node` of the aggregated call tree and resets them.
+  void Merge(ThreadProfile* thread, uint32_t tnode, uint32_t node);
+
+  /// Calls `f(node, path)` for all nodes of the aggregated call tree
+  /// (depth first, except for the root).
+  template <typename TFunction>
+  void ForEachNode(uint32_t node, const std::string& path, int depth,
+                   TFunction&& f) const;
+};
+
+/// Measures the time between construction and destruction if profiling is
+/// enabled (see `Profiler`). Otherwise, the overhead is a single check.
+class ProfileScope {
+ public:
+  explicit ProfileScope(uint32_t id) : profiler_(Profiler::GetActive()) {
+    if (profiler_) {
+      profiler_->Begin(id);
+    }
+  }
+
+  explicit ProfileScope(const std::string& name)
+      : profiler_(Profiler::GetActive()) {
+    if (profiler_) {
+      profiler_->Begin(Profiler::Intern(name));
+    }
+  }
+
+  explicit ProfileScope(const std::type_info& type)
+      : profiler_(Profiler::GetActive()) {
+    if (profiler_) {
+      profiler_->Begin(Profiler::Intern(type));
+    }
+  }
+
+  ~ProfileScope() {
+    if (profiler_) {
+      profiler_->End();
+    }
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  Profiler* profiler_;
+};
+
+/// Records the scopes of worker threads below the scopes that are open on
+/// the thread that starts a parallel loop, e.g. the behaviors below
+/// "agent ops". Otherwise, they would be recorded at the root of the call
+/// tree. Take the path with `GetPath` before the loop and open a
+/// `ProfilePathScope` for each chunk of work.
+class ProfilePathScope {
+ public:
+  explicit ProfilePathScope(const Profiler::ScopePath& path)
+      : profiler_(Profiler::GetActive()), size_(path.names.size()) {
+    if (profiler_ && !profiler_->BeginPath(path)) {
+      profiler_ = nullptr;
+    }
+  }
+
+  ~ProfilePathScope() {
+    if (profiler_) {
+      for (uint64_t i = 0; i < size_; ++i) {
+        profiler_->End();
+      }
+    }
+  }
+
+  /// Returns the open scopes of the calling thread, or an empty path if
+  /// profiling is disabled.
+  static Profiler::ScopePath GetPath() {
+    auto* profiler = Profiler::GetActive();
+    return profiler ? profiler->GetScopePath() : Profiler::ScopePath();
+  }
+
+  ProfilePathScope(const ProfilePathScope&) = delete;
+  ProfilePathScope& operator=(const ProfilePathScope&) = delete;
+
+ private:
+  Profiler* profiler_;
+  uint64_t size_;
+};
+
+#define BDM_PROFILE_CONCAT_IMPL(a, b) a##b
+#define BDM_PROFILE_CONCAT(a, b) BDM_PROFILE_CONCAT_IMPL(a, b)
+
+/// Profiles the remainder of the enclosing block. `name` must be a constant,
+/// since it is interned only once.
+#define BDM_PROFILE_SCOPE(name)                                          \
+  static const uint32_t BDM_PROFILE_CONCAT(bdm_profile_id_, __LINE__) = \
+      ::bdm::Profiler::Intern(name);                                     \
+  ::bdm::ProfileScope BDM_PROFILE_CONCAT(bdm_profile_scope_, __LINE__)(  \
+      BDM_PROFILE_CONCAT(bdm_profile_id_, __LINE__))
+
+}  // namespace bdm
+
+#endif  // CORE_UTIL_PROFILER_H_
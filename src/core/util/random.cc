@@ -16,11 +16,68 @@
 #include <TF1.h>
 #include <TF2.h>
 #include <TF3.h>
+#include <TMath.h>
 #include <TRandom3.h>
+#include <algorithm>
+#include <cmath>
 #include "core/simulation.h"
+#include "core/util/log.h"
+#include "core/util/philox.h"
+#include "core/util/philox_random.h"
 
 namespace bdm {
 
+namespace {
+
+/// Number of 32 bit numbers that the batch functions generate at once
+constexpr uint64_t kBatchSize = 512;
+
+/// Draws a Poisson deviate with mean `mean` < 10 by inversion.
+/// `p0` is exp(-mean).
+int PoissonInversion(Philox* engine, double mean, double p0) {
+  auto u = engine->Uniform();
+  int k = 0;
+  double p = p0;
+  double cdf = p0;
+  // The probabilities underflow long before k overflows
+  while (u > cdf && p > 0) {
+    ++k;
+    p *= mean / k;
+    cdf += p;
+  }
+  return k;
+}
+
+/// Draws a Poisson deviate with mean `mean` >= 10 with the transformed
+/// rejection method with squeeze PTRS (Hoermann, "The transformed rejection
+/// method for generating Poisson random variables", 1993).
+int PoissonPtrs(Philox* engine, double mean) {
+  const double slam = std::sqrt(mean);
+  const double loglam = std::log(mean);
+  const double b = 0.931 + 2.53 * slam;
+  const double a = -0.059 + 0.02483 * b;
+  const double inv_alpha = 1.1239 + 1.1328 / (b - 3.4);
+  const double vr = 0.9277 - 3.6224 / (b - 2);
+  while (true) {
+    auto u = engine->Uniform() - 0.5;
+    auto v = engine->Uniform();
+    auto us = 0.5 - std::abs(u);
+    auto k = std::floor((2 * a / us + b) * u + mean + 0.43);
+    if (us >= 0.07 && v <= vr) {
+      return static_cast<int>(k);
+    }
+    if (k < 0 || (us < 0.013 && v > us)) {
+      continue;
+    }
+    if (std::log(v) + std::log(inv_alpha) - std::log(a / (us * us) + b) <=
+        -mean + k * loglam - std::lgamma(k + 1)) {
+      return static_cast<int>(k);
+    }
+  }
+}
+
+}  // namespace
+
 // -----------------------------------------------------------------------------
 Random::Random() : generator_(new TRandom3()) {}
 
@@ -29,7 +86,8 @@ Random::Random(TRootIOCtor*) {}
 
 // -----------------------------------------------------------------------------
 Random::Random(const Random& other)
-    : generator_(static_cast<TRandom*>(other.generator_->Clone())) {}
+    : generator_(static_cast<TRandom*>(other.generator_->Clone())),
+      philox_(dynamic_cast<PhiloxRandom*>(generator_)) {}
 
 // -----------------------------------------------------------------------------
 Random::~Random() {
@@ -54,25 +112,120 @@ Random& Random::operator=(const Random& other) {
       delete generator_;
     }
     generator_ = static_cast<TRandom*>(other.generator_->Clone());
+    philox_ = dynamic_cast<PhiloxRandom*>(generator_);
   }
   return *this;
 }
 
 // -----------------------------------------------------------------------------
-real_t Random::Uniform(real_t max) { return generator_->Uniform(max); }
+real_t Random::Uniform(real_t max) {
+  if (philox_ != nullptr) {
+    return static_cast<real_t>(max * philox_->GetEngine()->Uniform());
+  }
+  return generator_->Uniform(max);
+}
 
 // -----------------------------------------------------------------------------
 real_t Random::Uniform(real_t min, real_t max) {
+  if (philox_ != nullptr) {
+    // Same arithmetic as TRandom::Uniform
+    const double lo = min;
+    const double range = static_cast<double>(max) - lo;
+    return static_cast<real_t>(lo + range * philox_->GetEngine()->Uniform());
+  }
   return generator_->Uniform(min, max);
 }
 
+// -----------------------------------------------------------------------------
+void Random::UniformArray(uint64_t n, real_t* buffer, real_t min,
+                          real_t max) {
+  if (philox_ == nullptr) {
+    for (uint64_t i = 0; i < n; ++i) {
+      buffer[i] = Uniform(min, max);
+    }
+    return;
+  }
+  auto* engine = philox_->GetEngine();
+  const double lo = min;
+  const double range = static_cast<double>(max) - lo;
+  uint32_t words[kBatchSize];
+  for (uint64_t i = 0; i < n; i += kBatchSize) {
+    auto size = std::min(kBatchSize, n - i);
+    engine->Generate(size, words);
+    auto* out = buffer + i;
+#pragma omp simd
+    for (uint64_t j = 0; j < size; ++j) {
+      auto unit = (words[j] + 0.5) * Philox::kWordToUnit;
+      out[j] = static_cast<real_t>(lo + range * unit);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void Random::GausArray(uint64_t n, real_t* buffer, real_t mean,
+                       real_t sigma) {
+  if (philox_ == nullptr) {
+    for (uint64_t i = 0; i < n; ++i) {
+      buffer[i] = Gaus(mean, sigma);
+    }
+    return;
+  }
+  auto* engine = philox_->GetEngine();
+  uint32_t words[kBatchSize];
+  double samples[kBatchSize];
+  for (uint64_t i = 0; i < n; i += kBatchSize) {
+    auto size = std::min(kBatchSize, n - i);
+    auto pairs = (size + 1) / 2;
+    engine->Generate(2 * pairs, words);
+#pragma omp simd
+    for (uint64_t j = 0; j < pairs; ++j) {
+      auto u1 = (words[2 * j] + 0.5) * Philox::kWordToUnit;
+      auto u2 = (words[2 * j + 1] + 0.5) * Philox::kWordToUnit;
+      auto r = sigma * std::sqrt(-2 * std::log(u1));
+      auto phi = TMath::TwoPi() * u2;
+      samples[2 * j] = mean + r * std::cos(phi);
+      samples[2 * j + 1] = mean + r * std::sin(phi);
+    }
+    std::copy(samples, samples + size, buffer + i);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void Random::PoissonArray(uint64_t n, int* buffer, real_t mean) {
+  if (philox_ == nullptr) {
+    for (uint64_t i = 0; i < n; ++i) {
+      buffer[i] = Poisson(mean);
+    }
+    return;
+  }
+  auto* engine = philox_->GetEngine();
+  if (mean <= 0) {
+    std::fill(buffer, buffer + n, 0);
+  } else if (mean < 10) {
+    const double p0 = std::exp(-static_cast<double>(mean));
+    for (uint64_t i = 0; i < n; ++i) {
+      buffer[i] = PoissonInversion(engine, mean, p0);
+    }
+  } else {
+    for (uint64_t i = 0; i < n; ++i) {
+      buffer[i] = PoissonPtrs(engine, mean);
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 real_t Random::Gaus(real_t mean, real_t sigma) {
   return generator_->Gaus(mean, sigma);
 }
 
 // -----------------------------------------------------------------------------
-real_t Random::Exp(real_t tau) { return generator_->Exp(tau); }
+real_t Random::Exp(real_t tau) {
+  if (philox_ != nullptr) {
+    auto unit = philox_->GetEngine()->Uniform();
+    return static_cast<real_t>(-tau * std::log(unit));
+  }
+  return generator_->Exp(tau);
+}
 
 // -----------------------------------------------------------------------------
 real_t Random::Landau(real_t mean, real_t sigma) {
@@ -88,7 +241,13 @@ real_t Random::BreitWigner(real_t mean, real_t gamma) {
 }
 
 // -----------------------------------------------------------------------------
-unsigned Random::Integer(int max) { return generator_->Integer(max); }
+unsigned Random::Integer(int max) {
+  if (philox_ != nullptr) {
+    auto unit = philox_->GetEngine()->Uniform();
+    return static_cast<unsigned>(static_cast<unsigned>(max) * unit);
+  }
+  return generator_->Integer(max);
+}
 
 // -----------------------------------------------------------------------------
 int Random::Binomial(int ntot, real_t prob) {
@@ -126,6 +285,33 @@ void Random::SetGenerator(TRandom* new_generator) {
     delete generator_;
   }
   generator_ = new_generator;
+  philox_ = dynamic_cast<PhiloxRandom*>(generator_);
+}
+
+// -----------------------------------------------------------------------------
+void Random::SetStream(uint64_t stream, uint64_t position) {
+  GetPhilox()->SetStream(stream, position);
+}
+
+// -----------------------------------------------------------------------------
+uint64_t Random::GetStream() const { return GetPhilox()->GetStream(); }
+
+// -----------------------------------------------------------------------------
+uint64_t Random::GetStreamPosition() const {
+  return GetPhilox()->GetPosition();
+}
+
+// -----------------------------------------------------------------------------
+PhiloxRandom* Random::GetPhilox() const {
+  if (philox_ == nullptr) {
+    philox_ = dynamic_cast<PhiloxRandom*>(generator_);
+    if (philox_ == nullptr) {
+      Log::Fatal("Random::GetPhilox",
+                 "Random streams require the counter-based generator "
+                 "PhiloxRandom (see Param::random_generator).");
+    }
+  }
+  return philox_;
 }
 
 // -----------------------------------------------------------------------------
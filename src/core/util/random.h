@@ -27,6 +27,8 @@ class TF3;
 
 namespace bdm {
 
+class PhiloxRandom;
+
 // -----------------------------------------------------------------------------
 /// Random number generator that generates samples from a distribution
 template <typename TSample>
@@ -259,6 +261,10 @@ class PoissonRng : public DistributionRng<int> {
 /// Decorator for ROOT's TRandom
 /// Uses TRandom3 as default random number generator
 /// \see https://root.cern/doc/master/classTRandom.html
+/// If the generator is the counter-based `PhiloxRandom` (see
+/// `Param::random_generator`), `Uniform`, `Exp`, `Integer`, and the batch
+/// functions (`UniformArray`, `GausArray`, `PoissonArray`) use its engine
+/// directly instead of the virtual functions of `TRandom`.
 class Random {
  public:
   Random();
@@ -296,6 +302,27 @@ class Random {
     return ret;
   }
 
+  /// Fills `buffer` with `n` uniform deviates on the interval (min, max).\n
+  /// The numbers are the same as for `n` calls of `Uniform(min, max)`. With
+  /// the counter-based generator, they are generated block-wise with SIMD
+  /// instructions.
+  void UniformArray(uint64_t n, real_t* buffer, real_t min = 0,
+                    real_t max = 1);
+
+  /// Fills `buffer` with `n` normal deviates.\n
+  /// With the counter-based generator, the Box-Muller transformation of the
+  /// vectorized uniform deviates is used, which consumes two 32 bit numbers
+  /// per sample (rounded up to an even number). Otherwise, calls
+  /// `Gaus(mean, sigma)` `n` times.
+  void GausArray(uint64_t n, real_t* buffer, real_t mean = 0,
+                 real_t sigma = 1);
+
+  /// Fills `buffer` with `n` Poisson deviates.\n
+  /// With the counter-based generator, the samples are drawn by inversion
+  /// for `mean < 10` and with the transformed rejection method PTRS
+  /// (Hoermann, 1993) otherwise. Otherwise, calls `Poisson(mean)` `n` times.
+  void PoissonArray(uint64_t n, int* buffer, real_t mean);
+
   /// Forwards call to ROOT's `TRandom`.\n
   /// \see https://root.cern/doc/master/classTRandom.html
   real_t Gaus(real_t mean = 0.0, real_t sigma = 1.0);
@@ -342,6 +369,16 @@ class Random {
   /// for a list of available choices
   void SetGenerator(TRandom* new_rng);
 
+  /// Continues at draw `position` of the stream `stream`.\n
+  /// Requires the counter-based generator `PhiloxRandom` (see
+  /// `Param::random_generator`).
+  void SetStream(uint64_t stream, uint64_t position = 0);
+  /// Returns the current stream of the counter-based generator.
+  uint64_t GetStream() const;
+  /// Returns the number of draws from the current stream of the
+  /// counter-based generator.
+  uint64_t GetStreamPosition() const;
+
   /// Returns a random number generator that draws samples from a
   /// uniform distribution with given parameters.
   UniformRng GetUniformRng(real_t min = 0, real_t max = 1) const;
@@ -423,6 +460,9 @@ class Random {
   friend class DistributionRng<int>;
 
   TRandom* generator_ = nullptr;
+  /// `generator_` if it is a `PhiloxRandom`; nullptr otherwise and after
+  /// ROOT I/O until `GetPhilox` has been called
+  mutable PhiloxRandom* philox_ = nullptr;  //!
   /// Stores TF1 pointers that have been created for a specific user-defined
   /// 1D distribution
   std::unordered_map<UserDefinedDist, TF1*> udd_tf1_map_;  //!
@@ -432,6 +472,11 @@ class Random {
   /// Stores TF3 pointers that have been created for a specific user-defined
   /// 3D distribution
   std::unordered_map<UserDefinedDist, TF3*> udd_tf3_map_;  //!
+
+  /// Returns `generator_` as `PhiloxRandom` or fails if it is a different
+  /// generator.
+  PhiloxRandom* GetPhilox() const;
+
   BDM_CLASS_DEF_NV(Random, 3);
 };
 
@@ -22,6 +22,7 @@
 #include "core/param/param.h"
 #include "core/scheduler.h"
 #include "core/simulation.h"
+#include "core/util/profiler.h"
 #include "core/util/timing_aggregator.h"
 
 namespace bdm {
@@ -39,8 +40,11 @@ class Timing {
     return millis.count();
   }
 
+  /// Measures the execution time of `f` if `Param::statistics` is enabled,
+  /// and records it in the `Profiler` if `Param::profiling` is enabled.
   template <typename TFunctor>
   static void Time(const std::string& description, TFunctor&& f) {
+    ProfileScope scope(description);
     static bool kUseTimer = Simulation::GetActive()->GetParam()->statistics;
     if (kUseTimer) {
       auto* agg = Simulation::GetActive()->GetScheduler()->GetOpTimes();
@@ -16,6 +16,7 @@
 #define CORE_UTIL_TIMING_AGGREGATOR_H_
 
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -24,6 +25,7 @@
 
 #include "core/simulation.h"
 #include "core/util/math.h"
+#include "core/util/spinlock.h"
 
 namespace bdm {
 
@@ -32,7 +34,10 @@ class TimingAggregator {
   TimingAggregator() = default;
   ~TimingAggregator() = default;
 
+  /// Thread-safe, because operations can be executed concurrently (see
+  /// `Param::concurrent_operations`).
   void AddEntry(const std::string& key, int64_t value) {
+    std::lock_guard<Spinlock> guard(lock_);
     if (!timings_.count(key)) {
       std::vector<int64_t> data;
       data.push_back(value);
@@ -54,6 +59,7 @@ class TimingAggregator {
  private:
   std::map<std::string, std::vector<int64_t>> timings_;
   std::vector<std::string> descriptions_;
+  Spinlock lock_;  //!
   BDM_CLASS_DEF_NV(TimingAggregator, 1);
 
   friend std::ostream& operator<<(std::ostream& os, const TimingAggregator& p);
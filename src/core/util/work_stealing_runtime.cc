@@ -0,0 +1,221 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/util/work_stealing_runtime.h"
+
+#include <omp.h>
+#include <algorithm>
+
+#include "core/util/log.h"
+#include "core/util/thread_info.h"
+
+namespace bdm {
+
+// -----------------------------------------------------------------------------
+WorkStealingRuntime* WorkStealingRuntime::GetInstance() {
+  static WorkStealingRuntime kInstance;
+  return &kInstance;
+}
+
+// -----------------------------------------------------------------------------
+void WorkStealingRuntime::ParallelFor(uint64_t num_tasks,
+                                      Functor<void, uint64_t>& task) {
+  auto max_threads = ThreadInfo::GetInstance()->GetMaxThreads();
+  std::vector<uint64_t> begin(max_threads);
+  std::vector<uint64_t> end(max_threads);
+  for (int t = 0; t < max_threads; ++t) {
+    begin[t] = num_tasks * t / max_threads;
+    end[t] = num_tasks * (t + 1) / max_threads;
+  }
+  Run(begin, end, task);
+}
+
+// -----------------------------------------------------------------------------
+void WorkStealingRuntime::ParallelForNuma(
+    const std::vector<uint64_t>& tasks_per_numa,
+    Functor<void, int, uint64_t>& task,
+    const std::vector<uint64_t>& thread_begin,
+    const std::vector<uint64_t>& thread_end) {
+  auto* ti = ThreadInfo::GetInstance();
+  auto max_threads = ti->GetMaxThreads();
+  auto numa_nodes = ti->GetNumaNodes();
+
+  // map the tasks of all NUMA nodes into one global index space
+  std::vector<uint64_t> numa_offset(numa_nodes + 1);
+  for (int n = 0; n < numa_nodes; ++n) {
+    numa_offset[n + 1] = numa_offset[n] + tasks_per_numa[n];
+  }
+
+  std::vector<uint64_t> begin(max_threads);
+  std::vector<uint64_t> end(max_threads);
+  for (int t = 0; t < max_threads; ++t) {
+    auto nid = ti->GetNumaNode(t);
+    if (thread_begin.empty()) {
+      auto threads_in_numa = ti->GetThreadsInNumaNode(nid);
+      auto numa_tid = ti->GetNumaThreadId(t);
+      begin[t] = tasks_per_numa[nid] * numa_tid / threads_in_numa;
+      end[t] = tasks_per_numa[nid] * (numa_tid + 1) / threads_in_numa;
+    } else {
+      begin[t] = thread_begin[t];
+      end[t] = thread_end[t];
+    }
+    begin[t] += numa_offset[nid];
+    end[t] += numa_offset[nid];
+  }
+
+  auto global_task = L2F([&](uint64_t idx) {
+    int n = 0;
+    while (idx >= numa_offset[n + 1]) {
+      n++;
+    }
+    task(n, idx - numa_offset[n]);
+  });
+  Run(begin, end, global_task);
+}
+
+// -----------------------------------------------------------------------------
+void WorkStealingRuntime::Initialize() {
+  auto* ti = ThreadInfo::GetInstance();
+  auto max_threads = ti->GetMaxThreads();
+  if (deques_.size() == static_cast<size_t>(max_threads) &&
+      numa_thread_offset_.size() ==
+          static_cast<size_t>(ti->GetNumaNodes() + 1)) {
+    return;
+  }
+
+  std::vector<Deque> deques(max_threads);
+  deques_.swap(deques);
+  for (int t = 0; t < max_threads; ++t) {
+    deques_[t].seed = 0x9e3779b97f4a7c15ULL * (t + 1);
+  }
+
+  threads_by_numa_.resize(max_threads);
+  for (int t = 0; t < max_threads; ++t) {
+    threads_by_numa_[t] = t;
+  }
+  std::stable_sort(threads_by_numa_.begin(), threads_by_numa_.end(),
+                   [&](int lhs, int rhs) {
+                     return ti->GetNumaNode(lhs) < ti->GetNumaNode(rhs);
+                   });
+  numa_thread_offset_.resize(ti->GetNumaNodes() + 1);
+  numa_thread_offset_[0] = 0;
+  for (int n = 0; n < ti->GetNumaNodes(); ++n) {
+    numa_thread_offset_[n + 1] =
+        numa_thread_offset_[n] + ti->GetThreadsInNumaNode(n);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void WorkStealingRuntime::Run(const std::vector<uint64_t>& begin,
+                              const std::vector<uint64_t>& end,
+                              Functor<void, uint64_t>& task) {
+  if (omp_in_parallel()) {
+    Log::Fatal("WorkStealingRuntime::Run",
+               "The work stealing runtime must not be used inside a parallel "
+               "region.");
+  }
+  Initialize();
+  for (size_t t = 0; t < deques_.size(); ++t) {
+    if (end[t] > kMaxTasks) {
+      Log::Fatal("WorkStealingRuntime::Run",
+                 "The number of tasks must not exceed ", kMaxTasks);
+    }
+    deques_[t].range.store(Pack(begin[t], std::max(begin[t], end[t])),
+                           std::memory_order_relaxed);
+  }
+
+#pragma omp parallel
+  {
+    auto tid = ThreadInfo::GetInstance()->GetMyThreadId();
+    uint64_t current = 0;
+    while (PopFront(tid, &current) || Steal(tid, &current)) {
+      task(current);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+bool WorkStealingRuntime::PopFront(int tid, uint64_t* task) {
+  auto& range = deques_[tid].range;
+  auto current = range.load(std::memory_order_acquire);
+  while (true) {
+    uint64_t begin = current >> 32;
+    uint64_t end = current & kMaxTasks;
+    if (begin >= end) {
+      return false;
+    }
+    if (range.compare_exchange_weak(current, Pack(begin + 1, end),
+                                    std::memory_order_acq_rel)) {
+      *task = begin;
+      return true;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+bool WorkStealingRuntime::Steal(int tid, uint64_t* task) {
+  auto* ti = ThreadInfo::GetInstance();
+  auto numa_nodes = ti->GetNumaNodes();
+  auto nid = ti->GetNumaNode(tid);
+  auto& seed = deques_[tid].seed;
+
+  // Start with the own NUMA node. Within a NUMA node, begin with a random
+  // victim to avoid that all thieves compete for the same deque.
+  for (int i = 0; i < numa_nodes; ++i) {
+    int current_nid = (nid + i) % numa_nodes;
+    int first = numa_thread_offset_[current_nid];
+    int num_threads = numa_thread_offset_[current_nid + 1] - first;
+    if (num_threads == 0) {
+      continue;
+    }
+    // xorshift64
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    int start = static_cast<int>(seed % num_threads);
+    for (int j = 0; j < num_threads; ++j) {
+      auto victim = threads_by_numa_[first + (start + j) % num_threads];
+      if (victim != tid && StealFrom(tid, victim, task)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+bool WorkStealingRuntime::StealFrom(int tid, int victim, uint64_t* task) {
+  auto& range = deques_[victim].range;
+  auto current = range.load(std::memory_order_acquire);
+  while (true) {
+    uint64_t begin = current >> 32;
+    uint64_t end = current & kMaxTasks;
+    if (begin >= end) {
+      return false;
+    }
+    // steal the back half (at least one task)
+    uint64_t stolen = (end - begin + 1) / 2;
+    if (range.compare_exchange_weak(current, Pack(begin, end - stolen),
+                                    std::memory_order_acq_rel)) {
+      *task = end - stolen;
+      // Only the owner adds tasks to its deque, and it is empty at this
+      // point.
+      deques_[tid].range.store(Pack(end - stolen + 1, end),
+                               std::memory_order_release);
+      return true;
+    }
+  }
+}
+
+}  // namespace bdm
@@ -0,0 +1,119 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_UTIL_WORK_STEALING_RUNTIME_H_
+#define CORE_UTIL_WORK_STEALING_RUNTIME_H_
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "core/functor.h"
+
+namespace bdm {
+
+/// Executes tasks in parallel with randomized, NUMA-aware work stealing.\n
+/// Tasks are identified by an index. Each OpenMP thread owns a deque that
+/// initially contains a contiguous range of tasks. A thread removes tasks
+/// from the front of its own deque. Once its deque is empty, the thread
+/// steals half of the remaining tasks from the back of the deque of another
+/// thread. Victims are chosen randomly among the threads of the same NUMA
+/// node first, and among the threads of the other NUMA nodes afterwards.\n
+/// The deques are allocated once and reused across calls.\n
+/// Usage in a standalone operation:
+///
+///     auto* runtime = WorkStealingRuntime::GetInstance();
+///     runtime->ParallelFor(num_blocks, [&](uint64_t block) {
+///       // process block
+///     });
+///
+/// The runtime must not be used inside a parallel region.
+/// \see `Param::work_stealing_runtime`
+class WorkStealingRuntime {
+ public:
+  static WorkStealingRuntime* GetInstance();
+
+  WorkStealingRuntime(const WorkStealingRuntime&) = delete;
+  WorkStealingRuntime& operator=(const WorkStealingRuntime&) = delete;
+
+  /// Executes `task(i)` for all `i` in [0, num_tasks). Initially, the tasks
+  /// are split evenly among all threads.
+  void ParallelFor(uint64_t num_tasks, Functor<void, uint64_t>& task);
+
+  template <typename TLambda,
+            typename = std::enable_if_t<!std::is_base_of<
+                Functor<void, uint64_t>, std::decay_t<TLambda>>::value>>
+  void ParallelFor(uint64_t num_tasks, TLambda&& lambda) {
+    auto task = L2F(lambda);
+    ParallelFor(num_tasks, task);
+  }
+
+  /// Executes `task(n, i)` for all NUMA nodes `n` and all `i` in
+  /// [0, tasks_per_numa[n]).\n
+  /// Thread `t` initially owns the tasks [thread_begin[t], thread_end[t]) of
+  /// its NUMA node. If `thread_begin` and `thread_end` are empty, the tasks
+  /// of each NUMA node are split evenly among its threads.
+  void ParallelForNuma(const std::vector<uint64_t>& tasks_per_numa,
+                       Functor<void, int, uint64_t>& task,
+                       const std::vector<uint64_t>& thread_begin = {},
+                       const std::vector<uint64_t>& thread_end = {});
+
+ private:
+  /// The task range [begin, end) of a deque is packed into a single 64 bit
+  /// word (begin in the upper, end in the lower 32 bits). Hence, the owner
+  /// and thieves can modify it with a single compare-and-swap.
+  struct alignas(64) Deque {
+    std::atomic<uint64_t> range{0};
+    /// State of the random number generator used for victim selection
+    uint64_t seed = 0;
+  };
+
+  static constexpr uint64_t kMaxTasks = 0xffffffff;
+
+  std::vector<Deque> deques_;
+  /// Threads sorted by NUMA node
+  std::vector<int> threads_by_numa_;
+  /// Index of the first thread of each NUMA node in `threads_by_numa_`
+  std::vector<int> numa_thread_offset_;
+
+  WorkStealingRuntime() = default;
+
+  /// Adapts the data structures to the current number of threads.
+  void Initialize();
+
+  /// Executes all tasks. `begin` and `end` contain the initial ranges of
+  /// each thread in the global task index space.
+  void Run(const std::vector<uint64_t>& begin,
+           const std::vector<uint64_t>& end, Functor<void, uint64_t>& task);
+
+  /// Removes the first task from the deque of thread `tid`.
+  bool PopFront(int tid, uint64_t* task);
+
+  /// Tries to steal tasks from other threads. On success, the first stolen
+  /// task is returned in `task` and the remaining ones are added to the deque
+  /// of thread `tid`.
+  bool Steal(int tid, uint64_t* task);
+
+  /// Tries to steal tasks from thread `victim`.
+  bool StealFrom(int tid, int victim, uint64_t* task);
+
+  static uint64_t Pack(uint64_t begin, uint64_t end) {
+    return (begin << 32) | end;
+  }
+};
+
+}  // namespace bdm
+
+#endif  // CORE_UTIL_WORK_STEALING_RUNTIME_H_
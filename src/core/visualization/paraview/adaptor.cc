@@ -14,9 +14,13 @@
 
 #include <cstdlib>
 #include <fstream>
+#include <functional>
 #include <memory>
 #include <sstream>
+#include <utility>
+#include <vector>
 
+#include "core/util/io_thread_pool.h"
 #include "core/visualization/paraview/adaptor.h"
 #include "core/visualization/paraview/helper.h"
 #include "core/visualization/paraview/vtk_agents.h"
@@ -52,6 +56,8 @@ struct ParaviewAdaptor::ParaviewImpl {
   std::unordered_map<std::string, VtkAgents*> vtk_agents_;
   std::unordered_map<std::string, VtkDiffusionGrid*> vtk_dgrids_;
   vtkCPDataDescription* data_description_ = nullptr;
+  /// Writes the files if `Param::visualization_export_async` is set
+  std::unique_ptr<IoThreadPool> io_pool_;
 };
 
 // ----------------------------------------------------------------------------
@@ -70,6 +76,8 @@ ParaviewAdaptor::~ParaviewAdaptor() {
   counter_--;
 
   if (impl_) {
+    // Finish pending asynchronous exports
+    impl_->io_pool_.reset();
     if (counter_ == 0 && impl_->g_processor_) {
       impl_->g_processor_->RemoveAllPipelines();
       impl_->g_processor_->Finalize();
@@ -186,6 +194,25 @@ void ParaviewAdaptor::ExportVisualization() {
 
   auto step = impl_->data_description_->GetTimeStep();
 
+  auto* param = Simulation::GetActive()->GetParam();
+  if (param->visualization_export_async) {
+    if (!impl_->io_pool_) {
+      impl_->io_pool_ = std::make_unique<IoThreadPool>(
+          param->visualization_export_threads,
+          param->visualization_export_queue_depth);
+    }
+    std::vector<std::function<void()>> tasks;
+    for (auto& el : impl_->vtk_agents_) {
+      el.second->StageWriteToFile(step, &tasks);
+    }
+    for (auto& el : impl_->vtk_dgrids_) {
+      el.second->StageWriteToFile(step, &tasks);
+    }
+    // Blocks if too many exports are pending
+    impl_->io_pool_->Submit(std::move(tasks));
+    return;
+  }
+
   for (auto& el : impl_->vtk_agents_) {
     el.second->WriteToFile(step);
   }
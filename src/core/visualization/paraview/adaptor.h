@@ -71,7 +71,9 @@ class ParaviewAdaptor : private VisualizationAdaptor {
   void InsituVisualization();
 
   /// Exports the visualized objects to file, so that they can be imported and
-  /// visualized in ParaView at a later point in time
+  /// visualized in ParaView at a later point in time.
+  /// With `Param::visualization_export_async`, the files are written by
+  /// dedicated I/O threads.
   void ExportVisualization();
 
   /// Creates the VTK objects that represent the agents in ParaView.
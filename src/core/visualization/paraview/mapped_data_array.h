@@ -24,9 +24,15 @@
 #include <vector>
 
 #include "core/agent/agent.h"
+#include "core/agent/agent_handle.h"
 #include "core/agent/agent_pointer.h"
+#include "core/agent/cell.h"
+#include "core/agent/spherical_agent.h"
+#include "core/agent_columns.h"
 #include "core/functor.h"
 #include "core/param/param.h"
+#include "core/resource_manager.h"
+#include "core/simulation.h"
 #include "core/util/thread_info.h"
 #include "core/util/type.h"
 
@@ -119,7 +125,10 @@ struct GetDataMemberForVis {
 struct MappedDataArrayInterface {
   MappedDataArrayInterface() = default;
   virtual ~MappedDataArrayInterface() = default;
-  virtual void Update(const std::vector<Agent*>* agents, uint64_t start,
+  /// `handles` contains the handle of each agent in `agents` if
+  /// `Param::agent_columns` is enabled, and is a nullptr otherwise.
+  virtual void Update(const std::vector<Agent*>* agents,
+                      const std::vector<AgentHandle>* handles, uint64_t start,
                       uint64_t end) = 0;
 };
 
@@ -135,7 +144,8 @@ class MappedDataArray : public vtkMappedDataArray<TScalar>,
 
   void Initialize(Param::MappedDataArrayMode mode, const std::string& name,
                   uint64_t num_components, uint64_t dm_offset);
-  void Update(const std::vector<Agent*>* agents, uint64_t start,
+  void Update(const std::vector<Agent*>* agents,
+              const std::vector<AgentHandle>* handles, uint64_t start,
               uint64_t end) final;
 
   // Reimplemented virtuals -- see superclasses for descriptions:
@@ -202,6 +212,12 @@ class MappedDataArray : public vtkMappedDataArray<TScalar>,
   /// Access agent data member functor.
   GetDataMemberForVis<TScalar*, TClass, TDataMember> get_dm_;
   const std::vector<Agent*>* agents_ = nullptr;
+  /// Data members that are also stored in `AgentColumns`
+  enum class ColumnSource { kNone, kPosition, kDiameter };
+  ColumnSource column_source_ = ColumnSource::kNone;
+  /// Set if the values of this array are read from the agent columns
+  const AgentColumns* columns_ = nullptr;
+  const std::vector<AgentHandle>* handles_ = nullptr;
   uint64_t start_ = 0;
   uint64_t end_ = 0;
   double* temp_array_ = nullptr;
@@ -221,6 +237,9 @@ class MappedDataArray : public vtkMappedDataArray<TScalar>,
   MappedDataArray(const MappedDataArray&) = delete;
   void operator=(const MappedDataArray&) = delete;
 
+  /// Returns the data of agent `(*agents_)[idx]`.
+  TScalar* GetAgentData(uint64_t idx) const;
+
   vtkIdType Lookup(const TScalar& val, vtkIdType start_index);
 };
 
@@ -231,6 +250,17 @@ void MappedDataArray<TScalar, TClass, TDataMember>::Initialize(
     Param::MappedDataArrayMode mode, const std::string& name,
     uint64_t num_components, uint64_t dm_offset) {
   get_dm_.dm_offset_ = dm_offset;
+  // Cells and spherical agents write their position and diameter through to
+  // the agent columns. \see `Param::agent_columns`
+  if (std::is_base_of<Cell, TClass>::value ||
+      std::is_base_of<SphericalAgent, TClass>::value) {
+    if (name == "position_" && std::is_same<TDataMember, Real3>::value) {
+      column_source_ = ColumnSource::kPosition;
+    } else if (name == "diameter_" &&
+               std::is_same<TDataMember, real_t>::value) {
+      column_source_ = ColumnSource::kDiameter;
+    }
+  }
   mode_ = mode;
   this->NumberOfComponents = num_components;
   this->SetName(name.c_str());
@@ -238,8 +268,16 @@ void MappedDataArray<TScalar, TClass, TDataMember>::Initialize(
 
 template <typename TScalar, typename TClass, typename TDataMember>
 void MappedDataArray<TScalar, TClass, TDataMember>::Update(
-    const std::vector<Agent*>* agents, uint64_t start, uint64_t end) {
+    const std::vector<Agent*>* agents, const std::vector<AgentHandle>* handles,
+    uint64_t start, uint64_t end) {
   agents_ = agents;
+  columns_ = nullptr;
+  handles_ = nullptr;
+  if (handles != nullptr && column_source_ != ColumnSource::kNone) {
+    auto* rm = Simulation::GetActive()->GetResourceManager();
+    columns_ = rm->GetAgentColumns();
+    handles_ = handles;
+  }
   start_ = start;
   end_ = end;
   get_dm_.Update();
@@ -262,7 +300,7 @@ void MappedDataArray<TScalar, TClass, TDataMember>::Update(
     if (mode_ == Param::MappedDataArrayMode::kCopy) {
       uint64_t counter = 0;
       for (uint64_t i = start; i < end; ++i) {
-        auto* data = get_dm_((*agents_)[i]);
+        auto* data = GetAgentData(i);
         for (uint64_t c = 0; c < this->NumberOfComponents; ++c) {
           data_[counter++] = data[c];
         }
@@ -281,6 +319,28 @@ void MappedDataArray<TScalar, TClass, TDataMember>::Update(
   }
 }
 
+//------------------------------------------------------------------------------
+template <typename TScalar, typename TClass, typename TDataMember>
+TScalar* MappedDataArray<TScalar, TClass, TDataMember>::GetAgentData(
+    uint64_t idx) const {
+  if (columns_ == nullptr) {
+    return get_dm_((*agents_)[idx]);
+  }
+  auto ah = (*handles_)[idx];
+  auto tid = ThreadInfo::GetInstance()->GetUniversalThreadId();
+  assert(get_dm_.temp_values_.size() > tid);
+  auto& values = get_dm_.temp_values_[tid];
+  if (column_source_ == ColumnSource::kPosition) {
+    auto position = columns_->GetPosition(ah);
+    for (uint64_t i = 0; i < 3; ++i) {
+      values[i] = position[i];
+    }
+  } else {
+    values[0] = columns_->GetDiameter(ah);
+  }
+  return &values[0];
+}
+
 //------------------------------------------------------------------------------
 // Can't use vtkStandardNewMacro with a template.
 template <typename TScalar, typename TClass, typename TDataMember>
@@ -437,7 +497,7 @@ void MappedDataArray<TScalar, TClass, TDataMember>::GetTuple(vtkIdType tuple_id,
       }
     }
     case Param::MappedDataArrayMode::kZeroCopy: {
-      auto* temporary_data = get_dm_((*agents_)[start_ + tuple_id]);
+      auto* temporary_data = GetAgentData(start_ + tuple_id);
       for (uint64_t i = 0; i < static_cast<uint64_t>(this->NumberOfComponents);
            ++i) {
         tuple[i] = static_cast<real_t>(temporary_data[i]);
@@ -489,7 +549,7 @@ MappedDataArray<TScalar, TClass, TDataMember>::GetValue(vtkIdType idx) const {
       }
     case Param::MappedDataArrayMode::kZeroCopy: {
       if (this->NumberOfComponents == 1) {
-        auto* data = get_dm_((*agents_)[start_ + idx]);
+        auto* data = GetAgentData(start_ + idx);
         if (mode_ == Param::MappedDataArrayMode::kCache) {
           data_[idx] = *data;
           is_matching_[idx] = match_value_;
@@ -498,7 +558,7 @@ MappedDataArray<TScalar, TClass, TDataMember>::GetValue(vtkIdType idx) const {
       }
       const vtkIdType tuple = idx / this->NumberOfComponents;
       const vtkIdType comp = idx % this->NumberOfComponents;
-      auto* data = get_dm_((*agents_)[start_ + tuple]);
+      auto* data = GetAgentData(start_ + tuple);
       if (mode_ == Param::MappedDataArrayMode::kCache) {
         data_[idx] = data[comp];
         is_matching_[idx] = match_value_;
@@ -521,7 +581,7 @@ TScalar& MappedDataArray<TScalar, TClass, TDataMember>::GetValueReference(
       }
     case Param::MappedDataArrayMode::kZeroCopy: {
       if (this->NumberOfComponents == 1) {
-        auto* data = get_dm_((*agents_)[start_ + idx]);
+        auto* data = GetAgentData(start_ + idx);
         if (mode_ == Param::MappedDataArrayMode::kCache) {
           data_[idx] = *data;
           is_matching_[idx] = match_value_;
@@ -530,7 +590,7 @@ TScalar& MappedDataArray<TScalar, TClass, TDataMember>::GetValueReference(
       }
       const vtkIdType tuple = idx / this->NumberOfComponents;
       const vtkIdType comp = idx % this->NumberOfComponents;
-      auto* data = get_dm_((*agents_)[start_ + tuple]);
+      auto* data = GetAgentData(start_ + tuple);
       if (mode_ == Param::MappedDataArrayMode::kCache) {
         data_[idx] = data[comp];
         is_matching_[idx] = match_value_;
@@ -546,7 +606,7 @@ TScalar& MappedDataArray<TScalar, TClass, TDataMember>::GetValueReference(
 template <typename TScalar, typename TClass, typename TDataMember>
 void MappedDataArray<TScalar, TClass, TDataMember>::GetTypedTuple(
     vtkIdType tuple_id, TScalar* tuple) const {
-  auto* data = get_dm_((*agents_)[start_ + tuple_id]);
+  auto* data = GetAgentData(start_ + tuple_id);
   for (uint64_t i = 0; i < static_cast<uint64_t>(this->NumberOfComponents);
        ++i) {
     tuple[i] = data[i];
@@ -110,26 +110,37 @@ void ParallelVtiWriter::operator()(
     const std::array<int, 6>& whole_extent,
     const std::vector<std::array<int, 6>>& piece_extents) const {
   auto* param = Simulation::GetActive()->GetParam();
+  auto compress = param->visualization_compress_pv_files;
 
 #pragma omp parallel for schedule(static, 1)
   for (uint64_t i = 0; i < num_pieces; ++i) {
-    auto vti_filename = Concat(folder, "/", file_prefix, "_", i, ".vti");
-    vtkNew<VtiWriter> vti;
-    vti->SetFileName(vti_filename.c_str());
-    vti->SetInputData(images[i]);
-    vti->SetWholeExtent(whole_extent.data());
-    vti->SetDataModeToBinary();
-    vti->SetEncodeAppendedData(false);
-    if (!param->visualization_compress_pv_files) {
-      vti->SetCompressorTypeToNone();
-    }
-    vti->Write();
-
-    if (i == 0) {
-      PvtiWriter pvti;
-      pvti.Write(folder, file_prefix, whole_extent, piece_extents, images[0],
-                 vti);
-    }
+    WritePiece(folder, file_prefix, images, i, whole_extent, piece_extents,
+               compress);
+  }
+}
+
+void ParallelVtiWriter::WritePiece(
+    const std::string& folder, const std::string& file_prefix,
+    const std::vector<vtkImageData*>& images, uint64_t i,
+    const std::array<int, 6>& whole_extent,
+    const std::vector<std::array<int, 6>>& piece_extents,
+    bool compress) const {
+  auto vti_filename = Concat(folder, "/", file_prefix, "_", i, ".vti");
+  vtkNew<VtiWriter> vti;
+  vti->SetFileName(vti_filename.c_str());
+  vti->SetInputData(images[i]);
+  vti->SetWholeExtent(whole_extent.data());
+  vti->SetDataModeToBinary();
+  vti->SetEncodeAppendedData(false);
+  if (!compress) {
+    vti->SetCompressorTypeToNone();
+  }
+  vti->Write();
+
+  if (i == 0) {
+    PvtiWriter pvti;
+    pvti.Write(folder, file_prefix, whole_extent, piece_extents, images[0],
+               vti);
   }
 }
 
@@ -17,6 +17,7 @@
 
 // std
 #include <array>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -70,6 +71,15 @@ struct ParallelVtiWriter {
                   const std::vector<vtkImageData*>& images, uint64_t num_pieces,
                   const std::array<int, 6>& whole_extent,
                   const std::vector<std::array<int, 6>>& piece_extents) const;
+
+  /// Writes the piece `images[i]`. Piece zero also writes the pvti file that
+  /// references all pieces. Does not access the active simulation and can
+  /// therefore be called from any thread.
+  void WritePiece(const std::string& folder, const std::string& file_prefix,
+                  const std::vector<vtkImageData*>& images, uint64_t i,
+                  const std::array<int, 6>& whole_extent,
+                  const std::vector<std::array<int, 6>>& piece_extents,
+                  bool compress) const;
 };
 
 }  // namespace bdm
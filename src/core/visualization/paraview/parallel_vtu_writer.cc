@@ -23,7 +23,6 @@
 #include "core/param/param.h"
 #include "core/simulation.h"
 #include "core/util/string.h"
-#include "core/util/thread_info.h"
 
 namespace bdm {
 
@@ -60,38 +59,45 @@ void FixPvtu(const std::string& filename, const std::string& file_prefix,
 void ParallelVtuWriter::operator()(
     const std::string& folder, const std::string& file_prefix,
     const std::vector<vtkUnstructuredGrid*>& grids) const {
-  auto* tinfo = ThreadInfo::GetInstance();
   auto* param = Simulation::GetActive()->GetParam();
+  auto compress = param->visualization_compress_pv_files;
 
 #pragma omp parallel for schedule(static, 1)
-  for (int i = 0; i < tinfo->GetMaxThreads(); ++i) {
-    if (i == 0) {
-      vtkNew<vtkXMLPUnstructuredGridWriter> pvtu_writer;
-      auto filename = Concat(folder, "/", file_prefix, ".pvtu");
-      pvtu_writer->SetFileName(filename.c_str());
-      auto max_threads = ThreadInfo::GetInstance()->GetMaxThreads();
-      pvtu_writer->SetInputData(grids[0]);
-      pvtu_writer->SetDataModeToBinary();
-      pvtu_writer->SetEncodeAppendedData(false);
-      if (!param->visualization_compress_pv_files) {
-        pvtu_writer->SetCompressorTypeToNone();
-      }
-      pvtu_writer->Write();
+  for (uint64_t i = 0; i < grids.size(); ++i) {
+    WritePiece(folder, file_prefix, grids, i, compress);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void ParallelVtuWriter::WritePiece(
+    const std::string& folder, const std::string& file_prefix,
+    const std::vector<vtkUnstructuredGrid*>& grids, uint64_t i,
+    bool compress) const {
+  if (i == 0) {
+    vtkNew<vtkXMLPUnstructuredGridWriter> pvtu_writer;
+    auto filename = Concat(folder, "/", file_prefix, ".pvtu");
+    pvtu_writer->SetFileName(filename.c_str());
+    pvtu_writer->SetInputData(grids[0]);
+    pvtu_writer->SetDataModeToBinary();
+    pvtu_writer->SetEncodeAppendedData(false);
+    if (!compress) {
+      pvtu_writer->SetCompressorTypeToNone();
+    }
+    pvtu_writer->Write();
 
-      FixPvtu(filename, file_prefix, max_threads);
-    } else {
-      vtkNew<vtkXMLUnstructuredGridWriter> vtu_writer;
-      vtu_writer->SetGlobalWarningDisplay(false);
-      auto filename = Concat(folder, "/", file_prefix, "_", i, ".vtu");
-      vtu_writer->SetFileName(filename.c_str());
-      vtu_writer->SetInputData(grids[i]);
-      vtu_writer->SetDataModeToBinary();
-      vtu_writer->SetEncodeAppendedData(false);
-      if (!param->visualization_compress_pv_files) {
-        vtu_writer->SetCompressorTypeToNone();
-      }
-      vtu_writer->Write();
+    FixPvtu(filename, file_prefix, grids.size());
+  } else {
+    vtkNew<vtkXMLUnstructuredGridWriter> vtu_writer;
+    vtu_writer->SetGlobalWarningDisplay(false);
+    auto filename = Concat(folder, "/", file_prefix, "_", i, ".vtu");
+    vtu_writer->SetFileName(filename.c_str());
+    vtu_writer->SetInputData(grids[i]);
+    vtu_writer->SetDataModeToBinary();
+    vtu_writer->SetEncodeAppendedData(false);
+    if (!compress) {
+      vtu_writer->SetCompressorTypeToNone();
     }
+    vtu_writer->Write();
   }
 }
 
@@ -16,6 +16,7 @@
 #define CORE_VISUALIZATION_PARAVIEW_PARALLEL_VTU_WRITER_H_
 
 // std
+#include <cstdint>
 #include <string>
 #include <vector>
 // Paraview
@@ -26,6 +27,13 @@ namespace bdm {
 struct ParallelVtuWriter {
   void operator()(const std::string& folder, const std::string& file_prefix,
                   const std::vector<vtkUnstructuredGrid*>& grids) const;
+
+  /// Writes the piece `grids[i]`. Piece zero also writes the pvtu file that
+  /// references all pieces. Does not access the active simulation and can
+  /// therefore be called from any thread.
+  void WritePiece(const std::string& folder, const std::string& file_prefix,
+                  const std::vector<vtkUnstructuredGrid*>& grids, uint64_t i,
+                  bool compress) const;
 };
 
 }  // namespace bdm
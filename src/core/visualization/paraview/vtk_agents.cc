@@ -15,11 +15,14 @@
 #include "core/visualization/paraview/vtk_agents.h"
 // std
 #include <algorithm>
+#include <memory>
 #include <set>
+#include <unordered_map>
 #include <vector>
 // ParaView
 #include <vtkCPDataDescription.h>
 #include <vtkCPInputDataDescription.h>
+#include <vtkDataArray.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkPoints.h>
@@ -122,6 +125,13 @@ TClass* VtkAgents::GetTClass() { return tclass_; }
 // -----------------------------------------------------------------------------
 void VtkAgents::Update(const std::vector<Agent*>* agents) {
   auto* param = Simulation::GetActive()->GetParam();
+  // The mapped data arrays read the position and diameter from the agent
+  // columns. The agents are grouped by type, so the handles are needed.
+  if (param->agent_columns) {
+    handles_.resize(agents->size());
+  } else {
+    handles_.clear();
+  }
   if (param->export_visualization) {
 #pragma omp parallel
     {
@@ -151,18 +161,99 @@ void VtkAgents::WriteToFile(uint64_t step) const {
   writer(sim->GetOutputDir(), filename_prefix, data_);
 }
 
+// -----------------------------------------------------------------------------
+namespace {
+
+/// Pieces that are written asynchronously. Deleted after the last write task
+/// has been finished.
+struct StagedPieces {
+  std::vector<vtkUnstructuredGrid*> grids;
+  ~StagedPieces() {
+    for (auto* grid : grids) {
+      grid->Delete();
+    }
+  }
+};
+
+/// Returns a copy of `piece` in which the mapped data arrays, which access
+/// the agents, have been replaced by regular arrays.
+vtkUnstructuredGrid* StagePiece(vtkUnstructuredGrid* piece) {
+  auto* staged = vtkUnstructuredGrid::New();
+  // The position array is used for the points and the point data
+  std::unordered_map<vtkDataArray*, vtkDataArray*> copies;
+  auto copy = [&](vtkDataArray* array) {
+    auto it = copies.find(array);
+    if (it != copies.end()) {
+      return it->second;
+    }
+    auto* array_copy = vtkDataArray::CreateDataArray(array->GetDataType());
+    array_copy->DeepCopy(array);
+    array_copy->SetName(array->GetName());
+    copies[array] = array_copy;
+    return array_copy;
+  };
+
+  if (piece->GetPoints() != nullptr) {
+    vtkNew<vtkPoints> points;
+    points->SetData(copy(piece->GetPoints()->GetData()));
+    staged->SetPoints(points.GetPointer());
+  }
+  auto* point_data = piece->GetPointData();
+  for (int i = 0; i < point_data->GetNumberOfArrays(); i++) {
+    staged->GetPointData()->AddArray(copy(point_data->GetArray(i)));
+  }
+  // The staged grid holds the remaining reference
+  for (auto& el : copies) {
+    el.second->Delete();
+  }
+  return staged;
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+void VtkAgents::StageWriteToFile(
+    uint64_t step, std::vector<std::function<void()>>* tasks) const {
+  auto* sim = Simulation::GetActive();
+  auto folder = sim->GetOutputDir();
+  auto filename_prefix = Concat(name_, "-", step);
+  auto compress = sim->GetParam()->visualization_compress_pv_files;
+
+  auto staged = std::make_shared<StagedPieces>();
+  staged->grids.resize(data_.size());
+#pragma omp parallel for schedule(static, 1)
+  for (uint64_t i = 0; i < data_.size(); ++i) {
+    staged->grids[i] = StagePiece(data_[i]);
+  }
+
+  for (uint64_t i = 0; i < data_.size(); ++i) {
+    tasks->push_back([=]() {
+      ParallelVtuWriter writer;
+      writer.WritePiece(folder, filename_prefix, staged->grids, i, compress);
+    });
+  }
+}
+
 // -----------------------------------------------------------------------------
 void VtkAgents::UpdateMappedDataArrays(uint64_t tid,
                                        const std::vector<Agent*>* agents,
                                        uint64_t start, uint64_t end) {
+  const std::vector<AgentHandle>* handles = nullptr;
+  if (!handles_.empty()) {
+    auto* rm = Simulation::GetActive()->GetResourceManager();
+    for (uint64_t i = start; i < end; ++i) {
+      handles_[i] = rm->GetAgentHandle((*agents)[i]->GetUid());
+    }
+    handles = &handles_;
+  }
   auto* parray = dynamic_cast<MappedDataArrayInterface*>(
       data_[tid]->GetPoints()->GetData());
-  parray->Update(agents, start, end);
+  parray->Update(agents, handles, start, end);
   auto* point_data = data_[tid]->GetPointData();
   for (int i = 0; i < point_data->GetNumberOfArrays(); i++) {
     auto* array =
         dynamic_cast<MappedDataArrayInterface*>(point_data->GetArray(i));
-    array->Update(agents, start, end);
+    array->Update(agents, handles, start, end);
   }
 }
 
@@ -16,6 +16,7 @@
 #define CORE_VISUALIZATION_PARAVIEW_VTK_AGENTS_H_
 
 // std
+#include <functional>
 #include <string>
 #include <vector>
 // Paraview
@@ -23,6 +24,7 @@
 #include <vtkUnstructuredGrid.h>
 // BioDynaMo
 #include "core/agent/agent.h"
+#include "core/agent/agent_handle.h"
 #include "core/shape.h"
 
 class TClass;
@@ -44,12 +46,20 @@ class VtkAgents {
   TClass* GetTClass();
   void Update(const std::vector<Agent*>* agents);
   void WriteToFile(uint64_t step) const;
+  /// Copies the data of all pieces into a staging buffer and appends one
+  /// task per piece to `tasks` that writes the copy to file. Hence, the
+  /// tasks can run while the simulation modifies the agents.
+  void StageWriteToFile(uint64_t step,
+                        std::vector<std::function<void()>>* tasks) const;
 
  private:
   std::string name_;
   TClass* tclass_;
   std::vector<vtkUnstructuredGrid*> data_;
   Shape shape_;
+  /// Handles of the agents passed to `Update`. Only used if
+  /// `Param::agent_columns` is enabled.
+  std::vector<AgentHandle> handles_;
 
   TClass* FindTClass();
   void InitializeDataMembers(const Agent* agent,
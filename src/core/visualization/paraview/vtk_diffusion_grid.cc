@@ -13,6 +13,8 @@
 // -----------------------------------------------------------------------------
 
 #include "core/visualization/paraview/vtk_diffusion_grid.h"
+// std
+#include <memory>
 // ParaView
 #include <vtkCPDataDescription.h>
 #include <vtkCPInputDataDescription.h>
@@ -200,6 +202,53 @@ void VtkDiffusionGrid::WriteToFile(uint64_t step) const {
          whole_extent_, piece_extents_);
 }
 
+// -----------------------------------------------------------------------------
+namespace {
+
+/// Pieces that are written asynchronously. Deleted after the last write task
+/// has been finished.
+struct StagedImages {
+  std::vector<vtkImageData*> images;
+  std::array<int, 6> whole_extent;
+  std::vector<std::array<int, 6>> piece_extents;
+  ~StagedImages() {
+    for (auto* image : images) {
+      image->Delete();
+    }
+  }
+};
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+void VtkDiffusionGrid::StageWriteToFile(
+    uint64_t step, std::vector<std::function<void()>>* tasks) const {
+  auto* sim = Simulation::GetActive();
+  auto folder = sim->GetOutputDir();
+  auto filename_prefix = Concat(name_, "-", step);
+  auto compress = sim->GetParam()->visualization_compress_pv_files;
+
+  // The pieces reference the memory of the diffusion grid
+  auto staged = std::make_shared<StagedImages>();
+  staged->images.resize(num_pieces_);
+  staged->whole_extent = whole_extent_;
+  staged->piece_extents = piece_extents_;
+#pragma omp parallel for schedule(static, 1)
+  for (uint64_t i = 0; i < num_pieces_; ++i) {
+    staged->images[i] = vtkImageData::New();
+    staged->images[i]->DeepCopy(data_[i]);
+  }
+
+  for (uint64_t i = 0; i < num_pieces_; ++i) {
+    tasks->push_back([=]() {
+      ParallelVtiWriter writer;
+      writer.WritePiece(folder, filename_prefix, staged->images, i,
+                        staged->whole_extent, staged->piece_extents,
+                        compress);
+    });
+  }
+}
+
 // -----------------------------------------------------------------------------
 void VtkDiffusionGrid::Dissect(uint64_t boxes_z, uint64_t num_pieces_target) {
   if (num_pieces_target == 1) {
@@ -18,6 +18,7 @@
 // std
 #include <algorithm>
 #include <array>
+#include <functional>
 #include <string>
 #include <vector>
 // Paraview
@@ -42,6 +43,11 @@ class VtkDiffusionGrid {
   bool IsUsed() const;
   void Update(const DiffusionGrid* grid);
   void WriteToFile(uint64_t step) const;
+  /// Copies the pieces into a staging buffer and appends one task per piece
+  /// to `tasks` that writes the copy to file. Hence, the tasks can run while
+  /// the simulation modifies the diffusion grid.
+  void StageWriteToFile(uint64_t step,
+                        std::vector<std::function<void()>>* tasks) const;
 
  private:
   std::vector<vtkImageData*> data_;
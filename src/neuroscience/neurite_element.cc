@@ -14,6 +14,7 @@
 
 #include "neuroscience/neurite_element.h"
 #include <string>
+#include "core/agent_columns.h"
 
 namespace bdm {
 namespace neuroscience {
@@ -141,6 +142,7 @@ void NeuriteElement::SetDiameter(real_t diameter) {
   }
   diameter_ = diameter;
   UpdateVolume();
+  UpdateAgentColumns();
 }
 
 void NeuriteElement::SetDensity(real_t density) {
@@ -153,11 +155,13 @@ void NeuriteElement::SetDensity(real_t density) {
 void NeuriteElement::SetPosition(const Real3& position) {
   position_ = position;
   SetMassLocation(position + spring_axis_ * 0.5);
+  UpdateAgentColumns();
 }
 
 void NeuriteElement::UpdatePosition() {
   position_ = mass_location_ - (spring_axis_ * 0.5);
   SetPropagateStaticness();
+  UpdateAgentColumns();
 }
 
 void NeuriteElement::SetMassLocation(const Real3& mass_location) {
@@ -672,6 +676,7 @@ void NeuriteElement::UpdateDiameter() {
     Base::SetPropagateStaticness();
   }
   diameter_ = diameter;
+  UpdateAgentColumns();
 }
 
 void NeuriteElement::UpdateVolume() {
@@ -1055,5 +1060,13 @@ void NeuriteElement::InitializeSideExtensionOrBranching(
   UpdateDependentPhysicalVariables();
 }
 
+void NeuriteElement::UpdateAgentColumns() {
+  AgentHandle ah;
+  if (auto* columns = GetAgentColumns(&ah)) {
+    columns->SetPosition(ah, position_);
+    columns->SetDiameter(ah, diameter_);
+  }
+}
+
 }  // namespace neuroscience
 }  // namespace bdm
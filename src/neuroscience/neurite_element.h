@@ -558,6 +558,10 @@ class NeuriteElement : public Agent, public NeuronOrNeurite {
   void InitializeSideExtensionOrBranching(NeuriteElement* mother, real_t length,
                                           real_t diameter,
                                           const Real3& direction);
+
+  /// Writes the position and diameter through to the agent columns (if
+  /// enabled). \see `Param::agent_columns`
+  void UpdateAgentColumns();
 };
 
 }  // namespace neuroscience
@@ -0,0 +1,169 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/agent_columns.h"
+#include <vector>
+#include "core/agent/cell.h"
+#include "core/environment/environment.h"
+#include "core/resource_manager.h"
+#include "gtest/gtest.h"
+#include "unit/test_util/test_util.h"
+
+namespace bdm {
+
+namespace {
+
+void EnableAgentColumns(Param* param) { param->agent_columns = true; }
+
+/// Checks that the columns contain the attributes of all agents.
+void ExpectColumnsInSync(ResourceManager* rm) {
+  auto* columns = rm->GetAgentColumns();
+  for (uint64_t n = 0; n < columns->GetNumNumaNodes(); ++n) {
+    EXPECT_EQ(rm->GetNumAgents(n), columns->GetNumAgents(n));
+  }
+  rm->ForEachAgent([&](Agent* agent, AgentHandle ah) {
+    auto* cell = bdm_static_cast<Cell*>(agent);
+    EXPECT_ARR_NEAR(columns->GetPosition(ah), cell->GetPosition());
+    EXPECT_REAL_EQ(cell->GetDiameter(), columns->GetDiameter(ah));
+    EXPECT_ARR_NEAR(columns->GetTractorForce(ah), cell->GetTractorForce());
+    EXPECT_EQ(cell->IsStatic(), columns->IsStatic(ah));
+    EXPECT_EQ(cell->GetShape(), columns->GetShape(ah));
+    EXPECT_EQ(cell->GetBoxIdx(), columns->GetBoxIdx(ah));
+  });
+}
+
+}  // namespace
+
+TEST(AgentColumnsTest, Disabled) {
+  Simulation simulation(TEST_NAME);
+  EXPECT_EQ(nullptr, simulation.GetResourceManager()->GetAgentColumns());
+}
+
+TEST(AgentColumnsTest, AddAgent) {
+  Simulation simulation(TEST_NAME, EnableAgentColumns);
+  auto* rm = simulation.GetResourceManager();
+  ASSERT_NE(nullptr, rm->GetAgentColumns());
+
+  for (int i = 0; i < 10; ++i) {
+    auto* cell = new Cell({i * 10.0, 1.0, 2.0});
+    cell->SetDiameter(i + 1);
+    rm->AddAgent(cell);
+  }
+  ExpectColumnsInSync(rm);
+}
+
+TEST(AgentColumnsTest, WriteThrough) {
+  Simulation simulation(TEST_NAME, EnableAgentColumns);
+  auto* rm = simulation.GetResourceManager();
+  auto* columns = rm->GetAgentColumns();
+
+  auto* cell = new Cell({1, 2, 3});
+  cell->SetDiameter(10);
+  rm->AddAgent(cell);
+  auto ah = rm->GetAgentHandle(cell->GetUid());
+
+  cell->SetPosition({4, 5, 6});
+  EXPECT_ARR_NEAR(columns->GetPosition(ah), {4, 5, 6});
+  cell->UpdatePosition({1, 1, 1});
+  EXPECT_ARR_NEAR(columns->GetPosition(ah), {5, 6, 7});
+  cell->MovePointMass({1, 0, 0}, 10);
+  EXPECT_ARR_NEAR(columns->GetPosition(ah), cell->GetPosition());
+
+  cell->SetDiameter(20);
+  EXPECT_REAL_EQ(20, columns->GetDiameter(ah));
+  cell->ChangeVolume(100);
+  EXPECT_REAL_EQ(cell->GetDiameter(), columns->GetDiameter(ah));
+
+  cell->SetTractorForce({1, 2, 3});
+  EXPECT_ARR_NEAR(columns->GetTractorForce(ah), {1, 2, 3});
+
+  cell->SetStaticnessNextTimestep(true);
+  cell->UpdateStaticness();
+  EXPECT_TRUE(columns->IsStatic(ah));
+  cell->SetStaticnessNextTimestep(false);
+  cell->UpdateStaticness();
+  EXPECT_FALSE(columns->IsStatic(ah));
+
+  // Agents that are not stored in the ResourceManager are not written through
+  Cell copy(*cell);
+  copy.SetPosition({7, 8, 9});
+  EXPECT_ARR_NEAR(columns->GetPosition(ah), cell->GetPosition());
+  auto* new_cell = new Cell({1, 1, 1});
+  new_cell->SetPosition({2, 2, 2});
+  delete new_cell;
+  EXPECT_EQ(1u, columns->GetNumAgents(ah.GetNumaNode()));
+  ExpectColumnsInSync(rm);
+}
+
+TEST(AgentColumnsTest, RemoveAgent) {
+  Simulation simulation(TEST_NAME, EnableAgentColumns);
+  auto* rm = simulation.GetResourceManager();
+
+  std::vector<AgentUid> uids;
+  for (int i = 0; i < 10; ++i) {
+    auto* cell = new Cell({i * 10.0, 0, 0});
+    cell->SetDiameter(i + 1);
+    rm->AddAgent(cell);
+    uids.push_back(cell->GetUid());
+  }
+  rm->RemoveAgent(uids[2]);
+  rm->RemoveAgent(uids[9]);
+  EXPECT_EQ(8u, rm->GetNumAgents());
+  ExpectColumnsInSync(rm);
+}
+
+TEST(AgentColumnsTest, RemoveAgents) {
+  Simulation simulation(TEST_NAME, EnableAgentColumns);
+  auto* rm = simulation.GetResourceManager();
+
+  std::vector<AgentUid> remove;
+  for (int i = 0; i < 100; ++i) {
+    auto* cell = new Cell({i * 10.0, 0, 0});
+    cell->SetDiameter(i + 1);
+    rm->AddAgent(cell);
+    if (i % 3 == 0) {
+      remove.push_back(cell->GetUid());
+    }
+  }
+  rm->RemoveAgents({&remove});
+  EXPECT_EQ(66u, rm->GetNumAgents());
+  ExpectColumnsInSync(rm);
+}
+
+TEST(AgentColumnsTest, LoadBalance) {
+  Simulation simulation(TEST_NAME, EnableAgentColumns);
+  auto* rm = simulation.GetResourceManager();
+
+  for (int x = 0; x < 10; ++x) {
+    for (int y = 0; y < 10; ++y) {
+      auto* cell = new Cell({x * 20.0, y * 20.0, 0});
+      cell->SetDiameter(10 + x);
+      rm->AddAgent(cell);
+    }
+  }
+  simulation.GetEnvironment()->Update();
+  ExpectColumnsInSync(rm);
+
+  rm->LoadBalance();
+  ExpectColumnsInSync(rm);
+
+  // The columns of the new storage locations are written through
+  rm->ForEachAgent([](Agent* agent) {
+    auto* cell = bdm_static_cast<Cell*>(agent);
+    cell->UpdatePosition({1, 2, 3});
+  });
+  ExpectColumnsInSync(rm);
+}
+
+}  // namespace bdm
@@ -0,0 +1,153 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/agent_costs.h"
+#include <unordered_map>
+#include <vector>
+#include "core/agent/cell.h"
+#include "core/environment/environment.h"
+#include "core/resource_manager.h"
+#include "gtest/gtest.h"
+#include "unit/test_util/test_util.h"
+
+namespace bdm {
+
+TEST(AgentCostsTest, Disabled) {
+  Simulation simulation(TEST_NAME);
+  EXPECT_EQ(nullptr, simulation.GetResourceManager()->GetAgentCosts());
+}
+
+TEST(AgentCostsTest, CummulatedCost) {
+  auto set_param = [](Param* param) {
+    param->cost_weighted_load_balancing = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* costs = rm->GetAgentCosts();
+  ASSERT_NE(nullptr, costs);
+
+  for (int i = 0; i < 10; ++i) {
+    rm->AddAgent(new Cell(10));
+  }
+
+  costs->StartMeasurement(rm);
+  EXPECT_TRUE(costs->IsMeasuring());
+  costs->AddChunkCost(0, 0, 4, 4);
+  costs->AddChunkCost(0, 4, 8, 12);
+  costs->AddChunkCost(0, 8, 10, 4);
+  costs->StopMeasurement();
+  EXPECT_FALSE(costs->IsMeasuring());
+  EXPECT_TRUE(costs->HasCosts());
+
+  EXPECT_REAL_EQ(1, costs->GetCost(AgentHandle(0, 3)));
+  EXPECT_REAL_EQ(3, costs->GetCost(AgentHandle(0, 4)));
+  EXPECT_REAL_EQ(2, costs->GetCost(AgentHandle(0, 9)));
+  EXPECT_REAL_EQ(0, costs->GetCummulatedCost(0, 0));
+  EXPECT_REAL_EQ(7, costs->GetCummulatedCost(0, 5));
+  EXPECT_REAL_EQ(20, costs->GetCummulatedCost(0, 10));
+
+  EXPECT_EQ(0u, costs->FindAgent(0, 10, 0));
+  EXPECT_EQ(4u, costs->FindAgent(0, 10, 4));
+  EXPECT_EQ(6u, costs->FindAgent(0, 10, 10));
+  EXPECT_EQ(10u, costs->FindAgent(0, 10, 20));
+
+  // agents that have been added after the measurement have the average cost
+  EXPECT_REAL_EQ(2, costs->GetCost(AgentHandle(0, 12)));
+  EXPECT_REAL_EQ(24, costs->GetCummulatedCost(0, 12));
+  EXPECT_EQ(11u, costs->FindAgent(0, 12, 22));
+}
+
+TEST(AgentCostsTest, RemoveAgents) {
+  auto set_param = [](Param* param) {
+    param->cost_weighted_load_balancing = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* costs = rm->GetAgentCosts();
+
+  for (int i = 0; i < 10; ++i) {
+    rm->AddAgent(new Cell(10));
+  }
+  costs->StartMeasurement(rm);
+  for (uint64_t i = 0; i < 10; ++i) {
+    costs->AddChunkCost(0, i, i + 1, i + 1);
+  }
+  costs->StopMeasurement();
+
+  // The removed agents are replaced by the last ones, which have been added
+  // after the measurement.
+  rm->AddAgent(new Cell(10));
+  rm->AddAgent(new Cell(10));
+  std::vector<AgentUid> remove = {AgentUid(0), AgentUid(4)};
+  rm->RemoveAgents({&remove});
+
+  ASSERT_EQ(10u, rm->GetNumAgents());
+  rm->ForEachAgent([&](Agent* agent, AgentHandle ah) {
+    auto idx = agent->GetUid().GetIndex();
+    real_t expected = idx < 10 ? idx + 1 : 5.5;
+    EXPECT_REAL_EQ(expected, costs->GetCost(ah));
+  });
+  EXPECT_REAL_EQ(60, costs->GetCummulatedCost(0, 10));
+}
+
+TEST(AgentCostsTest, LoadBalance) {
+  auto set_param = [](Param* param) {
+    param->cost_weighted_load_balancing = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* costs = rm->GetAgentCosts();
+
+  for (int x = 0; x < 10; ++x) {
+    for (int y = 0; y < 10; ++y) {
+      auto* cell = new Cell({x * 20.0, y * 20.0, 0});
+      cell->SetDiameter(10);
+      rm->AddAgent(cell);
+    }
+  }
+  simulation.GetEnvironment()->Update();
+
+  // agents with a small x coordinate are expensive
+  costs->StartMeasurement(rm);
+  std::unordered_map<AgentUid, real_t> expected;
+  rm->ForEachAgent([&](Agent* agent, AgentHandle ah) {
+    real_t cost = agent->GetPosition()[0] < 50 ? 10 : 1;
+    costs->AddChunkCost(ah.GetNumaNode(), ah.GetElementIdx(),
+                        ah.GetElementIdx() + 1, cost);
+    expected[agent->GetUid()] = cost;
+  });
+  costs->StopMeasurement();
+
+  rm->LoadBalance();
+
+  EXPECT_EQ(100u, rm->GetNumAgents());
+  for (auto& el : expected) {
+    auto ah = rm->GetAgentHandle(el.first);
+    EXPECT_EQ(el.first, rm->GetAgent(ah)->GetUid());
+    EXPECT_REAL_EQ(el.second, costs->GetCost(ah));
+  }
+
+  // ForEachAgentParallel must still visit every agent exactly once
+  std::vector<int> visited(100, 0);
+  auto count = L2F([&](Agent* agent, AgentHandle) {
+#pragma omp atomic
+    visited[agent->GetUid().GetIndex()]++;
+  });
+  rm->ForEachAgentParallel(3, count);
+  for (auto v : visited) {
+    EXPECT_EQ(1, v);
+  }
+}
+
+}  // namespace bdm
@@ -32,6 +32,15 @@ class TestField : public Continuum {
   int n_steps_ = 0;
 };
 
+class StiffTestField : public TestField {
+ public:
+  explicit StiffTestField(real_t stable_dt) : stable_dt_(stable_dt) {}
+  real_t GetStableTimeStep() const final { return stable_dt_; }
+
+ private:
+  real_t stable_dt_;
+};
+
 inline void CellFactory(const std::vector<Real3>& positions) {
   auto* rm = Simulation::GetActive()->GetResourceManager();
   rm->Reserve(positions.size());
@@ -116,4 +125,48 @@ TEST(ContinuumTest, AsynchronousUpdates) {
   EXPECT_REAL_EQ(expected_time_tf3, tf3->GetSimulatedTime());
 }
 
+TEST(ContinuumTest, MultiRateIntegration) {
+  auto set_param = [&](Param* param) {
+    param->simulation_time_step = 0.01;
+    param->continuum_multi_rate = true;
+    param->continuum_max_interval = 10;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  CellFactory({{-10, -10, -10}, {90, 90, 90}});
+
+  // Three calls of 0.01 are accumulated before the next one would exceed
+  // the stable time step.
+  auto* slow = new StiffTestField(0.035);
+  slow->SetContinuumId(0);
+  // Each call of 0.01 is split into three substeps.
+  auto* stiff = new StiffTestField(0.004);
+  stiff->SetContinuumId(1);
+  // Without stability limit, the continuum is integrated every 10 calls.
+  auto* unlimited = new TestField();
+  unlimited->SetContinuumId(2);
+  // Continua with a fixed time step are not affected.
+  auto* fixed = new StiffTestField(0.001);
+  fixed->SetContinuumId(3);
+  fixed->SetTimeStep(0.01);
+
+  auto* rm = simulation.GetResourceManager();
+  rm->AddContinuum(slow);
+  rm->AddContinuum(stiff);
+  rm->AddContinuum(unlimited);
+  rm->AddContinuum(fixed);
+
+  // The first execution of the operation does not integrate the continua
+  // (see `AsynchronousUpdates`). Hence, the continua are called 19 times.
+  simulation.GetScheduler()->Simulate(20);
+
+  EXPECT_EQ(6, slow->GetNSteps());
+  EXPECT_REAL_EQ(0.18, slow->GetSimulatedTime());
+  EXPECT_EQ(57, stiff->GetNSteps());
+  EXPECT_REAL_EQ(0.19, stiff->GetSimulatedTime());
+  EXPECT_EQ(1, unlimited->GetNSteps());
+  EXPECT_REAL_EQ(0.1, unlimited->GetSimulatedTime());
+  EXPECT_EQ(19, fixed->GetNSteps());
+  EXPECT_REAL_EQ(0.19, fixed->GetSimulatedTime());
+}
+
 }  // namespace bdm
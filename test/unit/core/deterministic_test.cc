@@ -0,0 +1,239 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include <omp.h>
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <vector>
+
+#include "core/agent/cell.h"
+#include "core/analysis/reduce.h"
+#include "core/behavior/behavior.h"
+#include "core/behavior/secretion.h"
+#include "core/diffusion/diffusion_grid.h"
+#include "core/model_initializer.h"
+#include "core/operation/operation_registry.h"
+#include "core/operation/reduction_op.h"
+#include "core/resource_manager.h"
+#include "core/scheduler.h"
+#include "core/simulation.h"
+#include "core/util/philox.h"
+#include "core/util/philox_random.h"
+#include "core/util/thread_info.h"
+#include "unit/test_util/test_util.h"
+
+namespace bdm {
+namespace deterministic_test_internal {
+
+TEST(PhiloxRandomTest, KnownAnswers) {
+  // Test vectors of the reference implementation (Random123)
+  std::array<uint32_t, 4> expected = {0x6627e8d5, 0xe169c58d, 0xbc57ac4c,
+                                      0x9b00dbd8};
+  EXPECT_EQ(expected, Philox::Block({0, 0, 0, 0}, {0, 0}));
+  expected = {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1};
+  std::array<uint32_t, 4> counter = {0x243f6a88, 0x85a308d3, 0x13198a2e,
+                                     0x03707344};
+  EXPECT_EQ(expected, Philox::Block(counter, {0xa4093822, 0x299f31d0}));
+}
+
+TEST(PhiloxRandomTest, Generate) {
+  Philox engine(42);
+  engine.SetStream(5, 3);
+  std::vector<uint32_t> expected(123);
+  for (auto& el : expected) {
+    el = engine.Next();
+  }
+  engine.SetStream(5, 3);
+  std::vector<uint32_t> words(expected.size());
+  engine.Generate(words.size(), words.data());
+  EXPECT_EQ(expected, words);
+  EXPECT_EQ(126u, engine.GetPosition());
+}
+
+TEST(PhiloxRandomTest, Streams) {
+  PhiloxRandom rng(42);
+  rng.SetStream(7);
+  std::vector<double> numbers;
+  for (int i = 0; i < 10; ++i) {
+    numbers.push_back(rng.Rndm());
+    EXPECT_LT(0, numbers.back());
+    EXPECT_GT(1, numbers.back());
+  }
+  EXPECT_EQ(10u, rng.GetPosition());
+
+  // Jump into the middle of the stream
+  rng.SetStream(7, 5);
+  EXPECT_EQ(numbers[5], rng.Rndm());
+  // Another stream is different
+  rng.SetStream(8);
+  EXPECT_NE(numbers[0], rng.Rndm());
+  // Another seed is different
+  PhiloxRandom other(43);
+  other.SetStream(7);
+  EXPECT_NE(numbers[0], other.Rndm());
+}
+
+TEST(CanonicalPartialResultsTest, OrderIndependent) {
+  Simulation simulation(TEST_NAME);
+  std::vector<Cell> cells(3);
+  // Floating point addition of these values is not associative
+  std::vector<real_t> values = {1e16, 1, -1e16};
+  SumReduction<real_t> sum;
+
+  CanonicalPartialResults<real_t> forward;
+  for (uint64_t i = 0; i < cells.size(); ++i) {
+    *forward.Add(&cells[i]) += values[i];
+  }
+  CanonicalPartialResults<real_t> backward;
+  for (uint64_t i = cells.size(); i > 0; --i) {
+    *backward.Add(&cells[i - 1]) += values[i - 1];
+  }
+  EXPECT_EQ(forward.Reduce(sum), backward.Reduce(sum));
+}
+
+struct RandomWalkAndDivide : public Behavior {
+  BDM_BEHAVIOR_HEADER(RandomWalkAndDivide, Behavior, 1);
+
+  RandomWalkAndDivide() { AlwaysCopyToNew(); }
+
+  void Run(Agent* agent) override {
+    auto* random = Simulation::GetActive()->GetRandom();
+    auto* cell = bdm_static_cast<Cell*>(agent);
+    cell->UpdatePosition(random->UniformArray<3>(-2, 2));
+    auto r = random->Uniform();
+    if (r < 0.02) {
+      cell->RemoveFromSimulation();
+    } else if (r < 0.2) {
+      cell->Divide();
+    } else {
+      cell->ChangeVolume(random->Uniform(0, 100));
+    }
+  }
+};
+
+/// Second agent operation that draws random numbers and creates agents
+struct RandomDivideOp : public AgentOperationImpl {
+  BDM_OP_HEADER(RandomDivideOp);
+
+  void operator()(Agent* agent) override {
+    auto* random = Simulation::GetActive()->GetRandom();
+    if (random->Uniform() < 0.1) {
+      bdm_static_cast<Cell*>(agent)->Divide();
+    }
+  }
+};
+
+BDM_REGISTER_OP(RandomDivideOp, "random divide op", kCpu);
+
+/// Returns key, position, and diameter of all agents sorted by key, the sum
+/// of all x coordinates, and the concentrations of the secreted substance.
+std::tuple<std::vector<std::array<real_t, 4>>, std::vector<uint64_t>, real_t,
+           std::vector<real_t>>
+RunSimulation(const char* name, int threads,
+              Param::ExecutionOrder order =
+                  Param::ExecutionOrder::kForEachAgentForEachOp,
+              bool random_divide_op = false) {
+  auto max_threads = omp_get_max_threads();
+  omp_set_num_threads(threads);
+  ThreadInfo::GetInstance()->Renew();
+
+  std::vector<std::array<real_t, 4>> agents;
+  std::vector<uint64_t> keys;
+  real_t sum_x = 0;
+  std::vector<real_t> concentrations;
+  {
+    auto set_param = [&](Param* param) {
+      param->deterministic = true;
+      param->execution_order = order;
+    };
+    Simulation simulation(name, set_param);
+    if (random_divide_op) {
+      simulation.GetScheduler()->ScheduleOp(NewOperation("random divide op"));
+    }
+    ModelInitializer::DefineSubstance(0, "substance", 0.5, 0.1, 10);
+    ModelInitializer::CreateAgentsRandom(0, 100, 200, [](const Real3& pos) {
+      auto* cell = new Cell(pos);
+      cell->SetDiameter(8);
+      cell->AddBehavior(new RandomWalkAndDivide());
+      // Different quantities, such that the result depends on the order in
+      // which the changes of a box are applied
+      cell->AddBehavior(new Secretion("substance", pos[0] / 100));
+      return cell;
+    });
+    simulation.GetScheduler()->Simulate(10);
+
+    auto* rm = simulation.GetResourceManager();
+    std::vector<std::pair<uint64_t, std::array<real_t, 4>>> sorted;
+    rm->ForEachAgent([&](Agent* agent) {
+      const auto& pos = agent->GetPosition();
+      sorted.push_back({agent->GetCanonicalKey(),
+                        {pos[0], pos[1], pos[2], agent->GetDiameter()}});
+    });
+    std::sort(sorted.begin(), sorted.end());
+    for (auto& el : sorted) {
+      keys.push_back(el.first);
+      agents.push_back(el.second);
+    }
+
+    auto add_x = L2F([](Agent* agent, real_t* sum) {
+      *sum += agent->GetPosition()[0];
+    });
+    SumReduction<real_t> combine;
+    sum_x = experimental::Reduce(&simulation, add_x, combine);
+
+    auto* dgrid = rm->GetDiffusionGrid(0);
+    const auto* c = dgrid->GetAllConcentrations();
+    concentrations.assign(c, c + dgrid->GetNumBoxes());
+  }
+
+  omp_set_num_threads(max_threads);
+  ThreadInfo::GetInstance()->Renew();
+  return {agents, keys, sum_x, concentrations};
+}
+
+TEST(DeterministicTest, IndependentOfThreadCount) {
+  auto serial = RunSimulation(TEST_NAME, 1);
+  auto parallel = RunSimulation(TEST_NAME, 4);
+
+  EXPECT_LT(200u, std::get<1>(serial).size());
+  EXPECT_EQ(std::get<1>(serial), std::get<1>(parallel));
+  EXPECT_EQ(std::get<0>(serial), std::get<0>(parallel));
+  EXPECT_EQ(std::get<2>(serial), std::get<2>(parallel));
+  // Secretion and diffusion
+  const auto& concentrations = std::get<3>(serial);
+  EXPECT_LT(0, *std::max_element(concentrations.begin(), concentrations.end()));
+  EXPECT_EQ(concentrations, std::get<3>(parallel));
+}
+
+// Each agent is executed once per operation. The operations must continue the
+// random stream of the agent instead of drawing the same numbers, and the
+// agents that they create must receive different keys.
+TEST(DeterministicTest, ForEachOpForEachAgent) {
+  auto order = Param::ExecutionOrder::kForEachOpForEachAgent;
+  auto serial = RunSimulation(TEST_NAME, 1, order, true);
+  auto parallel = RunSimulation(TEST_NAME, 4, order, true);
+
+  const auto& keys = std::get<1>(serial);
+  EXPECT_LT(200u, keys.size());
+  EXPECT_EQ(keys.end(), std::adjacent_find(keys.begin(), keys.end()));
+  EXPECT_EQ(keys, std::get<1>(parallel));
+  EXPECT_EQ(std::get<0>(serial), std::get<0>(parallel));
+  EXPECT_EQ(std::get<2>(serial), std::get<2>(parallel));
+  EXPECT_EQ(std::get<3>(serial), std::get<3>(parallel));
+}
+
+}  // namespace deterministic_test_internal
+}  // namespace bdm
@@ -12,14 +12,23 @@
 //
 // -----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <fstream>
+#include <utility>
+#include <vector>
 
 #include "core/agent/cell.h"
+#include "core/diffusion/adi_grid.h"
 #include "core/diffusion/diffusion_grid.h"
 #include "core/diffusion/euler_depletion_grid.h"
 #include "core/diffusion/euler_grid.h"
+#include "core/diffusion/multi_species_euler_grid.h"
+#include "core/diffusion/sparse_euler_grid.h"
+#include "core/diffusion/steady_state_grid.h"
 #include "core/environment/environment.h"
+#include "core/execution_context/execution_context.h"
 #include "core/model_initializer.h"
+#include "core/operation/operation_registry.h"
 #include "core/substance_initializers.h"
 #include "core/util/io.h"
 #include "gtest/gtest.h"
@@ -582,6 +591,114 @@ TEST(DiffusionTest, ChangeConcentrationByLogistic) {
   delete dgrid;
 }
 
+TEST(DiffusionTest, DeferredConcentrationUpdates) {
+  auto set_param = [](auto* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -100;
+    param->max_bound = 100;
+    param->deferred_concentration_updates = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+  DiffusionGrid* dgrid = new EulerGrid(0, "Kalium", 0.4, 0, 50);
+
+  Real3 pos_upper({{0, 0, 0}});
+  Real3 pos_lower({{10, 10, 10}});
+  dgrid->Initialize();
+  dgrid->SetUpperThreshold(100);
+  dgrid->SetLowerThreshold(0);
+
+  dgrid->ChangeConcentrationBy(pos_upper, 1.5, InteractionMode::kAdditive);
+  dgrid->ChangeConcentrationBy(pos_lower, 1.5, InteractionMode::kAdditive);
+  dgrid->ChangeConcentrationBy(pos_upper, 2, InteractionMode::kExponential);
+
+  // Changes are not visible before they have been applied
+  EXPECT_REAL_EQ(0, dgrid->GetValue(pos_upper));
+  EXPECT_REAL_EQ(0, dgrid->GetValue(pos_lower));
+
+  dgrid->ApplyDeferredUpdates();
+
+  // The changes of one thread are applied in the recorded order
+  EXPECT_REAL_EQ(3, dgrid->GetValue(pos_upper));
+  EXPECT_REAL_EQ(1.5, dgrid->GetValue(pos_lower));
+
+  // Many threads change the same boxes
+  const int n_changes = 1000;
+#pragma omp parallel for
+  for (int i = 0; i < n_changes; i++) {
+    dgrid->ChangeConcentrationBy(pos_upper, 0.01);
+    dgrid->ChangeConcentrationBy(pos_lower, 0.01);
+  }
+  dgrid->ApplyDeferredUpdates();
+
+  EXPECT_NEAR(13, dgrid->GetValue(pos_upper), 1e-3);
+  EXPECT_NEAR(11.5, dgrid->GetValue(pos_lower), 1e-3);
+
+  delete dgrid;
+}
+
+/// Agents with an even index double the concentration, the others add one.
+struct DeferredChangeOp : public AgentOperationImpl {
+  BDM_OP_HEADER(DeferredChangeOp);
+
+  void operator()(Agent* agent) override {
+    if (agent->GetUid().GetIndex() % 2 == 0) {
+      grid_->ChangeConcentrationBy(size_t{0}, 2, InteractionMode::kExponential);
+    } else {
+      grid_->ChangeConcentrationBy(size_t{0}, 1, InteractionMode::kAdditive);
+    }
+  }
+
+  DiffusionGrid* grid_ = nullptr;
+};
+
+BDM_REGISTER_OP(DeferredChangeOp, "deferred change op", kCpu);
+
+TEST(DiffusionTest, DeferredConcentrationUpdatesAgentOrder) {
+  auto set_param = [](auto* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -100;
+    param->max_bound = 100;
+    param->deferred_concentration_updates = true;
+    // The cells are not part of the simulation
+    param->thread_safety_mechanism = Param::ThreadSafetyMechanism::kNone;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+  DiffusionGrid* dgrid = new EulerGrid(0, "Kalium", 0.4, 0, 10);
+  dgrid->Initialize();
+
+  auto* op = NewOperation("deferred change op");
+  op->GetImplementation<DeferredChangeOp>()->grid_ = dgrid;
+  std::vector<Operation*> ops = {op};
+  std::vector<Cell> cells(40);
+
+  // Execute the agents in reverse order on several threads
+  const int64_t num_cells = cells.size();
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int64_t i = num_cells - 1; i >= 0; --i) {
+    auto* ctxt = simulation.GetExecutionContext();
+    ctxt->Execute(&cells[i], AgentHandle(i), ops);
+  }
+  dgrid->ApplyDeferredUpdates();
+
+  // The changes are applied in the order of the agent keys
+  std::vector<std::pair<uint64_t, Cell*>> sorted;
+  for (auto& cell : cells) {
+    sorted.emplace_back(cell.GetCanonicalKey(), &cell);
+  }
+  std::sort(sorted.begin(), sorted.end());
+  real_t expected = 0;
+  for (auto& el : sorted) {
+    auto index = el.second->GetUid().GetIndex();
+    expected = index % 2 == 0 ? expected * 2 : expected + 1;
+  }
+  EXPECT_REAL_EQ(expected, dgrid->GetConcentration(0));
+
+  delete op;
+  delete dgrid;
+}
+
 #ifdef USE_DICT
 
 // Test if all the data members of the diffusion grid are correctly serialized
@@ -835,6 +952,335 @@ TEST(DiffusionTest, EulerConvergenceDiffusion) {
   delete dgrid8;
 }
 
+// The implicit solver must converge for time steps that violate the stability
+// condition of the explicit solver.
+TEST(DiffusionTest, ADIConvergenceDiffusion) {
+  auto set_param = [](auto* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -100;
+    param->max_bound = 100;
+    param->diffusion_boundary_condition = "closed";
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+
+  real_t diff_coef = 0.5;
+  int init = 1e5;
+  int tot = 100;
+  Real3 source = {{0, 0, 0}};
+  Real3 marker = {10.0, 10.0, 10.0};
+
+  auto run = [&](real_t dt) {
+    ADIGrid dgrid(0, "Kalium", diff_coef, 0, 80);
+    dgrid.Initialize();
+    dgrid.SetUpperThreshold(1e15);
+    dgrid.ChangeConcentrationBy(source, init / pow(dgrid.GetBoxLength(), 3));
+    for (int t = 0; t < tot / dt; t++) {
+      dgrid.Diffuse(dt);
+    }
+    auto rc = GetRealCoordinates(dgrid.GetBoxCoordinates(source),
+                                 dgrid.GetBoxCoordinates(marker),
+                                 dgrid.GetBoxLength());
+    auto real_val =
+        CalculateAnalyticalSolution(init, rc[0], rc[1], rc[2], diff_coef, tot);
+    auto* conc = dgrid.GetAllConcentrations();
+    return std::abs(real_val - conc[dgrid.GetBoxIndex(marker)]) /
+           std::abs(real_val);
+  };
+
+  // The explicit solver requires dt < 2.1 for these parameters
+  auto error1 = run(1);
+  auto error10 = run(10);
+  EXPECT_LT(error1, error10);
+  EXPECT_LT(error1, 0.05);
+  EXPECT_LT(error10, 0.15);
+}
+
+TEST(DiffusionTest, ADINeumannPeriodicMassConservation) {
+  for (auto bc : {"Neumann", "Periodic"}) {
+    auto set_param = [&](auto* param) {
+      param->bound_space = Param::BoundSpaceMode::kClosed;
+      param->min_bound = -100;
+      param->max_bound = 100;
+      param->diffusion_boundary_condition = bc;
+    };
+    Simulation simulation(TEST_NAME, set_param);
+    simulation.GetEnvironment()->Update();
+
+    ADIGrid dgrid(0, "Kalium", 100, 0, 20);
+    dgrid.Initialize();
+    dgrid.SetUpperThreshold(1e15);
+    dgrid.ChangeConcentrationBy({{30, -20, 10}}, 1000);
+    for (int t = 0; t < 100; t++) {
+      dgrid.Diffuse(10);
+    }
+
+    // The mass is conserved and the concentration is (almost) uniform
+    auto* conc = dgrid.GetAllConcentrations();
+    real_t mass = 0;
+    for (size_t i = 0; i < dgrid.GetNumBoxes(); i++) {
+      EXPECT_GE(conc[i], 0);
+      mass += conc[i];
+    }
+    EXPECT_NEAR(1000, mass, 1e-6 * 1000);
+    EXPECT_NEAR(1000.0 / dgrid.GetNumBoxes(), conc[0], 1e-3);
+  }
+}
+
+// The fused sweep must yield the same result as separate sweeps
+TEST(DiffusionTest, MultiSpeciesEulerGrid) {
+  for (auto bc : {"closed", "open", "Neumann", "Dirichlet", "Periodic"}) {
+    auto set_param = [&](auto* param) {
+      param->bound_space = Param::BoundSpaceMode::kClosed;
+      param->min_bound = -100;
+      param->max_bound = 100;
+      param->diffusion_boundary_condition = bc;
+    };
+    Simulation simulation(TEST_NAME, set_param);
+    simulation.GetEnvironment()->Update();
+
+    std::vector<EulerGrid*> separate;
+    std::vector<EulerGrid*> fused;
+    for (int s = 0; s < 3; s++) {
+      for (auto* grids : {&separate, &fused}) {
+        auto* dgrid =
+            new EulerGrid(s, "Substance", 0.5 * (s + 1), 0.01 * s, 20);
+        if (std::string(bc) == "Neumann") {
+          dgrid->SetBoundaryCondition(
+              std::make_unique<ConstantBoundaryCondition>(0.1));
+        }
+        dgrid->Initialize();
+        dgrid->SetUpperThreshold(1e15);
+        dgrid->ChangeConcentrationBy({{10.0 * s, 0, -30}}, 1000);
+        dgrid->ChangeConcentrationBy({{-100, -100, -100}}, 500);
+        grids->push_back(dgrid);
+      }
+    }
+    auto* group = MultiSpeciesEulerGrid::Fuse(fused);
+    EXPECT_EQ(group, fused[2]->GetSpeciesGroup());
+    EXPECT_EQ(nullptr, separate[0]->GetSpeciesGroup());
+
+    for (int t = 0; t < 10; t++) {
+      for (int s = 0; s < 3; s++) {
+        separate[s]->Step(1);
+        fused[s]->Step(1);
+      }
+    }
+
+    for (int s = 0; s < 3; s++) {
+      auto* expected = separate[s]->GetAllConcentrations();
+      auto* actual = fused[s]->GetAllConcentrations();
+      for (size_t i = 0; i < fused[s]->GetNumBoxes(); i++) {
+        // The fused sweep computes exactly the same terms
+        EXPECT_EQ(expected[i], actual[i]);
+      }
+      delete separate[s];
+      delete fused[s];
+    }
+  }
+}
+
+TEST(DiffusionTest, MultiSpeciesEulerGridDifferentTimeSteps) {
+  ASSERT_DEATH(
+      {
+        Simulation simulation(TEST_NAME);
+        EulerGrid a(0, "A", 0.5, 0, 10);
+        EulerGrid b(1, "B", 0.5, 0, 10);
+        a.SetTimeStep(0.1);
+        b.SetTimeStep(0.2);
+        MultiSpeciesEulerGrid::Fuse({&a, &b});
+      },
+      ".*has the time step.*");
+}
+
+TEST(DiffusionTest, MultiSpeciesEulerGridReaction) {
+  auto set_param = [](auto* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -100;
+    param->max_bound = 100;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+
+  // Fixed substances, i.e. only the reaction changes the concentrations
+  EulerGrid a(0, "A", 0, 0, 10);
+  EulerGrid b(1, "B", 0, 0, 10);
+  for (auto* dgrid : {&a, &b}) {
+    dgrid->Initialize();
+    for (size_t i = 0; i < dgrid->GetNumBoxes(); i++) {
+      dgrid->ChangeConcentrationBy(i, 2);
+    }
+  }
+  // A + B -> 2 B
+  MultiSpeciesEulerGrid::Fuse({&a, &b}, [](real_t* c, real_t dt) {
+    real_t rate = 0.1 * c[0] * c[1] * dt;
+    c[0] -= rate;
+    c[1] += rate;
+  });
+  a.Step(0.5);
+  b.Step(0.5);
+
+  for (size_t i = 0; i < a.GetNumBoxes(); i++) {
+    EXPECT_REAL_EQ(1.8, a.GetConcentration(i));
+    EXPECT_REAL_EQ(2.2, b.GetConcentration(i));
+  }
+}
+
+TEST(DiffusionTest, SparseEulerGrid) {
+  for (auto bc : {"Neumann", "Dirichlet", "Periodic"}) {
+    auto set_param = [&](auto* param) {
+      param->bound_space = Param::BoundSpaceMode::kClosed;
+      param->min_bound = -100;
+      param->max_bound = 100;
+      param->diffusion_boundary_condition = bc;
+    };
+    Simulation simulation(TEST_NAME, set_param);
+    simulation.GetEnvironment()->Update();
+
+    // The resolution is not a multiple of the brick size
+    EulerGrid dense(0, "Substance", 0.5, 0.01, 20);
+    SparseEulerGrid sparse(0, "Substance", 0.5, 0.01, 20);
+    for (DiffusionGrid* dgrid : {static_cast<DiffusionGrid*>(&dense),
+                                 static_cast<DiffusionGrid*>(&sparse)}) {
+      if (std::string(bc) == "Neumann") {
+        dgrid->SetBoundaryCondition(
+            std::make_unique<ConstantBoundaryCondition>(0.1));
+      }
+      dgrid->Initialize();
+      dgrid->SetUpperThreshold(1e15);
+      dgrid->ChangeConcentrationBy({{0, 0, -30}}, 1000);
+      dgrid->ChangeConcentrationBy({{-100, -100, -100}}, 500);
+    }
+    EXPECT_EQ(27u, sparse.GetNumBricks());
+    EXPECT_EQ(2u, sparse.GetNumActiveBricks());
+
+    for (int t = 0; t < 10; t++) {
+      dense.Step(1);
+      sparse.Step(1);
+    }
+    dense.CalculateGradient();
+    sparse.CalculateGradient();
+
+    auto* expected = dense.GetAllConcentrations();
+    auto* actual = sparse.GetAllConcentrations();
+    for (size_t i = 0; i < dense.GetNumBoxes(); i++) {
+      EXPECT_NEAR(expected[i], actual[i], 1e-9);
+      EXPECT_NEAR(expected[i], sparse.GetConcentration(i), 1e-9);
+    }
+    for (Real3 pos : {Real3({0, 0, -30}), Real3({-95, -95, -95}),
+                      Real3({20, 10, -35})}) {
+      Real3 expected_gradient;
+      Real3 actual_gradient;
+      dense.GetGradient(pos, &expected_gradient, false);
+      sparse.GetGradient(pos, &actual_gradient, false);
+      for (int i = 0; i < 3; i++) {
+        EXPECT_NEAR(expected_gradient[i], actual_gradient[i], 1e-9);
+      }
+    }
+  }
+}
+
+TEST(DiffusionTest, SparseEulerGridActiveBricks) {
+  auto set_param = [](auto* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -100;
+    param->max_bound = 100;
+    param->diffusion_boundary_condition = "Neumann";
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+
+  SparseEulerGrid dgrid(0, "Substance", 0.5, 0, 64);
+  dgrid.SetActivationThreshold(1e-6);
+  dgrid.Initialize();
+  EXPECT_EQ(512u, dgrid.GetNumBricks());
+  EXPECT_EQ(0u, dgrid.GetNumActiveBricks());
+  EXPECT_EQ(0, dgrid.GetValue({{0, 0, 0}}));
+
+  dgrid.ChangeConcentrationBy({{1, 1, 1}}, 1000);
+  EXPECT_EQ(1u, dgrid.GetNumActiveBricks());
+  EXPECT_REAL_EQ(1000, dgrid.GetValue({{1, 1, 1}}));
+
+  for (int t = 0; t < 20; t++) {
+    dgrid.Step(1);
+  }
+  // The substance only reached the neighboring bricks
+  EXPECT_LT(1u, dgrid.GetNumActiveBricks());
+  EXPECT_GT(64u, dgrid.GetNumActiveBricks());
+  EXPECT_EQ(0, dgrid.GetValue({{90, 90, 90}}));
+
+  // Without decay, the substance is conserved up to the activation threshold
+  auto* concentrations = dgrid.GetAllConcentrations();
+  real_t total = 0;
+  for (size_t i = 0; i < dgrid.GetNumBoxes(); i++) {
+    total += concentrations[i];
+  }
+  EXPECT_NEAR(1000, total, 1e-2);
+}
+
+// The steady state must agree with the equilibrium of the explicit scheme
+TEST(DiffusionTest, SteadyStateGrid) {
+  for (auto bc : {"Neumann", "Dirichlet", "Periodic", "closed"}) {
+    auto set_param = [&](auto* param) {
+      param->bound_space = Param::BoundSpaceMode::kClosed;
+      param->min_bound = -100;
+      param->max_bound = 100;
+      param->diffusion_boundary_condition = bc;
+      param->multigrid_max_v_cycles = 50;
+      param->multigrid_tolerance = 1e-10;
+    };
+    Simulation simulation(TEST_NAME, set_param);
+    simulation.GetEnvironment()->Update();
+
+    EulerGrid euler(0, "Substance", 0.5, 0.1, 10);
+    SteadyStateGrid steady(0, "Substance", 0.5, 0.1, 10);
+    std::vector<Real3> sources = {{0, 0, -30}, {30, -20, 10}};
+    for (DiffusionGrid* dgrid : {static_cast<DiffusionGrid*>(&euler),
+                                 static_cast<DiffusionGrid*>(&steady)}) {
+      if (std::string(bc) == "Neumann") {
+        dgrid->SetBoundaryCondition(
+            std::make_unique<ConstantBoundaryCondition>(0.1));
+      } else if (std::string(bc) == "Dirichlet") {
+        dgrid->SetBoundaryCondition(
+            std::make_unique<ConstantBoundaryCondition>(1));
+      }
+      dgrid->Initialize();
+      dgrid->SetUpperThreshold(1e15);
+    }
+
+    for (int t = 0; t < 300; t++) {
+      for (auto& pos : sources) {
+        euler.ChangeConcentrationBy(pos, 1);
+      }
+      euler.Step(1);
+    }
+    for (auto& pos : sources) {
+      steady.ChangeConcentrationBy(pos, 1);
+    }
+    steady.Step(1);
+    EXPECT_LT(0u, steady.GetNumVCycles());
+    EXPECT_GT(1e-10, steady.GetRelativeResidual());
+
+    // The previous solution is the steady state of unchanged sources
+    for (auto& pos : sources) {
+      steady.ChangeConcentrationBy(pos, 1);
+    }
+    steady.Step(1);
+    EXPECT_EQ(0u, steady.GetNumVCycles());
+
+    // The explicit scheme stores the concentration after the decay and
+    // diffusion of the last secretion
+    std::vector<real_t> secreted(euler.GetNumBoxes(), 0);
+    for (auto& pos : sources) {
+      secreted[euler.GetBoxIndex(pos)] += 1;
+    }
+    for (size_t i = 0; i < euler.GetNumBoxes(); i++) {
+      EXPECT_NEAR(euler.GetConcentration(i) + secreted[i],
+                  steady.GetConcentration(i), 1e-6);
+    }
+  }
+}
+
 TEST(DiffusionTest, EulerDepletionConvergenceExponentialDecay) {
   double simulation_time_step{0.1};
   auto set_param = [](auto* param) {
@@ -1420,6 +1866,67 @@ TEST(DiffusionTest, LazyGradientComputation) {
   }
 }
 
+TEST(DiffusionTest, CachedGradientComputation) {
+  auto set_param = [](auto* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -100;
+    param->max_bound = 100;
+    param->lazy_gradients = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+
+  EulerGrid dgrid(0, "Substance", 0.5, 0.01, 20);
+  // Reference without precomputed gradients, i.e. computed on the fly
+  EulerGrid reference(1, "Reference", 0.5, 0.01, 20);
+  reference.TurnOffGradientCalculation();
+  for (auto* grid : {&dgrid, &reference}) {
+    grid->Initialize();
+    grid->ChangeConcentrationBy({{0, 0, 0}}, 1000);
+    grid->Step(1);
+    grid->CalculateGradient();
+  }
+
+  std::vector<Real3> positions = {{0, 0, 0}, {10, -5, 0}, {-95, 95, 0}};
+  for (const auto& pos : positions) {
+    Real3 expected;
+    Real3 actual;
+    reference.GetGradient(pos, &expected, false);
+    dgrid.GetGradient(pos, &actual, false);
+    for (int i = 0; i < 3; i++) {
+      EXPECT_REAL_EQ(expected[i], actual[i]);
+    }
+  }
+
+  // Cached gradients are kept until the next call to CalculateGradient
+  Real3 before;
+  dgrid.GetGradient({10, 0, 0}, &before, false);
+  dgrid.ChangeConcentrationBy({{20, 0, 0}}, 1000);
+  Real3 cached;
+  dgrid.GetGradient({10, 0, 0}, &cached, false);
+  EXPECT_REAL_EQ(before[0], cached[0]);
+  dgrid.CalculateGradient();
+  Real3 after;
+  dgrid.GetGradient({10, 0, 0}, &after, false);
+  EXPECT_LT(before[0], after[0]);
+
+  // All gradients are computed for the export
+  reference.ChangeConcentrationBy({{20, 0, 0}}, 1000);
+  const real_t* all = dgrid.GetAllGradients();
+  for (size_t idx = 0; idx < dgrid.GetNumBoxes(); idx++) {
+    auto box = dgrid.GetBoxCoordinates(idx);
+    Real3 pos;
+    for (int i = 0; i < 3; i++) {
+      pos[i] = -100 + (box[i] + 0.5) * dgrid.GetBoxLength();
+    }
+    Real3 expected;
+    reference.GetGradient(pos, &expected, false);
+    for (int i = 0; i < 3; i++) {
+      EXPECT_REAL_EQ(expected[i], all[3 * idx + i]);
+    }
+  }
+}
+
 TEST(DiffusionTest, PrintInfoBeforeInititialization) {
   Simulation simulation(TEST_NAME);
 
@@ -13,6 +13,7 @@
 // -----------------------------------------------------------------------------
 
 #include "core/environment/uniform_grid_environment.h"
+#include <set>
 #include <sstream>
 #include <string>
 #include "core/agent/cell.h"
@@ -151,6 +152,298 @@ TEST(UniformGridEnvironmentTest, ForEachNeighborWithoutDistance) {
   EXPECT_EQ(expected_63, neighbors[AgentUid(63)]);
 }
 
+// Returns the sorted neighbor uids of each agent.
+std::unordered_map<AgentUid, std::vector<AgentUid>> CollectNeighbors(
+    Simulation* simulation, bool with_distance) {
+  auto* rm = simulation->GetResourceManager();
+  auto* grid = simulation->GetEnvironment();
+
+  std::unordered_map<AgentUid, std::vector<AgentUid>> neighbors;
+  rm->ForEachAgent([&](Agent* agent) {
+    auto uid = agent->GetUid();
+    auto& agent_neighbors = neighbors[uid];
+    if (with_distance) {
+      auto fill_neighbor_list = L2F([&](Agent* neighbor, real_t) {
+        agent_neighbors.push_back(neighbor->GetUid());
+      });
+      grid->ForEachNeighbor(fill_neighbor_list, *agent, 900);
+    } else {
+      auto fill_neighbor_list = L2F([&](Agent* neighbor) {
+        agent_neighbors.push_back(neighbor->GetUid());
+      });
+      grid->ForEachNeighbor(fill_neighbor_list, *agent, nullptr);
+    }
+    std::sort(agent_neighbors.begin(), agent_neighbors.end());
+  });
+  return neighbors;
+}
+
+TEST(UniformGridEnvironmentTest, CellList) {
+  std::unordered_map<AgentUid, std::vector<AgentUid>> expected[2];
+  {
+    Simulation simulation(TEST_NAME);
+    CellFactory(simulation.GetResourceManager(), 5);
+    simulation.GetEnvironment()->Update();
+    expected[0] = CollectNeighbors(&simulation, true);
+    expected[1] = CollectNeighbors(&simulation, false);
+  }
+
+  auto set_param = [](Param* param) { param->uniform_grid_cell_list = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  CellFactory(simulation.GetResourceManager(), 5);
+  simulation.GetEnvironment()->Update();
+
+  EXPECT_EQ(125u, expected[0].size());
+  EXPECT_EQ(expected[0], CollectNeighbors(&simulation, true));
+  EXPECT_EQ(expected[1], CollectNeighbors(&simulation, false));
+}
+
+// The cell list must not filter neighbors by the positions at the time of
+// the last update
+void RunCellListCurrentPositionsTest(const std::string& name,
+                                     bool agent_columns) {
+  auto set_param = [&](Param* param) {
+    param->uniform_grid_cell_list = true;
+    param->agent_columns = agent_columns;
+  };
+  Simulation simulation(name, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* cell0 = new Cell({0, 0, 0});
+  cell0->SetDiameter(10);
+  rm->AddAgent(cell0);
+  auto* cell1 = new Cell({8, 0, 0});
+  cell1->SetDiameter(10);
+  rm->AddAgent(cell1);
+  simulation.GetEnvironment()->Update();
+
+  std::vector<real_t> distances;
+  auto collect = L2F([&](Agent*, real_t squared_distance) {
+    distances.push_back(squared_distance);
+  });
+  simulation.GetEnvironment()->ForEachNeighbor(collect, *cell0, 49);
+  EXPECT_TRUE(distances.empty());
+
+  cell1->SetPosition({6, 0, 0});
+  simulation.GetEnvironment()->ForEachNeighbor(collect, *cell0, 49);
+  ASSERT_EQ(1u, distances.size());
+  EXPECT_REAL_EQ(36, distances[0]);
+
+  distances.clear();
+  cell1->SetPosition({9, 0, 0});
+  simulation.GetEnvironment()->ForEachNeighbor(collect, *cell0, 49);
+  EXPECT_TRUE(distances.empty());
+}
+
+TEST(UniformGridEnvironmentTest, CellListCurrentPositions) {
+  RunCellListCurrentPositionsTest(TEST_NAME, false);
+}
+
+TEST(UniformGridEnvironmentTest, CellListCurrentPositionsAgentColumns) {
+  RunCellListCurrentPositionsTest(TEST_NAME, true);
+}
+
+TEST(UniformGridEnvironmentTest, SizeClasses) {
+  auto set_param = [](Param* param) {
+    param->uniform_grid_large_agent_factor = 3;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  for (int x = 0; x < 10; ++x) {
+    for (int y = 0; y < 10; ++y) {
+      for (int z = 0; z < 10; ++z) {
+        auto* cell = new Cell({x * 3.0, y * 3.0, z * 3.0});
+        cell->SetDiameter(x % 2 == 0 ? 3.5 : 4);
+        rm->AddAgent(cell);
+      }
+    }
+  }
+  for (real_t x : {7.5, 20.5}) {
+    auto* cell = new Cell({x, 12, 14});
+    cell->SetDiameter(20);
+    rm->AddAgent(cell);
+  }
+
+  auto* grid =
+      static_cast<UniformGridEnvironment*>(simulation.GetEnvironment());
+  grid->Update();
+  ASSERT_TRUE(grid->UsesSizeClasses());
+  EXPECT_REAL_EQ(4, grid->GetLargestSmallAgentSize());
+  EXPECT_EQ(4, grid->GetBoxLength());
+
+  // Search radius: (own diameter + largest small diameter) / 2
+  // All agents that touch the query agent must be found exactly once.
+  rm->ForEachAgent([&](Agent* agent) {
+    std::vector<AgentUid> expected;
+    rm->ForEachAgent([&](Agent* other) {
+      auto diff = agent->GetPosition() - other->GetPosition();
+      auto contact = (agent->GetDiameter() + other->GetDiameter()) / 2;
+      if (agent != other && diff * diff < contact * contact) {
+        expected.push_back(other->GetUid());
+      }
+    });
+
+    std::vector<AgentUid> actual;
+    auto fill_neighbor_list = L2F([&](Agent* neighbor, real_t) {
+      auto diff = agent->GetPosition() - neighbor->GetPosition();
+      auto contact = (agent->GetDiameter() + neighbor->GetDiameter()) / 2;
+      if (diff * diff < contact * contact) {
+        actual.push_back(neighbor->GetUid());
+      }
+    });
+    auto radius = (agent->GetDiameter() + 4) / 2;
+    grid->ForEachNeighbor(fill_neighbor_list, *agent, radius * radius);
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(expected, actual);
+  });
+
+  // The overload without search radius must also return large agents beyond
+  // the surrounding boxes
+  uint64_t num_large_neighbors = 0;
+  rm->ForEachAgent([&](Agent* agent) {
+    std::set<Agent*> neighbors;
+    auto collect = L2F([&](Agent* neighbor) { neighbors.insert(neighbor); });
+    grid->ForEachNeighbor(collect, *agent, nullptr);
+    rm->ForEachAgent([&](Agent* other) {
+      if (other == agent || other->GetDiameter() <= 4) {
+        return;
+      }
+      auto diff = agent->GetPosition() - other->GetPosition();
+      auto reach = 4 + (other->GetDiameter() - 4) / 2;
+      if (diff * diff < reach * reach) {
+        EXPECT_EQ(1u, neighbors.count(other));
+        num_large_neighbors++;
+      }
+    });
+  });
+  EXPECT_LT(0u, num_large_neighbors);
+}
+
+// Returns the neighbors of each agent within a distance of 30
+std::unordered_map<AgentUid, std::vector<AgentUid>> BruteForceNeighbors(
+    ResourceManager* rm) {
+  std::unordered_map<AgentUid, std::vector<AgentUid>> neighbors;
+  rm->ForEachAgent([&](Agent* agent) {
+    auto& agent_neighbors = neighbors[agent->GetUid()];
+    rm->ForEachAgent([&](Agent* other) {
+      auto diff = agent->GetPosition() - other->GetPosition();
+      if (agent != other && diff * diff < 900) {
+        agent_neighbors.push_back(other->GetUid());
+      }
+    });
+    std::sort(agent_neighbors.begin(), agent_neighbors.end());
+  });
+  return neighbors;
+}
+
+TEST(UniformGridEnvironmentTest, VerletLists) {
+  auto set_param = [](Param* param) { param->verlet_skin = 4; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* random = simulation.GetRandom();
+  auto* grid = simulation.GetEnvironment();
+  CellFactory(rm, 5);
+  grid->Update();
+  EXPECT_EQ(34, static_cast<UniformGridEnvironment*>(grid)->GetBoxLength());
+  EXPECT_EQ(BruteForceNeighbors(rm), CollectNeighbors(&simulation, true));
+
+  // Displacements smaller than half the skin reuse the Verlet lists
+  for (int i = 0; i < 2; ++i) {
+    rm->ForEachAgent([&](Agent* agent) {
+      agent->SetPosition(agent->GetPosition() +
+                         random->UniformArray<3>(-0.5, 0.5));
+    });
+    grid->ForcedUpdate();
+    EXPECT_EQ(BruteForceNeighbors(rm), CollectNeighbors(&simulation, true));
+  }
+
+  // Larger displacements trigger a rebuild
+  rm->ForEachAgent([&](Agent* agent) {
+    if (agent->GetUid() == AgentUid(62)) {
+      agent->SetPosition(agent->GetPosition() + Real3{15, 0, 0});
+    }
+  });
+  grid->ForcedUpdate();
+  EXPECT_EQ(BruteForceNeighbors(rm), CollectNeighbors(&simulation, true));
+}
+
+void RunIncrementalUpdateTest(const std::string& name, bool agent_columns) {
+  auto set_param = [&](Param* param) {
+    param->uniform_grid_incremental_update = true;
+    param->agent_columns = agent_columns;
+  };
+  Simulation simulation(name, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* grid = simulation.GetEnvironment();
+  CellFactory(rm, 4);
+  grid->Update();
+  auto dimensions = grid->GetDimensions();
+
+  // Move agents into different boxes and add a new agent that copies the
+  // box index of an existing one
+  rm->ForEachAgent([&](Agent* agent) {
+    Real3 displacement = {5, 0, 0};
+    if (agent->GetUid().GetIndex() % 3 == 0) {
+      displacement += {7, 11, 10};
+    }
+    agent->SetPosition(agent->GetPosition() + displacement);
+  });
+  auto* cell = new Cell({31, 29, 30});
+  cell->SetDiameter(30);
+  cell->SetBoxIdx(rm->GetAgent(AgentUid(0))->GetBoxIdx());
+  rm->AddAgent(cell);
+  grid->ForcedUpdate();
+
+  // A full rebuild would have shrunk the grid
+  EXPECT_EQ(dimensions, grid->GetDimensions());
+  EXPECT_EQ(65u, rm->GetNumAgents());
+  EXPECT_EQ(BruteForceNeighbors(rm), CollectNeighbors(&simulation, true));
+}
+
+TEST(UniformGridEnvironmentTest, IncrementalUpdate) {
+  RunIncrementalUpdateTest(TEST_NAME, false);
+}
+
+TEST(UniformGridEnvironmentTest, IncrementalUpdateAgentColumns) {
+  RunIncrementalUpdateTest(TEST_NAME, true);
+}
+
+TEST(UniformGridEnvironmentTest, AgentColumns) {
+  auto set_param = [](Param* param) { param->agent_columns = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* random = simulation.GetRandom();
+  auto* grid =
+      static_cast<UniformGridEnvironment*>(simulation.GetEnvironment());
+  CellFactory(rm, 5);
+  rm->ForEachAgent([&](Agent* agent) {
+    agent->SetPosition(agent->GetPosition() +
+                       random->UniformArray<3>(-3, 3));
+  });
+  grid->Update();
+  EXPECT_EQ(BruteForceNeighbors(rm), CollectNeighbors(&simulation, true));
+
+  // The handle version returns the same neighbors and distances
+  rm->ForEachAgent([&](Agent* agent) {
+    std::vector<std::pair<AgentUid, real_t>> expected;
+    auto collect = L2F([&](Agent* neighbor, real_t squared_distance) {
+      expected.push_back({neighbor->GetUid(), squared_distance});
+    });
+    grid->ForEachNeighbor(collect, *agent, 900);
+
+    std::vector<std::pair<AgentUid, real_t>> actual;
+    auto collect_handles = L2F([&](AgentHandle nh, real_t squared_distance) {
+      actual.push_back({rm->GetAgent(nh)->GetUid(), squared_distance});
+    });
+    grid->ForEachNeighborHandle(collect_handles, *agent, 900);
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(expected, actual);
+  });
+}
+
 void RunUpdateGridTest(Simulation* simulation) {
   auto* rm = simulation->GetResourceManager();
   auto* grid =
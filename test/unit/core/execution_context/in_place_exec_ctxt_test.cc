@@ -16,6 +16,7 @@
 
 #include "core/agent/cell.h"
 #include "core/environment/environment.h"
+#include "core/environment/uniform_grid_environment.h"
 #include "core/execution_context/in_place_exec_ctxt.h"
 #include "core/model_initializer.h"
 #include "core/operation/operation_registry.h"
@@ -356,6 +357,51 @@ TEST(InPlaceExecutionContext, ExecuteThreadSafetyTestAutomaticThreadSafety) {
       Param::ThreadSafetyMechanism::kAutomatic);
 }
 
+struct ColoredTestFunctor : public Functor<void, Agent*, AgentHandle> {
+  Operation* op;
+
+  explicit ColoredTestFunctor(Operation* op) : op(op) {}
+  void operator()(Agent* agent, AgentHandle ah) override {
+    auto* ctxt = Simulation::GetActive()->GetExecutionContext();
+    ctxt->Execute(agent, ah, {op});
+  }
+};
+
+TEST(InPlaceExecutionContext, ExecuteThreadSafetyTestBoxColoring) {
+  Simulation sim(TEST_NAME, [](Param* param) {
+    param->thread_safety_mechanism =
+        Param::ThreadSafetyMechanism::kBoxColoring;
+  });
+  auto* rm = sim.GetResourceManager();
+  auto* grid = static_cast<UniformGridEnvironment*>(sim.GetEnvironment());
+
+  auto construct = [](const Real3& position) {
+    Cell* cell = new Cell(position);
+    cell->SetDiameter(10);
+    return cell;
+  };
+  ModelInitializer::Grid3D(32, 10, construct);
+
+  const auto& all_exec_ctxts = sim.GetAllExecCtxts();
+  all_exec_ctxts[0]->SetupIterationAll(all_exec_ctxts);
+  grid->Update();
+
+  // this operation increases the diameter of the current agent and of all
+  // its neighbors without locks
+  auto* op = NewOperation("TestOperation");
+  ColoredTestFunctor functor(op);
+  grid->ForEachAgentByBoxColor(functor);
+
+  // No increment got lost, and each agent was processed exactly once
+  auto& num_neighbors = op->GetImplementation<TestOperation>()->num_neighbors;
+  EXPECT_EQ(rm->GetNumAgents(), num_neighbors.size());
+  rm->ForEachAgent([&](Agent* agent) {
+    EXPECT_REAL_EQ(11 + num_neighbors[agent->GetUid()], agent->GetDiameter());
+  });
+
+  delete op;
+}
+
 TEST(InPlaceExecutionContext, PushBackMultithreadingTest) {
   Simulation simulation(TEST_NAME);
 
@@ -14,6 +14,8 @@
 
 #include "core/exporter.h"
 #include "core/agent/cell.h"
+#include "core/agent/spherical_agent.h"
+#include "core/columnar_snapshot.h"
 #include "core/resource_manager.h"
 #include "core/simulation.h"
 #include "gtest/gtest.h"
@@ -171,4 +173,98 @@ TEST(ExportTest, ExportToFile) {
   ifs.close();
   remove("TestResultsParaview-0.vtu");
 }
+
+void CheckColumnarSnapshot(const std::string& filename) {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  ColumnarSnapshotReader reader(filename);
+  EXPECT_EQ(rm->GetNumAgents(), reader.GetNumAgents());
+  EXPECT_EQ(3u, reader.GetIteration());
+  std::vector<std::string> expected_columns = {
+      "uid",        "type",           "position", "diameter",
+      "adherence_", "tractor_force_", "box_idx_"};
+  EXPECT_EQ(expected_columns, reader.GetColumnNames());
+  std::vector<std::string> expected_types = {"bdm::Cell",
+                                             "bdm::SphericalAgent"};
+  EXPECT_EQ(expected_types, reader.GetTypeNames());
+  EXPECT_EQ(3u, reader.GetColumnEntry("tractor_force_").components);
+
+  const auto* uid = reader.GetColumn<uint64_t>("uid");
+  const auto* type = reader.GetColumn<uint16_t>("type");
+  const auto* position = reader.GetColumn<real_t>("position");
+  const auto* diameter = reader.GetColumn<real_t>("diameter");
+  const auto* adherence = reader.GetColumn<real_t>("adherence_");
+  const auto* tractor_force = reader.GetColumn<real_t>("tractor_force_");
+  const auto* box_idx = reader.GetColumn<uint32_t>("box_idx_");
+  // The rows follow the order of the agents in the resource manager
+  uint64_t i = 0;
+  rm->ForEachAgent([&](Agent* agent) {
+    EXPECT_EQ(uint64_t(agent->GetUid()), uid[i]);
+    EXPECT_EQ(agent->GetTypeName(),
+              reader.GetTypeNames()[type[i]].substr(5));
+    for (uint64_t d = 0; d < 3; ++d) {
+      EXPECT_EQ(agent->GetPosition()[d], position[3 * i + d]);
+    }
+    EXPECT_EQ(agent->GetDiameter(), diameter[i]);
+    EXPECT_EQ(agent->GetBoxIdx(), box_idx[i]);
+    if (auto* cell = dynamic_cast<Cell*>(agent)) {
+      EXPECT_EQ(cell->GetAdherence(), adherence[i]);
+      for (uint64_t d = 0; d < 3; ++d) {
+        EXPECT_EQ(cell->GetTractorForce()[d], tractor_force[3 * i + d]);
+      }
+    } else {
+      // Agents without the data member get zeros
+      EXPECT_EQ(0, adherence[i]);
+      EXPECT_EQ(0, tractor_force[3 * i]);
+    }
+    i++;
+  });
+  EXPECT_EQ(rm->GetNumAgents(), i);
+}
+
+TEST(ExportTest, ColumnarExporter) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+
+  for (int i = 0; i < 5000; ++i) {
+    auto* cell = new Cell({static_cast<real_t>(i), 1, 2});
+    cell->SetDiameter(10);
+    cell->SetAdherence(i % 7);
+    cell->SetTractorForce({0, static_cast<real_t>(i % 3), 1});
+    rm->AddAgent(cell);
+  }
+  rm->AddAgent(new SphericalAgent(3));
+
+  std::vector<std::string> data_members = {"adherence_", "tractor_force_",
+                                           "box_idx_"};
+  ColumnarExporter uncompressed(data_members);
+  uncompressed.ExportIteration("TestColumnarExporter.bdmcol", 3);
+  {
+    ColumnarSnapshotReader reader("TestColumnarExporter.bdmcol");
+    EXPECT_EQ(columnar::Compression::kNone,
+              reader.GetColumnEntry("position").compression);
+    // Uncompressed columns are read from the mapped file without copying
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(
+                      reader.GetColumn<real_t>("position")) %
+                      columnar::kAlignment);
+  }
+  CheckColumnarSnapshot("TestColumnarExporter.bdmcol");
+
+  ColumnarExporter compressed(data_members, columnar::Compression::kLz4);
+  compressed.SetCompression("uid", columnar::Compression::kNone);
+  compressed.SetCompression("tractor_force_", columnar::Compression::kZstd);
+  compressed.ExportIteration("TestColumnarExporter.bdmcol", 3);
+  {
+    ColumnarSnapshotReader reader("TestColumnarExporter.bdmcol");
+    EXPECT_EQ(columnar::Compression::kNone,
+              reader.GetColumnEntry("uid").compression);
+    EXPECT_EQ(columnar::Compression::kZstd,
+              reader.GetColumnEntry("tractor_force_").compression);
+    const auto& position = reader.GetColumnEntry("position");
+    EXPECT_EQ(columnar::Compression::kLz4, position.compression);
+    EXPECT_GT(position.raw_size, position.size);
+  }
+  CheckColumnarSnapshot("TestColumnarExporter.bdmcol");
+  remove("TestColumnarExporter.bdmcol");
+}
+
 }  // namespace bdm
@@ -0,0 +1,55 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/operation/mechanical_forces_op_simd.h"
+#include "core/scheduler.h"
+#include "unit/core/operation/standalone_mechanical_forces_op_test.h"
+#include "gtest/gtest.h"
+
+namespace bdm {
+namespace standalone_mechanical_forces_op_test_internal {
+
+inline void RunSimdMechanicalForces() {
+  auto* op = NewOperation("mechanical forces");
+  op->SelectComputeTarget(kCpuSimd);
+  op->SetUp();
+  (*op)();
+  op->TearDown();
+  delete op;
+}
+
+// Same results as `PairwiseMechanicalForcesOp`
+TEST(MechanicalForcesOpSimdTest, TwoCells) {
+  Simulation simulation(TEST_NAME);
+  RunTwoCellsTest(&simulation, RunSimdMechanicalForces);
+}
+
+TEST(MechanicalForcesOpSimdTest, BruteForce) {
+  Simulation simulation(TEST_NAME);
+  RunBruteForceTest(&simulation, RunSimdMechanicalForces);
+}
+
+TEST(MechanicalForcesOpSimdTest, ComputeTarget) {
+  auto set_param = [](Param* param) { param->compute_target = "cpu_simd"; };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetResourceManager()->AddAgent(new Cell(10));
+  simulation.GetScheduler()->Simulate(1);
+
+  auto* op = simulation.GetScheduler()->GetOps("mechanical forces")[0];
+  EXPECT_EQ(kCpuSimd, op->active_target_);
+  EXPECT_TRUE(op->IsStandalone());
+}
+
+}  // namespace standalone_mechanical_forces_op_test_internal
+}  // namespace bdm
@@ -26,5 +26,13 @@ TEST(DisplacementOpTest, ComputeNewUniformGrid) { RunTest2("uniform_grid"); }
 TEST(DisplacementOpTest, ComputeNewKDTree) { RunTest2("kd_tree"); }
 TEST(DisplacementOpTest, ComputeNewOctree) { RunTest2("octree"); }
 
+// The neighbor forces are calculated from the agent columns
+TEST(DisplacementOpTest, ComputeUniformGridAgentColumns) {
+  RunTest("uniform_grid", true);
+}
+TEST(DisplacementOpTest, ComputeNewUniformGridAgentColumns) {
+  RunTest2("uniform_grid", true);
+}
+
 }  // namespace mechanical_forces_op_test_internal
 }  // namespace bdm
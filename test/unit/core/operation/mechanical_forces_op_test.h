@@ -21,8 +21,12 @@
 
 namespace bdm {
 namespace mechanical_forces_op_test_internal {
-inline void RunTest(const std::string& environment) {
-  auto set_param = [&](auto* param) { param->environment = environment; };
+inline void RunTest(const std::string& environment,
+                    bool agent_columns = false) {
+  auto set_param = [&](auto* param) {
+    param->environment = environment;
+    param->agent_columns = agent_columns;
+  };
   Simulation simulation("mechanical_forces_op_test_RunTest", set_param);
   auto* rm = simulation.GetResourceManager();
 
@@ -93,8 +97,12 @@ inline void RunTest(const std::string& environment) {
   delete op;
 }
 
-inline void RunTest2(const std::string& environment) {
-  auto set_param = [&](auto* param) { param->environment = environment; };
+inline void RunTest2(const std::string& environment,
+                     bool agent_columns = false) {
+  auto set_param = [&](auto* param) {
+    param->environment = environment;
+    param->agent_columns = agent_columns;
+  };
   Simulation simulation("mechanical_forces_op_test_RunTest", set_param);
   auto* rm = simulation.GetResourceManager();
   auto* env = simulation.GetEnvironment();
@@ -22,6 +22,7 @@
 #include "core/resource_manager.h"
 #include "core/scheduler.h"
 #include "core/simulation.h"
+#include "unit/test_util/test_util.h"
 
 namespace bdm {
 
@@ -151,4 +152,57 @@ TEST(OperationTest, ReductionOpMultiThreading) {
   EXPECT_EQ(8000, op_impl->GetResults()[0]);
 }
 
+TEST(OperationTest, DataAccessConflicts) {
+  auto diffusion_a = OpDataAccess().ReadEnvironment().WriteContinuum("A");
+  auto diffusion_b = OpDataAccess().ReadEnvironment().WriteContinuum("B");
+  auto agents_read_b =
+      OpDataAccess().ReadAgents().WriteAgents().ReadContinuum("B");
+  auto all_continua = OpDataAccess().WriteAllContinua();
+
+  EXPECT_FALSE(diffusion_a.ConflictsWith(diffusion_b));
+  EXPECT_FALSE(diffusion_a.ConflictsWith(agents_read_b));
+  EXPECT_TRUE(diffusion_b.ConflictsWith(agents_read_b));
+  EXPECT_TRUE(agents_read_b.ConflictsWith(diffusion_b));
+  EXPECT_TRUE(all_continua.ConflictsWith(diffusion_a));
+  EXPECT_TRUE(all_continua.ConflictsWith(agents_read_b));
+  EXPECT_FALSE(all_continua.ConflictsWith(OpDataAccess().ReadAgents()));
+  EXPECT_TRUE(OpDataAccess::All().ConflictsWith(OpDataAccess()));
+
+  auto merged = OpDataAccess().ReadAgents();
+  EXPECT_FALSE(merged.ConflictsWith(diffusion_b));
+  merged.Merge(agents_read_b);
+  EXPECT_TRUE(merged.ConflictsWith(diffusion_b));
+
+  // Operations that use thread state must not run concurrently
+  auto thread_state = OpDataAccess().UseThreadState();
+  EXPECT_TRUE(thread_state.ConflictsWith(OpDataAccess().UseThreadState()));
+  EXPECT_FALSE(thread_state.ConflictsWith(diffusion_a));
+}
+
+TEST(OperationTest, ContinuumOpDataAccess) {
+  Simulation simulation(TEST_NAME);
+  ModelInitializer::DefineSubstance(0, "A", 0.4, 0, 10);
+  auto* op = NewOperation("continuum");
+  auto access = op->GetDataAccess();
+  EXPECT_TRUE(access.ConflictsWith(OpDataAccess().ReadContinuum("A")));
+  EXPECT_FALSE(access.ConflictsWith(OpDataAccess().ReadContinuum("B")));
+  EXPECT_FALSE(access.ConflictsWith(OpDataAccess().WriteAgents()));
+  EXPECT_FALSE(access.ConflictsWith(OpDataAccess().UseThreadState()));
+  // The behaviors can change the concentration of all substances
+  auto* behavior = NewOperation("behavior");
+  EXPECT_TRUE(access.ConflictsWith(behavior->GetDataAccess()));
+  delete behavior;
+  delete op;
+}
+
+TEST(OperationTest, SetDataAccess) {
+  Simulation simulation(TEST_NAME);
+  auto* op = NewOperation("OperationTestOp");
+  auto access = OpDataAccess().ReadAgents();
+  EXPECT_TRUE(op->GetDataAccess().ConflictsWith(access));
+  op->SetDataAccess(OpDataAccess().ReadContinuum("A"));
+  EXPECT_FALSE(op->GetDataAccess().ConflictsWith(access));
+  delete op;
+}
+
 }  // namespace bdm
@@ -0,0 +1,39 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/operation/pairwise_mechanical_forces_op.h"
+#include "unit/core/operation/standalone_mechanical_forces_op_test.h"
+#include "gtest/gtest.h"
+
+namespace bdm {
+namespace standalone_mechanical_forces_op_test_internal {
+
+inline void RunPairwiseMechanicalForces() {
+  auto* op = NewOperation("pairwise mechanical forces");
+  (*op)();
+  delete op;
+}
+
+TEST(PairwiseMechanicalForcesOpTest, TwoCells) {
+  Simulation simulation(TEST_NAME);
+  RunTwoCellsTest(&simulation, RunPairwiseMechanicalForces);
+}
+
+TEST(PairwiseMechanicalForcesOpTest, BruteForce) {
+  Simulation simulation(TEST_NAME);
+  RunBruteForceTest(&simulation, RunPairwiseMechanicalForces);
+}
+
+}  // namespace standalone_mechanical_forces_op_test_internal
+}  // namespace bdm
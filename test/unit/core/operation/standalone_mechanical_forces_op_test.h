@@ -0,0 +1,137 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef UNIT_CORE_OPERATION_STANDALONE_MECHANICAL_FORCES_OP_TEST_H_
+#define UNIT_CORE_OPERATION_STANDALONE_MECHANICAL_FORCES_OP_TEST_H_
+
+#include <functional>
+#include <vector>
+#include "core/agent/cell.h"
+#include "core/environment/environment.h"
+#include "core/functor.h"
+#include "core/interaction_force.h"
+#include "core/resource_manager.h"
+#include "core/simulation.h"
+#include "gtest/gtest.h"
+#include "unit/test_util/test_util.h"
+
+namespace bdm {
+namespace standalone_mechanical_forces_op_test_internal {
+
+/// Tests standalone operations that calculate all displacements based on the
+/// positions at the beginning of the operation (e.g.
+/// `PairwiseMechanicalForcesOp`). `run_op` executes the operation once.
+inline void RunTwoCellsTest(Simulation* simulation,
+                            const std::function<void()>& run_op) {
+  auto* rm = simulation->GetResourceManager();
+
+  Cell* cell0 = new Cell();
+  cell0->SetAdherence(0.3);
+  cell0->SetDiameter(9);
+  cell0->SetMass(1.4);
+  cell0->SetPosition({0, 0, 0});
+  rm->AddAgent(cell0);
+
+  Cell* cell1 = new Cell();
+  cell1->SetAdherence(0.4);
+  cell1->SetDiameter(11);
+  cell1->SetMass(1.1);
+  cell1->SetPosition({0, 5, 0});
+  rm->AddAgent(cell1);
+
+  simulation->GetEnvironment()->Update();
+  run_op();
+
+  // Both displacements are calculated based on the initial positions.
+  // Therefore, the result for cell1 differs from `MechanicalForcesOp`, which
+  // updates the agents one after another.
+  auto final_position = cell0->GetPosition();
+  EXPECT_NEAR(0, final_position[0], abs_error<real_t>::value);
+  EXPECT_NEAR(-0.07797206232558615, final_position[1],
+              abs_error<real_t>::value);
+  EXPECT_NEAR(0, final_position[2], abs_error<real_t>::value);
+  final_position = cell1->GetPosition();
+  EXPECT_NEAR(0, final_position[0], abs_error<real_t>::value);
+  EXPECT_NEAR(5.0992371702325645, final_position[1], abs_error<real_t>::value);
+  EXPECT_NEAR(0, final_position[2], abs_error<real_t>::value);
+
+  // The operation must not leave a cell list with the old positions behind.
+  // The distance between the cells was 5 before and is 5.177 after the
+  // operation.
+  uint64_t num_neighbors = 0;
+  auto count = L2F([&](Agent*, real_t) { num_neighbors++; });
+  simulation->GetEnvironment()->ForEachNeighbor(count, *cell0, 26);
+  EXPECT_EQ(0u, num_neighbors);
+}
+
+/// Compares the result of `run_op` with a brute force calculation over all
+/// pairs.
+inline void RunBruteForceTest(Simulation* simulation,
+                              const std::function<void()>& run_op) {
+  auto* rm = simulation->GetResourceManager();
+  auto* random = simulation->GetRandom();
+
+  std::vector<Cell*> cells;
+  for (int x = 0; x < 6; ++x) {
+    for (int y = 0; y < 6; ++y) {
+      for (int z = 0; z < 6; ++z) {
+        auto* cell = new Cell();
+        cell->SetAdherence(0);
+        cell->SetMass(1);
+        cell->SetDiameter(random->Uniform(6, 10));
+        cell->SetPosition({x * 8 + random->Uniform(-1, 1),
+                           y * 8 + random->Uniform(-1, 1),
+                           z * 8 + random->Uniform(-1, 1)});
+        rm->AddAgent(cell);
+        cells.push_back(cell);
+      }
+    }
+  }
+
+  auto* env = simulation->GetEnvironment();
+  env->Update();
+  auto squared_radius = env->GetLargestAgentSizeSquared();
+
+  InteractionForce force;
+  std::vector<Real3> expected(cells.size(), {0, 0, 0});
+  for (size_t i = 0; i < cells.size(); ++i) {
+    for (size_t j = 0; j < cells.size(); ++j) {
+      auto diff = cells[i]->GetPosition() - cells[j]->GetPosition();
+      if (i == j || diff * diff >= squared_radius) {
+        continue;
+      }
+      auto f = force.Calculate(cells[i], cells[j]);
+      expected[i] += Real3{f[0], f[1], f[2]};
+    }
+  }
+  std::vector<Real3> initial_positions;
+  for (auto* cell : cells) {
+    initial_positions.push_back(cell->GetPosition());
+  }
+
+  run_op();
+
+  auto dt = simulation->GetParam()->simulation_time_step;
+  for (size_t i = 0; i < cells.size(); ++i) {
+    auto displacement = cells[i]->GetPosition() - initial_positions[i];
+    for (int d = 0; d < 3; ++d) {
+      EXPECT_NEAR(expected[i][d] * dt, displacement[d], 1e-6);
+    }
+  }
+}
+
+}  // namespace standalone_mechanical_forces_op_test_internal
+}  // namespace bdm
+
+#endif  // UNIT_CORE_OPERATION_STANDALONE_MECHANICAL_FORCES_OP_TEST_H_
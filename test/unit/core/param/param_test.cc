@@ -14,6 +14,9 @@
 
 #include <gtest/gtest.h>
 #include <json.hpp>
+#include <sstream>
+
+#include "cpptoml/cpptoml.h"
 
 #include "core/multi_simulation/optimization_param.h"
 #include "core/multi_simulation/optimization_param_type/particle_swarm_param.h"
@@ -99,6 +102,81 @@ TEST(ParamTest, RestoreFromJson) {
   EXPECT_EQ(-10, test_param->test_param3);
 }
 
+// -----------------------------------------------------------------------------
+TEST(ParamTest, AssignFromConfig) {
+  std::stringstream toml(
+      "[simulation]\n"
+      "thread_safety_mechanism = \"box-coloring\"\n"
+      "random_generator = \"philox\"\n"
+      "deterministic = true\n"
+      "multigrid_max_v_cycles = 7\n"
+      "multigrid_tolerance = 0.001\n"
+      "\n"
+      "[visualization]\n"
+      "export_async = true\n"
+      "export_threads = 3\n"
+      "export_queue_depth = 4\n"
+      "\n"
+      "[performance]\n"
+      "work_stealing_runtime = true\n"
+      "concurrent_operations = true\n"
+      "agent_op_fusion = true\n"
+      "deferred_concentration_updates = true\n"
+      "lazy_gradients = true\n"
+      "continuum_multi_rate = true\n"
+      "continuum_max_interval = 5\n"
+      "uniform_grid_cell_list = true\n"
+      "uniform_grid_large_agent_factor = 2.5\n"
+      "verlet_skin = 1.5\n"
+      "uniform_grid_incremental_update = true\n"
+      "agent_columns = true\n"
+      "cost_weighted_load_balancing = true\n"
+      "\n"
+      "[development]\n"
+      "profiling = true\n"
+      "profiling_buffer_size = 1024\n"
+      "profiling_max_trace_events = 500\n"
+      "cost_accounting_sampling_interval = 8\n");
+  cpptoml::parser parser(toml);
+  Param param;
+  param.AssignFromConfig(parser.parse());
+
+  // simulation group
+  EXPECT_EQ(Param::ThreadSafetyMechanism::kBoxColoring,
+            param.thread_safety_mechanism);
+  EXPECT_EQ("philox", param.random_generator);
+  EXPECT_TRUE(param.deterministic);
+  EXPECT_EQ(7u, param.multigrid_max_v_cycles);
+  EXPECT_REAL_EQ(real_t(0.001), param.multigrid_tolerance);
+
+  // visualization group
+  EXPECT_TRUE(param.visualization_export_async);
+  EXPECT_EQ(3u, param.visualization_export_threads);
+  EXPECT_EQ(4u, param.visualization_export_queue_depth);
+
+  // performance group
+  EXPECT_TRUE(param.work_stealing_runtime);
+  EXPECT_TRUE(param.concurrent_operations);
+  EXPECT_TRUE(param.agent_op_fusion);
+  EXPECT_TRUE(param.deferred_concentration_updates);
+  EXPECT_TRUE(param.lazy_gradients);
+  EXPECT_TRUE(param.continuum_multi_rate);
+  EXPECT_EQ(5u, param.continuum_max_interval);
+  EXPECT_TRUE(param.uniform_grid_cell_list);
+  EXPECT_REAL_EQ(real_t(2.5), param.uniform_grid_large_agent_factor);
+  EXPECT_REAL_EQ(real_t(1.5), param.verlet_skin);
+  EXPECT_TRUE(param.uniform_grid_incremental_update);
+  EXPECT_TRUE(param.agent_columns);
+  EXPECT_TRUE(param.cost_weighted_load_balancing);
+
+  // development group
+  EXPECT_TRUE(param.profiling);
+  EXPECT_EQ(1024u, param.profiling_buffer_size);
+  EXPECT_EQ(500u, param.profiling_max_trace_events);
+  EXPECT_EQ(8u, param.cost_accounting_sampling_interval);
+}
+
+// -----------------------------------------------------------------------------
 TEST(ParamTest, OptimizationParam) {
   Param param;
   auto* opt_param = param.Get<OptimizationParam>();
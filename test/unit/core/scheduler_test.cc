@@ -13,6 +13,8 @@
 // -----------------------------------------------------------------------------
 
 #include "unit/core/scheduler_test.h"
+#include <atomic>
+#include <chrono>
 #include "core/environment/uniform_grid_environment.h"
 #include "core/model_initializer.h"
 #include "core/operation/operation_registry.h"
@@ -667,4 +669,114 @@ TEST(Scheduler, ForEachOpForEachAgent_ExecutionOrder) {
   EXPECT_EQ(AgentUid(1), execution_order[3].second);
 }
 
+// -----------------------------------------------------------------------------
+TEST(Scheduler, AgentOpFusion_ExecutionOrder) {
+  auto set_param = [](Param* param) {
+    param->execution_order = Param::ExecutionOrder::kForEachOpForEachAgent;
+    param->agent_op_fusion = true;
+    param->scheduling_batch_size = 1;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+
+  // Turn off load balancing and multi-threading to avoid any interference
+  omp_set_num_threads(1);
+  ThreadInfo::GetInstance()->Renew();
+  auto* scheduler = simulation.GetScheduler();
+  scheduler->UnscheduleOp(scheduler->GetOps("load balancing")[0]);
+
+  simulation.GetResourceManager()->AddAgent(new Cell(10));
+  simulation.GetResourceManager()->AddAgent(new Cell(10));
+
+  std::vector<std::pair<uint64_t, AgentUid>> execution_order;
+  for (uint64_t i = 0; i < 3; ++i) {
+    auto* op = NewOperation("em_test_op");
+    scheduler->ScheduleOp(op);
+    auto* op_impl = op->GetImplementation<ExecutionOrderTestOp>();
+    op_impl->id = i;
+    op_impl->execution_order = &execution_order;
+    // the last operation must not be fused with the previous ones
+    if (i == 2) {
+      op->SetRequiresGlobalBarrier(true);
+    }
+  }
+
+  scheduler->Simulate(1);
+
+  // reset to max number of threads
+  omp_set_num_threads(omp_get_max_threads());
+  ThreadInfo::GetInstance()->Renew();
+
+  std::vector<std::pair<uint64_t, AgentUid>> expected = {
+      {0, AgentUid(0)}, {1, AgentUid(0)}, {0, AgentUid(1)},
+      {1, AgentUid(1)}, {2, AgentUid(0)}, {2, AgentUid(1)}};
+  EXPECT_EQ(expected, execution_order);
+}
+
+// -----------------------------------------------------------------------------
+struct ConcurrentTestOp : public StandaloneOperationImpl {
+  BDM_OP_HEADER(ConcurrentTestOp);
+
+  void operator()() override {
+    if (predecessor_) {
+      predecessor_finished_ = predecessor_->finished_.load();
+    }
+    started_ = true;
+    if (other_) {
+      // wait (with a timeout) until the other operation has started
+      auto start = std::chrono::steady_clock::now();
+      while (!other_->started_ &&
+             std::chrono::steady_clock::now() - start <
+                 std::chrono::seconds(10)) {
+      }
+      other_started_ = other_->started_.load();
+    }
+    finished_ = true;
+  }
+
+  OpDataAccess GetDataAccess() const override { return access_; }
+
+  OpDataAccess access_;
+  ConcurrentTestOp* other_ = nullptr;
+  ConcurrentTestOp* predecessor_ = nullptr;
+  std::atomic<bool> started_{false};
+  std::atomic<bool> finished_{false};
+  bool other_started_ = false;
+  bool predecessor_finished_ = false;
+
+  ConcurrentTestOp() = default;
+  ConcurrentTestOp(const ConcurrentTestOp& other) : access_(other.access_) {}
+};
+
+BDM_REGISTER_OP(ConcurrentTestOp, "concurrent_test_op", kCpu)
+
+TEST(Scheduler, ConcurrentOperations) {
+  auto set_param = [](Param* param) { param->concurrent_operations = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* scheduler = simulation.GetScheduler();
+
+  auto* op_a = NewOperation("concurrent_test_op");
+  auto* op_b = NewOperation("concurrent_test_op");
+  auto* op_c = NewOperation("concurrent_test_op");
+  auto* a = op_a->GetImplementation<ConcurrentTestOp>();
+  auto* b = op_b->GetImplementation<ConcurrentTestOp>();
+  auto* c = op_c->GetImplementation<ConcurrentTestOp>();
+  a->access_ = OpDataAccess().WriteContinuum("A");
+  b->access_ = OpDataAccess().WriteContinuum("B");
+  c->access_ = OpDataAccess().ReadContinuum("A");
+  // a and b must run concurrently; c must wait for a
+  a->other_ = b;
+  b->other_ = a;
+  c->predecessor_ = a;
+  scheduler->ScheduleOp(op_a);
+  scheduler->ScheduleOp(op_b);
+  scheduler->ScheduleOp(op_c);
+
+  simulation.Simulate(1);
+
+  EXPECT_TRUE(a->other_started_);
+  EXPECT_TRUE(b->other_started_);
+  EXPECT_TRUE(c->predecessor_finished_);
+  EXPECT_TRUE(c->finished_);
+}
+
 }  // namespace bdm
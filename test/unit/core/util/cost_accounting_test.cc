@@ -0,0 +1,162 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/util/cost_accounting.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include "core/agent/cell.h"
+#include "core/behavior/behavior.h"
+#include "core/resource_manager.h"
+#include "core/scheduler.h"
+#include "core/simulation.h"
+#include "unit/test_util/test_util.h"
+
+namespace bdm {
+namespace cost_accounting_test_internal {
+
+struct CheapBehavior : public Behavior {
+  BDM_BEHAVIOR_HEADER(CheapBehavior, Behavior, 1);
+  void Run(Agent* agent) override {}
+};
+
+struct ExpensiveBehavior : public Behavior {
+  BDM_BEHAVIOR_HEADER(ExpensiveBehavior, Behavior, 1);
+  void Run(Agent* agent) override {
+    auto start = CostAccounting::Now();
+    while (CostAccounting::Now() - start < 20000) {
+    }
+  }
+};
+
+struct OtherCell : public Cell {
+  BDM_AGENT_HEADER(OtherCell, Cell, 1);
+
+ public:
+  OtherCell() = default;
+  explicit OtherCell(const Real3& position) : Base(position) {}
+};
+
+TEST(CostAccountingTest, AllCalls) {
+  CostAccounting cost_accounting(1);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(cost_accounting.StartSample());
+    EXPECT_TRUE(cost_accounting.IsSampling());
+    cost_accounting.AddBehaviorCost(typeid(CheapBehavior), 10);
+    cost_accounting.AddBehaviorCost(typeid(ExpensiveBehavior), 100);
+    cost_accounting.StopSample(typeid(Cell), 200);
+    EXPECT_FALSE(cost_accounting.IsSampling());
+  }
+
+  auto agents = cost_accounting.GetAgentCosts();
+  ASSERT_EQ(1u, agents.size());
+  EXPECT_EQ("bdm::Cell", agents[0].name);
+  EXPECT_EQ(10u, agents[0].sampled_calls);
+  EXPECT_EQ(10u, agents[0].calls);
+  EXPECT_EQ(2000u, agents[0].time_ns);
+
+  auto behaviors = cost_accounting.GetBehaviorCosts();
+  ASSERT_EQ(2u, behaviors.size());
+  EXPECT_EQ("bdm::cost_accounting_test_internal::ExpensiveBehavior",
+            behaviors[0].name);
+  EXPECT_EQ(1000u, behaviors[0].time_ns);
+  EXPECT_EQ("bdm::cost_accounting_test_internal::CheapBehavior",
+            behaviors[1].name);
+  EXPECT_EQ(100u, behaviors[1].time_ns);
+  EXPECT_EQ(10u, behaviors[1].calls);
+
+  cost_accounting.Reset();
+  EXPECT_EQ(0u, cost_accounting.GetAgentCosts().size());
+  EXPECT_EQ(0u, cost_accounting.GetBehaviorCosts().size());
+}
+
+TEST(CostAccountingTest, Sampling) {
+  CostAccounting cost_accounting(4);
+  // Alternating agent types must not bias the samples
+  for (int i = 0; i < 8000; ++i) {
+    if (cost_accounting.StartSample()) {
+      if (i % 2 == 0) {
+        cost_accounting.StopSample(typeid(Cell), 100);
+      } else {
+        cost_accounting.StopSample(typeid(OtherCell), 300);
+      }
+    }
+  }
+
+  auto agents = cost_accounting.GetAgentCosts();
+  ASSERT_EQ(2u, agents.size());
+  EXPECT_EQ("bdm::cost_accounting_test_internal::OtherCell", agents[0].name);
+  EXPECT_EQ("bdm::Cell", agents[1].name);
+  EXPECT_EQ(8000u, agents[0].calls + agents[1].calls);
+  EXPECT_NEAR(4000, agents[0].calls, 400);
+  EXPECT_NEAR(1200000, agents[0].time_ns, 120000);
+  EXPECT_NEAR(2000, agents[0].sampled_calls + agents[1].sampled_calls, 200);
+}
+
+void RunSimulation(Param::ExecutionOrder execution_order) {
+  auto set_param = [&](Param* param) {
+    param->cost_accounting_sampling_interval = 2;
+    param->execution_order = execution_order;
+  };
+  Simulation simulation("CostAccountingTest-RunSimulation", set_param);
+  auto* rm = simulation.GetResourceManager();
+  for (int i = 0; i < 20; ++i) {
+    auto* cell = new Cell({i * 20.0, 0, 0});
+    cell->AddBehavior(new CheapBehavior());
+    rm->AddAgent(cell);
+    auto* other = new OtherCell({i * 20.0, 20, 0});
+    other->AddBehavior(new ExpensiveBehavior());
+    other->AddBehavior(new CheapBehavior());
+    rm->AddAgent(other);
+  }
+  auto* scheduler = simulation.GetScheduler();
+  scheduler->Simulate(5);
+
+  auto* cost_accounting = scheduler->GetCostAccounting();
+  ASSERT_NE(nullptr, cost_accounting);
+  auto agents = cost_accounting->GetAgentCosts();
+  ASSERT_EQ(2u, agents.size());
+  EXPECT_EQ("bdm::cost_accounting_test_internal::OtherCell", agents[0].name);
+  EXPECT_EQ("bdm::Cell", agents[1].name);
+
+  auto behaviors = cost_accounting->GetBehaviorCosts();
+  ASSERT_EQ(2u, behaviors.size());
+  EXPECT_EQ("bdm::cost_accounting_test_internal::ExpensiveBehavior",
+            behaviors[0].name);
+  EXPECT_EQ("bdm::cost_accounting_test_internal::CheapBehavior",
+            behaviors[1].name);
+  EXPECT_LT(0u, behaviors[1].sampled_calls);
+
+  std::stringstream out;
+  scheduler->PrintInfo(out);
+  EXPECT_NE(std::string::npos, out.str().find("Behavior type"));
+  EXPECT_NE(std::string::npos, out.str().find("ExpensiveBehavior"));
+}
+
+TEST(CostAccountingTest, ForEachAgentForEachOp) {
+  RunSimulation(Param::ExecutionOrder::kForEachAgentForEachOp);
+}
+
+TEST(CostAccountingTest, ForEachOpForEachAgent) {
+  RunSimulation(Param::ExecutionOrder::kForEachOpForEachAgent);
+}
+
+TEST(CostAccountingTest, Disabled) {
+  Simulation simulation(TEST_NAME);
+  simulation.GetScheduler()->Simulate(1);
+  EXPECT_EQ(nullptr, simulation.GetScheduler()->GetCostAccounting());
+  EXPECT_EQ(nullptr, CostAccounting::GetActive());
+}
+
+}  // namespace cost_accounting_test_internal
+}  // namespace bdm
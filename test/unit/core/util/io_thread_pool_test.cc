@@ -0,0 +1,71 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "core/util/io_thread_pool.h"
+
+namespace bdm {
+
+TEST(IoThreadPoolTest, ExecutesAllTasks) {
+  std::atomic<int> executed(0);
+  {
+    IoThreadPool pool(3, 2);
+    EXPECT_EQ(3u, pool.GetNumThreads());
+    for (int job = 0; job < 10; ++job) {
+      std::vector<std::function<void()>> tasks(5, [&]() { executed++; });
+      pool.Submit(std::move(tasks));
+    }
+    pool.Wait();
+    EXPECT_EQ(50, executed.load());
+    EXPECT_EQ(0u, pool.GetNumPendingJobs());
+
+    // The destructor finishes pending jobs
+    pool.Submit({[&]() { executed++; }});
+  }
+  EXPECT_EQ(51, executed.load());
+}
+
+TEST(IoThreadPoolTest, Backpressure) {
+  IoThreadPool pool(2, 1);
+  std::atomic<bool> release(false);
+  pool.Submit({[&]() {
+    while (!release) {
+      std::this_thread::yield();
+    }
+  }});
+  EXPECT_EQ(1u, pool.GetNumPendingJobs());
+
+  std::atomic<bool> submitted(false);
+  std::thread producer([&]() {
+    pool.Submit({[]() {}});
+    submitted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  // The second job must wait until the first one has been finished
+  EXPECT_FALSE(submitted.load());
+
+  release = true;
+  producer.join();
+  EXPECT_TRUE(submitted.load());
+  pool.Wait();
+  EXPECT_EQ(0u, pool.GetNumPendingJobs());
+}
+
+}  // namespace bdm
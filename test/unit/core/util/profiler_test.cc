@@ -0,0 +1,194 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/util/profiler.h"
+#include <gtest/gtest.h>
+#include <omp.h>
+#include <fstream>
+#include <sstream>
+#include "core/agent/cell.h"
+#include "core/behavior/behavior.h"
+#include "core/resource_manager.h"
+#include "core/scheduler.h"
+#include "core/simulation.h"
+#include "unit/test_util/test_util.h"
+
+namespace bdm {
+namespace profiler_test_internal {
+
+struct ProfiledBehavior : public Behavior {
+  BDM_BEHAVIOR_HEADER(ProfiledBehavior, Behavior, 1);
+  void Run(Agent* agent) override {}
+};
+
+std::string ReadFile(const std::string& filename) {
+  std::ifstream in(filename);
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  return buffer.str();
+}
+
+TEST(ProfilerTest, CallTree) {
+  Profiler profiler(1000, 1000);
+  Profiler::SetActive(&profiler);
+  int num_threads = 0;
+  for (int i = 0; i < 2; ++i) {
+    {
+      ProfileScope a(std::string("a"));
+#pragma omp parallel
+      {
+#pragma omp single
+        num_threads = omp_get_num_threads();
+        // Directly nested scope with the same name is collapsed
+        ProfileScope a1(std::string("a"));
+        ProfileScope b(std::string("b"));
+      }
+    }
+    profiler.EndIteration();
+  }
+  Profiler::SetActive(nullptr);
+
+  auto* a = profiler.GetStats("a");
+  ASSERT_NE(nullptr, a);
+  // The master thread collapses both scopes; each worker opens "a" once
+  EXPECT_EQ(2u * num_threads, a->count);
+  EXPECT_EQ(nullptr, profiler.GetStats("a;a"));
+
+  auto* b = profiler.GetStats("a;b");
+  ASSERT_NE(nullptr, b);
+  EXPECT_EQ(2u * num_threads, b->count);
+  uint64_t sum = 0;
+  for (auto ns : b->thread_ns) {
+    sum += ns;
+  }
+  EXPECT_EQ(b->total_ns, sum);
+  EXPECT_EQ(0u, profiler.GetNumDroppedEvents());
+}
+
+TEST(ProfilerTest, DroppedEvents) {
+  Profiler profiler(4, 6);
+  Profiler::SetActive(&profiler);
+  for (int i = 0; i < 10; ++i) {
+    BDM_PROFILE_SCOPE("scope");
+  }
+  // 6 events are dropped by the ring buffer
+  profiler.EndIteration();
+  EXPECT_EQ(6u, profiler.GetNumDroppedEvents());
+  for (int i = 0; i < 3; ++i) {
+    BDM_PROFILE_SCOPE("scope");
+  }
+  // The trace can only hold 2 more events
+  profiler.EndIteration();
+  Profiler::SetActive(nullptr);
+  EXPECT_EQ(7u, profiler.GetNumDroppedEvents());
+  EXPECT_EQ(13u, profiler.GetStats("scope")->count);
+}
+
+TEST(ProfilerTest, Output) {
+  Profiler profiler(100, 100);
+  Profiler::SetActive(&profiler);
+  {
+    ProfileScope outer(std::string("outer"));
+    ProfileScope inner(typeid(ProfiledBehavior));
+  }
+  profiler.EndIteration();
+  Profiler::SetActive(nullptr);
+
+  auto name = Profiler::GetName(Profiler::Intern(typeid(ProfiledBehavior)));
+  EXPECT_EQ("bdm::profiler_test_internal::ProfiledBehavior", name);
+
+  profiler.WriteChromeTrace("profiler_test.json");
+  auto trace = ReadFile("profiler_test.json");
+  EXPECT_NE(std::string::npos, trace.find("\"traceEvents\""));
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"outer\",\"ph\":\"X\""));
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"" + name + "\""));
+
+  profiler.WriteFoldedStacks("profiler_test.folded");
+  auto folded = ReadFile("profiler_test.folded");
+  EXPECT_NE(std::string::npos, folded.find("outer;" + name + " "));
+}
+
+TEST(ProfilerTest, Simulation) {
+  auto set_param = [](Param* param) { param->profiling = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  for (int i = 0; i < 1000; ++i) {
+    auto* cell = new Cell({(i % 10) * 20.0, (i / 10) * 20.0, 0});
+    cell->AddBehavior(new ProfiledBehavior());
+    rm->AddAgent(cell);
+  }
+  auto* scheduler = simulation.GetScheduler();
+  scheduler->Simulate(3);
+
+  auto* profiler = scheduler->GetProfiler();
+  ASSERT_NE(nullptr, profiler);
+  EXPECT_EQ(profiler, Profiler::GetActive());
+  std::stringstream out;
+  profiler->Print(out);
+  auto str = out.str();
+  EXPECT_NE(std::string::npos,
+            str.find("bdm::profiler_test_internal::ProfiledBehavior"));
+  EXPECT_NE(std::string::npos, str.find("UniformGridEnvironment::Update"));
+
+  // All threads record the behaviors below "agent ops"
+  const std::string behavior = "bdm::profiler_test_internal::ProfiledBehavior";
+  EXPECT_EQ(nullptr, profiler->GetStats(behavior));
+  auto* stats = profiler->GetStats("agent ops;" + behavior);
+  ASSERT_NE(nullptr, stats);
+  EXPECT_EQ(3000u, stats->count);
+  uint64_t num_threads = 0;
+  for (auto ns : stats->thread_ns) {
+    if (ns != 0) {
+      num_threads++;
+    }
+  }
+  if (omp_get_max_threads() > 1) {
+    EXPECT_LT(1u, num_threads);
+  } else {
+    EXPECT_EQ(1u, num_threads);
+  }
+}
+
+TEST(ProfilerTest, SimulationBoxColoring) {
+  auto set_param = [](Param* param) {
+    param->profiling = true;
+    param->thread_safety_mechanism =
+        Param::ThreadSafetyMechanism::kBoxColoring;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  for (int i = 0; i < 1000; ++i) {
+    auto* cell = new Cell({(i % 10) * 20.0, (i / 10) * 20.0, 0});
+    cell->AddBehavior(new ProfiledBehavior());
+    rm->AddAgent(cell);
+  }
+  simulation.GetScheduler()->Simulate(1);
+
+  auto* profiler = simulation.GetScheduler()->GetProfiler();
+  const std::string behavior = "bdm::profiler_test_internal::ProfiledBehavior";
+  EXPECT_EQ(nullptr, profiler->GetStats(behavior));
+  auto* stats = profiler->GetStats("agent ops;" + behavior);
+  ASSERT_NE(nullptr, stats);
+  EXPECT_EQ(1000u, stats->count);
+}
+
+TEST(ProfilerTest, Disabled) {
+  Simulation simulation(TEST_NAME);
+  simulation.GetScheduler()->Simulate(1);
+  EXPECT_EQ(nullptr, simulation.GetScheduler()->GetProfiler());
+  EXPECT_EQ(nullptr, Profiler::GetActive());
+}
+
+}  // namespace profiler_test_internal
+}  // namespace bdm
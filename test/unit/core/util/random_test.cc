@@ -18,6 +18,7 @@
 #include <TRandom3.h>
 #include <gtest/gtest.h>
 #include <limits>
+#include <vector>
 #include "unit/test_util/io_test.h"
 #include "unit/test_util/test_util.h"
 
@@ -423,6 +424,68 @@ TEST(RandomTest, Sphere) {
   }
 }
 
+TEST(RandomTest, UniformArrayBuffer) {
+  Simulation simulation(TEST_NAME);
+  auto* random = simulation.GetRandom();
+  TRandom3 reference;
+
+  random->SetSeed(42);
+  reference.SetSeed(42);
+
+  std::vector<real_t> buffer(20);
+  random->UniformArray(buffer.size(), buffer.data(), 5.1, 9.87);
+  for (auto el : buffer) {
+    EXPECT_REAL_EQ(static_cast<real_t>(reference.Uniform(5.1, 9.87)), el);
+  }
+}
+
+TEST(RandomTest, PhiloxBatch) {
+  auto set_param = [](Param* param) { param->random_generator = "philox"; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* random = simulation.GetRandom();
+
+  // Start in the middle of a block and cover several batches
+  random->SetStream(3, 1);
+  std::vector<real_t> expected(1500);
+  for (auto& el : expected) {
+    el = random->Uniform(-2, 5);
+  }
+  random->SetStream(3, 1);
+  std::vector<real_t> buffer(expected.size());
+  random->UniformArray(buffer.size(), buffer.data(), -2, 5);
+  for (uint64_t i = 0; i < buffer.size(); i++) {
+    EXPECT_REAL_EQ(expected[i], buffer[i]);
+  }
+  EXPECT_EQ(1501u, random->GetStreamPosition());
+
+  // Moments of the normal and Poisson deviates
+  uint64_t n = 100000;
+  std::vector<real_t> gaus(n);
+  random->GausArray(n, gaus.data(), 3, 2);
+  double gaus_mean = 0;
+  double gaus_var = 0;
+  for (auto el : gaus) {
+    gaus_mean += el / n;
+    gaus_var += (el - 3) * (el - 3) / n;
+  }
+  EXPECT_NEAR(3, gaus_mean, 0.05);
+  EXPECT_NEAR(4, gaus_var, 0.1);
+
+  for (real_t lambda : {0.5, 4.0, 50.0}) {
+    std::vector<int> poisson(n);
+    random->PoissonArray(n, poisson.data(), lambda);
+    double mean = 0;
+    double var = 0;
+    for (auto el : poisson) {
+      EXPECT_LE(0, el);
+      mean += static_cast<double>(el) / n;
+      var += (el - lambda) * (el - lambda) / n;
+    }
+    EXPECT_NEAR(lambda, mean, 0.05 * lambda);
+    EXPECT_NEAR(lambda, var, 0.05 * lambda);
+  }
+}
+
 #ifdef USE_DICT
 TEST_F(IOTest, Random) {
   Random random;
@@ -0,0 +1,90 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <vector>
+
+#include "core/agent/cell.h"
+#include "core/resource_manager.h"
+#include "core/util/thread_info.h"
+#include "core/util/work_stealing_runtime.h"
+#include "unit/test_util/test_util.h"
+
+namespace bdm {
+
+TEST(WorkStealingRuntimeTest, ParallelFor) {
+  auto* runtime = WorkStealingRuntime::GetInstance();
+  for (uint64_t num_tasks : {0, 1, 7, 1000, 100000}) {
+    std::vector<std::atomic<int>> executed(num_tasks);
+    runtime->ParallelFor(num_tasks, [&](uint64_t i) { executed[i]++; });
+    for (auto& e : executed) {
+      EXPECT_EQ(1, e.load());
+    }
+  }
+}
+
+// All tasks are initially assigned to one thread. Therefore, the other
+// threads must steal them.
+TEST(WorkStealingRuntimeTest, ParallelForNumaImbalanced) {
+  auto* ti = ThreadInfo::GetInstance();
+  auto* runtime = WorkStealingRuntime::GetInstance();
+  std::vector<uint64_t> tasks_per_numa(ti->GetNumaNodes(), 0);
+  tasks_per_numa[0] = 10000;
+  std::vector<uint64_t> begin(ti->GetMaxThreads(), 0);
+  std::vector<uint64_t> end(ti->GetMaxThreads(), 0);
+  for (int t = 0; t < ti->GetMaxThreads(); ++t) {
+    if (ti->GetNumaNode(t) == 0) {
+      end[t] = 10000;
+      break;
+    }
+  }
+
+  std::vector<std::atomic<int>> executed(10000);
+  std::vector<std::atomic<int>> tasks_per_thread(ti->GetMaxThreads());
+  auto task = L2F([&](int nid, uint64_t i) {
+    EXPECT_EQ(0, nid);
+    executed[i]++;
+    tasks_per_thread[ti->GetMyThreadId()]++;
+  });
+  runtime->ParallelForNuma(tasks_per_numa, task, begin, end);
+  for (auto& e : executed) {
+    EXPECT_EQ(1, e.load());
+  }
+  int total = 0;
+  for (auto& t : tasks_per_thread) {
+    total += t.load();
+  }
+  EXPECT_EQ(10000, total);
+}
+
+TEST(WorkStealingRuntimeTest, ForEachAgentParallel) {
+  auto set_param = [](Param* param) { param->work_stealing_runtime = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  for (int i = 0; i < 1000; ++i) {
+    rm->AddAgent(new Cell(10));
+  }
+
+  std::vector<std::atomic<int>> visited(1000);
+  auto count = L2F([&](Agent* agent, AgentHandle) {
+    visited[agent->GetUid().GetIndex()]++;
+  });
+  rm->ForEachAgentParallel(7, count);
+  for (auto& v : visited) {
+    EXPECT_EQ(1, v.load());
+  }
+}
+
+}  // namespace bdm
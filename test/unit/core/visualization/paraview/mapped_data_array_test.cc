@@ -17,6 +17,8 @@
 #include <TClassTable.h>
 #include <gtest/gtest.h>
 #include "core/agent/agent_uid_generator.h"
+#include "core/agent/cell.h"
+#include "core/resource_manager.h"
 #include "core/util/jit.h"
 #include "neuroscience/neurite_element.h"
 #include "neuroscience/neuroscience.h"
@@ -95,6 +97,52 @@ TEST(GetDataMemberForVisTest, NeuriteElement) {
   }
 }
 
+// -----------------------------------------------------------------------------
+TEST(MappedDataArrayTest, AgentColumns) {
+  auto set_param = [](Param* param) { param->agent_columns = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* cell = new Cell({1, 2, 3});
+  cell->SetDiameter(4);
+  rm->AddAgent(cell);
+  std::vector<Agent*> agents = {cell};
+  std::vector<AgentHandle> handles = {rm->GetAgentHandle(cell->GetUid())};
+
+  auto* tclass = TClassTable::GetDict("bdm::Cell")();
+  auto dms = FindDataMemberSlow(tclass, "position_");
+  ASSERT_EQ(1u, dms.size());
+  auto* position = MappedDataArray<real_t, Cell, Real3>::New();
+  position->Initialize(Param::MappedDataArrayMode::kZeroCopy, "position_", 3,
+                       dms[0]->GetOffset());
+  dms = FindDataMemberSlow(tclass, "diameter_");
+  ASSERT_EQ(1u, dms.size());
+  auto* diameter = MappedDataArray<real_t, Cell, real_t>::New();
+  diameter->Initialize(Param::MappedDataArrayMode::kZeroCopy, "diameter_", 1,
+                       dms[0]->GetOffset());
+
+  // The values are read from the columns, not from the agent
+  position->Update(&agents, &handles, 0, 1);
+  diameter->Update(&agents, &handles, 0, 1);
+  auto* columns = rm->GetAgentColumns();
+  columns->SetPosition(handles[0], {5, 6, 7});
+  columns->SetDiameter(handles[0], 8);
+  EXPECT_REAL_EQ(5, position->GetValue(0));
+  EXPECT_REAL_EQ(6, position->GetValue(1));
+  EXPECT_REAL_EQ(7, position->GetValue(2));
+  EXPECT_REAL_EQ(8, diameter->GetValue(0));
+
+  // Without handles, the agents are accessed
+  position->Update(&agents, nullptr, 0, 1);
+  diameter->Update(&agents, nullptr, 0, 1);
+  EXPECT_REAL_EQ(1, position->GetValue(0));
+  EXPECT_REAL_EQ(2, position->GetValue(1));
+  EXPECT_REAL_EQ(3, position->GetValue(2));
+  EXPECT_REAL_EQ(4, diameter->GetValue(0));
+
+  position->Delete();
+  diameter->Delete();
+}
+
 }  // namespace bdm
 
 #endif  // USE_PARAVIEW